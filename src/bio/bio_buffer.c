@@ -7,8 +7,19 @@
 #include <spdk/env.h>
 #include <spdk/blob.h>
 #include <spdk/thread.h>
+#include <gurt/atomic.h>
+#include <daos/checksum.h>
 #include "bio_internal.h"
 
+/*
+ * Process wide accounting of fetched bytes, of bytes copied by the CPU and of
+ * bytes consumed in place (zero-copy).
+ */
+static ATOMIC uint64_t	bio_fetched_bytes;
+static ATOMIC uint64_t	bio_copied_bytes;
+static ATOMIC uint64_t	bio_zero_copy_bytes;
+static ATOMIC uint64_t	bio_dma_bytes;
+
 static void
 dma_free_chunk(struct bio_dma_chunk *chunk)
 {
@@ -269,6 +280,10 @@ struct bio_copy_args {
 	int		 ca_iov_idx;
 	/* Current offset inside of current IOV */
 	ssize_t		 ca_iov_off;
+	/* Bytes copied between media and DRAM sg lists */
+	uint64_t	 ca_copied;
+	/* Checksum verification of each sg list while copying, optional */
+	struct dcs_copy_verify	*ca_cvs;
 };
 
 static int
@@ -467,6 +482,12 @@ dma_map_one(struct bio_desc *biod, struct bio_iov *biov,
 		return 0;
 	}
 
+	/* Decompressed by VOS, data is already staged in DRAM */
+	if (biov->bi_addr.ba_compressed) {
+		D_ASSERT(bio_iov2raw_buf(biov) != NULL);
+		return 0;
+	}
+
 	if (biov->bi_addr.ba_type == DAOS_MEDIA_SCM) {
 		struct umem_instance *umem = biod->bd_ctxt->bic_umem;
 		bio_iov_set_raw_buf(biov,
@@ -647,15 +668,96 @@ skip_media_error:
 		ABT_eventual_set(biod->bd_dma_done, NULL, 0);
 }
 
+/* Number of DMA pages spanned by a reserved region */
+static inline unsigned int
+region_pg_cnt(struct bio_rsrvd_region *rg)
+{
+	uint64_t pg_end = (rg->brr_end + BIO_DMA_PAGE_SZ - 1) >>
+				BIO_DMA_PAGE_SHIFT;
+
+	D_ASSERT(pg_end > (rg->brr_off >> BIO_DMA_PAGE_SHIFT));
+	return pg_end - (rg->brr_off >> BIO_DMA_PAGE_SHIFT);
+}
+
+/*
+ * Reset the DMA state of the io descriptor, return false if there isn't any
+ * NVMe I/O to be issued.
+ */
+static bool
+dma_rw_begin(struct bio_desc *biod)
+{
+	/* Write back already started by bio_iod_post_partial() */
+	if (biod->bd_rg_posted != 0 || biod->bd_pg_posted != 0)
+		return true;
+
+	biod->bd_inflights = 0;
+	biod->bd_dma_issued = 0;
+	biod->bd_result = 0;
+
+	/* Bypass NVMe I/O, used by daos_perf for performance evaluation */
+	if (daos_io_bypass & IOBP_NVME)
+		return false;
+
+	if (!is_blob_valid(biod->bd_ctxt)) {
+		D_ERROR("Blobstore is invalid. blob:%p, closing:%d\n",
+			biod->bd_ctxt->bic_blob, biod->bd_ctxt->bic_closing);
+		biod->bd_result = -DER_NO_HDL;
+		return false;
+	}
+
+	D_ASSERT(biod->bd_ctxt->bic_xs_ctxt->bxc_io_channel != NULL);
+	biod->bd_ctxt->bic_inflight_dmas++;
+	return true;
+}
+
+/* Issue the NVMe I/O for pages [pg_start, pg_end) of a reserved region */
+static void
+dma_rw_region(struct bio_desc *biod, struct bio_rsrvd_region *rg,
+	      unsigned int pg_start, unsigned int pg_end)
+{
+	struct bio_xs_context	*xs_ctxt = biod->bd_ctxt->bic_xs_ctxt;
+	struct spdk_blob	*blob = biod->bd_ctxt->bic_blob;
+	uint64_t		 pg_idx, pg_cnt;
+	void			*payload;
+
+	D_ASSERT(rg->brr_chk != NULL);
+	D_ASSERT(pg_start < pg_end && pg_end <= region_pg_cnt(rg));
+	pg_idx = (rg->brr_off >> BIO_DMA_PAGE_SHIFT) + pg_start;
+	pg_cnt = pg_end - pg_start;
+	payload = rg->brr_chk->bdc_ptr +
+		((rg->brr_pg_idx + pg_start) << BIO_DMA_PAGE_SHIFT);
+
+	biod->bd_inflights++;
+	xs_ctxt->bxc_blob_rw++;
+	/* NVMe poll needs be scheduled */
+	if (bio_need_nvme_poll(xs_ctxt))
+		bio_yield();
+
+	D_DEBUG(DB_IO, "%s blob:%p payload:%p, "
+		"pg_idx:"DF_U64", pg_cnt:"DF_U64"\n",
+		biod->bd_update ? "Write" : "Read",
+		blob, payload, pg_idx, pg_cnt);
+
+	if (biod->bd_update)
+		spdk_blob_io_write(blob, xs_ctxt->bxc_io_channel, payload,
+				   page2io_unit(biod->bd_ctxt, pg_idx),
+				   page2io_unit(biod->bd_ctxt, pg_cnt),
+				   rw_completion, biod);
+	else
+		spdk_blob_io_read(blob, xs_ctxt->bxc_io_channel, payload,
+				  page2io_unit(biod->bd_ctxt, pg_idx),
+				  page2io_unit(biod->bd_ctxt, pg_cnt),
+				  rw_completion, biod);
+}
+
 static void
 dma_rw(struct bio_desc *biod, bool prep)
 {
-	struct spdk_io_channel	*channel;
 	struct spdk_blob	*blob;
 	struct bio_rsrvd_dma	*rsrvd_dma = &biod->bd_rsrvd;
 	struct bio_rsrvd_region	*rg;
 	struct bio_xs_context	*xs_ctxt;
-	uint64_t		 pg_idx, pg_cnt, pg_end;
+	uint64_t		 pg_idx, pg_end;
 	void			*payload, *pg_rmw = NULL;
 	bool			 rmw_read = (prep && biod->bd_update);
 	unsigned int		 pg_off;
@@ -664,30 +766,14 @@ dma_rw(struct bio_desc *biod, bool prep)
 	D_ASSERT(biod->bd_ctxt->bic_xs_ctxt);
 	xs_ctxt = biod->bd_ctxt->bic_xs_ctxt;
 	blob = biod->bd_ctxt->bic_blob;
-	channel = xs_ctxt->bxc_io_channel;
 
-	biod->bd_inflights = 0;
-	biod->bd_dma_issued = 0;
-	biod->bd_result = 0;
-
-	/* Bypass NVMe I/O, used by daos_perf for performance evaluation */
-	if (daos_io_bypass & IOBP_NVME)
+	if (!dma_rw_begin(biod))
 		return;
 
-	if (!is_blob_valid(biod->bd_ctxt)) {
-		D_ERROR("Blobstore is invalid. blob:%p, closing:%d\n",
-			blob, biod->bd_ctxt->bic_closing);
-		biod->bd_result = -DER_NO_HDL;
-		return;
-	}
-
-	D_ASSERT(channel != NULL);
-	biod->bd_ctxt->bic_inflight_dmas++;
-
 	D_DEBUG(DB_IO, "DMA start, blob:%p, update:%d, rmw:%d\n",
 		blob, biod->bd_update, rmw_read);
 
-	for (i = 0; i < rsrvd_dma->brd_rg_cnt; i++) {
+	for (i = biod->bd_rg_posted; i < rsrvd_dma->brd_rg_cnt; i++) {
 		rg = &rsrvd_dma->brd_regions[i];
 
 		D_ASSERT(rg->brr_chk != NULL);
@@ -696,32 +782,10 @@ dma_rw(struct bio_desc *biod, bool prep)
 			(rg->brr_pg_idx << BIO_DMA_PAGE_SHIFT);
 
 		if (!rmw_read) {
-			pg_cnt = (rg->brr_end + BIO_DMA_PAGE_SZ - 1) >>
-					BIO_DMA_PAGE_SHIFT;
-			D_ASSERT(pg_cnt > pg_idx);
-			pg_cnt -= pg_idx;
-
-			biod->bd_inflights++;
-			xs_ctxt->bxc_blob_rw++;
-			/* NVMe poll needs be scheduled */
-			if (bio_need_nvme_poll(xs_ctxt))
-				bio_yield();
-
-			D_DEBUG(DB_IO, "%s blob:%p payload:%p, "
-				"pg_idx:"DF_U64", pg_cnt:"DF_U64"\n",
-				biod->bd_update ? "Write" : "Read",
-				blob, payload, pg_idx, pg_cnt);
-
-			if (biod->bd_update)
-				spdk_blob_io_write(blob, channel, payload,
-					page2io_unit(biod->bd_ctxt, pg_idx),
-					page2io_unit(biod->bd_ctxt, pg_cnt),
-					rw_completion, biod);
-			else
-				spdk_blob_io_read(blob, channel, payload,
-					page2io_unit(biod->bd_ctxt, pg_idx),
-					page2io_unit(biod->bd_ctxt, pg_cnt),
-					rw_completion, biod);
+			/* Skip the pages written by bio_iod_post_partial() */
+			pg_off = i == biod->bd_rg_posted ?
+				 biod->bd_pg_posted : 0;
+			dma_rw_region(biod, rg, pg_off, region_pg_cnt(rg));
 			continue;
 		}
 
@@ -754,6 +818,8 @@ dma_rw(struct bio_desc *biod, bool prep)
 			pg_rmw = payload;
 		}
 	}
+	biod->bd_rg_posted = 0;
+	biod->bd_pg_posted = 0;
 
 	if (xs_ctxt->bxc_tgt_id == -1) {
 		D_DEBUG(DB_IO, "Self poll completion, blob:%p\n", blob);
@@ -790,6 +856,19 @@ bio_memcpy(struct bio_desc *biod, uint16_t media, void *media_addr,
 	}
 }
 
+struct bio_memcpy_args {
+	struct bio_desc	*ma_biod;
+	uint16_t	 ma_media;
+};
+
+static void
+bio_memcpy_cb(void *dst, void *src, size_t len, void *arg)
+{
+	struct bio_memcpy_args	*ma = arg;
+
+	bio_memcpy(ma->ma_biod, ma->ma_media, dst, src, len);
+}
+
 static int
 copy_one(struct bio_desc *biod, struct bio_iov *biov,
 	 struct bio_copy_args *arg)
@@ -823,12 +902,25 @@ copy_one(struct bio_desc *biod, struct bio_iov *biov,
 		}
 
 		nob = min(size, buf_len - arg->ca_iov_off);
-		if (addr != NULL) {
+		if (addr != NULL && arg->ca_cvs != NULL) {
+			struct bio_memcpy_args	ma = { biod, media };
+			int			rc;
+
+			D_ASSERT(biod->bd_update);
+			rc = daos_csummer_copy_verify(
+					&arg->ca_cvs[arg->ca_sgl_idx], addr,
+					iov->iov_buf + arg->ca_iov_off, nob,
+					bio_memcpy_cb, &ma);
+			if (rc != 0)
+				return rc;
+			addr += nob;
+		} else if (addr != NULL) {
 			D_DEBUG(DB_TRACE, "bio copy %p size %zd\n",
 				addr, nob);
 			bio_memcpy(biod, media, addr, iov->iov_buf +
 					arg->ca_iov_off, nob);
 			addr += nob;
+			arg->ca_copied += nob;
 		} else {
 			/* fetch on hole */
 			D_ASSERT(!biod->bd_update);
@@ -863,6 +955,65 @@ copy_one(struct bio_desc *biod, struct bio_iov *biov,
 	return -DER_REC2BIG;
 }
 
+static void
+iod_account_fetch(struct bio_desc *biod)
+{
+	struct bio_iov	*biov;
+	uint64_t	 bytes = 0;
+	uint64_t	 dma_bytes = 0;
+	int		 i, j;
+
+	for (i = 0; i < biod->bd_sgl_cnt; i++) {
+		struct bio_sglist *bsgl = &biod->bd_sgls[i];
+
+		for (j = 0; j < bsgl->bs_nr_out; j++) {
+			biov = &bsgl->bs_iovs[j];
+			if (bio_addr_is_hole(&biov->bi_addr))
+				continue;
+			bytes += bio_iov2req_len(biov);
+			if (bio_iov2media(biov) == DAOS_MEDIA_NVME)
+				dma_bytes += bio_iov2req_len(biov);
+		}
+	}
+
+	biod->bd_fetched = bytes;
+	biod->bd_copied = 0;
+	if (bytes != 0)
+		atomic_fetch_add_relaxed(&bio_fetched_bytes, bytes);
+	if (dma_bytes != 0)
+		atomic_fetch_add_relaxed(&bio_dma_bytes, dma_bytes);
+}
+
+/*
+ * The fetched data not copied by bio_iod_copy() was consumed in place through
+ * bio_iod_sgl(), e.g. by a bulk transfer straight from SCM or DMA buffers.
+ */
+static void
+iod_account_zero_copy(struct bio_desc *biod)
+{
+	if (biod->bd_fetched > biod->bd_copied)
+		atomic_fetch_add_relaxed(&bio_zero_copy_bytes,
+					 biod->bd_fetched - biod->bd_copied);
+	biod->bd_fetched = 0;
+}
+
+void
+bio_copy_stats_get(struct bio_copy_stats *stats, bool reset)
+{
+	stats->bcs_fetched = atomic_load_relaxed(&bio_fetched_bytes);
+	stats->bcs_copied = atomic_load_relaxed(&bio_copied_bytes);
+	stats->bcs_zero_copy = atomic_load_relaxed(&bio_zero_copy_bytes);
+	stats->bcs_dma = atomic_load_relaxed(&bio_dma_bytes);
+	if (reset) {
+		atomic_fetch_sub_relaxed(&bio_fetched_bytes,
+					 stats->bcs_fetched);
+		atomic_fetch_sub_relaxed(&bio_copied_bytes, stats->bcs_copied);
+		atomic_fetch_sub_relaxed(&bio_zero_copy_bytes,
+					 stats->bcs_zero_copy);
+		atomic_fetch_sub_relaxed(&bio_dma_bytes, stats->bcs_dma);
+	}
+}
+
 static void
 dma_drop_iod(struct bio_dma_buffer *bdb)
 {
@@ -916,6 +1067,8 @@ retry:
 		goto retry;
 	}
 	biod->bd_buffer_prep = 1;
+	if (!biod->bd_update)
+		iod_account_fetch(biod);
 
 	/* All SCM IOVs, no DMA transfer prepared */
 	if (biod->bd_rsrvd.brd_rg_cnt == 0)
@@ -951,6 +1104,9 @@ bio_iod_post(struct bio_desc *biod)
 	if (!biod->bd_buffer_prep)
 		return -DER_INVAL;
 
+	if (!biod->bd_update)
+		iod_account_zero_copy(biod);
+
 	/* No more actions for SCM IOVs */
 	if (biod->bd_rsrvd.brd_rg_cnt == 0) {
 		iod_release_buffer(biod);
@@ -969,10 +1125,98 @@ bio_iod_post(struct bio_desc *biod)
 	return biod->bd_result;
 }
 
+/* Locate the reserved region holding @buf, from the first unwritten one */
+static int
+iod_buf2region(struct bio_desc *biod, void *buf, unsigned int *pg)
+{
+	struct bio_rsrvd_dma	*rsrvd_dma = &biod->bd_rsrvd;
+	struct bio_rsrvd_region	*rg;
+	char			*payload;
+	int			 i;
+
+	for (i = biod->bd_rg_posted; i < rsrvd_dma->brd_rg_cnt; i++) {
+		rg = &rsrvd_dma->brd_regions[i];
+		payload = rg->brr_chk->bdc_ptr +
+			(rg->brr_pg_idx << BIO_DMA_PAGE_SHIFT);
+
+		if ((char *)buf >= payload &&
+		    (char *)buf < payload +
+		    ((uint64_t)region_pg_cnt(rg) << BIO_DMA_PAGE_SHIFT)) {
+			*pg = ((char *)buf - payload) >> BIO_DMA_PAGE_SHIFT;
+			return i;
+		}
+	}
+	return -1;
+}
+
 int
-bio_iod_copy(struct bio_desc *biod, d_sg_list_t *sgls, unsigned int nr_sgl)
+bio_iod_post_partial(struct bio_desc *biod, unsigned int sgl_idx,
+		     unsigned int iov_idx, uint64_t iov_off)
+{
+	struct bio_rsrvd_dma	*rsrvd_dma = &biod->bd_rsrvd;
+	unsigned int		 rg_end = rsrvd_dma->brd_rg_cnt;
+	unsigned int		 pg_end = 0;
+	unsigned int		 i, j;
+	int			 rg_idx;
+
+	if (!biod->bd_buffer_prep || !biod->bd_update)
+		return -DER_INVAL;
+
+	/* Data before the first NVMe IOV not filled yet is in place */
+	for (i = sgl_idx; i < biod->bd_sgl_cnt; i++) {
+		struct bio_sglist *bsgl = &biod->bd_sgls[i];
+
+		for (j = i == sgl_idx ? iov_idx : 0; j < bsgl->bs_nr_out;
+		     j++) {
+			struct bio_iov	*biov = &bsgl->bs_iovs[j];
+			char		*buf;
+
+			if (bio_iov2req_len(biov) == 0 ||
+			    biov->bi_addr.ba_type != DAOS_MEDIA_NVME ||
+			    bio_addr_is_hole(&biov->bi_addr) ||
+			    biov->bi_addr.ba_compressed)
+				continue;
+
+			buf = bio_iov2req_buf(biov);
+			if (i == sgl_idx && j == iov_idx)
+				buf += iov_off;
+			rg_idx = iod_buf2region(biod, buf, &pg_end);
+			/* Not filled in IOV order, wait for bio_iod_post() */
+			if (rg_idx < 0)
+				return 0;
+			rg_end = rg_idx;
+			goto post;
+		}
+	}
+post:
+	if (rg_end < biod->bd_rg_posted ||
+	    (rg_end == biod->bd_rg_posted && pg_end <= biod->bd_pg_posted))
+		return 0;
+
+	if (!dma_rw_begin(biod))
+		return biod->bd_result;
+
+	for (i = biod->bd_rg_posted; i < rg_end; i++) {
+		struct bio_rsrvd_region *rg = &rsrvd_dma->brd_regions[i];
+
+		dma_rw_region(biod, rg, biod->bd_pg_posted, region_pg_cnt(rg));
+		biod->bd_pg_posted = 0;
+	}
+	if (pg_end > biod->bd_pg_posted)
+		dma_rw_region(biod, &rsrvd_dma->brd_regions[rg_end],
+			      biod->bd_pg_posted, pg_end);
+	biod->bd_rg_posted = rg_end;
+	biod->bd_pg_posted = pg_end;
+
+	return 0;
+}
+
+static int
+iod_copy(struct bio_desc *biod, d_sg_list_t *sgls, unsigned int nr_sgl,
+	 struct dcs_copy_verify *cvs)
 {
 	struct bio_copy_args arg = { 0 };
+	int rc;
 
 	if (!biod->bd_buffer_prep)
 		return -DER_INVAL;
@@ -982,8 +1226,31 @@ bio_iod_copy(struct bio_desc *biod, d_sg_list_t *sgls, unsigned int nr_sgl)
 
 	arg.ca_sgls = sgls;
 	arg.ca_sgl_cnt = nr_sgl;
+	arg.ca_cvs = cvs;
+
+	rc = iterate_biov(biod, copy_one, &arg);
+	if (!biod->bd_update && arg.ca_copied != 0) {
+		biod->bd_copied += arg.ca_copied;
+		atomic_fetch_add_relaxed(&bio_copied_bytes, arg.ca_copied);
+	}
+
+	return rc;
+}
+
+int
+bio_iod_copy(struct bio_desc *biod, d_sg_list_t *sgls, unsigned int nr_sgl)
+{
+	return iod_copy(biod, sgls, nr_sgl, NULL);
+}
+
+int
+bio_iod_copy_verify(struct bio_desc *biod, d_sg_list_t *sgls,
+		    unsigned int nr_sgl, struct dcs_copy_verify *cvs)
+{
+	if (!biod->bd_update)
+		return -DER_INVAL;
 
-	return iterate_biov(biod, copy_one, &arg);
+	return iod_copy(biod, sgls, nr_sgl, cvs);
 }
 
 static int
@@ -196,6 +196,15 @@ struct bio_desc {
 	/* Inflight SPDK DMA transfers */
 	unsigned int		 bd_inflights;
 	int			 bd_result;
+	/*
+	 * Write back started by bio_iod_post_partial(): regions before
+	 * bd_rg_posted and the first bd_pg_posted pages of it are written.
+	 */
+	unsigned int		 bd_rg_posted;
+	unsigned int		 bd_pg_posted;
+	/* Fetched bytes, and those copied by bio_iod_copy(), for accounting */
+	uint64_t		 bd_fetched;
+	uint64_t		 bd_copied;
 	/* Flags */
 	unsigned int		 bd_buffer_prep:1,
 				 bd_update:1,
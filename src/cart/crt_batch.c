@@ -0,0 +1,730 @@
+/*
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * This file is part of CaRT. It implements the RPC batching: the small RPCs
+ * sent to the same endpoint within CRT_BATCH_DELAY us are packed in one
+ * CRT_OPC_BATCH envelope, whose handler on the target runs them as if they
+ * were received one by one, and replies all of them at once.
+ *
+ * The batched RPCs are not tracked by the context once packed, the envelope
+ * is tracked in their place with the largest of their timeouts. A batch is
+ * sent once full, or past its deadline by crt_progress() or by the next RPC
+ * submitted to the context.
+ *
+ * On the target, a batched RPC has no HG handle of its own, it keeps a
+ * reference of its envelope, whose handle is used for its bulk transfers.
+ */
+#define D_LOGFAC	DD_FAC(rpc)
+
+#include "crt_internal.h"
+
+/* encoded size of a reply which only carries an error */
+#define CRT_BATCH_HDR_SIZE	(sizeof(struct crt_common_hdr))
+
+static inline bool
+crt_batch_eligible(struct crt_rpc_priv *rpc_priv)
+{
+	return crt_gdata.cg_batch_delay != 0 &&
+	       rpc_priv->crp_opc_info->coi_batch &&
+	       !rpc_priv->crp_coll &&
+	       !(rpc_priv->crp_flags & CRT_RPC_FLAG_COLL);
+}
+
+static struct crt_batch *
+crt_batch_alloc(struct crt_context *ctx, crt_endpoint_t *ep, uint32_t nr)
+{
+	struct crt_batch	*batch;
+
+	D_ALLOC(batch, sizeof(*batch) + nr * sizeof(batch->cb_ents[0]));
+	if (batch == NULL)
+		return NULL;
+
+	D_INIT_LIST_HEAD(&batch->cb_link);
+	batch->cb_ctx = ctx;
+	batch->cb_ep = *ep;
+
+	return batch;
+}
+
+static void
+crt_batch_free(struct crt_batch *batch)
+{
+	D_FREE(batch->cb_buf);
+	D_FREE(batch);
+}
+
+/* Take \a rpc_priv out of its envelope, return NULL if it was already */
+static struct crt_batch *
+crt_batch_claim(struct crt_rpc_priv *rpc_priv)
+{
+	struct crt_batch	*batch;
+
+	D_SPIN_LOCK(&rpc_priv->crp_lock);
+	batch = rpc_priv->crp_batch;
+	rpc_priv->crp_batch = NULL;
+	D_SPIN_UNLOCK(&rpc_priv->crp_lock);
+
+	return batch;
+}
+
+/* Append a message to the \a size bytes of packed messages of \a buf */
+static void
+crt_batch_msg_put(char *buf, size_t *size, void *msg, uint32_t len)
+{
+	memcpy(buf + *size, &len, sizeof(len));
+	memcpy(buf + *size + sizeof(len), msg, len);
+	*size += sizeof(len) + len;
+}
+
+/* Get the next message of the \a size bytes of packed messages of \a buf */
+static int
+crt_batch_msg_get(char **buf, size_t *size, void **msg, uint32_t *len)
+{
+	if (*size < sizeof(*len))
+		return -DER_PROTO;
+
+	memcpy(len, *buf, sizeof(*len));
+	if (*size - sizeof(*len) < *len)
+		return -DER_PROTO;
+
+	*msg = *buf + sizeof(*len);
+	*buf += sizeof(*len) + *len;
+	*size -= sizeof(*len) + *len;
+
+	return 0;
+}
+
+/*
+ * Run the input or the output proc of \a rpc_priv on \a buf. An encoding
+ * which does not fit in \a buf fails with -DER_OVERFLOW.
+ */
+static int
+crt_batch_proc(struct crt_rpc_priv *rpc_priv, bool input, hg_proc_op_t op,
+	       void *buf, size_t size, size_t *size_used)
+{
+	struct crt_context	*ctx = rpc_priv->crp_pub.cr_ctx;
+	hg_proc_t		 proc;
+	hg_return_t		 hg_ret;
+	int			 rc;
+
+	hg_ret = hg_proc_create_set(ctx->cc_hg_ctx.chc_hgcla, buf, size, op,
+				    HG_NOHASH, &proc);
+	if (hg_ret != HG_SUCCESS) {
+		RPC_ERROR(rpc_priv, "hg_proc_create_set failed, hg_ret: %d\n",
+			  hg_ret);
+		return crt_hgret_2_der(hg_ret);
+	}
+
+	if (input)
+		hg_ret = crt_proc_in_common(proc, &rpc_priv->crp_pub.cr_input);
+	else
+		hg_ret = crt_proc_out_common(proc,
+					     &rpc_priv->crp_pub.cr_output);
+	rc = crt_hgret_2_der(hg_ret);
+
+	/* mercury spills what does not fit in the buffer to an extra one */
+	if (rc == 0 && op == HG_ENCODE && hg_proc_get_extra_buf(proc) != NULL)
+		rc = -DER_OVERFLOW;
+	if (rc == 0 && size_used != NULL)
+		*size_used = hg_proc_get_size_used(proc);
+
+	hg_proc_free(proc);
+	return rc;
+}
+
+/* Complete the RPCs of a batch with the \a replies of the target */
+static void
+crt_batch_complete(struct crt_batch *batch, int rc, d_iov_t *replies)
+{
+	struct crt_rpc_priv	*rpc_priv;
+	char			*buf = NULL;
+	size_t			 size = 0;
+	void			*msg = NULL;
+	uint32_t		 len = 0;
+	uint32_t		 i;
+	int			 rpc_rc;
+
+	if (replies != NULL) {
+		buf = replies->iov_buf;
+		size = replies->iov_len;
+	}
+
+	for (i = 0; i < batch->cb_nr; i++) {
+		rpc_priv = batch->cb_ents[i].be_rpc;
+
+		rpc_rc = rc;
+		if (rpc_rc == 0)
+			rpc_rc = crt_batch_msg_get(&buf, &size, &msg, &len);
+
+		/* aborted while in the envelope */
+		if (crt_batch_claim(rpc_priv) == NULL)
+			goto next;
+
+		if (rpc_rc == 0 && !rpc_priv->crp_opc_info->coi_no_reply) {
+			/* freed by crt_batch_req_free() */
+			rpc_priv->crp_output_got = 1;
+			rpc_rc = crt_batch_proc(rpc_priv, false, HG_DECODE,
+						msg, len, NULL);
+			if (rpc_rc == 0)
+				rpc_rc = rpc_priv->crp_reply_hdr.cch_rc;
+			/* HLC is checked during unpacking of the response */
+			if (rpc_rc == 0 && rpc_priv->crp_fail_hlc)
+				rpc_rc = -DER_HLC_SYNC;
+		}
+
+		crt_rpc_complete(rpc_priv, rpc_rc);
+next:
+		/* addref in crt_batch_req_add */
+		RPC_DECREF(rpc_priv);
+	}
+
+	crt_batch_free(batch);
+}
+
+static void
+crt_batch_env_cb(const struct crt_cb_info *cb_info)
+{
+	struct crt_batch	*batch = cb_info->cci_arg;
+	struct crt_batch_out	*out;
+	int			 rc = cb_info->cci_rc;
+
+	if (rc != 0) {
+		D_ERROR("envelope of %u RPCs to rank %d tag %d failed, "
+			DF_RC"\n", batch->cb_nr, batch->cb_ep.ep_rank,
+			batch->cb_ep.ep_tag, DP_RC(rc));
+		crt_batch_complete(batch, rc, NULL);
+		return;
+	}
+
+	out = crt_reply_get(cb_info->cci_rpc);
+	crt_batch_complete(batch, out->bo_rc, &out->bo_replies);
+}
+
+/* Send the envelope of a closed batch */
+static void
+crt_batch_send(struct crt_batch *batch)
+{
+	struct crt_batch_in	*in;
+	crt_rpc_t		*env;
+	int			 rc;
+
+	rc = crt_req_create(batch->cb_ctx, &batch->cb_ep, CRT_OPC_BATCH, &env);
+	if (rc != 0) {
+		D_ERROR("crt_req_create failed, "DF_RC"\n", DP_RC(rc));
+		crt_batch_complete(batch, rc, NULL);
+		return;
+	}
+
+	in = crt_req_get(env);
+	in->bi_nr = batch->cb_nr;
+	d_iov_set(&in->bi_msgs, batch->cb_buf, batch->cb_size);
+	crt_req_set_timeout(env, batch->cb_timeout_sec);
+
+	/* failures are reported through crt_batch_env_cb */
+	crt_req_send(env, crt_batch_env_cb, batch);
+}
+
+/* caller should hold crt_context::cc_batch_mutex */
+static void
+crt_batch_close(struct crt_context *ctx, struct crt_batch *batch,
+		d_list_t *closed)
+{
+	d_list_move_tail(&batch->cb_link, closed);
+	atomic_fetch_sub_relaxed(&ctx->cc_batch_nr, 1);
+}
+
+/*
+ * Pack \a rpc_priv in the open batch to its endpoint, or in a new one.
+ *
+ * Return 0 if it was packed, 1 if it should be sent on its own, negative
+ * value if error.
+ */
+int
+crt_batch_req_add(struct crt_rpc_priv *rpc_priv)
+{
+	struct crt_context	*ctx = rpc_priv->crp_pub.cr_ctx;
+	crt_endpoint_t		*ep = &rpc_priv->crp_pub.cr_ep;
+	struct crt_batch	*batch;
+	struct crt_batch	*tmp;
+	d_list_t		 closed;
+	char			 msg[CRT_BATCH_MSG_MAX];
+	size_t			 len;
+	uint64_t		 now;
+	int			 rc;
+
+	if (!crt_batch_eligible(rpc_priv))
+		return 1;
+
+	rc = crt_batch_proc(rpc_priv, true, HG_ENCODE, msg, sizeof(msg), &len);
+	if (rc != 0) {
+		/* too large, or the regular path reports the error */
+		RPC_TRACE(DB_NET, rpc_priv, "not batched, "DF_RC"\n",
+			  DP_RC(rc));
+		return 1;
+	}
+
+	/* decref in crt_batch_complete */
+	RPC_ADDREF(rpc_priv);
+
+	/* the envelope is tracked in place of the RPCs it carries */
+	crt_context_req_untrack(rpc_priv);
+
+	D_INIT_LIST_HEAD(&closed);
+	D_MUTEX_LOCK(&ctx->cc_batch_mutex);
+
+	/* few batches are open at once, they are sent within the delay */
+	batch = NULL;
+	d_list_for_each_entry(tmp, &ctx->cc_batch_list, cb_link) {
+		if (tmp->cb_ep.ep_grp == ep->ep_grp &&
+		    tmp->cb_ep.ep_rank == ep->ep_rank &&
+		    tmp->cb_ep.ep_tag == ep->ep_tag) {
+			batch = tmp;
+			break;
+		}
+	}
+
+	if (batch != NULL &&
+	    batch->cb_size + sizeof(uint32_t) + len > CRT_BATCH_SIZE_MAX) {
+		crt_batch_close(ctx, batch, &closed);
+		batch = NULL;
+	}
+
+	if (batch == NULL) {
+		batch = crt_batch_alloc(ctx, ep, CRT_BATCH_NR_MAX);
+		if (batch == NULL)
+			D_GOTO(out_unlock, rc = -DER_NOMEM);
+
+		D_ALLOC(batch->cb_buf, CRT_BATCH_SIZE_MAX);
+		if (batch->cb_buf == NULL) {
+			D_FREE(batch);
+			D_GOTO(out_unlock, rc = -DER_NOMEM);
+		}
+
+		batch->cb_deadline = d_timeus_secdiff(0) +
+				     crt_gdata.cg_batch_delay;
+		d_list_add_tail(&batch->cb_link, &ctx->cc_batch_list);
+		atomic_fetch_add_relaxed(&ctx->cc_batch_nr, 1);
+	}
+
+	crt_batch_msg_put(batch->cb_buf, &batch->cb_size, msg, len);
+	batch->cb_ents[batch->cb_nr].be_rpc = rpc_priv;
+	if (batch->cb_timeout_sec < rpc_priv->crp_timeout_sec)
+		batch->cb_timeout_sec = rpc_priv->crp_timeout_sec;
+
+	D_SPIN_LOCK(&rpc_priv->crp_lock);
+	rpc_priv->crp_batch = batch;
+	rpc_priv->crp_batch_idx = batch->cb_nr;
+	D_SPIN_UNLOCK(&rpc_priv->crp_lock);
+	rpc_priv->crp_batched = 1;
+	rpc_priv->crp_state = RPC_STATE_REQ_SENT;
+	rpc_priv->crp_on_wire = 1;
+
+	RPC_TRACE(DB_NET, rpc_priv, "packed in batch %p (%u RPCs).\n", batch,
+		  batch->cb_nr + 1);
+
+	if (++batch->cb_nr == CRT_BATCH_NR_MAX)
+		crt_batch_close(ctx, batch, &closed);
+
+	/*
+	 * do not wait for the progress to send the batches which are due,
+	 * this one included, they are sorted by deadline
+	 */
+	now = d_timeus_secdiff(0);
+	d_list_for_each_entry_safe(batch, tmp, &ctx->cc_batch_list, cb_link) {
+		if (batch->cb_deadline > now)
+			break;
+		crt_batch_close(ctx, batch, &closed);
+	}
+
+out_unlock:
+	D_MUTEX_UNLOCK(&ctx->cc_batch_mutex);
+
+	while ((batch = d_list_pop_entry(&closed, struct crt_batch, cb_link)))
+		crt_batch_send(batch);
+
+	if (rc != 0) {
+		RPC_ERROR(rpc_priv, "batching failed, "DF_RC"\n", DP_RC(rc));
+		/* addref above */
+		RPC_DECREF(rpc_priv);
+	}
+
+	return rc;
+}
+
+/* Abort a batched RPC, its reply is dropped when the envelope completes */
+int
+crt_batch_req_abort(struct crt_rpc_priv *rpc_priv)
+{
+	if (crt_batch_claim(rpc_priv) == NULL) {
+		RPC_TRACE(DB_NET, rpc_priv, "already completed.\n");
+		return -DER_ALREADY;
+	}
+
+	RPC_TRACE(DB_NET, rpc_priv, "aborted in its envelope.\n");
+	crt_rpc_complete(rpc_priv, -DER_CANCELED);
+
+	return 0;
+}
+
+/*
+ * Send the open batches which are due, or all of them.
+ *
+ * Return the time to the next deadline in us, or -1 if no batch is open.
+ */
+int64_t
+crt_batch_flush(struct crt_context *ctx, bool all)
+{
+	struct crt_batch	*batch;
+	struct crt_batch	*tmp;
+	d_list_t		 closed;
+	uint64_t		 now;
+	int64_t			 next = -1;
+
+	if (atomic_load_relaxed(&ctx->cc_batch_nr) == 0)
+		return -1;
+
+	D_INIT_LIST_HEAD(&closed);
+	now = d_timeus_secdiff(0);
+
+	D_MUTEX_LOCK(&ctx->cc_batch_mutex);
+	/* all the batches have the same delay, so they are sorted */
+	d_list_for_each_entry_safe(batch, tmp, &ctx->cc_batch_list, cb_link) {
+		if (!all && batch->cb_deadline > now) {
+			next = batch->cb_deadline - now;
+			break;
+		}
+		crt_batch_close(ctx, batch, &closed);
+	}
+	D_MUTEX_UNLOCK(&ctx->cc_batch_mutex);
+
+	while ((batch = d_list_pop_entry(&closed, struct crt_batch, cb_link)))
+		crt_batch_send(batch);
+
+	return next;
+}
+
+/* Drop a reference of the replies to wait for, reply when it was the last */
+static void
+crt_batch_reply_put(struct crt_batch *batch)
+{
+	struct crt_rpc_priv	*env = batch->cb_env;
+	struct crt_batch_out	*out;
+	d_iov_t			*reply;
+	char			*buf;
+	size_t			 size = 0;
+	uint32_t		 i;
+	int			 rc;
+
+	if (atomic_fetch_sub(&batch->cb_pending, 1) != 1)
+		return;
+
+	out = crt_reply_get(&env->crp_pub);
+	for (i = 0; i < batch->cb_nr; i++)
+		size += sizeof(uint32_t) + batch->cb_ents[i].be_reply.iov_len;
+
+	D_ALLOC(buf, size);
+	if (buf == NULL) {
+		out->bo_rc = -DER_NOMEM;
+	} else {
+		size = 0;
+		for (i = 0; i < batch->cb_nr; i++) {
+			reply = &batch->cb_ents[i].be_reply;
+			crt_batch_msg_put(buf, &size, reply->iov_buf,
+					  reply->iov_len);
+		}
+		d_iov_set(&out->bo_replies, buf, size);
+	}
+
+	/* the output is encoded before crt_reply_send() returns */
+	rc = crt_reply_send(&env->crp_pub);
+	if (rc != 0)
+		RPC_ERROR(env, "crt_reply_send failed, "DF_RC"\n", DP_RC(rc));
+
+	d_iov_set(&out->bo_replies, NULL, 0);
+	D_FREE(buf);
+	for (i = 0; i < batch->cb_nr; i++)
+		D_FREE(batch->cb_ents[i].be_reply.iov_buf);
+
+	/* addref in crt_hdlr_batch */
+	RPC_DECREF(env);
+	crt_batch_free(batch);
+}
+
+/* Encode the reply of \a rpc_priv in the slot \a idx of its envelope */
+static void
+crt_batch_reply_store(struct crt_batch *batch, uint32_t idx,
+		      struct crt_rpc_priv *rpc_priv)
+{
+	d_iov_t		*reply = &batch->cb_ents[idx].be_reply;
+	char		 msg[CRT_BATCH_MSG_MAX];
+	size_t		 len = 0;
+	uint32_t	 body;
+	uint32_t	 room;
+	int		 rc;
+
+	/* every reply has room for its header, the bodies share the rest */
+	room = CRT_BATCH_SIZE_MAX -
+	       batch->cb_nr * (sizeof(uint32_t) + CRT_BATCH_HDR_SIZE);
+
+	rc = crt_batch_proc(rpc_priv, false, HG_ENCODE, msg, sizeof(msg),
+			    &len);
+	if (rc == 0 && len > CRT_BATCH_HDR_SIZE) {
+		body = len - CRT_BATCH_HDR_SIZE;
+		if (atomic_fetch_add(&batch->cb_reply_size, body) + body >
+		    room) {
+			atomic_fetch_sub(&batch->cb_reply_size, body);
+			rc = -DER_OVERFLOW;
+		}
+	}
+
+	if (rc != 0) {
+		RPC_ERROR(rpc_priv, "reply does not fit in the envelope, "
+			  DF_RC"\n", DP_RC(rc));
+		/* a failed reply only carries its header */
+		rpc_priv->crp_reply_hdr.cch_rc = rc;
+		rc = crt_batch_proc(rpc_priv, false, HG_ENCODE, msg,
+				    sizeof(msg), &len);
+		if (rc != 0)
+			len = 0;
+	}
+
+	if (len > 0) {
+		D_ALLOC(reply->iov_buf, len);
+		if (reply->iov_buf != NULL)
+			memcpy(reply->iov_buf, msg, len);
+		else
+			len = 0;
+	}
+	reply->iov_buf_len = len;
+	reply->iov_len = len;
+
+	crt_batch_reply_put(batch);
+}
+
+/* Reply a batched RPC on the target */
+int
+crt_batch_reply_send(struct crt_rpc_priv *rpc_priv)
+{
+	struct crt_batch	*batch;
+
+	batch = crt_batch_claim(rpc_priv);
+	if (batch == NULL) {
+		RPC_ERROR(rpc_priv, "already replied.\n");
+		return -DER_ALREADY;
+	}
+
+	crt_batch_reply_store(batch, rpc_priv->crp_batch_idx, rpc_priv);
+	return 0;
+}
+
+/* Release the input or output of a batched RPC, and its envelope */
+void
+crt_batch_req_free(struct crt_rpc_priv *rpc_priv)
+{
+	int	rc;
+
+	if (rpc_priv->crp_output_got) {
+		rc = crt_batch_proc(rpc_priv, false, HG_FREE, NULL, 0, NULL);
+		if (rc != 0)
+			RPC_ERROR(rpc_priv, "output free failed, "DF_RC"\n",
+				  DP_RC(rc));
+		rpc_priv->crp_output_got = 0;
+	}
+
+	if (rpc_priv->crp_input_got) {
+		rc = crt_batch_proc(rpc_priv, true, HG_FREE, NULL, 0, NULL);
+		if (rc != 0)
+			RPC_ERROR(rpc_priv, "input free failed, "DF_RC"\n",
+				  DP_RC(rc));
+		rpc_priv->crp_input_got = 0;
+	}
+
+	if (rpc_priv->crp_batch_env != NULL) {
+		/* addref in crt_batch_dispatch */
+		RPC_DECREF(rpc_priv->crp_batch_env);
+		rpc_priv->crp_batch_env = NULL;
+	}
+}
+
+/* Unpack and run the RPC \a idx of an envelope, as crt_rpc_handler_common */
+static void
+crt_batch_dispatch(struct crt_batch *batch, uint32_t idx, void *msg,
+		   uint32_t len)
+{
+	struct crt_rpc_priv	*env = batch->cb_env;
+	struct crt_context	*ctx = env->crp_pub.cr_ctx;
+	struct crt_rpc_priv	 rpc_tmp = {0};
+	struct crt_rpc_priv	*rpc_priv;
+	struct crt_opc_info	*opc_info;
+	crt_rpc_t		*rpc_pub;
+	crt_opcode_t		 opc;
+	crt_proc_t		 proc = NULL;
+	int			 rc;
+
+	rpc_tmp.crp_hg_addr = env->crp_hg_addr;
+	rpc_tmp.crp_pub.cr_ctx = ctx;
+
+	rc = crt_hg_unpack_header_buf(&rpc_tmp, msg, len, HG_NOHASH, &proc);
+	if (rc != 0) {
+		D_ERROR("crt_hg_unpack_header_buf failed, "DF_RC"\n",
+			DP_RC(rc));
+		D_GOTO(out_tmp, rc = -DER_MISC);
+	}
+	opc = rpc_tmp.crp_req_hdr.cch_opc;
+	rpc_tmp.crp_pub.cr_opc = opc;
+
+	opc_info = crt_opc_lookup(crt_gdata.cg_opc_map, opc, CRT_UNLOCK);
+	if (opc_info == NULL) {
+		D_ERROR("opc: %#x, lookup failed.\n", opc);
+		D_GOTO(out_tmp, rc = -DER_UNREG);
+	}
+	if (!opc_info->coi_batch || (rpc_tmp.crp_flags & CRT_RPC_FLAG_COLL)) {
+		D_ERROR("opc: %#x, can not be batched.\n", opc);
+		D_GOTO(out_tmp, rc = -DER_PROTO);
+	}
+
+	D_ALLOC(rpc_priv, opc_info->coi_rpc_size);
+	if (rpc_priv == NULL)
+		D_GOTO(out_tmp, rc = -DER_DOS);
+
+	crt_hg_header_copy(&rpc_tmp, rpc_priv);
+	rpc_pub = &rpc_priv->crp_pub;
+	rpc_priv->crp_opc_info = opc_info;
+	rpc_priv->crp_fail_hlc = rpc_tmp.crp_fail_hlc;
+	rpc_pub->cr_opc = opc;
+	rpc_pub->cr_ep.ep_rank = rpc_priv->crp_req_hdr.cch_dst_rank;
+	rpc_pub->cr_ep.ep_tag = rpc_priv->crp_req_hdr.cch_dst_tag;
+
+	rc = crt_rpc_priv_init(rpc_priv, ctx, true /* srv_flag */);
+	if (rc != 0) {
+		D_ERROR("crt_rpc_priv_init rc=%d, opc=%#x\n", rc, opc);
+		D_FREE(rpc_priv);
+		D_GOTO(out_tmp, rc = -DER_MISC);
+	}
+	rpc_priv->crp_batched = 1;
+	rpc_priv->crp_batch = batch;
+	rpc_priv->crp_batch_idx = idx;
+	/* decref in crt_batch_req_free */
+	RPC_ADDREF(env);
+	rpc_priv->crp_batch_env = env;
+
+	RPC_TRACE(DB_TRACE, rpc_priv, "unpacked from envelope %p.\n", env);
+
+	if (rpc_pub->cr_input_size > 0) {
+		/* freed by crt_batch_req_free() */
+		rc = crt_hg_unpack_body(rpc_priv, proc);
+		if (rc != 0) {
+			D_ERROR("_unpack_body failed, rc: %d, opc: %#x.\n",
+				rc, opc);
+			crt_hg_reply_error_send(rpc_priv, -DER_MISC);
+			D_GOTO(decref, rc);
+		}
+		rpc_priv->crp_input_got = 1;
+		rpc_pub->cr_ep.ep_grp = NULL;
+	} else {
+		crt_hg_unpack_cleanup(proc);
+	}
+
+	if (opc_info->coi_rpc_cb == NULL) {
+		D_ERROR("NULL rpc_cb, opc: %#x.\n", opc);
+		crt_hg_reply_error_send(rpc_priv, -DER_UNREG);
+		D_GOTO(decref, rc = -DER_UNREG);
+	}
+
+	if (rpc_priv->crp_fail_hlc) {
+		crt_hg_reply_error_send(rpc_priv, -DER_HLC_SYNC);
+		D_GOTO(decref, rc = -DER_HLC_SYNC);
+	}
+
+	/* one-way RPCs leave their slot empty */
+	if (opc_info->coi_no_reply) {
+		crt_batch_claim(rpc_priv);
+		crt_batch_reply_put(batch);
+	}
+
+	rc = crt_rpc_common_hdlr(rpc_priv);
+	if (rc != 0) {
+		RPC_ERROR(rpc_priv,
+			  "failed to invoke RPC handler, rc: %d, opc: %#x\n",
+			  rc, opc);
+		crt_hg_reply_error_send(rpc_priv, rc);
+	}
+
+decref:
+	/* the customized callback releases it, see crt_handle_rpc() */
+	if (rc != 0 || !crt_rpc_cb_customized(ctx, rpc_pub))
+		RPC_DECREF(rpc_priv);
+	return;
+
+out_tmp:
+	if (proc != NULL)
+		crt_hg_unpack_cleanup(proc);
+	rpc_tmp.crp_reply_hdr.cch_rc = rc;
+	crt_batch_reply_store(batch, idx, &rpc_tmp);
+}
+
+/* Handler of the envelopes */
+void
+crt_hdlr_batch(crt_rpc_t *rpc_req)
+{
+	struct crt_rpc_priv	*env;
+	struct crt_batch_in	*in = crt_req_get(rpc_req);
+	struct crt_batch_out	*out = crt_reply_get(rpc_req);
+	struct crt_batch	*batch;
+	struct crt_rpc_priv	 rpc_tmp = {0};
+	char			*buf;
+	size_t			 size;
+	void			*msg;
+	uint32_t		 len;
+	uint32_t		 i;
+	int			 rc;
+
+	env = container_of(rpc_req, struct crt_rpc_priv, crp_pub);
+
+	if (in->bi_nr == 0 || in->bi_nr > CRT_BATCH_NR_MAX) {
+		RPC_ERROR(env, "bad envelope of %u RPCs.\n", in->bi_nr);
+		D_GOTO(out, rc = -DER_PROTO);
+	}
+
+	batch = crt_batch_alloc(rpc_req->cr_ctx, &rpc_req->cr_ep, in->bi_nr);
+	if (batch == NULL)
+		D_GOTO(out, rc = -DER_NOMEM);
+
+	/* decref in crt_batch_reply_put */
+	RPC_ADDREF(env);
+	batch->cb_env = env;
+	batch->cb_nr = in->bi_nr;
+	/* one more reference while dispatching, not to reply early */
+	atomic_store_relaxed(&batch->cb_pending, batch->cb_nr + 1);
+
+	atomic_fetch_add_relaxed(&crt_gdata.cg_batch_env_cnt, 1);
+	atomic_fetch_add_relaxed(&crt_gdata.cg_batch_rpc_cnt, batch->cb_nr);
+
+	buf = in->bi_msgs.iov_buf;
+	size = in->bi_msgs.iov_len;
+	for (i = 0; i < batch->cb_nr; i++) {
+		rc = crt_batch_msg_get(&buf, &size, &msg, &len);
+		if (rc == 0) {
+			crt_batch_dispatch(batch, i, msg, len);
+			continue;
+		}
+
+		RPC_ERROR(env, "truncated envelope, RPC %u of %u.\n", i,
+			  batch->cb_nr);
+		rpc_tmp.crp_pub.cr_ctx = rpc_req->cr_ctx;
+		rpc_tmp.crp_reply_hdr.cch_rc = rc;
+		crt_batch_reply_store(batch, i, &rpc_tmp);
+	}
+
+	crt_batch_reply_put(batch);
+	return;
+
+out:
+	out->bo_rc = rc;
+	rc = crt_reply_send(rpc_req);
+	if (rc != 0)
+		RPC_ERROR(env, "crt_reply_send failed, "DF_RC"\n", DP_RC(rc));
+}
@@ -11,6 +11,8 @@
 #include "crt_internal.h"
 
 static void crt_epi_destroy(struct crt_ep_inflight *epi);
+static void crt_context_submit_drain(struct crt_context *ctx, bool all);
+static void crt_context_progress_stop(struct crt_context *ctx);
 
 static struct crt_ep_inflight *
 epi_link2ptr(d_list_t *rlink)
@@ -120,6 +122,10 @@ crt_context_ep_empty(crt_context_t crt_ctx)
 	int			 rc;
 
 	ctx = crt_ctx;
+	if (atomic_load_seq_cst(&ctx->cc_submit_head) != NULL ||
+	    atomic_load_seq_cst(&ctx->cc_submit_pend) != NULL)
+		return false;
+
 	D_MUTEX_LOCK(&ctx->cc_mutex);
 	rc = d_hash_table_traverse(&ctx->cc_epi_table, crt_ep_empty, NULL);
 	D_MUTEX_UNLOCK(&ctx->cc_mutex);
@@ -131,7 +137,6 @@ static int
 crt_context_init(crt_context_t crt_ctx)
 {
 	struct crt_context	*ctx;
-	uint32_t		 bh_node_cnt;
 	int			 rc;
 
 	D_ASSERT(crt_ctx != NULL);
@@ -141,16 +146,19 @@ crt_context_init(crt_context_t crt_ctx)
 	if (rc != 0)
 		D_GOTO(out, rc);
 
+	rc = D_MUTEX_INIT(&ctx->cc_batch_mutex, NULL);
+	if (rc != 0)
+		D_GOTO(out_mutex_destroy, rc);
+
 	D_INIT_LIST_HEAD(&ctx->cc_link);
+	D_INIT_LIST_HEAD(&ctx->cc_batch_list);
 
-	/* create timeout binheap */
-	bh_node_cnt = CRT_DEFAULT_CREDITS_PER_EP_CTX * 64;
-	rc = d_binheap_create_inplace(DBH_FT_NOLOCK, bh_node_cnt,
-				      NULL /* priv */, &crt_timeout_bh_ops,
-				      &ctx->cc_bh_timeout);
+	/* create timeout wheel, timestamps are in us, tick is 1ms */
+	rc = d_twheel_init(&ctx->cc_timeout_wheel, CRT_TIMEOUT_TICK_US,
+			   d_timeus_secdiff(0));
 	if (rc != 0) {
-		D_ERROR("d_binheap_create() failed, " DF_RC "\n", DP_RC(rc));
-		D_GOTO(out_mutex_destroy, rc);
+		D_ERROR("d_twheel_init() failed, " DF_RC "\n", DP_RC(rc));
+		D_GOTO(out_batch_mutex_destroy, rc);
 	}
 
 	/* create epi table, use external lock */
@@ -159,12 +167,14 @@ crt_context_init(crt_context_t crt_ctx)
 					  &ctx->cc_epi_table);
 	if (rc != 0) {
 		D_ERROR("d_hash_table_create() failed, " DF_RC "\n", DP_RC(rc));
-		D_GOTO(out_binheap_destroy, rc);
+		D_GOTO(out_twheel_fini, rc);
 	}
 	D_GOTO(out, rc);
 
-out_binheap_destroy:
-	d_binheap_destroy_inplace(&ctx->cc_bh_timeout);
+out_twheel_fini:
+	d_twheel_fini(&ctx->cc_timeout_wheel);
+out_batch_mutex_destroy:
+	D_MUTEX_DESTROY(&ctx->cc_batch_mutex);
 out_mutex_destroy:
 	D_MUTEX_DESTROY(&ctx->cc_mutex);
 out:
@@ -420,8 +430,10 @@ int
 crt_context_destroy(crt_context_t crt_ctx, int force)
 {
 	struct crt_context	*ctx;
+	uint32_t		 prog_nr;
 	int			 flags;
 	int			 rc = 0;
+	int			 rc2;
 	int			 i;
 
 	if (crt_ctx == CRT_CONTEXT_NULL) {
@@ -434,13 +446,21 @@ crt_context_destroy(crt_context_t crt_ctx, int force)
 	}
 
 	ctx = crt_ctx;
+	/* restarted if the context cannot be destroyed yet */
+	prog_nr = ctx->cc_prog_nr;
+	crt_context_progress_stop(ctx);
+
 	rc = crt_grp_ctx_invalid(ctx, false /* locked */);
 	if (rc) {
 		D_ERROR("crt_grp_ctx_invalid failed, rc: %d.\n", rc);
 		if (!force)
-			D_GOTO(out, rc);
+			D_GOTO(err_prog, rc);
 	}
 
+	/* queued RPCs are tracked first, so that they can be aborted */
+	crt_context_submit_drain(ctx, true /* all */);
+	crt_batch_flush(ctx, true /* all */);
+
 	flags = force ? (CRT_EPI_ABORT_FORCE | CRT_EPI_ABORT_WAIT) : 0;
 	D_MUTEX_LOCK(&ctx->cc_mutex);
 	for (i = 0; i < CRT_SWIM_FLUSH_ATTEMPTS; i++) {
@@ -473,7 +493,7 @@ crt_context_destroy(crt_context_t crt_ctx, int force)
 			D_GOTO(err_unlock, rc);
 	}
 
-	d_binheap_destroy_inplace(&ctx->cc_bh_timeout);
+	d_twheel_fini(&ctx->cc_timeout_wheel);
 
 	D_MUTEX_UNLOCK(&ctx->cc_mutex);
 
@@ -488,6 +508,7 @@ crt_context_destroy(crt_context_t crt_ctx, int force)
 	d_list_del(&ctx->cc_link);
 	D_RWLOCK_UNLOCK(&crt_gdata.cg_rwlock);
 
+	D_MUTEX_DESTROY(&ctx->cc_batch_mutex);
 	D_MUTEX_DESTROY(&ctx->cc_mutex);
 	D_DEBUG(DB_TRACE, "destroyed context (idx %d, force %d)\n",
 		ctx->cc_idx, force);
@@ -498,6 +519,14 @@ out:
 
 err_unlock:
 	D_MUTEX_UNLOCK(&ctx->cc_mutex);
+err_prog:
+	if (prog_nr > 0) {
+		rc2 = crt_context_set_progress_threads(ctx, prog_nr);
+		if (rc2)
+			D_ERROR("context (idx %d) failed to restart %u "
+				"progress threads, "DF_RC"\n", ctx->cc_idx,
+				prog_nr, DP_RC(rc2));
+	}
 	return rc;
 }
 
@@ -572,28 +601,20 @@ int
 crt_req_timeout_track(struct crt_rpc_priv *rpc_priv)
 {
 	struct crt_context *crt_ctx = rpc_priv->crp_pub.cr_ctx;
-	int rc;
 
 	D_ASSERT(crt_ctx != NULL);
 
-	if (rpc_priv->crp_in_binheap == 1)
-		D_GOTO(out, rc = 0);
+	if (rpc_priv->crp_in_twheel == 1)
+		return 0;
 
-	/* add to binheap for timeout tracking */
+	/* add to timing wheel for timeout tracking */
 	RPC_ADDREF(rpc_priv); /* decref in crt_req_timeout_untrack */
-	rc = d_binheap_insert(&crt_ctx->cc_bh_timeout,
-			      &rpc_priv->crp_timeout_bp_node);
-	if (rc == 0) {
-		rpc_priv->crp_in_binheap = 1;
-	} else {
-		RPC_ERROR(rpc_priv,
-			  "d_binheap_insert failed, rc: %d\n",
-			  rc);
-		RPC_DECREF(rpc_priv);
-	}
+	d_twheel_insert(&crt_ctx->cc_timeout_wheel,
+			&rpc_priv->crp_timeout_node, rpc_priv->crp_timeout_ts);
+	rpc_priv->crp_in_twheel = 1;
+	RPC_TRACE(DB_NET, rpc_priv, "entering the timeout wheel.\n");
 
-out:
-	return rc;
+	return 0;
 }
 
 /* caller should already hold crt_ctx->cc_mutex */
@@ -604,11 +625,12 @@ crt_req_timeout_untrack(struct crt_rpc_priv *rpc_priv)
 
 	D_ASSERT(crt_ctx != NULL);
 
-	/* remove from timeout binheap */
-	if (rpc_priv->crp_in_binheap == 1) {
-		rpc_priv->crp_in_binheap = 0;
-		d_binheap_remove(&crt_ctx->cc_bh_timeout,
-				 &rpc_priv->crp_timeout_bp_node);
+	/* remove from timeout wheel */
+	if (rpc_priv->crp_in_twheel == 1) {
+		rpc_priv->crp_in_twheel = 0;
+		d_twheel_remove(&crt_ctx->cc_timeout_wheel,
+				&rpc_priv->crp_timeout_node);
+		RPC_TRACE(DB_NET, rpc_priv, "exiting the timeout wheel.\n");
 		RPC_DECREF(rpc_priv); /* addref in crt_req_timeout_track */
 	}
 }
@@ -765,31 +787,38 @@ static void
 crt_context_timeout_check(struct crt_context *crt_ctx)
 {
 	struct crt_rpc_priv		*rpc_priv;
-	struct d_binheap_node		*bh_node;
+	struct d_twheel_node		*node;
+	struct d_twheel_node		*tmp;
+	d_list_t			 expired_list;
 	d_list_t			 timeout_list;
 	uint64_t			 ts_now;
 
 	D_ASSERT(crt_ctx != NULL);
 
+	D_INIT_LIST_HEAD(&expired_list);
 	D_INIT_LIST_HEAD(&timeout_list);
 	ts_now = d_timeus_secdiff(0);
 
 	D_MUTEX_LOCK(&crt_ctx->cc_mutex);
-	while (1) {
-		bh_node = d_binheap_root(&crt_ctx->cc_bh_timeout);
-		if (bh_node == NULL)
-			break;
-		rpc_priv = container_of(bh_node, struct crt_rpc_priv,
-					crp_timeout_bp_node);
-		if (rpc_priv->crp_timeout_ts > ts_now)
-			break;
+	if (d_twheel_expire(&crt_ctx->cc_timeout_wheel, ts_now,
+			    &expired_list) == 0) {
+		D_MUTEX_UNLOCK(&crt_ctx->cc_mutex);
+		return;
+	}
 
-		/* +1 to prevent it from being released in timeout_untrack */
-		RPC_ADDREF(rpc_priv);
-		crt_req_timeout_untrack(rpc_priv);
+	/*
+	 * The expired RPCs are out of the wheel already, keep the reference
+	 * of crt_req_timeout_track until they are handled.
+	 */
+	d_list_for_each_entry_safe(node, tmp, &expired_list, tn_link) {
+		d_list_del_init(&node->tn_link);
+		rpc_priv = container_of(node, struct crt_rpc_priv,
+					crp_timeout_node);
+		rpc_priv->crp_in_twheel = 0;
+		RPC_TRACE(DB_NET, rpc_priv, "exiting the timeout wheel.\n");
 
 		d_list_add_tail(&rpc_priv->crp_tmp_link, &timeout_list);
-	};
+	}
 	D_MUTEX_UNLOCK(&crt_ctx->cc_mutex);
 
 	/* handle the timeout RPCs */
@@ -937,6 +966,141 @@ out_unlock:
 	return rc;
 }
 
+/* max RPCs sent by a submitting thread, crt_progress() sends the others */
+#define CRT_SUBMIT_DRAIN_MAX	(64)
+
+/*
+ * Track and send up to \a max RPCs of crt_context::cc_submit_pend, refilled
+ * from cc_submit_head when empty, called with cc_submit_busy set. Returns the
+ * number of RPCs sent.
+ */
+static int
+crt_context_submit_batch(struct crt_context *ctx, int max)
+{
+	struct crt_rpc_priv	*rpc_priv;
+	struct crt_rpc_priv	*list;
+	struct crt_rpc_priv	*next;
+	bool			 canceled;
+	int			 nr = 0;
+	int			 rc;
+
+	rpc_priv = atomic_load_seq_cst(&ctx->cc_submit_pend);
+	if (rpc_priv == NULL) {
+		/* the stack is LIFO, reverse it to send in submission order */
+		list = atomic_exchange_seq_cst(&ctx->cc_submit_head, NULL);
+		while (list != NULL) {
+			next = list->crp_submit_next;
+			list->crp_submit_next = rpc_priv;
+			rpc_priv = list;
+			list = next;
+		}
+	}
+
+	while (rpc_priv != NULL && nr < max) {
+		next = rpc_priv->crp_submit_next;
+		rpc_priv->crp_submit_next = NULL;
+
+		/*
+		 * Claim it for sending, unless crt_req_abort() canceled it
+		 * while queued, see crt_context_req_submit_cancel().
+		 */
+		D_SPIN_LOCK(&rpc_priv->crp_lock);
+		canceled = rpc_priv->crp_state != RPC_STATE_SUBMIT_QUEUED;
+		if (!canceled)
+			rpc_priv->crp_state = RPC_STATE_INITED;
+		D_SPIN_UNLOCK(&rpc_priv->crp_lock);
+
+		if (canceled) {
+			RPC_TRACE(DB_NET, rpc_priv, "canceled while queued.\n");
+		} else {
+			rc = crt_req_submit(rpc_priv);
+			if (rc != 0)
+				crt_rpc_complete(rpc_priv, rc);
+		}
+		/* addref in crt_context_req_submit */
+		RPC_DECREF(rpc_priv);
+		rpc_priv = next;
+		nr++;
+	}
+	atomic_store_release(&ctx->cc_submit_pend, rpc_priv);
+
+	return nr;
+}
+
+/*
+ * Track and send the RPCs queued on the context, unless another thread is
+ * already doing it, in which case that thread will also pick up whatever it
+ * finds queued once it is done. A submitting thread sends at most
+ * CRT_SUBMIT_DRAIN_MAX RPCs, so that it does not end up sending for all the
+ * others, and leaves the rest to the progress, which sends \a all of them.
+ */
+static void
+crt_context_submit_drain(struct crt_context *ctx, bool all)
+{
+	int	max = all ? INT_MAX : CRT_SUBMIT_DRAIN_MAX;
+	int	nr;
+
+	while (atomic_load_seq_cst(&ctx->cc_submit_head) != NULL ||
+	       atomic_load_seq_cst(&ctx->cc_submit_pend) != NULL) {
+		if (atomic_exchange_seq_cst(&ctx->cc_submit_busy, 1) != 0)
+			return;
+
+		while (max > 0 && (nr = crt_context_submit_batch(ctx, max)) > 0)
+			max -= nr;
+
+		atomic_exchange_seq_cst(&ctx->cc_submit_busy, 0);
+		if (max == 0)
+			return;
+	}
+}
+
+/*
+ * Submit an RPC without taking any lock of the context: push it on the
+ * lock-free submission stack, the thread pushing on an empty stack then
+ * drains it. With many threads sending on one context, one of them (or the
+ * progress thread) tracks and sends the RPCs in batches while the others
+ * return immediately, instead of all of them queueing on cc_mutex.
+ */
+void
+crt_context_req_submit(struct crt_rpc_priv *rpc_priv)
+{
+	struct crt_context	*ctx = rpc_priv->crp_pub.cr_ctx;
+	struct crt_rpc_priv	*head;
+
+	D_ASSERT(ctx != NULL);
+
+	RPC_ADDREF(rpc_priv); /* decref in crt_context_submit_batch */
+	/* not visible to the other threads until pushed */
+	rpc_priv->crp_state = RPC_STATE_SUBMIT_QUEUED;
+	do {
+		head = atomic_load_relaxed(&ctx->cc_submit_head);
+		rpc_priv->crp_submit_next = head;
+	} while (!atomic_compare_exchange_seq_cst(&ctx->cc_submit_head, head,
+						  rpc_priv));
+
+	if (head == NULL)
+		crt_context_submit_drain(ctx, false /* all */);
+}
+
+/*
+ * Cancel \a rpc_priv if it is still queued by crt_context_req_submit(), the
+ * submitting thread then drops it. Return false if it has already been
+ * claimed for sending.
+ */
+bool
+crt_context_req_submit_cancel(struct crt_rpc_priv *rpc_priv)
+{
+	bool	canceled;
+
+	D_SPIN_LOCK(&rpc_priv->crp_lock);
+	canceled = rpc_priv->crp_state == RPC_STATE_SUBMIT_QUEUED;
+	if (canceled)
+		rpc_priv->crp_state = RPC_STATE_CANCELED;
+	D_SPIN_UNLOCK(&rpc_priv->crp_lock);
+
+	return canceled;
+}
+
 void
 crt_context_req_untrack(struct crt_rpc_priv *rpc_priv)
 {
@@ -1106,6 +1270,26 @@ out:
 	return rc;
 }
 
+int
+crt_context_eager_size(crt_context_t crt_ctx, size_t *size)
+{
+	struct crt_context	*ctx;
+	hg_class_t		*hg_class;
+
+	if (crt_ctx == CRT_CONTEXT_NULL || size == NULL) {
+		D_ERROR("invalid parameter, crt_ctx: %p, size: %p.\n",
+			crt_ctx, size);
+		return -DER_INVAL;
+	}
+
+	ctx = crt_ctx;
+	hg_class = ctx->cc_hg_ctx.chc_hgcla;
+	*size = min(HG_Class_get_input_eager_size(hg_class),
+		    HG_Class_get_output_eager_size(hg_class));
+
+	return 0;
+}
+
 int
 crt_self_uri_get(int tag, char **uri)
 {
@@ -1197,6 +1381,7 @@ crt_progress_cond(crt_context_t crt_ctx, int64_t timeout,
 {
 	struct crt_context	*ctx;
 	int64_t			 hg_timeout;
+	int64_t			 next;
 	uint64_t		 now;
 	uint64_t		 end = 0;
 	int			 rc = 0;
@@ -1253,10 +1438,16 @@ crt_progress_cond(crt_context_t crt_ctx, int64_t timeout,
 
 	/** loop until callback returns non-null value */
 	while ((rc = cond_cb(arg)) == 0) {
+		crt_context_submit_drain(ctx, true /* all */);
 		crt_context_timeout_check(ctx);
 		crt_exec_progress_cb(ctx);
 
-		rc = crt_hg_progress(&ctx->cc_hg_ctx, hg_timeout);
+		/* wake up in time to send the open batches */
+		next = crt_batch_flush(ctx, false /* all */);
+		if (next < 0 || next > hg_timeout)
+			next = hg_timeout;
+
+		rc = crt_hg_progress(&ctx->cc_hg_ctx, next);
 		if (unlikely(rc && rc != -DER_TIMEDOUT)) {
 			D_ERROR("crt_hg_progress failed with %d\n", rc);
 			return rc;
@@ -1292,6 +1483,7 @@ int
 crt_progress(crt_context_t crt_ctx, int64_t timeout)
 {
 	struct crt_context	*ctx;
+	int64_t			 next;
 	int			 rc = 0;
 
 	/** validate input parameters */
@@ -1302,6 +1494,9 @@ crt_progress(crt_context_t crt_ctx, int64_t timeout)
 
 	ctx = crt_ctx;
 
+	/* send whatever is left queued by the submitting threads */
+	crt_context_submit_drain(ctx, true /* all */);
+
 	/**
 	 * call progress once w/o any timeout before processing timed out
 	 * requests in case any replies are pending in the queue
@@ -1317,6 +1512,11 @@ crt_progress(crt_context_t crt_ctx, int64_t timeout)
 	crt_context_timeout_check(ctx);
 	crt_exec_progress_cb(ctx);
 
+	/* wake up in time to send the open batches */
+	next = crt_batch_flush(ctx, false /* all */);
+	if (next >= 0 && (timeout < 0 || timeout > next))
+		timeout = next;
+
 	if (timeout != 0 && (rc == 0 || rc == -DER_TIMEDOUT)) {
 		/** call progress once again with the real timeout */
 		rc = crt_hg_progress(&ctx->cc_hg_ctx, timeout);
@@ -1505,6 +1705,115 @@ exit:
 	return rc;
 }
 
+/* max helper progress threads per context */
+#define CRT_CTX_PROG_THREADS_MAX	(64)
+/* timeout of the progress calls of the helper threads, in us */
+#define CRT_CTX_PROG_TIMEOUT		(1000)
+
+/*
+ * Helper progress thread. Mercury lets several threads progress and trigger
+ * one HG context, the RPC handlers are then run by all of them.
+ */
+static void *
+crt_context_progress_fn(void *arg)
+{
+	struct crt_context	*ctx = arg;
+	int			 rc;
+
+	while (atomic_load_relaxed(&ctx->cc_prog_stop) == 0) {
+		crt_context_submit_drain(ctx, true /* all */);
+
+		rc = crt_hg_progress(&ctx->cc_hg_ctx, CRT_CTX_PROG_TIMEOUT);
+		if (unlikely(rc && rc != -DER_TIMEDOUT)) {
+			D_ERROR("context (idx %d) progress failed, helper "
+				"thread exiting, "DF_RC"\n", ctx->cc_idx,
+				DP_RC(rc));
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+static void
+crt_context_progress_stop(struct crt_context *ctx)
+{
+	uint32_t	i;
+
+	if (ctx->cc_prog_threads == NULL)
+		return;
+
+	atomic_store_relaxed(&ctx->cc_prog_stop, 1);
+	for (i = 0; i < ctx->cc_prog_nr; i++)
+		pthread_join(ctx->cc_prog_threads[i], NULL);
+
+	D_DEBUG(DB_TRACE, "context (idx %d) stopped %u progress threads.\n",
+		ctx->cc_idx, ctx->cc_prog_nr);
+	D_FREE(ctx->cc_prog_threads);
+	ctx->cc_prog_nr = 0;
+}
+
+int
+crt_context_set_progress_threads(crt_context_t crt_ctx, uint32_t nr)
+{
+	struct crt_context	*ctx = crt_ctx;
+	int			 rc = 0;
+
+	if (crt_ctx == CRT_CONTEXT_NULL || nr > CRT_CTX_PROG_THREADS_MAX) {
+		D_ERROR("invalid parameter, crt_ctx %p, nr %u.\n",
+			crt_ctx, nr);
+		return -DER_INVAL;
+	}
+
+	crt_context_progress_stop(ctx);
+	if (nr == 0)
+		return 0;
+
+	D_ALLOC_ARRAY(ctx->cc_prog_threads, nr);
+	if (ctx->cc_prog_threads == NULL)
+		return -DER_NOMEM;
+
+	atomic_store_relaxed(&ctx->cc_prog_stop, 0);
+	for (; ctx->cc_prog_nr < nr; ctx->cc_prog_nr++) {
+		rc = pthread_create(&ctx->cc_prog_threads[ctx->cc_prog_nr],
+				    NULL, crt_context_progress_fn, ctx);
+		if (rc != 0) {
+			D_ERROR("pthread_create() failed, rc: %d.\n", rc);
+			crt_context_progress_stop(ctx);
+			return d_errno2der(rc);
+		}
+	}
+
+	D_DEBUG(DB_TRACE, "context (idx %d) started %u progress threads.\n",
+		ctx->cc_idx, nr);
+	return 0;
+}
+
+int
+crt_context_hdl_pool_stats(crt_context_t crt_ctx,
+			   struct crt_hdl_pool_stats *stats)
+{
+	struct crt_context	*ctx = crt_ctx;
+	struct crt_hg_pool	*hg_pool;
+
+	if (crt_ctx == CRT_CONTEXT_NULL || stats == NULL) {
+		D_ERROR("invalid parameter, crt_ctx %p, stats %p.\n",
+			crt_ctx, stats);
+		return -DER_INVAL;
+	}
+
+	hg_pool = &ctx->cc_hg_ctx.chc_hg_pool;
+	D_SPIN_LOCK(&hg_pool->chp_lock);
+	stats->hps_hits = hg_pool->chp_hits;
+	stats->hps_addr_hits = hg_pool->chp_addr_hits;
+	stats->hps_misses = hg_pool->chp_misses;
+	stats->hps_num = hg_pool->chp_num;
+	stats->hps_max_num = hg_pool->chp_max_num;
+	D_SPIN_UNLOCK(&hg_pool->chp_lock);
+
+	return 0;
+}
+
 /* Execute handling for unreachable rpcs */
 void
 crt_req_force_timeout(struct crt_rpc_priv *rpc_priv)
@@ -1528,8 +1837,8 @@ crt_req_force_timeout(struct crt_rpc_priv *rpc_priv)
 	crt_ctx = rpc_priv->crp_pub.cr_ctx;
 
 	/**
-	 *  set the RPC's expiration time stamp to the past, move it to the top
-	 *  of the heap.
+	 *  set the RPC's expiration time stamp to the past, so it expires on
+	 *  the next timeout check.
 	 */
 	D_MUTEX_LOCK(&crt_ctx->cc_mutex);
 	crt_req_timeout_untrack(rpc_priv);
@@ -1106,6 +1106,7 @@ crt_grp_priv_destroy(struct crt_grp_priv *grp_priv)
 
 	D_FREE(grp_priv->gp_psr_phy_addr);
 	D_FREE(grp_priv->gp_pub.cg_grpid);
+	D_FREE(grp_priv->gp_doms);
 
 	D_RWLOCK_DESTROY(&grp_priv->gp_rwlock);
 	D_FREE(grp_priv);
@@ -1384,6 +1385,102 @@ out:
 	return rc;
 }
 
+static int
+crt_grp_dom_cmp(const void *a, const void *b)
+{
+	const struct crt_grp_dom	*dom_a = a;
+	const struct crt_grp_dom	*dom_b = b;
+
+	if (dom_a->gd_rank < dom_b->gd_rank)
+		return -1;
+	if (dom_a->gd_rank > dom_b->gd_rank)
+		return 1;
+	return 0;
+}
+
+int
+crt_group_domains_set(crt_group_t *grp, d_rank_list_t *ranks,
+		      uint32_t *domains)
+{
+	struct crt_grp_priv	*grp_priv;
+	struct crt_grp_dom	*doms = NULL;
+	uint32_t		 nr = 0;
+	uint32_t		 i;
+	int			 rc = 0;
+
+	if (!crt_initialized()) {
+		D_ERROR("CRT not initialized.\n");
+		D_GOTO(out, rc = -DER_UNINIT);
+	}
+
+	if (ranks != NULL && ranks->rl_nr > 0 && domains == NULL) {
+		D_ERROR("invalid parameter: domains is NULL.\n");
+		D_GOTO(out, rc = -DER_INVAL);
+	}
+
+	grp_priv = crt_grp_pub2priv(grp);
+	if (!grp_priv) {
+		D_ERROR("Invalid group\n");
+		D_GOTO(out, rc = -DER_INVAL);
+	}
+
+	if (ranks != NULL && ranks->rl_nr > 0) {
+		nr = ranks->rl_nr;
+		D_ALLOC_ARRAY(doms, nr);
+		if (doms == NULL)
+			D_GOTO(out, rc = -DER_NOMEM);
+
+		for (i = 0; i < nr; i++) {
+			doms[i].gd_rank = ranks->rl_ranks[i];
+			doms[i].gd_dom = domains[i];
+		}
+		qsort(doms, nr, sizeof(*doms), crt_grp_dom_cmp);
+	}
+
+	D_RWLOCK_WRLOCK(&grp_priv->gp_rwlock);
+	D_FREE(grp_priv->gp_doms);
+	grp_priv->gp_doms = doms;
+	grp_priv->gp_dom_nr = nr;
+	D_RWLOCK_UNLOCK(&grp_priv->gp_rwlock);
+
+	D_DEBUG(DB_TRACE, "group %s, %u ranks with domains.\n",
+		grp_priv->gp_pub.cg_grpid, nr);
+out:
+	return rc;
+}
+
+/*
+ * Look up the fault domain of each rank of \a ranks, \a doms is NULL if the
+ * group has no domains set. Caller should hold crt_grp_priv::gp_rwlock.
+ */
+int
+crt_grp_doms_get(struct crt_grp_priv *grp_priv, d_rank_list_t *ranks,
+		 uint32_t **doms)
+{
+	struct crt_grp_dom	 key;
+	struct crt_grp_dom	*dom;
+	uint32_t		*result;
+	uint32_t		 i;
+
+	*doms = NULL;
+	if (grp_priv->gp_dom_nr == 0)
+		return 0;
+
+	D_ALLOC_ARRAY(result, ranks->rl_nr);
+	if (result == NULL)
+		return -DER_NOMEM;
+
+	for (i = 0; i < ranks->rl_nr; i++) {
+		key.gd_rank = ranks->rl_ranks[i];
+		dom = bsearch(&key, grp_priv->gp_doms, grp_priv->gp_dom_nr,
+			      sizeof(key), crt_grp_dom_cmp);
+		result[i] = dom != NULL ? dom->gd_dom : CRT_NO_DOMAIN;
+	}
+
+	*doms = result;
+	return 0;
+}
+
 static int
 crt_primary_grp_init(crt_group_id_t grpid)
 {
@@ -45,6 +45,12 @@ struct crt_grp_priv_sec {
 	d_list_t		gps_link;
 };
 
+/* Fault domain of a group rank, see crt_group_domains_set */
+struct crt_grp_dom {
+	d_rank_t		gd_rank;
+	uint32_t		gd_dom;
+};
+
 struct crt_grp_priv;
 
 struct crt_grp_priv {
@@ -102,6 +108,10 @@ struct crt_grp_priv {
 	/* Secondary to primary rank mapping table */
 	struct d_hash_table	 gp_s2p_table;
 
+	/* fault domains of the members sorted by rank, for CRT_TREE_DOMAIN */
+	struct crt_grp_dom	*gp_doms;
+	uint32_t		 gp_dom_nr;
+
 	/* set of variables only valid in primary service groups */
 	uint32_t		 gp_primary:1, /* flag of primary group */
 				 gp_view:1, /* flag to indicate it is a view */
@@ -375,4 +385,8 @@ int crt_grp_psr_reload(struct crt_grp_priv *grp_priv);
 int
 grp_add_to_membs_list(struct crt_grp_priv *grp_priv, d_rank_t rank);
 
+int
+crt_grp_doms_get(struct crt_grp_priv *grp_priv, d_rank_list_t *ranks,
+		 uint32_t **doms);
+
 #endif /* __CRT_GROUP_H__ */
@@ -49,10 +49,74 @@ struct crt_na_dict crt_na_dict[] = {
 	}
 };
 
+/* per-address list of the handles last bound to \a addr */
+static inline d_list_t *
+crt_hg_pool_addr_list(struct crt_hg_pool *hg_pool, hg_addr_t addr)
+{
+	return &hg_pool->chp_addr_lists[d_u64_hash((uintptr_t)addr,
+						   CRT_HG_POOL_ADDR_BITS)];
+}
+
+static inline void
+crt_hg_pool_destroy_list(d_list_t *destroy_list)
+{
+	struct crt_hg_hdl	*hdl;
+	hg_return_t		 hg_ret = HG_SUCCESS;
+
+	while ((hdl = d_list_pop_entry(destroy_list,
+				       struct crt_hg_hdl,
+				       chh_link))) {
+		D_ASSERT(hdl->chh_hdl != HG_HANDLE_NULL);
+		hg_ret = HG_Destroy(hdl->chh_hdl);
+		if (hg_ret != HG_SUCCESS)
+			D_ERROR("HG_Destroy() failed, hg_hdl %p, hg_ret: %d.\n",
+				hdl->chh_hdl, hg_ret);
+		else
+			D_DEBUG(DB_NET, "hg_hdl %p destroyed.\n", hdl->chh_hdl);
+		D_FREE(hdl);
+	}
+}
+
+/*
+ * Called with chp_lock held at the end of a window of CRT_HG_POOL_WINDOW
+ * gets, fit the max number of handles to the peak demand of the window, and
+ * move the idle handles above it to \a destroy_list, oldest first. The pool
+ * grows at once in get when the demand exceeds the max, so this only shrinks
+ * a pool which was sized by a past burst.
+ */
+static inline void
+crt_hg_pool_resize(struct crt_hg_pool *hg_pool, d_list_t *destroy_list)
+{
+	struct crt_hg_hdl	*hdl;
+	int32_t			 max_num;
+
+	max_num = hg_pool->chp_peak + hg_pool->chp_peak / 4;
+	max_num = max(max_num, hg_pool->chp_min_num);
+	hg_pool->chp_max_num = min(max_num, CRT_HG_POOL_LIMIT);
+
+	while (hg_pool->chp_num > hg_pool->chp_max_num) {
+		hdl = d_list_pop_entry(&hg_pool->chp_list, struct crt_hg_hdl,
+				       chh_link);
+		D_ASSERT(hdl != NULL);
+		d_list_del_init(&hdl->chh_addr_link);
+		d_list_add_tail(&hdl->chh_link, destroy_list);
+		hg_pool->chp_num--;
+	}
+
+	D_DEBUG(DB_NET, "hg_pool %p, peak %d, max_num %d, chp_num %d.\n",
+		hg_pool, hg_pool->chp_peak, hg_pool->chp_max_num,
+		hg_pool->chp_num);
+	hg_pool->chp_peak = hg_pool->chp_inuse;
+	hg_pool->chp_window = CRT_HG_POOL_WINDOW;
+}
+
 /**
  * Enable the HG handle pool, can change/tune the max_num and prepost_num.
  * This allows the pool be enabled/re-enabled and be tunable at runtime
  * automatically based on workload or manually by cart_ctl.
+ *
+ * The max_num is only the initial size, the pool then adapts it to the
+ * number of handles in use, between prepost_num and CRT_HG_POOL_LIMIT.
  */
 static inline int
 crt_hg_pool_enable(struct crt_hg_context *hg_ctx, int32_t max_num,
@@ -65,7 +129,7 @@ crt_hg_pool_enable(struct crt_hg_context *hg_ctx, int32_t max_num,
 	int			 rc = 0;
 
 	if (hg_ctx == NULL || max_num <= 0 || prepost_num < 0 ||
-	    prepost_num > max_num) {
+	    prepost_num > max_num || max_num > CRT_HG_POOL_LIMIT) {
 		D_ERROR("Invalid parameter of crt_hg_pool_enable, hg_ctx %p, "
 			"max_bum %d, prepost_num %d.\n", hg_ctx, max_num,
 			prepost_num);
@@ -74,6 +138,8 @@ crt_hg_pool_enable(struct crt_hg_context *hg_ctx, int32_t max_num,
 
 	D_SPIN_LOCK(&hg_pool->chp_lock);
 	hg_pool->chp_max_num = max_num;
+	hg_pool->chp_min_num = prepost_num;
+	hg_pool->chp_window = CRT_HG_POOL_WINDOW;
 	hg_pool->chp_enabled = true;
 	prepost = hg_pool->chp_num < prepost_num;
 	D_SPIN_UNLOCK(&hg_pool->chp_lock);
@@ -85,6 +151,7 @@ crt_hg_pool_enable(struct crt_hg_context *hg_ctx, int32_t max_num,
 			break;
 		}
 		D_INIT_LIST_HEAD(&hdl->chh_link);
+		D_INIT_LIST_HEAD(&hdl->chh_addr_link);
 
 		hg_ret = HG_Create(hg_ctx->chc_hgctx, NULL,
 				   CRT_HG_RPCID, &hdl->chh_hdl);
@@ -97,6 +164,8 @@ crt_hg_pool_enable(struct crt_hg_context *hg_ctx, int32_t max_num,
 
 		D_SPIN_LOCK(&hg_pool->chp_lock);
 		d_list_add_tail(&hdl->chh_link, &hg_pool->chp_list);
+		d_list_add(&hdl->chh_addr_link,
+			   crt_hg_pool_addr_list(hg_pool, hdl->chh_addr));
 		hg_pool->chp_num++;
 		D_DEBUG(DB_NET, "hg_pool %p, add, chp_num %d.\n",
 			hg_pool, hg_pool->chp_num);
@@ -113,9 +182,8 @@ static inline void
 crt_hg_pool_disable(struct crt_hg_context *hg_ctx)
 {
 	struct crt_hg_pool	*hg_pool = &hg_ctx->chc_hg_pool;
-	struct crt_hg_hdl	*hdl;
 	d_list_t		 destroy_list;
-	hg_return_t		 hg_ret = HG_SUCCESS;
+	int			 i;
 
 	D_INIT_LIST_HEAD(&destroy_list);
 
@@ -124,22 +192,15 @@ crt_hg_pool_disable(struct crt_hg_context *hg_ctx)
 	hg_pool->chp_max_num = 0;
 	hg_pool->chp_enabled = false;
 	d_list_splice_init(&hg_pool->chp_list, &destroy_list);
-	D_DEBUG(DB_NET, "hg_pool %p disabled and become empty (chp_num 0).\n",
-		hg_pool);
+	for (i = 0; i < (1 << CRT_HG_POOL_ADDR_BITS); i++)
+		D_INIT_LIST_HEAD(&hg_pool->chp_addr_lists[i]);
+	D_DEBUG(DB_NET, "hg_pool %p disabled and become empty (chp_num 0), "
+		"hits "DF_U64" (same address "DF_U64"), misses "DF_U64".\n",
+		hg_pool, hg_pool->chp_hits, hg_pool->chp_addr_hits,
+		hg_pool->chp_misses);
 	D_SPIN_UNLOCK(&hg_pool->chp_lock);
 
-	while ((hdl = d_list_pop_entry(&destroy_list,
-				       struct crt_hg_hdl,
-				       chh_link))) {
-		D_ASSERT(hdl->chh_hdl != HG_HANDLE_NULL);
-		hg_ret = HG_Destroy(hdl->chh_hdl);
-		if (hg_ret != HG_SUCCESS)
-			D_ERROR("HG_Destroy() failed, hg_hdl %p, hg_ret: %d.\n",
-				hdl->chh_hdl, hg_ret);
-		else
-			D_DEBUG(DB_NET, "hg_hdl %p destroyed.\n", hdl->chh_hdl);
-		D_FREE(hdl);
-	}
+	crt_hg_pool_destroy_list(&destroy_list);
 }
 
 static inline int
@@ -147,6 +208,7 @@ crt_hg_pool_init(struct crt_hg_context *hg_ctx)
 {
 	struct crt_hg_pool	*hg_pool = &hg_ctx->chc_hg_pool;
 	int			 rc = 0;
+	int			 i;
 
 	rc = D_SPIN_INIT(&hg_pool->chp_lock, PTHREAD_PROCESS_PRIVATE);
 	if (rc != 0)
@@ -154,8 +216,16 @@ crt_hg_pool_init(struct crt_hg_context *hg_ctx)
 
 	hg_pool->chp_num = 0;
 	hg_pool->chp_max_num = 0;
+	hg_pool->chp_min_num = 0;
+	hg_pool->chp_inuse = 0;
+	hg_pool->chp_peak = 0;
+	hg_pool->chp_hits = 0;
+	hg_pool->chp_addr_hits = 0;
+	hg_pool->chp_misses = 0;
 	hg_pool->chp_enabled = false;
 	D_INIT_LIST_HEAD(&hg_pool->chp_list);
+	for (i = 0; i < (1 << CRT_HG_POOL_ADDR_BITS); i++)
+		D_INIT_LIST_HEAD(&hg_pool->chp_addr_lists[i]);
 
 	rc = crt_hg_pool_enable(hg_ctx, CRT_HG_POOL_MAX_NUM,
 				CRT_HG_POOL_PREPOST_NUM);
@@ -178,11 +248,23 @@ crt_hg_pool_fini(struct crt_hg_context *hg_ctx)
 	}
 }
 
+/* max number of handles looked at in a per-address list */
+#define CRT_HG_POOL_ADDR_SCAN	(8)
+
+/*
+ * Get a handle for an RPC to \a addr, preferably one last bound to it, so
+ * that resetting it to \a addr does not need to release and bind addresses.
+ */
 static inline struct crt_hg_hdl *
-crt_hg_pool_get(struct crt_hg_context *hg_ctx)
+crt_hg_pool_get(struct crt_hg_context *hg_ctx, hg_addr_t addr)
 {
 	struct crt_hg_pool	*hg_pool = &hg_ctx->chc_hg_pool;
 	struct crt_hg_hdl	*hdl = NULL;
+	struct crt_hg_hdl	*tmp;
+	d_list_t		 destroy_list;
+	int			 i = 0;
+
+	D_INIT_LIST_HEAD(&destroy_list);
 
 	D_SPIN_LOCK(&hg_pool->chp_lock);
 	if (!hg_pool->chp_enabled) {
@@ -190,16 +272,43 @@ crt_hg_pool_get(struct crt_hg_context *hg_ctx)
 			"hg_pool %p is not enabled cannot get.\n", hg_pool);
 		D_GOTO(unlock, hdl);
 	}
-	hdl = d_list_pop_entry(&hg_pool->chp_list,
-			       struct crt_hg_hdl,
-			       chh_link);
+
+	hg_pool->chp_inuse++;
+	if (hg_pool->chp_inuse > hg_pool->chp_peak) {
+		hg_pool->chp_peak = hg_pool->chp_inuse;
+		/* grow at once to keep the handles of a burst */
+		if (hg_pool->chp_peak > hg_pool->chp_max_num)
+			hg_pool->chp_max_num = min(hg_pool->chp_peak,
+						   CRT_HG_POOL_LIMIT);
+	}
+	if (--hg_pool->chp_window == 0)
+		crt_hg_pool_resize(hg_pool, &destroy_list);
+
+	d_list_for_each_entry(tmp, crt_hg_pool_addr_list(hg_pool, addr),
+			      chh_addr_link) {
+		if (tmp->chh_addr == addr) {
+			hdl = tmp;
+			hg_pool->chp_addr_hits++;
+			d_list_del_init(&hdl->chh_link);
+			break;
+		}
+		if (++i == CRT_HG_POOL_ADDR_SCAN)
+			break;
+	}
+	if (hdl == NULL)
+		hdl = d_list_pop_entry(&hg_pool->chp_list,
+				       struct crt_hg_hdl,
+				       chh_link);
 	if (hdl == NULL) {
+		hg_pool->chp_misses++;
 		D_DEBUG(DB_NET,
 			"hg_pool %p is empty, cannot get.\n", hg_pool);
 		D_GOTO(unlock, hdl);
 	}
 
 	D_ASSERT(hdl->chh_hdl != HG_HANDLE_NULL);
+	d_list_del_init(&hdl->chh_addr_link);
+	hg_pool->chp_hits++;
 	hg_pool->chp_num--;
 	D_ASSERT(hg_pool->chp_num >= 0);
 	D_DEBUG(DB_NET, "hg_pool %p, remove, chp_num %d.\n",
@@ -207,6 +316,8 @@ crt_hg_pool_get(struct crt_hg_context *hg_ctx)
 
 unlock:
 	D_SPIN_UNLOCK(&hg_pool->chp_lock);
+
+	crt_hg_pool_destroy_list(&destroy_list);
 	return hdl;
 }
 
@@ -224,18 +335,31 @@ crt_hg_pool_put(struct crt_rpc_priv *rpc_priv)
 
 	if (rpc_priv->crp_hdl_reuse == NULL) {
 		D_ALLOC_PTR(hdl);
-		if (hdl == NULL)
+		if (hdl == NULL) {
+			/* the handle is destroyed, still no longer in use */
+			D_SPIN_LOCK(&hg_pool->chp_lock);
+			if (hg_pool->chp_inuse > 0)
+				hg_pool->chp_inuse--;
+			D_SPIN_UNLOCK(&hg_pool->chp_lock);
 			D_GOTO(out, 0);
+		}
 		D_INIT_LIST_HEAD(&hdl->chh_link);
+		D_INIT_LIST_HEAD(&hdl->chh_addr_link);
 		hdl->chh_hdl = rpc_priv->crp_hg_hdl;
 	} else {
 		hdl = rpc_priv->crp_hdl_reuse;
 		rpc_priv->crp_hdl_reuse = NULL;
 	}
+	hdl->chh_addr = rpc_priv->crp_hg_addr;
 
 	D_SPIN_LOCK(&hg_pool->chp_lock);
+	if (hg_pool->chp_inuse > 0)
+		hg_pool->chp_inuse--;
 	if (hg_pool->chp_enabled && hg_pool->chp_num < hg_pool->chp_max_num) {
 		d_list_add_tail(&hdl->chh_link, &hg_pool->chp_list);
+		/* most recently put first */
+		d_list_add(&hdl->chh_addr_link,
+			   crt_hg_pool_addr_list(hg_pool, hdl->chh_addr));
 		hg_pool->chp_num++;
 		D_DEBUG(DB_NET, "hg_pool %p, add, chp_num %d.\n",
 			hg_pool, hg_pool->chp_num);
@@ -860,7 +984,8 @@ crt_hg_req_create(struct crt_hg_context *hg_ctx, struct crt_rpc_priv *rpc_priv)
 
 	if (!rpc_priv->crp_opc_info->coi_no_reply) {
 		rpcid = CRT_HG_RPCID;
-		rpc_priv->crp_hdl_reuse = crt_hg_pool_get(hg_ctx);
+		rpc_priv->crp_hdl_reuse =
+			crt_hg_pool_get(hg_ctx, rpc_priv->crp_hg_addr);
 	} else {
 		rpcid = CRT_HG_ONEWAY_RPCID;
 	}
@@ -911,6 +1036,10 @@ crt_hg_req_destroy(struct crt_rpc_priv *rpc_priv)
 	hg_return_t hg_ret;
 
 	D_ASSERT(rpc_priv != NULL);
+	/* packed in an envelope, no HG handle */
+	if (rpc_priv->crp_batched)
+		crt_batch_req_free(rpc_priv);
+
 	if (rpc_priv->crp_output_got != 0) {
 		hg_ret = HG_Free_output(rpc_priv->crp_hg_hdl,
 					&rpc_priv->crp_pub.cr_output);
@@ -1193,6 +1322,12 @@ crt_hg_reply_error_send(struct crt_rpc_priv *rpc_priv, int error_code)
 
 	hg_out_struct = &rpc_priv->crp_pub.cr_output;
 	rpc_priv->crp_reply_hdr.cch_rc = error_code;
+	if (rpc_priv->crp_batched) {
+		crt_batch_reply_send(rpc_priv);
+		rpc_priv->crp_reply_pending = 0;
+		return;
+	}
+
 	hg_ret = HG_Respond(rpc_priv->crp_hg_hdl, NULL, NULL, hg_out_struct);
 	if (hg_ret != HG_SUCCESS) {
 		RPC_ERROR(rpc_priv,
@@ -1487,6 +1622,7 @@ crt_hg_bulk_transfer(struct crt_bulk_desc *bulk_desc, crt_bulk_cb_t complete_cb,
 	hg_bulk_op_t			hg_bulk_op;
 	struct crt_bulk_desc		*bulk_desc_dup;
 	struct crt_rpc_priv		*rpc_priv;
+	hg_handle_t			hg_hdl;
 	hg_return_t			hg_ret = HG_SUCCESS;
 	int				rc = 0;
 
@@ -1516,6 +1652,9 @@ crt_hg_bulk_transfer(struct crt_bulk_desc *bulk_desc, crt_bulk_cb_t complete_cb,
 		     HG_BULK_PUSH : HG_BULK_PULL;
 	rpc_priv = container_of(bulk_desc->bd_rpc, struct crt_rpc_priv,
 				crp_pub);
+	/* batched RPCs have no handle, the envelope has the context id */
+	hg_hdl = rpc_priv->crp_batch_env != NULL ?
+		 rpc_priv->crp_batch_env->crp_hg_hdl : rpc_priv->crp_hg_hdl;
 	if (bind)
 		hg_ret = HG_Bulk_bind_transfer(hg_ctx->chc_bulkctx,
 				crt_hg_bulk_transfer_cb, bulk_cbinfo,
@@ -1530,7 +1669,7 @@ crt_hg_bulk_transfer(struct crt_bulk_desc *bulk_desc, crt_bulk_cb_t complete_cb,
 		hg_ret = HG_Bulk_transfer_id(hg_ctx->chc_bulkctx,
 				crt_hg_bulk_transfer_cb, bulk_cbinfo,
 				hg_bulk_op, rpc_priv->crp_hg_addr,
-				HG_Get_info(rpc_priv->crp_hg_hdl)->context_id,
+				HG_Get_info(hg_hdl)->context_id,
 				bulk_desc->bd_remote_hdl,
 				bulk_desc->bd_remote_off,
 				bulk_desc->bd_local_hdl,
@@ -22,10 +22,16 @@
 #define CRT_HG_RPCID		(0xDA036868)
 #define CRT_HG_ONEWAY_RPCID	(0xDA036869)
 
-/** MAX number of HG handles in pool */
+/** initial MAX number of HG handles in pool */
 #define CRT_HG_POOL_MAX_NUM	(512)
 /** number of prepost HG handles when enable pool */
 #define CRT_HG_POOL_PREPOST_NUM	(16)
+/** upper bound of the MAX number of HG handles when the pool adapts it */
+#define CRT_HG_POOL_LIMIT	(16384)
+/** number of gets from the pool between two resizings */
+#define CRT_HG_POOL_WINDOW	(4096)
+/** log2 of the number of per-address lists of the pool */
+#define CRT_HG_POOL_ADDR_BITS	(6)
 
 struct crt_rpc_priv;
 struct crt_common_hdr;
@@ -64,18 +70,36 @@ extern struct crt_na_dict crt_na_dict[];
 struct crt_hg_hdl {
 	/* link to crt_hg_pool::chp_hg_list */
 	d_list_t		chh_link;
+	/* link to the crt_hg_pool::chp_addr_lists list of chh_addr */
+	d_list_t		chh_addr_link;
 	/* HG handle */
 	hg_handle_t		chh_hdl;
+	/* address the handle was last bound to */
+	hg_addr_t		chh_addr;
 };
 
 struct crt_hg_pool {
 	pthread_spinlock_t	chp_lock;
 	/* number of HG handles in pool */
 	int32_t			chp_num;
-	/* maximum number of HG handles in pool */
+	/* maximum number of HG handles in pool, adapted to the demand */
 	int32_t			chp_max_num;
-	/* HG handle list */
+	/* lower bound of chp_max_num, the prepost number */
+	int32_t			chp_min_num;
+	/* handles got from the pool or created on a miss, not put back */
+	int32_t			chp_inuse;
+	/* highest chp_inuse in the current window */
+	int32_t			chp_peak;
+	/* gets left before the end of the current window */
+	int32_t			chp_window;
+	/* HG handle list, least recently put first */
 	d_list_t		chp_list;
+	/* HG handles by last bound address, to reuse them for the same one */
+	d_list_t		chp_addr_lists[1 << CRT_HG_POOL_ADDR_BITS];
+	/* statistics */
+	uint64_t		chp_hits;
+	uint64_t		chp_addr_hits;
+	uint64_t		chp_misses;
 	bool			chp_enabled;
 };
 
@@ -111,6 +135,9 @@ int crt_rpc_handler_common(hg_handle_t hg_hdl);
 /* crt_hg_proc.c */
 int crt_hg_unpack_header(hg_handle_t hg_hdl, struct crt_rpc_priv *rpc_priv,
 			 crt_proc_t *proc);
+int crt_hg_unpack_header_buf(struct crt_rpc_priv *rpc_priv, void *buf,
+			     size_t size, hg_proc_hash_t hash,
+			     crt_proc_t *proc);
 void crt_hg_header_copy(struct crt_rpc_priv *in, struct crt_rpc_priv *out);
 void crt_hg_unpack_cleanup(crt_proc_t proc);
 int crt_hg_unpack_body(struct crt_rpc_priv *rpc_priv, crt_proc_t proc);
@@ -12,6 +12,12 @@
 #include "crt_internal.h"
 
 #define CRT_PROC_NULL (NULL)
+
+/*
+ * RPC whose input is being decoded, or freed, in place by this thread, NULL
+ * if none, see crt_proc_buf().
+ */
+static __thread struct crt_rpc_priv *crt_proc_inplace_rpc;
 #define CRT_PROC_TYPE_FUNC(type)				\
 	int crt_proc_##type(crt_proc_t proc, type *data)	\
 	{							\
@@ -101,6 +107,84 @@ crt_proc_memcpy(crt_proc_t proc, void *data, size_t data_size)
 	return rc;
 }
 
+/* is \a buf in the input buffer of the RPC decoded in place */
+static inline bool
+crt_proc_buf_inplace(const void *buf)
+{
+	struct crt_rpc_priv	*rpc_priv = crt_proc_inplace_rpc;
+
+	if (rpc_priv == NULL)
+		return false;
+
+	return (const char *)buf >= (char *)rpc_priv->crp_in_buf &&
+	       (const char *)buf < (char *)rpc_priv->crp_in_buf +
+				   rpc_priv->crp_in_buf_size;
+}
+
+void
+crt_proc_buf_free(void **buf)
+{
+	if (*buf != NULL && !crt_proc_buf_inplace(*buf))
+		D_FREE(*buf);
+	*buf = NULL;
+}
+
+int
+crt_proc_buf(crt_proc_t proc, void **buf, size_t size, size_t align)
+{
+	crt_proc_op_t	 proc_op;
+	hg_size_t	 pad;
+	void		*ptr;
+	int		 rc;
+
+	D_ASSERT(align != 0 && (align & (align - 1)) == 0);
+
+	rc = crt_proc_get_op(proc, &proc_op);
+	if (unlikely(rc))
+		return -DER_HG;
+
+	if (proc_op == CRT_PROC_FREE) {
+		crt_proc_buf_free(buf);
+		return 0;
+	}
+
+	if (size == 0) {
+		if (proc_op == CRT_PROC_DECODE)
+			*buf = NULL;
+		return 0;
+	}
+
+	/* the offset is the same on both sides, pad it to the alignment */
+	pad = -hg_proc_get_size_used(proc) & (align - 1);
+	if (pad != 0) {
+		ptr = hg_proc_save_ptr(proc, pad);
+		if (proc_op == CRT_PROC_ENCODE)
+			memset(ptr, 0, pad);
+	}
+
+	ptr = hg_proc_save_ptr(proc, size);
+	if (proc_op == CRT_PROC_ENCODE) {
+		memcpy(ptr, *buf, size);
+		return 0;
+	}
+
+	/* the RPC buffer itself may not be aligned */
+	if (crt_proc_inplace_rpc != NULL &&
+	    ((uintptr_t)ptr & (align - 1)) == 0) {
+		atomic_fetch_add_relaxed(&crt_gdata.cg_proc_inplace_cnt, 1);
+		*buf = ptr;
+		return 0;
+	}
+
+	atomic_fetch_add_relaxed(&crt_gdata.cg_proc_alloc_cnt, 1);
+	D_ALLOC(*buf, size);
+	if (*buf == NULL)
+		return -DER_NOMEM;
+	memcpy(*buf, ptr, size);
+
+	return 0;
+}
+
 CRT_PROC_TYPE_FUNC(int8_t)
 CRT_PROC_TYPE_FUNC(uint8_t)
 CRT_PROC_TYPE_FUNC(int16_t)
@@ -127,8 +211,13 @@ crt_proc_d_string_t(crt_proc_t proc, d_string_t *data)
 	hg_return_t	hg_ret;
 
 	hg_ret = hg_proc_hg_string_t(proc, data);
+	if (hg_ret != HG_SUCCESS)
+		return -DER_HG;
 
-	return (hg_ret == HG_SUCCESS) ? 0 : -DER_HG;
+	if (hg_proc_get_op(proc) == HG_DECODE && *data != NULL)
+		atomic_fetch_add_relaxed(&crt_gdata.cg_proc_alloc_cnt, 1);
+
+	return 0;
 }
 
 int
@@ -189,6 +278,7 @@ crt_proc_d_rank_list_t(crt_proc_t proc, d_rank_list_t **data)
 			D_GOTO(out, rc = 0);
 		}
 
+		atomic_fetch_add_relaxed(&crt_gdata.cg_proc_alloc_cnt, 1);
 		rank_list = d_rank_list_alloc(nr);
 		if (rank_list == NULL)
 			D_GOTO(out, rc = -DER_NOMEM);
@@ -252,6 +342,8 @@ crt_proc_d_iov_t(crt_proc_t proc, d_iov_t *div)
 			 * Just point at memory in request buffer instead.
 			 */
 			div->iov_buf = hg_proc_save_ptr(proc, div->iov_len);
+			atomic_fetch_add_relaxed(&crt_gdata.cg_proc_inplace_cnt,
+						 1);
 		}
 	} else { /* proc_op == CRT_PROC_ENCODE */
 		rc = crt_proc_memcpy(proc, div->iov_buf, div->iov_len);
@@ -360,8 +452,6 @@ int
 crt_hg_unpack_header(hg_handle_t handle, struct crt_rpc_priv *rpc_priv,
 		     crt_proc_t *proc)
 {
-	int	rc = 0;
-
 	/*
 	 * Use some low level HG APIs to unpack header first and then unpack the
 	 * body, avoid unpacking two times (which needs to lookup, create the
@@ -373,11 +463,7 @@ crt_hg_unpack_header(hg_handle_t handle, struct crt_rpc_priv *rpc_priv,
 	void			*in_buf = NULL;
 	hg_size_t		in_buf_size;
 	hg_return_t		hg_ret = HG_SUCCESS;
-	hg_class_t		*hg_class;
-	struct crt_context	*ctx;
-	struct crt_hg_context	*hg_ctx;
-	uint64_t		clock_offset;
-	hg_proc_t		hg_proc = HG_PROC_NULL;
+	int			rc = 0;
 
 	/* Get extra input buffer; if it's null, get regular input buffer */
 	hg_ret = HG_Get_input_extra_buf(handle, &in_buf, &in_buf_size);
@@ -395,12 +481,39 @@ crt_hg_unpack_header(hg_handle_t handle, struct crt_rpc_priv *rpc_priv,
 		}
 	}
 
+	if (crt_gdata.cg_proc_inplace) {
+		rpc_priv->crp_in_buf = in_buf;
+		rpc_priv->crp_in_buf_size = in_buf_size;
+	}
+
+	rc = crt_hg_unpack_header_buf(rpc_priv, in_buf, in_buf_size, HG_CRC32,
+				      proc);
+out:
+	return rc;
+}
+
+/*
+ * Unpack the common header of a request packed in \a buf, and return the
+ * decoding proc positioned on the body.
+ */
+int
+crt_hg_unpack_header_buf(struct crt_rpc_priv *rpc_priv, void *buf,
+			 size_t size, hg_proc_hash_t hash, crt_proc_t *proc)
+{
+	hg_return_t		hg_ret = HG_SUCCESS;
+	hg_class_t		*hg_class;
+	struct crt_context	*ctx;
+	struct crt_hg_context	*hg_ctx;
+	uint64_t		clock_offset;
+	hg_proc_t		hg_proc = HG_PROC_NULL;
+	int			rc = 0;
+
 	/* Create a new decoding proc */
 	ctx = rpc_priv->crp_pub.cr_ctx;
 	hg_ctx = &ctx->cc_hg_ctx;
 	hg_class = hg_ctx->chc_hgcla;
-	hg_ret = hg_proc_create_set(hg_class, in_buf, in_buf_size, HG_DECODE,
-				    HG_CRC32, &hg_proc);
+	hg_ret = hg_proc_create_set(hg_class, buf, size, HG_DECODE, hash,
+				    &hg_proc);
 	if (hg_ret != HG_SUCCESS) {
 		D_ERROR("Could not create proc, hg_ret: %d.", hg_ret);
 		D_GOTO(out, rc = -DER_HG);
@@ -453,6 +566,8 @@ crt_hg_header_copy(struct crt_rpc_priv *in, struct crt_rpc_priv *out)
 	out->crp_hg_hdl = in->crp_hg_hdl;
 	out->crp_pub.cr_ctx = in->crp_pub.cr_ctx;
 	out->crp_flags = in->crp_flags;
+	out->crp_in_buf = in->crp_in_buf;
+	out->crp_in_buf_size = in->crp_in_buf_size;
 
 	out->crp_req_hdr = in->crp_req_hdr;
 	out->crp_reply_hdr.cch_hlc = in->crp_reply_hdr.cch_hlc;
@@ -498,7 +613,10 @@ crt_hg_unpack_body(struct crt_rpc_priv *rpc_priv, crt_proc_t proc)
 	D_ASSERT(rpc_priv != NULL && proc != HG_PROC_NULL);
 
 	/* Decode input parameters */
+	if (rpc_priv->crp_in_buf != NULL)
+		crt_proc_inplace_rpc = rpc_priv;
 	rc = crt_proc_input(rpc_priv, proc);
+	crt_proc_inplace_rpc = NULL;
 	if (rc != 0) {
 		D_ERROR("crt_hg_unpack_body failed, rc: %d, opc: %#x.\n",
 			rc, rpc_priv->crp_pub.cr_opc);
@@ -603,7 +721,11 @@ crt_proc_in_common(crt_proc_t proc, crt_rpc_input_t *data)
 		D_GOTO(out, rc);
 	}
 
+	/* release what was not decoded in place */
+	if (proc_op == CRT_PROC_FREE && rpc_priv->crp_in_buf != NULL)
+		crt_proc_inplace_rpc = rpc_priv;
 	rc = crt_proc_input(rpc_priv, proc);
+	crt_proc_inplace_rpc = NULL;
 	if (rc != 0) {
 		D_ERROR("unpack input fails for opc: %#x\n",
 			rpc_priv->crp_pub.cr_opc);
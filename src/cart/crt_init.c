@@ -67,6 +67,9 @@ static int data_init(int server, crt_init_options_t *opt)
 	uint32_t	timeout;
 	uint32_t	credits;
 	bool		share_addr = false;
+	bool		submit_queue = true;
+	bool		proc_inplace = true;
+	uint32_t	batch_delay = 0;
 	uint32_t	ctx_num = 1;
 	uint32_t	fi_univ_size = 0;
 	uint32_t	mem_pin_disable = 0;
@@ -167,6 +170,20 @@ static int data_init(int server, crt_init_options_t *opt)
 	crt_gdata.cg_credit_ep_ctx = credits;
 	D_ASSERT(crt_gdata.cg_credit_ep_ctx <= CRT_MAX_CREDITS_PER_EP_CTX);
 
+	d_getenv_bool("CRT_CTX_SUBMIT_QUEUE", &submit_queue);
+	crt_gdata.cg_submit_queue = submit_queue;
+	D_DEBUG(DB_ALL, "set cg_submit_queue %d.\n", submit_queue);
+
+	d_getenv_bool("CRT_PROC_INPLACE", &proc_inplace);
+	crt_gdata.cg_proc_inplace = proc_inplace;
+	D_DEBUG(DB_ALL, "set cg_proc_inplace %d.\n", proc_inplace);
+
+	d_getenv_int("CRT_BATCH_DELAY", &batch_delay);
+	if (batch_delay > CRT_BATCH_DELAY_MAX)
+		batch_delay = CRT_BATCH_DELAY_MAX;
+	crt_gdata.cg_batch_delay = batch_delay;
+	D_DEBUG(DB_ALL, "set cg_batch_delay %u us.\n", batch_delay);
+
 	if (opt && opt->cio_sep_override) {
 		if (opt->cio_use_sep) {
 			crt_gdata.cg_sep_mode = true;
@@ -30,6 +30,8 @@ enum {
 };
 
 int crt_context_req_track(struct crt_rpc_priv *rpc_priv);
+void crt_context_req_submit(struct crt_rpc_priv *rpc_priv);
+bool crt_context_req_submit_cancel(struct crt_rpc_priv *rpc_priv);
 bool crt_context_empty(int locked);
 void crt_context_req_untrack(struct crt_rpc_priv *rpc_priv);
 crt_context_t crt_context_lookup(int ctx_idx);
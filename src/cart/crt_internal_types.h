@@ -18,7 +18,7 @@
 
 #include <gurt/list.h>
 #include <gurt/hash.h>
-#include <gurt/heap.h>
+#include <gurt/twheel.h>
 #include <gurt/atomic.h>
 
 struct crt_hg_gdata;
@@ -45,6 +45,12 @@ struct crt_gdata {
 	uint32_t		cg_timeout;
 	/* credits limitation for #inflight RPCs per target EP CTX */
 	uint32_t		cg_credit_ep_ctx;
+	/* submit RPCs through the lock-free stack of the context */
+	bool			cg_submit_queue;
+	/* decode RPC inputs in place in the Mercury buffer */
+	bool			cg_proc_inplace;
+	/* flush deadline of the RPC batches in us, 0 to disable batching */
+	uint32_t		cg_batch_delay;
 
 	/* CaRT contexts list */
 	d_list_t		cg_ctx_list;
@@ -69,6 +75,12 @@ struct crt_gdata {
 				cg_auto_swim_disable	: 1;
 
 	ATOMIC uint64_t		cg_rpcid; /* rpc id */
+	/* # variable-length fields decoded in place, or allocated */
+	ATOMIC uint64_t		cg_proc_inplace_cnt;
+	ATOMIC uint64_t		cg_proc_alloc_cnt;
+	/* # envelopes received, and # RPCs they carried */
+	ATOMIC uint64_t		cg_batch_env_cnt;
+	ATOMIC uint64_t		cg_batch_rpc_cnt;
 
 	/* protects crt_gdata */
 	pthread_rwlock_t	cg_rwlock;
@@ -136,12 +148,33 @@ struct crt_context {
 	crt_rpc_task_t		 cc_iv_resp_cb;
 	/* in-flight endpoint tracking hash table */
 	struct d_hash_table	 cc_epi_table;
-	/* binheap for inflight RPC timeout tracking */
-	struct d_binheap	 cc_bh_timeout;
-	/* mutex to protect cc_epi_table and timeout binheap */
+	/* timing wheel for inflight RPC timeout tracking */
+	struct d_twheel		 cc_timeout_wheel;
+	/* mutex to protect cc_epi_table and timeout wheel */
 	pthread_mutex_t		 cc_mutex;
+	/*
+	 * Lock-free stack of the RPCs submitted and not tracked yet, linked
+	 * by crt_rpc_priv::crp_submit_next, see crt_context_req_submit().
+	 */
+	struct crt_rpc_priv	* ATOMIC cc_submit_head;
+	/*
+	 * RPCs popped from cc_submit_head and not sent yet, in submission
+	 * order, only modified with cc_submit_busy set
+	 */
+	struct crt_rpc_priv	* ATOMIC cc_submit_pend;
+	/* set while a thread drains cc_submit_head */
+	ATOMIC uint32_t		 cc_submit_busy;
 	/* timeout per-context */
 	uint32_t		 cc_timeout_sec;
+	/* helper progress threads, see crt_context_set_progress_threads() */
+	pthread_t		*cc_prog_threads;
+	uint32_t		 cc_prog_nr;
+	/* set to stop the helper progress threads */
+	ATOMIC uint32_t		 cc_prog_stop;
+	/* open RPC batches, by creation time, see crt_batch.c */
+	d_list_t		 cc_batch_list;
+	ATOMIC uint32_t		 cc_batch_nr;
+	pthread_mutex_t		 cc_batch_mutex;
 	/* Stores self uri for the current context */
 	char			 cc_self_uri[CRT_ADDR_STR_MAX_LEN];
 	/* provider on which context is allocated */
@@ -192,7 +225,8 @@ struct crt_opc_info {
 				 coi_coops_init:1,
 				 coi_no_reply:1, /* flag of one-way RPC */
 				 coi_queue_front:1, /* add to front of queue */
-				 coi_reset_timer:1; /* reset timer on timeout */
+				 coi_reset_timer:1, /* reset timer on timeout */
+				 coi_batch:1; /* may be sent in an envelope */
 
 	crt_rpc_cb_t		 coi_rpc_cb;
 	struct crt_corpc_ops	*coi_co_ops;
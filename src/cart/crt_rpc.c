@@ -130,7 +130,7 @@ CRT_RPC_DEFINE(crt_st_open_session,
 	       CRT_ISEQ_ST_SEND_SESSION, CRT_OSEQ_ST_REPLY_ID)
 
 CRT_RPC_DEFINE(crt_st_close_session,
-	       CRT_ISEQ_ST_SEND_ID, CRT_OSEQ_ST_REPLY_EMPTY)
+	       CRT_ISEQ_ST_SEND_ID, CRT_OSEQ_ST_CLOSE_SESSION)
 
 CRT_RPC_DEFINE(crt_st_start, CRT_ISEQ_ST_START, CRT_OSEQ_ST_START)
 
@@ -1221,6 +1221,11 @@ crt_req_send_immediately(struct crt_rpc_priv *rpc_priv)
 	D_ASSERT(rpc_priv != NULL);
 	D_ASSERT(rpc_priv->crp_hg_addr != NULL);
 
+	/* small RPCs may be packed in an envelope to the same endpoint */
+	rc = crt_batch_req_add(rpc_priv);
+	if (rc <= 0)
+		D_GOTO(out, rc);
+
 	req = &rpc_priv->crp_pub;
 	ctx = req->cr_ctx;
 	rc = crt_hg_req_create(&ctx->cc_hg_ctx, rpc_priv);
@@ -1314,6 +1319,34 @@ out:
 	return rc;
 }
 
+/* Track the RPC in its context and put it on the wire if it gets credits */
+int
+crt_req_submit(struct crt_rpc_priv *rpc_priv)
+{
+	int	rc;
+
+	rc = crt_context_req_track(rpc_priv);
+	if (rc == CRT_REQ_TRACK_IN_INFLIGHQ) {
+		/* tracked in crt_ep_inflight::epi_req_q */
+		rc = crt_req_send_internal(rpc_priv);
+		if (rc != 0) {
+			RPC_ERROR(rpc_priv,
+				  "crt_req_send_internal() failed, " DF_RC "\n",
+				  DP_RC(rc));
+			crt_context_req_untrack(rpc_priv);
+		}
+	} else if (rc == CRT_REQ_TRACK_IN_WAITQ) {
+		/* queued in crt_hg_context::dhc_req_q */
+		rc = 0;
+	} else {
+		RPC_ERROR(rpc_priv,
+			  "crt_context_req_track() failed, " DF_RC "\n",
+			  DP_RC(rc));
+	}
+
+	return rc;
+}
+
 int
 crt_req_send(crt_rpc_t *req, crt_cb_t complete_cb, void *arg)
 {
@@ -1367,25 +1400,14 @@ crt_req_send(crt_rpc_t *req, crt_cb_t complete_cb, void *arg)
 
 	RPC_TRACE(DB_TRACE, rpc_priv, "submitted.\n");
 
-	rc = crt_context_req_track(rpc_priv);
-	if (rc == CRT_REQ_TRACK_IN_INFLIGHQ) {
-		/* tracked in crt_ep_inflight::epi_req_q */
-		rc = crt_req_send_internal(rpc_priv);
-		if (rc != 0) {
-			RPC_ERROR(rpc_priv,
-				  "crt_req_send_internal() failed, " DF_RC "\n",
-				  DP_RC(rc));
-			crt_context_req_untrack(rpc_priv);
-		}
-	} else if (rc == CRT_REQ_TRACK_IN_WAITQ) {
-		/* queued in crt_hg_context::dhc_req_q */
-		rc = 0;
-	} else {
-		RPC_ERROR(rpc_priv,
-			  "crt_context_req_track() failed, " DF_RC "\n",
-			  DP_RC(rc));
+	/* errors of queued RPCs can only be reported by the callback */
+	if (crt_gdata.cg_submit_queue && complete_cb != NULL) {
+		crt_context_req_submit(rpc_priv);
+		D_GOTO(out, rc = 0);
 	}
 
+	rc = crt_req_submit(rpc_priv);
+
 out:
 	/* internally destroy the req when failed */
 	if (rc != 0) {
@@ -1428,6 +1450,11 @@ crt_reply_send(crt_rpc_t *req)
 		cb_info.cci_arg = rpc_priv;
 
 		crt_corpc_reply_hdlr(&cb_info);
+	} else if (rpc_priv->crp_batched) {
+		rc = crt_batch_reply_send(rpc_priv);
+		if (rc != 0)
+			D_ERROR("crt_batch_reply_send failed, rc: %d, "
+				"opc: %#x.\n", rc, rpc_priv->crp_pub.cr_opc);
 	} else {
 		D_DEBUG(DB_ALL, "call crt_hg_reply_send: rpc_priv: %p\n",
 			rpc_priv);
@@ -1455,6 +1482,13 @@ crt_req_abort(crt_rpc_t *req)
 
 	rpc_priv = container_of(req, struct crt_rpc_priv, crp_pub);
 
+	if (crt_context_req_submit_cancel(rpc_priv)) {
+		RPC_TRACE(DB_NET, rpc_priv,
+			  "queued for submission, complete it as canceled.\n");
+		crt_rpc_complete(rpc_priv, -DER_CANCELED);
+		D_GOTO(out, rc = 0);
+	}
+
 	if (rpc_priv->crp_state == RPC_STATE_CANCELED ||
 	    rpc_priv->crp_state == RPC_STATE_COMPLETED) {
 		RPC_TRACE(DB_NET, rpc_priv,
@@ -1472,6 +1506,11 @@ crt_req_abort(crt_rpc_t *req)
 		D_GOTO(out, rc = 0);
 	}
 
+	if (rpc_priv->crp_batched) {
+		rc = crt_batch_req_abort(rpc_priv);
+		D_GOTO(out, rc);
+	}
+
 	rc = crt_hg_req_cancel(rpc_priv);
 	if (rc != 0) {
 		RPC_ERROR(rpc_priv, "crt_hg_req_cancel failed, rc: %d, "
@@ -1695,57 +1734,6 @@ out:
 	return rc;
 }
 
-static int
-timeout_bp_node_enter(struct d_binheap *h, struct d_binheap_node *e)
-{
-	struct crt_rpc_priv	*rpc_priv;
-
-	D_ASSERT(h != NULL);
-	D_ASSERT(e != NULL);
-
-	rpc_priv = container_of(e, struct crt_rpc_priv, crp_timeout_bp_node);
-
-	RPC_TRACE(DB_NET, rpc_priv, "entering the timeout binheap.\n");
-
-	return 0;
-}
-
-static int
-timeout_bp_node_exit(struct d_binheap *h, struct d_binheap_node *e)
-{
-	struct crt_rpc_priv	*rpc_priv;
-
-	D_ASSERT(h != NULL);
-	D_ASSERT(e != NULL);
-
-	rpc_priv = container_of(e, struct crt_rpc_priv, crp_timeout_bp_node);
-
-	RPC_TRACE(DB_NET, rpc_priv, "exiting the timeout binheap.\n");
-
-	return 0;
-}
-
-static bool
-timeout_bp_node_cmp(struct d_binheap_node *a, struct d_binheap_node *b)
-{
-	struct crt_rpc_priv	*rpc_priv_a;
-	struct crt_rpc_priv	*rpc_priv_b;
-
-	D_ASSERT(a != NULL);
-	D_ASSERT(b != NULL);
-
-	rpc_priv_a = container_of(a, struct crt_rpc_priv, crp_timeout_bp_node);
-	rpc_priv_b = container_of(b, struct crt_rpc_priv, crp_timeout_bp_node);
-
-	return rpc_priv_a->crp_timeout_ts < rpc_priv_b->crp_timeout_ts;
-}
-
-struct d_binheap_ops crt_timeout_bh_ops = {
-	.hop_enter	= timeout_bp_node_enter,
-	.hop_exit	= timeout_bp_node_exit,
-	.hop_compare	= timeout_bp_node_cmp
-};
-
 int
 crt_req_src_rank_get(crt_rpc_t *rpc, d_rank_t *rank)
 {
@@ -11,17 +11,17 @@
 #ifndef __CRT_RPC_H__
 #define __CRT_RPC_H__
 
-#include <gurt/heap.h>
+#include <gurt/twheel.h>
 #include "gurt/common.h"
 
 /* default RPC timeout 60 seconds */
 #define CRT_DEFAULT_TIMEOUT_S	(60) /* second */
 #define CRT_DEFAULT_TIMEOUT_US	(CRT_DEFAULT_TIMEOUT_S * 1e6) /* micro-second */
+#define CRT_TIMEOUT_TICK_US	(1000) /* timeout wheel granularity */
 
 /* uri lookup max retry times */
 #define CRT_URI_LOOKUP_RETRY_MAX	(8)
 
-extern struct d_binheap_ops crt_timeout_bh_ops;
 void crt_hdlr_rank_evict(crt_rpc_t *rpc_req);
 void crt_hdlr_memb_sample(crt_rpc_t *rpc_req);
 
@@ -82,6 +82,8 @@ typedef enum {
 	RPC_STATE_ADDR_LOOKUP,
 	RPC_STATE_URI_LOOKUP,
 	RPC_STATE_FWD_UNREACH,
+	/* on crt_context::cc_submit_head, not tracked yet */
+	RPC_STATE_SUBMIT_QUEUED,
 } crt_rpc_state_t;
 
 /* corpc info to track the tree topo and child RPCs info */
@@ -119,6 +121,49 @@ struct crt_corpc_info {
 	int			 co_rc;
 };
 
+/* max # RPCs packed in one envelope */
+#define CRT_BATCH_NR_MAX	(32)
+/* max encoded size of a batched request, or of its reply */
+#define CRT_BATCH_MSG_MAX	(512)
+/* max size of the packed requests, or replies, of one envelope */
+#define CRT_BATCH_SIZE_MAX	(3072)
+/* max delay before an open envelope is sent (micro-second) */
+#define CRT_BATCH_DELAY_MAX	(10000)
+
+/* envelope entry, one per batched RPC */
+struct crt_batch_ent {
+	/* the batched RPC, referenced until the envelope completes */
+	struct crt_rpc_priv	*be_rpc;
+	/* its encoded reply, on the target */
+	d_iov_t			 be_reply;
+};
+
+/*
+ * Envelope of small RPCs to the same endpoint, sent as one CRT_OPC_BATCH
+ * request, see crt_batch.c.
+ */
+struct crt_batch {
+	/* link to crt_context::cc_batch_list while the batch is open */
+	d_list_t		 cb_link;
+	struct crt_context	*cb_ctx;
+	crt_endpoint_t		 cb_ep;
+	/* time to send the batch at, in us */
+	uint64_t		 cb_deadline;
+	/* max timeout of the batched RPCs, in seconds */
+	uint32_t		 cb_timeout_sec;
+	/* packed requests */
+	char			*cb_buf;
+	size_t			 cb_size;
+	/* the envelope RPC, on the target */
+	struct crt_rpc_priv	*cb_env;
+	/* # replies the target still waits for, plus one while dispatching */
+	ATOMIC uint32_t		 cb_pending;
+	/* bytes of the replies beyond their header, on the target */
+	ATOMIC uint32_t		 cb_reply_size;
+	uint32_t		 cb_nr;
+	struct crt_batch_ent	 cb_ents[0];
+};
+
 struct crt_rpc_priv {
 	crt_rpc_t		crp_pub; /* public part */
 	/* link to crt_ep_inflight::epi_req_q/::epi_req_waitq */
@@ -127,18 +172,36 @@ struct crt_rpc_priv {
 	d_list_t		crp_tmp_link;
 	/* link to parent RPC crp_opc_info->co_child_rpcs/co_replied_rpcs */
 	d_list_t		crp_parent_link;
-	/* binheap node for timeout management, in crt_context::cc_bh_timeout */
-	struct d_binheap_node	crp_timeout_bp_node;
+	/* node for timeout management, in crt_context::cc_timeout_wheel */
+	struct d_twheel_node	crp_timeout_node;
 	/* the timeout in seconds set by user */
 	uint32_t		crp_timeout_sec;
-	/* time stamp to be timeout, the key of timeout binheap */
+	/* time stamp to be timeout, the key of timeout wheel */
 	uint64_t		crp_timeout_ts;
 	crt_cb_t		crp_complete_cb;
 	void			*crp_arg; /* argument for crp_complete_cb */
 	struct crt_ep_inflight	*crp_epi; /* point back to inflight ep */
+	/* next RPC in crt_context::cc_submit_head */
+	struct crt_rpc_priv	*crp_submit_next;
+	/* envelope the RPC is packed in until it is replied, see crt_batch.c */
+	struct crt_batch	*crp_batch;
+	/* index of the RPC in crp_batch */
+	uint32_t		 crp_batch_idx;
+	/*
+	 * envelope a batched RPC was received in, referenced until the RPC is
+	 * destroyed as its input points in the envelope input and its bulk
+	 * transfers go through the HG handle of the envelope
+	 */
+	struct crt_rpc_priv	*crp_batch_env;
 
 	crt_rpc_state_t		crp_state; /* RPC state */
 	hg_handle_t		crp_hg_hdl; /* HG request handle */
+	/*
+	 * HG input buffer the input is decoded in place in, NULL if it is
+	 * not, see crt_proc_buf()
+	 */
+	void			*crp_in_buf;
+	size_t			crp_in_buf_size;
 	hg_addr_t		crp_hg_addr; /* target na address */
 	struct crt_hg_hdl	*crp_hdl_reuse; /* reused hg_hdl */
 	crt_phy_addr_t		crp_tgt_uri; /* target uri address */
@@ -163,8 +226,8 @@ struct crt_rpc_priv {
 				crp_uri_free:1,
 				/* flag of forwarded rpc for corpc */
 				crp_forward:1,
-				/* flag of in timeout binheap */
-				crp_in_binheap:1,
+				/* flag of in timeout wheel */
+				crp_in_twheel:1,
 				/* set if a call to crt_req_reply pending */
 				crp_reply_pending:1,
 				/* set to 1 if target ep is set */
@@ -174,7 +237,9 @@ struct crt_rpc_priv {
 				/* 1 if RPC is successfully put on the wire */
 				crp_on_wire:1,
 				/* 1 if RPC fails HLC epsilon check */
-				crp_fail_hlc:1;
+				crp_fail_hlc:1,
+				/* 1 if RPC is packed in an envelope */
+				crp_batched:1;
 	uint32_t		crp_refcount;
 	struct crt_opc_info	*crp_opc_info;
 	/* corpc info, only valid when (crp_coll == 1) */
@@ -185,9 +250,9 @@ struct crt_rpc_priv {
 	struct crt_corpc_hdr	crp_coreq_hdr; /* collective request header */
 };
 
-#define CRT_PROTO_INTERNAL_VERSION 4
+#define CRT_PROTO_INTERNAL_VERSION 5
 #define CRT_PROTO_FI_VERSION 2
-#define CRT_PROTO_ST_VERSION 1
+#define CRT_PROTO_ST_VERSION 3
 #define CRT_PROTO_CTL_VERSION 1
 #define CRT_PROTO_IV_VERSION 1
 
@@ -207,6 +272,9 @@ struct crt_rpc_priv {
 	X(CRT_OPC_CTL_LS,						\
 		0, &CQF_crt_ctl_ep_ls,					\
 		crt_hdlr_ctl_ls, NULL)					\
+	X(CRT_OPC_BATCH,						\
+		0, &CQF_crt_batch,					\
+		crt_hdlr_batch, NULL)					\
 
 #define CRT_FI_RPCS_LIST						\
 	X(CRT_OPC_CTL_FI_TOGGLE,					\
@@ -218,16 +286,16 @@ struct crt_rpc_priv {
 
 #define CRT_ST_RPCS_LIST						\
 	X(CRT_OPC_SELF_TEST_BOTH_EMPTY,					\
-		0, NULL,						\
+		CRT_RPC_FEAT_BATCH, NULL,				\
 		crt_self_test_msg_handler, NULL)			\
 	X(CRT_OPC_SELF_TEST_SEND_ID_REPLY_IOV,				\
-		0, &CQF_crt_st_send_id_reply_iov,			\
+		CRT_RPC_FEAT_BATCH, &CQF_crt_st_send_id_reply_iov,	\
 		crt_self_test_msg_handler, NULL)			\
 	X(CRT_OPC_SELF_TEST_SEND_IOV_REPLY_EMPTY,			\
-		0, &CQF_crt_st_send_iov_reply_empty,			\
+		CRT_RPC_FEAT_BATCH, &CQF_crt_st_send_iov_reply_empty,	\
 		crt_self_test_msg_handler, NULL)			\
 	X(CRT_OPC_SELF_TEST_BOTH_IOV,					\
-		0, &CQF_crt_st_both_iov,				\
+		CRT_RPC_FEAT_BATCH, &CQF_crt_st_both_iov,		\
 		crt_self_test_msg_handler, NULL)			\
 	X(CRT_OPC_SELF_TEST_SEND_BULK_REPLY_IOV,			\
 		0, &CQF_crt_st_send_bulk_reply_iov,			\
@@ -270,10 +338,10 @@ struct crt_rpc_priv {
 
 #define CRT_IV_RPCS_LIST						\
 	X(CRT_OPC_IV_FETCH,						\
-		0, &CQF_crt_iv_fetch,					\
+		CRT_RPC_FEAT_BATCH, &CQF_crt_iv_fetch,			\
 		crt_hdlr_iv_fetch, NULL)				\
 	X(CRT_OPC_IV_UPDATE,						\
-		0, &CQF_crt_iv_update,					\
+		CRT_RPC_FEAT_BATCH, &CQF_crt_iv_update,			\
 		crt_hdlr_iv_update, NULL)				\
 	X(CRT_OPC_IV_SYNC,						\
 		0, &CQF_crt_iv_sync,					\
@@ -351,6 +419,17 @@ CRT_GEN_STRUCT(crt_grp_cache, CRT_SEQ_GRP_CACHE)
 
 CRT_RPC_DECLARE(crt_uri_lookup, CRT_ISEQ_URI_LOOKUP, CRT_OSEQ_URI_LOOKUP)
 
+/* the messages are packed as a 32-bit length followed by the message */
+#define CRT_ISEQ_BATCH		/* input fields */		 \
+	((uint32_t)		(bi_nr)			CRT_VAR) \
+	((d_iov_t)		(bi_msgs)		CRT_VAR)
+
+#define CRT_OSEQ_BATCH		/* output fields */		 \
+	((d_iov_t)		(bo_replies)		CRT_VAR) \
+	((int32_t)		(bo_rc)			CRT_VAR)
+
+CRT_RPC_DECLARE(crt_batch, CRT_ISEQ_BATCH, CRT_OSEQ_BATCH)
+
 #define CRT_ISEQ_ST_SEND_ID	/* input fields */		 \
 	((uint64_t)		(unused1)		CRT_VAR)
 
@@ -402,8 +481,15 @@ CRT_RPC_DECLARE(crt_st_both_bulk,
 CRT_RPC_DECLARE(crt_st_open_session,
 		CRT_ISEQ_ST_SEND_SESSION, CRT_OSEQ_ST_REPLY_ID)
 
+/* input decodes and envelopes on the endpoint while the session was open */
+#define CRT_OSEQ_ST_CLOSE_SESSION /* output fields */		 \
+	((uint64_t)		(proc_inplace)		CRT_VAR) \
+	((uint64_t)		(proc_alloc)		CRT_VAR) \
+	((uint64_t)		(batch_envs)		CRT_VAR) \
+	((uint64_t)		(batch_rpcs)		CRT_VAR)
+
 CRT_RPC_DECLARE(crt_st_close_session,
-		CRT_ISEQ_ST_SEND_ID, CRT_OSEQ_ST_REPLY_EMPTY)
+		CRT_ISEQ_ST_SEND_ID, CRT_OSEQ_ST_CLOSE_SESSION)
 
 #define CRT_ISEQ_ST_START	/* input fields */		 \
 	((crt_group_id_t)	(unused1)		CRT_VAR) \
@@ -424,6 +510,11 @@ CRT_RPC_DECLARE(crt_st_start, CRT_ISEQ_ST_START, CRT_OSEQ_ST_START)
 
 #define CRT_OSEQ_ST_STATUS_REQ	/* output fields */		 \
 	((uint64_t)		(test_duration_ns)	CRT_VAR) \
+	((uint64_t)		(proc_inplace)		CRT_VAR) \
+	((uint64_t)		(proc_alloc)		CRT_VAR) \
+	((uint64_t)		(batch_envs)		CRT_VAR) \
+	((uint64_t)		(batch_rpcs)		CRT_VAR) \
+	((uint64_t)		(cpu_ns)		CRT_VAR) \
 	((uint32_t)		(num_remaining)		CRT_VAR) \
 	((int32_t)		(status)		CRT_VAR)
 
@@ -632,6 +723,7 @@ int crt_req_create_internal(crt_context_t crt_ctx, crt_endpoint_t *tgt_ep,
 int crt_internal_rpc_register(bool server);
 int crt_rpc_common_hdlr(struct crt_rpc_priv *rpc_priv);
 int crt_req_send_internal(struct crt_rpc_priv *rpc_priv);
+int crt_req_submit(struct crt_rpc_priv *rpc_priv);
 
 static inline bool
 crt_req_timedout(struct crt_rpc_priv *rpc_priv)
@@ -641,7 +733,7 @@ crt_req_timedout(struct crt_rpc_priv *rpc_priv)
 		rpc_priv->crp_state == RPC_STATE_ADDR_LOOKUP ||
 		rpc_priv->crp_state == RPC_STATE_TIMEOUT ||
 		rpc_priv->crp_state == RPC_STATE_FWD_UNREACH) &&
-	       !rpc_priv->crp_in_binheap;
+	       !rpc_priv->crp_in_twheel;
 }
 
 static inline uint64_t
@@ -669,6 +761,14 @@ void crt_corpc_reply_hdlr(const struct crt_cb_info *cb_info);
 int crt_corpc_common_hdlr(struct crt_rpc_priv *rpc_priv);
 void crt_corpc_info_fini(struct crt_rpc_priv *rpc_priv);
 
+/* crt_batch.c */
+int crt_batch_req_add(struct crt_rpc_priv *rpc_priv);
+int crt_batch_req_abort(struct crt_rpc_priv *rpc_priv);
+int crt_batch_reply_send(struct crt_rpc_priv *rpc_priv);
+void crt_batch_req_free(struct crt_rpc_priv *rpc_priv);
+int64_t crt_batch_flush(struct crt_context *ctx, bool all);
+void crt_hdlr_batch(crt_rpc_t *rpc_req);
+
 /* crt_iv.c */
 void crt_hdlr_iv_fetch(crt_rpc_t *rpc_req);
 void crt_hdlr_iv_update(crt_rpc_t *rpc_req);
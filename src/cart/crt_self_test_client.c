@@ -82,6 +82,9 @@ struct st_g_data {
 	/* Start / stop times for this test run */
 	struct timespec			  time_start;
 	struct timespec			  time_stop;
+	/* CPU time of the process at the same points */
+	struct timespec			  cpu_start;
+	struct timespec			  cpu_stop;
 
 	/* Used to protect the following counters across threads */
 	pthread_spinlock_t		  ctr_lock;
@@ -89,6 +92,20 @@ struct st_g_data {
 	/* Set to nonzero only after the entire test cycle has completed */
 	uint32_t			  test_complete;
 
+	/*
+	 * Input decodes done in place / with an allocation by the endpoints
+	 * NOTE: Write-protected by ctr_lock
+	 */
+	uint64_t			  proc_inplace;
+	uint64_t			  proc_alloc;
+
+	/*
+	 * Envelopes and the RPCs packed in them received by the endpoints
+	 * NOTE: Write-protected by ctr_lock
+	 */
+	uint64_t			  batch_envs;
+	uint64_t			  batch_rpcs;
+
 	/*
 	 * Used to track how many RPCs have been sent so far
 	 * NOTE: Read/Write-protected by ctr_lock
@@ -169,14 +186,26 @@ void crt_self_test_client_fini(void)
 static void
 close_session_cb(const struct crt_cb_info *cb_info)
 {
-	struct st_test_endpt	*endpt = cb_info->cci_arg;
+	struct st_test_endpt		*endpt = cb_info->cci_arg;
+	struct crt_st_close_session_out	*res;
 
 	D_ASSERT(endpt != NULL);
 	D_ASSERT(g_data != NULL);
 
-	if (cb_info->cci_rc != 0)
+	if (cb_info->cci_rc != 0) {
 		D_WARN("Close session failed for endpoint=%u:%u\n",
 		       endpt->rank, endpt->tag);
+	} else {
+		res = crt_reply_get(cb_info->cci_rpc);
+		D_ASSERT(res != NULL);
+
+		D_SPIN_LOCK(&g_data->ctr_lock);
+		g_data->proc_inplace += res->proc_inplace;
+		g_data->proc_alloc += res->proc_alloc;
+		g_data->batch_envs += res->batch_envs;
+		g_data->batch_rpcs += res->batch_rpcs;
+		D_SPIN_UNLOCK(&g_data->ctr_lock);
+	}
 
 	/* Decrement the number of inflight RPCs now that this one is done */
 	ST_DEC_NUM_INFLIGHT();
@@ -507,6 +536,7 @@ abort:
 		ret = d_gettime(&g_data->time_stop);
 		if (ret != 0)
 			D_ERROR("d_gettime failed; ret = %d\n", ret);
+		clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &g_data->cpu_stop);
 
 		close_sessions();
 	}
@@ -575,6 +605,7 @@ static void launch_test_rpcs(void)
 	D_ASSERT(g_data->max_inflight > 0);
 
 	/* Record the time right when we start processing this size */
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &g_data->cpu_start);
 	ret = d_gettime(&g_data->time_start);
 	if (ret != 0) {
 		D_ERROR("d_gettime failed; ret = %d\n", ret);
@@ -1025,6 +1056,11 @@ static int status_req_bulk_put_cb(const struct crt_bulk_cb_info *cb_info)
 	res->num_remaining = 0;
 	res->test_duration_ns =
 		d_timediff_ns(&g_data->time_start, &g_data->time_stop);
+	res->proc_inplace = g_data->proc_inplace;
+	res->proc_alloc = g_data->proc_alloc;
+	res->batch_envs = g_data->batch_envs;
+	res->batch_rpcs = g_data->batch_rpcs;
+	res->cpu_ns = d_timediff_ns(&g_data->cpu_start, &g_data->cpu_stop);
 	gethostname(hostname, 1024);
 	res->status = CRT_ST_STATUS_TEST_COMPLETE;
 
@@ -1071,6 +1107,11 @@ crt_self_test_status_req_handler(crt_rpc_t *rpc_req)
 
 	/* Default response values if no test data is available */
 	res->test_duration_ns = -1;
+	res->proc_inplace = 0;
+	res->proc_alloc = 0;
+	res->batch_envs = 0;
+	res->batch_rpcs = 0;
+	res->cpu_ns = 0;
 	res->num_remaining = UINT32_MAX;
 	res->status = CRT_ST_STATUS_INVAL;
 
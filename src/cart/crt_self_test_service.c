@@ -48,6 +48,13 @@ struct st_session {
 	/** Lock to protect the list head pointer */
 	pthread_spinlock_t		 buf_list_lock;
 
+	/** Input decode counters of CaRT when the session was opened */
+	uint64_t			 proc_inplace;
+	uint64_t			 proc_alloc;
+	/** Batching counters of CaRT when the session was opened */
+	uint64_t			 batch_envs;
+	uint64_t			 batch_rpcs;
+
 	/** Pointer to the next session in the session list */
 	struct st_session		*next;
 };
@@ -369,6 +376,14 @@ crt_self_test_open_session_handler(crt_rpc_t *rpc_req)
 	} else {
 		/* Success - found an unused session ID */
 		new_session->session_id = session_id;
+		new_session->proc_inplace =
+			atomic_load_relaxed(&crt_gdata.cg_proc_inplace_cnt);
+		new_session->proc_alloc =
+			atomic_load_relaxed(&crt_gdata.cg_proc_alloc_cnt);
+		new_session->batch_envs =
+			atomic_load_relaxed(&crt_gdata.cg_batch_env_cnt);
+		new_session->batch_rpcs =
+			atomic_load_relaxed(&crt_gdata.cg_batch_rpc_cnt);
 		g_last_session_id = session_id;
 		*reply_session_id = session_id;
 
@@ -395,16 +410,20 @@ send_rpc:
 void
 crt_self_test_close_session_handler(crt_rpc_t *rpc_req)
 {
-	int64_t			*args;
-	struct st_session	*del_session;
-	struct st_session	**prev;
-	int64_t			 session_id;
-	int			 ret;
+	int64_t				*args;
+	struct crt_st_close_session_out	*res;
+	struct st_session		*del_session;
+	struct st_session		**prev;
+	int64_t				 session_id;
+	int				 ret;
 
 	args = crt_req_get(rpc_req);
 	D_ASSERT(args != NULL);
 	session_id = *args;
 
+	res = crt_reply_get(rpc_req);
+	D_ASSERT(res != NULL);
+
 	/******************** LOCK: g_all_session_lock (w) ********************/
 	D_RWLOCK_WRLOCK(&g_all_session_lock);
 
@@ -418,6 +437,22 @@ crt_self_test_close_session_handler(crt_rpc_t *rpc_req)
 	/* Remove the session from the list of active sessions */
 	*prev = del_session->next;
 
+	/* Report the input decodes done during the session */
+	res->proc_inplace =
+		atomic_load_relaxed(&crt_gdata.cg_proc_inplace_cnt) -
+		del_session->proc_inplace;
+	res->proc_alloc =
+		atomic_load_relaxed(&crt_gdata.cg_proc_alloc_cnt) -
+		del_session->proc_alloc;
+
+	/* Report the envelopes received during the session */
+	res->batch_envs =
+		atomic_load_relaxed(&crt_gdata.cg_batch_env_cnt) -
+		del_session->batch_envs;
+	res->batch_rpcs =
+		atomic_load_relaxed(&crt_gdata.cg_batch_rpc_cnt) -
+		del_session->batch_rpcs;
+
 	D_RWLOCK_UNLOCK(&g_all_session_lock);
 	/******************* UNLOCK: g_all_session_lock *******************/
 
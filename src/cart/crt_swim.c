@@ -13,7 +13,7 @@
 #include "crt_internal.h"
 #include "swim/swim_internal.h"
 
-#define CRT_OPC_SWIM_VERSION	1
+#define CRT_OPC_SWIM_VERSION	3
 #define CRT_SWIM_FAIL_BASE	((CRT_OPC_SWIM_BASE >> 16) | \
 				 (CRT_OPC_SWIM_VERSION << 4))
 #define CRT_SWIM_FAIL_DROP_RPC	(CRT_SWIM_FAIL_BASE | 0x1)	/* id: 65025 */
@@ -35,11 +35,62 @@
 #define CRT_OSEQ_RPC_SWIM	/* output fields */		 \
 	((int32_t)		     (rc)		CRT_VAR)
 
+/*
+ * Compact update on the wire: the member IDs are ranks, and the status is
+ * packed with the delay, so that an update takes 20 bytes instead of 32.
+ */
+#define CRT_SWIM_STATUS_SHIFT	30
+#define CRT_SWIM_DELAY_MASK	((1U << CRT_SWIM_STATUS_SHIFT) - 1)
+
 static inline int
 crt_proc_struct_swim_member_update(crt_proc_t proc,
 				   struct swim_member_update *data)
 {
-	return crt_proc_memcpy(proc, data, sizeof(*data));
+	crt_proc_op_t	proc_op;
+	d_rank_t	rank = 0;
+	d_rank_t	origin = CRT_NO_RANK;
+	uint32_t	status_delay = 0;
+	int		rc;
+
+	rc = crt_proc_get_op(proc, &proc_op);
+	if (rc)
+		return rc;
+	if (proc_op == CRT_PROC_FREE)
+		return 0;
+
+	if (proc_op == CRT_PROC_ENCODE) {
+		rank = data->smu_id;
+		if (data->smu_origin != SWIM_ID_INVALID)
+			origin = data->smu_origin;
+		status_delay = min(data->smu_state.sms_delay,
+				   CRT_SWIM_DELAY_MASK) |
+			       data->smu_state.sms_status <<
+			       CRT_SWIM_STATUS_SHIFT;
+	}
+
+	rc = crt_proc_d_rank_t(proc, &rank);
+	if (rc)
+		return rc;
+	rc = crt_proc_uint64_t(proc, &data->smu_state.sms_incarnation);
+	if (rc)
+		return rc;
+	rc = crt_proc_uint32_t(proc, &status_delay);
+	if (rc)
+		return rc;
+	rc = crt_proc_d_rank_t(proc, &origin);
+	if (rc)
+		return rc;
+
+	if (proc_op == CRT_PROC_DECODE) {
+		data->smu_id = rank;
+		data->smu_origin = origin == CRT_NO_RANK ?
+				   SWIM_ID_INVALID : origin;
+		data->smu_state.sms_status = status_delay >>
+					     CRT_SWIM_STATUS_SHIFT;
+		data->smu_state.sms_delay = status_delay & CRT_SWIM_DELAY_MASK;
+	}
+
+	return 0;
 }
 
 /* One way RPC */
@@ -99,12 +150,14 @@ static void crt_swim_srv_cb(crt_rpc_t *rpc_req);
 static struct crt_proto_rpc_format crt_swim_proto_rpc_fmt[] = {
 	{
 		.prf_flags	= CRT_RPC_FEAT_QUEUE_FRONT |
-				  CRT_RPC_FEAT_NO_REPLY,
+				  CRT_RPC_FEAT_NO_REPLY |
+				  CRT_RPC_FEAT_BATCH,
 		.prf_req_fmt	= &CQF_crt_rpc_swim,
 		.prf_hdlr	= crt_swim_srv_cb,
 		.prf_co_ops	= NULL,
 	}, {
-		.prf_flags	= CRT_RPC_FEAT_QUEUE_FRONT,
+		.prf_flags	= CRT_RPC_FEAT_QUEUE_FRONT |
+				  CRT_RPC_FEAT_BATCH,
 		.prf_req_fmt	= &CQF_crt_rpc_swim_wack,
 		.prf_hdlr	= crt_swim_srv_cb,
 		.prf_co_ops	= NULL,
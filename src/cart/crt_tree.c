@@ -81,6 +81,17 @@ out:
 	return rc;
 }
 
+/* fault domains of the ranks of the tree, only the domain tree needs them */
+static inline int
+crt_tree_get_doms(struct crt_grp_priv *grp_priv, uint32_t tree_type,
+		  d_rank_list_t *grp_rank_list, uint32_t **grp_doms)
+{
+	*grp_doms = NULL;
+	if (tree_type != CRT_TREE_DOMAIN)
+		return 0;
+
+	return crt_grp_doms_get(grp_priv, grp_rank_list, grp_doms);
+}
 
 #define CRT_TREE_PARAMETER_CHECKING(grp_priv, tree_topo, root, self)	\
 	do {								\
@@ -110,6 +121,7 @@ crt_tree_get_nchildren(struct crt_grp_priv *grp_priv, uint32_t grp_ver,
 		       d_rank_t root, d_rank_t self, uint32_t *nchildren)
 {
 	d_rank_list_t		*grp_rank_list = NULL;
+	uint32_t		*grp_doms = NULL;
 	d_rank_t		 grp_root, grp_self;
 	bool			 allocated = false;
 	uint32_t		 tree_type, tree_ratio;
@@ -146,9 +158,13 @@ crt_tree_get_nchildren(struct crt_grp_priv *grp_priv, uint32_t grp_ver,
 		D_GOTO(out, rc = -DER_INVAL);
 	}
 
+	rc = crt_tree_get_doms(grp_priv, tree_type, grp_rank_list, &grp_doms);
+	if (rc != 0)
+		D_GOTO(out, rc);
+
 	tops = crt_tops[tree_type];
-	rc = tops->to_get_children_cnt(grp_size, tree_ratio, grp_root, grp_self,
-				       nchildren);
+	rc = tops->to_get_children_cnt(grp_size, tree_ratio, grp_doms, grp_root,
+				       grp_self, nchildren);
 	if (rc != 0)
 		D_ERROR("to_get_children_cnt (group %s, root %d, self %d) "
 			"failed, rc: %d.\n", grp_priv->gp_pub.cg_grpid,
@@ -156,6 +172,7 @@ crt_tree_get_nchildren(struct crt_grp_priv *grp_priv, uint32_t grp_ver,
 
 out:
 	D_RWLOCK_UNLOCK(&grp_priv->gp_rwlock);
+	D_FREE(grp_doms);
 	if (allocated)
 		d_rank_list_free(grp_rank_list);
 	return rc;
@@ -175,6 +192,7 @@ crt_tree_get_children(struct crt_grp_priv *grp_priv, uint32_t grp_ver,
 		      d_rank_list_t **children_rank_list, bool *ver_match)
 {
 	d_rank_list_t		*grp_rank_list = NULL;
+	uint32_t		*grp_doms = NULL;
 	d_rank_list_t		*result_rank_list = NULL;
 	d_rank_t		 grp_root, grp_self;
 	bool			 allocated = false;
@@ -225,10 +243,14 @@ crt_tree_get_children(struct crt_grp_priv *grp_priv, uint32_t grp_ver,
 		D_GOTO(out, rc);
 	}
 
+	rc = crt_tree_get_doms(grp_priv, tree_type, grp_rank_list, &grp_doms);
+	if (rc != 0)
+		D_GOTO(out, rc);
+
 	tops = crt_tops[tree_type];
 
-	rc = tops->to_get_children_cnt(grp_size, tree_ratio, grp_root, grp_self,
-				       &nchildren);
+	rc = tops->to_get_children_cnt(grp_size, tree_ratio, grp_doms, grp_root,
+				       grp_self, &nchildren);
 	if (rc != 0) {
 		D_ERROR("to_get_children_cnt (group %s, root %d, self %d) "
 			"failed, rc: %d.\n", grp_priv->gp_pub.cg_grpid,
@@ -248,8 +270,8 @@ crt_tree_get_children(struct crt_grp_priv *grp_priv, uint32_t grp_ver,
 		d_rank_list_free(result_rank_list);
 		D_GOTO(out, rc = -DER_NOMEM);
 	}
-	rc = tops->to_get_children(grp_size, tree_ratio, grp_root, grp_self,
-				   tree_children);
+	rc = tops->to_get_children(grp_size, tree_ratio, grp_doms, grp_root,
+				   grp_self, tree_children);
 	if (rc != 0) {
 		D_ERROR("to_get_children (group %s, root %d, self %d) "
 			"failed, rc: %d.\n", grp_priv->gp_pub.cg_grpid,
@@ -268,6 +290,7 @@ crt_tree_get_children(struct crt_grp_priv *grp_priv, uint32_t grp_ver,
 
 out:
 	D_RWLOCK_UNLOCK(&grp_priv->gp_rwlock);
+	D_FREE(grp_doms);
 	if (allocated)
 		d_rank_list_free(grp_rank_list);
 	return rc;
@@ -279,6 +302,7 @@ crt_tree_get_parent(struct crt_grp_priv *grp_priv, uint32_t grp_ver,
 		    d_rank_t root, d_rank_t self, d_rank_t *parent_rank)
 {
 	d_rank_list_t		*grp_rank_list = NULL;
+	uint32_t		*grp_doms = NULL;
 	d_rank_t		 grp_root, grp_self;
 	bool			 allocated = false;
 	uint32_t		 tree_type, tree_ratio;
@@ -315,9 +339,13 @@ crt_tree_get_parent(struct crt_grp_priv *grp_priv, uint32_t grp_ver,
 		D_GOTO(out, rc = -DER_INVAL);
 	}
 
+	rc = crt_tree_get_doms(grp_priv, tree_type, grp_rank_list, &grp_doms);
+	if (rc != 0)
+		D_GOTO(out, rc);
+
 	tops = crt_tops[tree_type];
-	rc = tops->to_get_parent(grp_size, tree_ratio, grp_root, grp_self,
-				 &tree_parent);
+	rc = tops->to_get_parent(grp_size, tree_ratio, grp_doms, grp_root,
+				 grp_self, &tree_parent);
 	if (rc != 0) {
 		D_ERROR("to_get_parent (group %s, root %d, self %d) failed, "
 			"rc: %d.\n", grp_priv->gp_pub.cg_grpid, root, self, rc);
@@ -327,6 +355,7 @@ crt_tree_get_parent(struct crt_grp_priv *grp_priv, uint32_t grp_ver,
 
 out:
 	D_RWLOCK_UNLOCK(&grp_priv->gp_rwlock);
+	D_FREE(grp_doms);
 	if (allocated)
 		d_rank_list_free(grp_rank_list);
 	return rc;
@@ -337,4 +366,5 @@ struct crt_topo_ops *crt_tops[] = {
 	&crt_flat_ops,		/* CRT_TREE_FLAT */
 	&crt_kary_ops,		/* CRT_TREE_KARY */
 	&crt_knomial_ops,	/* CRT_TREE_KNOMIAL */
+	&crt_domain_ops,	/* CRT_TREE_DOMAIN */
 };
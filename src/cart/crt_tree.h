@@ -44,18 +44,22 @@ int crt_tree_get_parent(struct crt_grp_priv *grp_priv, uint32_t grp_ver,
  *    assume group_root is the group rank of the root in the tree topo, then:
  *    tree_rank  = (group_rank - group_root + group_size) % (group_size)
  *    group_rank = (tree_rank + group_root) % (group_size)
+ *
+ * grp_doms, only passed for CRT_TREE_DOMAIN, is the fault domain of each group
+ * rank (CRT_NO_DOMAIN if unknown), or NULL if the group has no domains set.
  */
 typedef int (*crt_topo_get_children_cnt_t)(uint32_t grp_size,
 					   uint32_t branch_ratio,
+					   uint32_t *grp_doms,
 					   uint32_t grp_root,
 					   uint32_t grp_self,
 					   uint32_t *nchildren);
 typedef int (*crt_topo_get_children_t)(uint32_t grp_size, uint32_t branch_ratio,
-				       uint32_t grp_root, uint32_t grp_self,
-				       uint32_t *children);
+				       uint32_t *grp_doms, uint32_t grp_root,
+				       uint32_t grp_self, uint32_t *children);
 typedef int (*crt_topo_get_parent_t)(uint32_t grp_size, uint32_t branch_ratio,
-				     uint32_t grp_root, uint32_t grp_self,
-				     uint32_t *parent);
+				     uint32_t *grp_doms, uint32_t grp_root,
+				     uint32_t grp_self, uint32_t *parent);
 
 struct crt_topo_ops {
 	crt_topo_get_children_cnt_t	to_get_children_cnt;
@@ -66,6 +70,7 @@ struct crt_topo_ops {
 extern struct crt_topo_ops	 crt_flat_ops;
 extern struct crt_topo_ops	 crt_kary_ops;
 extern struct crt_topo_ops	 crt_knomial_ops;
+extern struct crt_topo_ops	 crt_domain_ops;
 
 extern struct crt_topo_ops	*crt_tops[];
 
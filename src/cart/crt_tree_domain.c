@@ -0,0 +1,250 @@
+/*
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * This file is part of CaRT. It gives out the fault domain tree topo related
+ * function implementation.
+ *
+ * The ranks are sorted by fault domain, the root first in its domain and the
+ * other domains by ID. The first rank of each domain (the root for its own
+ * domain) is the leader of the domain, the leaders form a knomial tree rooted
+ * at the root, and each leader is the root of a knomial tree of its domain.
+ * So the RPC crosses the fabric once per domain, and fans out locally. Ranks
+ * without a domain are each in a domain of their own.
+ */
+#define D_LOGFAC	DD_FAC(grp)
+
+#include "crt_internal.h"
+
+struct domain_ent {
+	/* domain, or a key past all the domain IDs if in no domain */
+	uint64_t	de_key;
+	/* 0 for the root, the group rank + 1 for the others */
+	uint32_t	de_order;
+	uint32_t	de_rank;
+};
+
+/* the domain tree of a group, seen from one rank of it */
+struct domain_tree {
+	struct domain_ent	*dt_ents;
+	/* position of the leader of each domain in dt_ents, root first */
+	uint32_t		*dt_leaders;
+	uint32_t		 dt_nleaders;
+	/* position of self in dt_ents, and of its domain */
+	uint32_t		 dt_self;
+	uint32_t		 dt_dom_start;
+	uint32_t		 dt_dom_size;
+	/* position of self in dt_leaders if it is a leader, else -1 */
+	int			 dt_leader;
+};
+
+static int
+domain_ent_cmp(const void *a, const void *b)
+{
+	const struct domain_ent	*ent_a = a;
+	const struct domain_ent	*ent_b = b;
+
+	if (ent_a->de_key != ent_b->de_key)
+		return ent_a->de_key < ent_b->de_key ? -1 : 1;
+	if (ent_a->de_order != ent_b->de_order)
+		return ent_a->de_order < ent_b->de_order ? -1 : 1;
+	return 0;
+}
+
+static void
+domain_tree_fini(struct domain_tree *tree)
+{
+	D_FREE(tree->dt_ents);
+	D_FREE(tree->dt_leaders);
+}
+
+static int
+domain_tree_init(struct domain_tree *tree, uint32_t grp_size,
+		 uint32_t *grp_doms, uint32_t grp_root, uint32_t grp_self)
+{
+	struct domain_ent	*ents;
+	uint32_t		 root_dom = 0;
+	uint32_t		 i, j;
+
+	D_ASSERT(grp_size > 0);
+	D_ASSERT(grp_root < grp_size && grp_self < grp_size);
+
+	memset(tree, 0, sizeof(*tree));
+	D_ALLOC_ARRAY(tree->dt_ents, grp_size);
+	D_ALLOC_ARRAY(tree->dt_leaders, grp_size);
+	if (tree->dt_ents == NULL || tree->dt_leaders == NULL) {
+		domain_tree_fini(tree);
+		return -DER_NOMEM;
+	}
+
+	ents = tree->dt_ents;
+	for (i = 0; i < grp_size; i++) {
+		if (grp_doms == NULL || grp_doms[i] == CRT_NO_DOMAIN)
+			ents[i].de_key = (1ULL << 32) + i;
+		else
+			ents[i].de_key = grp_doms[i];
+		ents[i].de_order = i == grp_root ? 0 : i + 1;
+		ents[i].de_rank = i;
+	}
+	qsort(ents, grp_size, sizeof(*ents), domain_ent_cmp);
+
+	/* the first rank of each domain leads it, the root leads its own */
+	tree->dt_leader = -1;
+	tree->dt_leaders[tree->dt_nleaders++] = 0;
+	for (i = 0; i < grp_size; i++) {
+		if (ents[i].de_order == 0)
+			root_dom = i;
+		else if (i == 0 || ents[i].de_key != ents[i - 1].de_key)
+			tree->dt_leaders[tree->dt_nleaders++] = i;
+
+		if (ents[i].de_rank == grp_self)
+			tree->dt_self = i;
+	}
+	tree->dt_leaders[0] = root_dom;
+
+	for (i = 0; i < tree->dt_nleaders; i++) {
+		j = tree->dt_leaders[i];
+		if (j > tree->dt_self)
+			continue;
+		if (j == tree->dt_self)
+			tree->dt_leader = i;
+		if (ents[j].de_key == ents[tree->dt_self].de_key)
+			tree->dt_dom_start = j;
+	}
+
+	for (j = tree->dt_dom_start; j < grp_size &&
+	     ents[j].de_key == ents[tree->dt_self].de_key; j++)
+		tree->dt_dom_size++;
+
+	return 0;
+}
+
+/*
+ * Get the children of self, the other leaders first if it is one, then the
+ * ranks of its domain. \a children can be NULL to only count them.
+ */
+static int
+domain_get_children(uint32_t grp_size, uint32_t tree_ratio,
+		    uint32_t *grp_doms, uint32_t grp_root, uint32_t grp_self,
+		    uint32_t *children, uint32_t *nchildren)
+{
+	struct domain_tree	tree;
+	uint32_t		nleaders = 0;
+	uint32_t		nmembers = 0;
+	uint32_t		i;
+	int			rc;
+
+	rc = domain_tree_init(&tree, grp_size, grp_doms, grp_root, grp_self);
+	if (rc != 0)
+		return rc;
+
+	if (tree.dt_leader >= 0) {
+		crt_knomial_ops.to_get_children_cnt(tree.dt_nleaders,
+						    tree_ratio, NULL, 0,
+						    tree.dt_leader, &nleaders);
+		if (children != NULL && nleaders > 0) {
+			crt_knomial_ops.to_get_children(tree.dt_nleaders,
+							tree_ratio, NULL, 0,
+							tree.dt_leader,
+							children);
+			for (i = 0; i < nleaders; i++)
+				children[i] = tree.dt_ents[
+					tree.dt_leaders[children[i]]].de_rank;
+		}
+	}
+
+	crt_knomial_ops.to_get_children_cnt(tree.dt_dom_size, tree_ratio,
+					    NULL, 0,
+					    tree.dt_self - tree.dt_dom_start,
+					    &nmembers);
+	if (children != NULL && nmembers > 0) {
+		crt_knomial_ops.to_get_children(tree.dt_dom_size, tree_ratio,
+						NULL, 0,
+						tree.dt_self -
+						tree.dt_dom_start,
+						children + nleaders);
+		for (i = nleaders; i < nleaders + nmembers; i++)
+			children[i] = tree.dt_ents[tree.dt_dom_start +
+						   children[i]].de_rank;
+	}
+
+	*nchildren = nleaders + nmembers;
+	domain_tree_fini(&tree);
+	return 0;
+}
+
+int
+crt_domain_get_children_cnt(uint32_t grp_size, uint32_t tree_ratio,
+			    uint32_t *grp_doms, uint32_t grp_root,
+			    uint32_t grp_self, uint32_t *nchildren)
+{
+	D_ASSERT(grp_size > 0);
+	D_ASSERT(nchildren != NULL);
+	D_ASSERT(tree_ratio >= CRT_TREE_MIN_RATIO &&
+		 tree_ratio <= CRT_TREE_MAX_RATIO);
+
+	return domain_get_children(grp_size, tree_ratio, grp_doms, grp_root,
+				   grp_self, NULL, nchildren);
+}
+
+int
+crt_domain_get_children(uint32_t grp_size, uint32_t tree_ratio,
+			uint32_t *grp_doms, uint32_t grp_root,
+			uint32_t grp_self, uint32_t *children)
+{
+	uint32_t	nchildren;
+
+	D_ASSERT(grp_size > 0);
+	D_ASSERT(children != NULL);
+	D_ASSERT(tree_ratio >= CRT_TREE_MIN_RATIO &&
+		 tree_ratio <= CRT_TREE_MAX_RATIO);
+
+	return domain_get_children(grp_size, tree_ratio, grp_doms, grp_root,
+				   grp_self, children, &nchildren);
+}
+
+int
+crt_domain_get_parent(uint32_t grp_size, uint32_t tree_ratio,
+		      uint32_t *grp_doms, uint32_t grp_root, uint32_t grp_self,
+		      uint32_t *parent)
+{
+	struct domain_tree	tree;
+	uint32_t		tree_parent;
+	int			rc;
+
+	D_ASSERT(grp_size > 0);
+	D_ASSERT(parent != NULL);
+	D_ASSERT(tree_ratio >= CRT_TREE_MIN_RATIO &&
+		 tree_ratio <= CRT_TREE_MAX_RATIO);
+
+	if (grp_self == grp_root)
+		return -DER_INVAL;
+
+	rc = domain_tree_init(&tree, grp_size, grp_doms, grp_root, grp_self);
+	if (rc != 0)
+		return rc;
+
+	if (tree.dt_leader > 0) {
+		crt_knomial_ops.to_get_parent(tree.dt_nleaders, tree_ratio,
+					      NULL, 0, tree.dt_leader,
+					      &tree_parent);
+		*parent = tree.dt_ents[tree.dt_leaders[tree_parent]].de_rank;
+	} else {
+		crt_knomial_ops.to_get_parent(tree.dt_dom_size, tree_ratio,
+					      NULL, 0,
+					      tree.dt_self - tree.dt_dom_start,
+					      &tree_parent);
+		*parent = tree.dt_ents[tree.dt_dom_start + tree_parent].de_rank;
+	}
+
+	domain_tree_fini(&tree);
+	return 0;
+}
+
+struct crt_topo_ops crt_domain_ops = {
+	.to_get_children_cnt	= crt_domain_get_children_cnt,
+	.to_get_children	= crt_domain_get_children,
+	.to_get_parent		= crt_domain_get_parent
+};
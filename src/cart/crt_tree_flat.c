@@ -13,8 +13,8 @@
 
 int
 crt_flat_get_children_cnt(uint32_t grp_size, uint32_t branch_ratio,
-			  uint32_t grp_root, uint32_t grp_self,
-			  uint32_t *nchildren)
+			  uint32_t *grp_doms, uint32_t grp_root,
+			  uint32_t grp_self, uint32_t *nchildren)
 {
 	D_ASSERT(grp_size > 0);
 	D_ASSERT(nchildren != NULL);
@@ -29,7 +29,8 @@ crt_flat_get_children_cnt(uint32_t grp_size, uint32_t branch_ratio,
 
 int
 crt_flat_get_children(uint32_t grp_size, uint32_t branch_ratio,
-		      uint32_t grp_root, uint32_t grp_self, uint32_t *children)
+		      uint32_t *grp_doms, uint32_t grp_root, uint32_t grp_self,
+		      uint32_t *children)
 {
 	int	i, j;
 
@@ -48,8 +49,9 @@ crt_flat_get_children(uint32_t grp_size, uint32_t branch_ratio,
 }
 
 int
-crt_flat_get_parent(uint32_t grp_size, uint32_t branch_ratio, uint32_t grp_root,
-		    uint32_t grp_self, uint32_t *parent)
+crt_flat_get_parent(uint32_t grp_size, uint32_t branch_ratio,
+		    uint32_t *grp_doms, uint32_t grp_root, uint32_t grp_self,
+		    uint32_t *parent)
 {
 	D_ASSERT(grp_size > 0);
 	D_ASSERT(parent != NULL);
@@ -79,6 +79,80 @@ swim_ping_timeout_get(void)
 	return swim_ping_timeout;
 }
 
+/*
+ * Lifeguard local health: a member which is slow itself, e.g. its progress
+ * is late under load, would suspect the others for the acks it is late to
+ * process. So its ping timeouts and period are scaled by its local health,
+ * raised by late progress, failed pings and suspicions of self, and lowered
+ * by acked pings.
+ */
+static inline void
+swim_health_inc(struct swim_context *ctx)
+{
+	if (ctx->sc_health < SWIM_HEALTH_MAX) {
+		ctx->sc_health++;
+		SWIM_INFO("%lu: local health %u\n", ctx->sc_self,
+			  ctx->sc_health);
+	}
+}
+
+static inline void
+swim_health_dec(struct swim_context *ctx)
+{
+	if (ctx->sc_health > 0) {
+		ctx->sc_health--;
+		SWIM_INFO("%lu: local health %u\n", ctx->sc_self,
+			  ctx->sc_health);
+	}
+}
+
+static inline uint64_t
+swim_ping_timeout_local(struct swim_context *ctx)
+{
+	return swim_ping_timeout_get() * (1 + ctx->sc_health);
+}
+
+static inline uint64_t
+swim_period_local(struct swim_context *ctx)
+{
+	return swim_period_get() * (1 + ctx->sc_health);
+}
+
+/*
+ * Lifeguard suspicion timeout: a member suspected by this one only has
+ * SWIM_SUSPECT_TIMEOUT_MULT suspect timeouts to refute it, down to one suspect
+ * timeout as SWIM_SUSPECT_CONFIRMS other members are heard suspecting it too.
+ * Relays of a suspicion by other members do not count, only their own.
+ */
+static uint64_t
+swim_suspect_timeout_confirmed(uint32_t nconfirms)
+{
+	/* log(nconfirms + 1) / log(SWIM_SUSPECT_CONFIRMS + 1) per mille */
+	static const uint64_t	frac[] = {0, 500, 792, 1000};
+	uint64_t		min = swim_suspect_timeout_get();
+	uint64_t		max = SWIM_SUSPECT_TIMEOUT_MULT * min;
+
+	D_CASSERT(ARRAY_SIZE(frac) == SWIM_SUSPECT_CONFIRMS + 1);
+	return max - (max - min) * frac[nconfirms] / 1000;
+}
+
+/* The member which suspected \a id, to be sent along with its state */
+static swim_id_t
+swim_updates_origin(struct swim_context *ctx, swim_id_t id,
+		    struct swim_member_state *id_state)
+{
+	struct swim_item *item;
+
+	if (id_state->sms_status != SWIM_MEMBER_SUSPECT)
+		return SWIM_ID_INVALID;
+
+	TAILQ_FOREACH(item, &ctx->sc_suspects, si_link) {
+		if (item->si_id == id)
+			return item->si_origin;
+	}
+	return SWIM_ID_INVALID;
+}
+
 static inline void
 swim_dump_updates(swim_id_t self_id, swim_id_t from, swim_id_t to,
 		  struct swim_member_update *upds, size_t nupds)
@@ -111,9 +185,29 @@ swim_dump_updates(swim_id_t self_id, swim_id_t from, swim_id_t to,
 	}
 }
 
+/*
+ * Keep the updates ordered by the count of transfers, so that each message
+ * piggybacks the updates sent the least, the fresh ones first, and none is
+ * dropped before it is sent sc_piggyback_tx_max times.
+ */
+static void
+swim_updates_insert(struct swim_context *ctx, struct swim_item *item)
+{
+	struct swim_item *pos;
+
+	TAILQ_FOREACH(pos, &ctx->sc_updates, si_link) {
+		if (pos->u.si_count >= item->u.si_count) {
+			TAILQ_INSERT_BEFORE(pos, item, si_link);
+			return;
+		}
+	}
+	TAILQ_INSERT_TAIL(&ctx->sc_updates, item, si_link);
+}
+
 static int
 swim_updates_send(struct swim_context *ctx, swim_id_t id, swim_id_t to)
 {
+	TAILQ_HEAD(, swim_item)  sent;
 	struct swim_member_update *upds;
 	struct swim_item *next, *item;
 	swim_id_t self_id = swim_self_get(ctx);
@@ -137,6 +231,7 @@ swim_updates_send(struct swim_context *ctx, swim_id_t id, swim_id_t to)
 		SWIM_ERROR("get_member_state() failed rc=%d\n", rc);
 		D_GOTO(out_unlock, rc);
 	}
+	upds[i].smu_origin = swim_updates_origin(ctx, id, &upds[i].smu_state);
 	upds[i++].smu_id = id;
 
 	if (id != self_id) {
@@ -147,21 +242,15 @@ swim_updates_send(struct swim_context *ctx, swim_id_t id, swim_id_t to)
 			SWIM_ERROR("get_member_state() failed rc=%d\n", rc);
 			D_GOTO(out_unlock, rc);
 		}
+		upds[i].smu_origin = SWIM_ID_INVALID;
 		upds[i++].smu_id = self_id;
 	}
 
+	TAILQ_INIT(&sent);
 	item = TAILQ_FIRST(&ctx->sc_updates);
-	while (item != NULL) {
+	while (item != NULL && i < nupds) {
 		next = TAILQ_NEXT(item, si_link);
 
-		/* delete entries that are too many */
-		if (i >= nupds) {
-			TAILQ_REMOVE(&ctx->sc_updates, item, si_link);
-			D_FREE(item);
-			item = next;
-			continue;
-		}
-
 		/* update with recent updates */
 		if (item->si_id != id && item->si_id != self_id) {
 			rc = ctx->sc_ops->get_member_state(ctx, item->si_id,
@@ -173,23 +262,33 @@ swim_updates_send(struct swim_context *ctx, swim_id_t id, swim_id_t to)
 						     si_link);
 					D_FREE(item);
 					item = next;
+					rc = 0;
 					continue;
 				}
 				SWIM_ERROR("get_member_state() failed rc=%d\n",
 					   rc);
-				D_GOTO(out_unlock, rc);
+				break;
 			}
+			upds[i].smu_origin =
+				swim_updates_origin(ctx, item->si_id,
+						    &upds[i].smu_state);
 			upds[i++].smu_id = item->si_id;
 		}
 
-		if (++item->u.si_count > ctx->sc_piggyback_tx_max) {
-			TAILQ_REMOVE(&ctx->sc_updates, item, si_link);
+		TAILQ_REMOVE(&ctx->sc_updates, item, si_link);
+		if (++item->u.si_count > ctx->sc_piggyback_tx_max)
 			D_FREE(item);
-		}
+		else
+			TAILQ_INSERT_TAIL(&sent, item, si_link);
 
 		item = next;
 	}
-	rc = 0;
+
+	/* requeue the updates sent behind the ones sent less */
+	while ((item = TAILQ_FIRST(&sent)) != NULL) {
+		TAILQ_REMOVE(&sent, item, si_link);
+		swim_updates_insert(ctx, item);
+	}
 
 out_unlock:
 	swim_ctx_unlock(ctx);
@@ -214,8 +313,10 @@ swim_updates_notify(struct swim_context *ctx, swim_id_t from, swim_id_t id,
 	/* determine if this member already have an update */
 	TAILQ_FOREACH(item, &ctx->sc_updates, si_link) {
 		if (item->si_id == id) {
+			TAILQ_REMOVE(&ctx->sc_updates, item, si_link);
 			item->si_from = from;
 			item->u.si_count = count;
+			swim_updates_insert(ctx, item);
 			D_GOTO(update, 0);
 		}
 	}
@@ -228,7 +329,7 @@ swim_updates_notify(struct swim_context *ctx, swim_id_t from, swim_id_t id,
 		item->si_id   = id;
 		item->si_from = from;
 		item->u.si_count = count;
-		TAILQ_INSERT_HEAD(&ctx->sc_updates, item, si_link);
+		swim_updates_insert(ctx, item);
 	}
 update:
 	return ctx->sc_ops->set_member_state(ctx, id, id_state);
@@ -322,9 +423,43 @@ out:
 	return rc;
 }
 
+/* Shrink the suspicion timeout of a member suspected by another one too */
+static void
+swim_member_suspect_confirm(struct swim_context *ctx, swim_id_t origin,
+			    swim_id_t id)
+{
+	struct swim_item *item;
+	uint32_t i;
+
+	if (origin == SWIM_ID_INVALID || origin == swim_self_get(ctx))
+		return;
+
+	TAILQ_FOREACH(item, &ctx->sc_suspects, si_link) {
+		if (item->si_id == id)
+			break;
+	}
+	if (item == NULL || item->si_origin == origin ||
+	    item->si_nconfirms == SWIM_SUSPECT_CONFIRMS)
+		return;
+
+	for (i = 0; i < item->si_nconfirms; i++) {
+		if (item->si_confirms[i] == origin)
+			return;
+	}
+
+	item->si_confirms[item->si_nconfirms++] = origin;
+	item->u.si_deadline -=
+		swim_suspect_timeout_confirmed(item->si_nconfirms - 1) -
+		swim_suspect_timeout_confirmed(item->si_nconfirms);
+}
+
+/*
+ * \a id is suspected by \a origin, as heard from \a from. The origin is
+ * unknown (SWIM_ID_INVALID) if the sender did not know it either.
+ */
 static int
 swim_member_suspect(struct swim_context *ctx, swim_id_t from,
-		    swim_id_t id, uint64_t nr)
+		    swim_id_t origin, swim_id_t id, uint64_t nr)
 {
 	struct swim_member_state id_state;
 	struct swim_item *item;
@@ -346,8 +481,12 @@ swim_member_suspect(struct swim_context *ctx, swim_id_t from,
 	/* ignore old updates or updates for dead members */
 	if (id_state.sms_status == SWIM_MEMBER_DEAD ||
 	    id_state.sms_status == SWIM_MEMBER_SUSPECT ||
-	    id_state.sms_incarnation > nr)
+	    id_state.sms_incarnation > nr) {
+		if (id_state.sms_status == SWIM_MEMBER_SUSPECT &&
+		    id_state.sms_incarnation == nr)
+			swim_member_suspect_confirm(ctx, origin, id);
 		D_GOTO(out, rc = -EALREADY);
+	}
 
 search:
 	/* determine if this member is already suspected */
@@ -362,7 +501,9 @@ search:
 		D_GOTO(out, rc = -ENOMEM);
 	item->si_id = id;
 	item->si_from = from;
-	item->u.si_deadline = swim_now_ms() + swim_suspect_timeout_get();
+	item->si_origin = origin;
+	item->u.si_deadline = swim_now_ms() +
+			      swim_suspect_timeout_confirmed(0);
 	TAILQ_INSERT_TAIL(&ctx->sc_suspects, item, si_link);
 
 update:
@@ -402,7 +543,8 @@ swim_member_update_suspected(struct swim_context *ctx, uint64_t now,
 				from = item->si_from;
 
 				item->si_from = self_id;
-				item->u.si_deadline += swim_ping_timeout_get();
+				item->u.si_deadline +=
+						swim_ping_timeout_local(ctx);
 
 				D_ALLOC_PTR(item);
 				if (item == NULL)
@@ -707,6 +849,9 @@ swim_progress(struct swim_context *ctx, int64_t timeout)
 		}
 
 		swim_ctx_lock(ctx);
+		if (net_glitch_delay)
+			swim_health_inc(ctx);
+
 		ctx_state = SCS_DEAD;
 		if (ctx->sc_target != SWIM_ID_INVALID) {
 			rc = ctx->sc_ops->get_member_state(ctx,
@@ -729,7 +874,7 @@ swim_progress(struct swim_context *ctx, int64_t timeout)
 		case SCS_BEGIN:
 			if (now > ctx->sc_next_tick_time) {
 				ctx->sc_next_tick_time = now
-							 + swim_period_get();
+						       + swim_period_local(ctx);
 
 				id_target = ctx->sc_target;
 				id_sendto = ctx->sc_target;
@@ -741,7 +886,7 @@ swim_progress(struct swim_context *ctx, int64_t timeout)
 					  target_state.sms_incarnation);
 
 				ctx->sc_dping_deadline = now
-						      + swim_ping_timeout_get();
+						+ swim_ping_timeout_local(ctx);
 				ctx_state = SCS_DPINGED;
 			}
 			break;
@@ -756,6 +901,7 @@ swim_progress(struct swim_context *ctx, int64_t timeout)
 				if (target_state.sms_status != SWIM_MEMBER_INACTIVE) {
 					/* suspect this member */
 					swim_member_suspect(ctx, ctx->sc_self,
+							    ctx->sc_self,
 							    ctx->sc_target,
 						  target_state.sms_incarnation);
 					ctx_state = SCS_TIMEDOUT;
@@ -784,6 +930,7 @@ swim_progress(struct swim_context *ctx, int64_t timeout)
 						       target_state.sms_status],
 					   target_state.sms_incarnation);
 				/* So, just goto next member. */
+				swim_health_inc(ctx);
 				ctx_state = SCS_DEAD;
 			}
 			break;
@@ -822,7 +969,7 @@ swim_progress(struct swim_context *ctx, int64_t timeout)
 				item = TAILQ_FIRST(&ctx->sc_subgroup);
 				if (item == NULL) {
 					ctx->sc_iping_deadline = now
-						  + 2 * swim_ping_timeout_get();
+					    + 2 * swim_ping_timeout_local(ctx);
 					ctx_state = SCS_IPINGED;
 				}
 				break;
@@ -883,8 +1030,10 @@ swim_parse_message(struct swim_context *ctx, swim_id_t from,
 	ctx_state = swim_state_get(ctx);
 
 	if (from == ctx->sc_target &&
-	    (ctx_state == SCS_BEGIN || ctx_state == SCS_DPINGED))
+	    (ctx_state == SCS_BEGIN || ctx_state == SCS_DPINGED)) {
+		swim_health_dec(ctx);
 		ctx_state = SCS_ACKED;
+	}
 
 	to = upds[0].smu_id; /* save first index from update */
 	for (i = 0; i < nupds; i++) {
@@ -901,8 +1050,10 @@ swim_parse_message(struct swim_context *ctx, swim_id_t from,
 			if (id == self_id)
 				break; /* ignore alive updates for self */
 
-			if (id == ctx->sc_target && ctx_state == SCS_IPINGED)
+			if (id == ctx->sc_target && ctx_state == SCS_IPINGED) {
+				swim_health_dec(ctx);
 				ctx_state = SCS_ACKED;
+			}
 
 			swim_member_alive(ctx, from, id,
 					  upds[i].smu_state.sms_incarnation);
@@ -935,6 +1086,7 @@ swim_parse_message(struct swim_context *ctx, swim_id_t from,
 					   upds[i].smu_state.sms_incarnation,
 					   from);
 
+				swim_health_inc(ctx);
 				self_state.sms_incarnation++;
 				rc = swim_updates_notify(ctx, self_id, self_id,
 							 &self_state, 0);
@@ -947,7 +1099,7 @@ swim_parse_message(struct swim_context *ctx, swim_id_t from,
 				break;
 			}
 
-			swim_member_suspect(ctx, from, id,
+			swim_member_suspect(ctx, from, upds[i].smu_origin, id,
 					    upds[i].smu_state.sms_incarnation);
 			break;
 		case SWIM_MEMBER_DEAD:
@@ -1020,7 +1172,7 @@ swim_parse_message(struct swim_context *ctx, swim_id_t from,
 				item->si_id   = to;
 				item->si_from = from;
 				item->u.si_deadline = swim_now_ms()
-						      + swim_ping_timeout_get();
+						+ swim_ping_timeout_local(ctx);
 				TAILQ_INSERT_TAIL(&ctx->sc_ipings, item,
 						  si_link);
 				SWIM_INFO("%lu: iping %lu => %lu\n",
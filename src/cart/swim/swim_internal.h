@@ -57,6 +57,18 @@ extern "C" {
 					 * until it be removed from the list of
 					 * updates.
 					 */
+#define SWIM_HEALTH_MAX		8	/**< max of the local health, the ping
+					 * timeouts and the period are scaled
+					 * by (1 + local health).
+					 */
+#define SWIM_SUSPECT_TIMEOUT_MULT 3	/**< the suspicion timeout of a member
+					 * no one else suspects, in suspect
+					 * timeouts.
+					 */
+#define SWIM_SUSPECT_CONFIRMS	3	/**< count of other members suspecting
+					 * the member to shrink its suspicion
+					 * timeout down to the suspect timeout.
+					 */
 
 enum swim_context_state {
 	SCS_BEGIN = 0,		/**< initial state when next target was already
@@ -85,6 +97,11 @@ struct swim_item {
 		uint64_t	 si_deadline; /**< for sc_suspects/sc_ipings */
 		uint64_t	 si_count;    /**< for sc_updates */
 	} u;
+	/** for sc_suspects: the member which suspected it first */
+	swim_id_t		 si_origin;
+	/** for sc_suspects: other members which suspected it too */
+	swim_id_t		 si_confirms[SWIM_SUSPECT_CONFIRMS];
+	uint32_t		 si_nconfirms;
 };
 
 /** internal swim context implementation */
@@ -109,6 +126,10 @@ struct swim_context {
 	uint64_t		 sc_iping_deadline;
 
 	uint64_t		 sc_piggyback_tx_max;
+	/** Lifeguard local health, raised by late progress, failed pings
+	 * and suspicions of self, lowered by acked pings.
+	 */
+	uint32_t		 sc_health;
 };
 
 static inline int
@@ -245,6 +245,9 @@ daos_fini(void)
 		D_GOTO(unlock, rc = 0);
 	}
 
+	/* cached bulk buffers are registered with the global context */
+	dc_obj_bulk_cache_purge();
+
 	rc = daos_eq_lib_fini();
 	if (rc != 0) {
 		D_ERROR("failed to finalize eq: "DF_RC"\n", DP_RC(rc));
@@ -426,6 +426,29 @@ done:
 	return rc;
 }
 
+/** Max number of chunks hashed by a single daos_mhash_batch() call */
+#define CSUM_BATCH_NR	32
+
+static int
+csum_batch_flush(struct daos_csummer *obj, struct daos_mhash_buf *bufs,
+		 uint32_t *nr)
+{
+	int rc;
+
+	if (*nr == 0)
+		return 0;
+
+	rc = daos_mhash_batch(obj->dcs_algo, obj->dcs_ctx, bufs, *nr);
+	if (rc != 0)
+		D_ERROR("daos_mhash_batch error: %d\n", rc);
+	*nr = 0;
+	return rc;
+}
+
+/**
+ * Chunks which are contiguous in the sgl are hashed in batches, the others
+ * are hashed piece by piece.
+ */
 static int
 calc_csum_recx_with_no_map(struct daos_csummer *obj, size_t csum_nr,
 			   daos_recx_t *recx,
@@ -434,22 +457,45 @@ calc_csum_recx_with_no_map(struct daos_csummer *obj, size_t csum_nr,
 			   uint32_t rec_chunksize,
 			   struct daos_sgl_idx *idx)
 {
+	struct daos_mhash_buf	 bufs[CSUM_BATCH_NR];
 	struct daos_csum_range	 chunk;
 	daos_size_t		 bytes_for_csum;
+	uint32_t		 batch_nr = 0;
 	uint8_t			*buf;
+	uint8_t			*data = NULL;
+	size_t			 len;
 	uint32_t		 i;
 	int			 rc;
 
 	for (i = 0; i < csum_nr; i++) {
 		buf = ci_idx2csum(csum_info, i);
-		daos_csummer_set_buffer(obj, buf, csum_info->cs_len);
-		daos_csummer_reset(obj);
-
 		chunk = csum_recx_chunkidx2range(recx, rec_len,
 						 rec_chunksize, i);
 
 		bytes_for_csum = chunk.dcr_nr * rec_len;
-		rc = daos_sgl_processor(sgl, false, idx, bytes_for_csum,
+		daos_sgl_get_bytes(sgl, false, idx, bytes_for_csum, &data,
+				   &len);
+		if (len == bytes_for_csum) {
+			bufs[batch_nr].mb_buf = data;
+			bufs[batch_nr].mb_len = len;
+			bufs[batch_nr].mb_hash = buf;
+			if (++batch_nr < CSUM_BATCH_NR)
+				continue;
+			rc = csum_batch_flush(obj, bufs, &batch_nr);
+			if (rc != 0)
+				return rc;
+			continue;
+		}
+
+		/** chunk spans several iovs, keep the order of the chunks */
+		rc = csum_batch_flush(obj, bufs, &batch_nr);
+		if (rc != 0)
+			return rc;
+		daos_csummer_set_buffer(obj, buf, csum_info->cs_len);
+		daos_csummer_reset(obj);
+		if (len > 0)
+			daos_csummer_update(obj, data, len);
+		rc = daos_sgl_processor(sgl, false, idx, bytes_for_csum - len,
 					checksum_sgl_cb, obj);
 		if (rc != 0) {
 			D_ERROR("daos_sgl_processor error: %d\n", rc);
@@ -458,7 +504,7 @@ calc_csum_recx_with_no_map(struct daos_csummer *obj, size_t csum_nr,
 		daos_csummer_finish(obj);
 	}
 
-	return 0;
+	return csum_batch_flush(obj, bufs, &batch_nr);
 }
 
 static bool
@@ -916,6 +962,160 @@ done:
 	return rc;
 }
 
+/**
+ * Size of the pieces of the fused copy and checksum, a piece should still be
+ * in the L1 cache when it is copied after being checksummed.
+ */
+#define CSUM_COPY_PIECE		(8 << 10)
+
+int
+daos_csummer_copy_update(struct daos_csummer *obj, void *dst, void *src,
+			 size_t len, daos_csum_copy_fn_t copy_fn, void *arg)
+{
+	size_t	piece;
+	int	rc;
+
+	while (len > 0) {
+		piece = min(len, CSUM_COPY_PIECE);
+		rc = daos_csummer_update(obj, src, piece);
+		if (rc != 0)
+			return rc;
+
+		if (copy_fn != NULL)
+			copy_fn(dst, src, piece, arg);
+		else
+			memcpy(dst, src, piece);
+		dst += piece;
+		src += piece;
+		len -= piece;
+	}
+
+	return 0;
+}
+
+void
+daos_csummer_copy_verify_init(struct dcs_copy_verify *cv,
+			      struct daos_csummer *obj, daos_iod_t *iod,
+			      struct dcs_iod_csums *iod_csum)
+{
+	D_ASSERT(daos_csummer_get_csum_len(obj) <= DAOS_CSUM_MAX_LEN);
+
+	memset(cv, 0, sizeof(*cv));
+	cv->cv_csummer = obj;
+	cv->cv_iod = iod;
+	cv->cv_iod_csum = iod_csum;
+	if (iod->iod_size != 0)
+		cv->cv_rec_chunksize =
+			daos_csummer_get_rec_chunksize(obj, iod->iod_size);
+}
+
+/** Size of the next chunk to verify, 0 if all of them are done */
+static daos_size_t
+cv_next_chunk(struct dcs_copy_verify *cv)
+{
+	daos_iod_t		*iod = cv->cv_iod;
+	struct daos_csum_range	 chunk;
+
+	if (iod->iod_size == 0)
+		return 0;
+
+	if (!is_array(iod))
+		return cv->cv_recx_idx == 0 ? iod->iod_size : 0;
+
+	while (cv->cv_recx_idx < iod->iod_nr &&
+	       cv->cv_chunk_idx >=
+	       daos_recx_calc_chunks(iod->iod_recxs[cv->cv_recx_idx],
+				     iod->iod_size, cv->cv_rec_chunksize)) {
+		cv->cv_recx_idx++;
+		cv->cv_chunk_idx = 0;
+	}
+	if (cv->cv_recx_idx == iod->iod_nr)
+		return 0;
+
+	chunk = csum_recx_chunkidx2range(&iod->iod_recxs[cv->cv_recx_idx],
+					 iod->iod_size, cv->cv_rec_chunksize,
+					 cv->cv_chunk_idx);
+	return chunk.dcr_nr * iod->iod_size;
+}
+
+static int
+cv_chunk_done(struct dcs_copy_verify *cv)
+{
+	struct daos_csummer	*obj = cv->cv_csummer;
+	uint16_t		 csum_len = daos_csummer_get_csum_len(obj);
+	uint8_t			*expected;
+
+	daos_csummer_finish(obj);
+	expected = ci_idx2csum(&cv->cv_iod_csum->ic_data[cv->cv_recx_idx],
+			       cv->cv_chunk_idx);
+	if (expected == NULL ||
+	    !daos_csummer_csum_compare(obj, cv->cv_csum, expected, csum_len)) {
+		D_ERROR("Data corruption found in extent %u chunk %u. "
+			"Calculated "DF_CI_BUF" != received "DF_CI_BUF"\n",
+			cv->cv_recx_idx, cv->cv_chunk_idx,
+			DP_CI_BUF(cv->cv_csum, csum_len),
+			DP_CI_BUF(expected, expected == NULL ? 0 : csum_len));
+		return -DER_CSUM;
+	}
+
+	if (is_array(cv->cv_iod))
+		cv->cv_chunk_idx++;
+	else
+		cv->cv_recx_idx++;
+	return 0;
+}
+
+int
+daos_csummer_copy_verify(struct dcs_copy_verify *cv, void *dst, void *src,
+			 size_t len, daos_csum_copy_fn_t copy_fn, void *arg)
+{
+	struct daos_csummer	*obj = cv->cv_csummer;
+	size_t			 nob;
+	int			 rc;
+
+	while (len > 0) {
+		if (cv->cv_chunk_left == 0) {
+			cv->cv_chunk_left = cv_next_chunk(cv);
+			if (cv->cv_chunk_left == 0)
+				return -DER_REC2BIG;
+
+			memset(cv->cv_csum, 0, sizeof(cv->cv_csum));
+			daos_csummer_set_buffer(obj, cv->cv_csum,
+						daos_csummer_get_csum_len(obj));
+			daos_csummer_reset(obj);
+		}
+
+		nob = min(len, cv->cv_chunk_left);
+		rc = daos_csummer_copy_update(obj, dst, src, nob, copy_fn, arg);
+		if (rc != 0)
+			return rc;
+
+		cv->cv_chunk_left -= nob;
+		if (cv->cv_chunk_left == 0) {
+			rc = cv_chunk_done(cv);
+			if (rc != 0)
+				return rc;
+		}
+		dst += nob;
+		src += nob;
+		len -= nob;
+	}
+
+	return 0;
+}
+
+int
+daos_csummer_copy_verify_fini(struct dcs_copy_verify *cv)
+{
+	if (cv->cv_chunk_left != 0 || cv_next_chunk(cv) != 0) {
+		D_ERROR("Data of extent %u chunk %u not verified\n",
+			cv->cv_recx_idx, cv->cv_chunk_idx);
+		return -DER_CSUM;
+	}
+
+	return 0;
+}
+
 int
 daos_csummer_verify_key(struct daos_csummer *obj, daos_key_t *key,
 			struct dcs_csum_info *csum)
@@ -106,3 +106,135 @@ daos_str2encryptcontprop(const char *value)
 
 	return -DER_INVAL;
 }
+
+/** ------------------------------------------------------------- */
+
+int
+daos_cipherer_init_with_type(struct daos_cipherer **obj,
+			     enum DAOS_CIPHER_TYPE type, const uint8_t *key)
+{
+	struct daos_cipherer	*result;
+	struct cipher_ft	*ft;
+	int			 rc;
+
+	ft = daos_cipher_type2algo(type);
+	if (ft == NULL || ft->cf_init == NULL) {
+		D_ERROR("cipher %s isn't supported for object data\n",
+			ft != NULL ? ft->cf_name : "unknown");
+		return -DER_NOSYS;
+	}
+
+	D_ALLOC_PTR(result);
+	if (result == NULL)
+		return -DER_NOMEM;
+
+	rc = ft->cf_init(&result->dc_ctx, key);
+	if (rc != 0) {
+		D_FREE(result);
+		return rc;
+	}
+
+	result->dc_algo = ft;
+	*obj = result;
+	return 0;
+}
+
+void
+daos_cipherer_destroy(struct daos_cipherer **obj)
+{
+	struct daos_cipherer	*cipherer = *obj;
+
+	if (cipherer == NULL)
+		return;
+
+	if (cipherer->dc_algo->cf_destroy)
+		cipherer->dc_algo->cf_destroy(cipherer->dc_ctx);
+	D_FREE(cipherer);
+	*obj = NULL;
+}
+
+static inline void
+cipher_tweak_set(uint8_t *tw, uint64_t tweak, uint64_t unit)
+{
+	memcpy(tw, &unit, sizeof(unit));
+	memcpy(tw + sizeof(unit), &tweak, sizeof(tweak));
+}
+
+static inline bool
+cipher_blk_is_zero(const uint8_t *blk)
+{
+	const uint64_t	*w = (const uint64_t *)blk;
+
+	return (w[0] | w[1]) == 0;
+}
+
+int
+daos_cipherer_crypt_range(struct daos_cipherer *obj, uint64_t tweak,
+			  uint64_t off, const void *src, void *dst, size_t len,
+			  bool encrypt)
+{
+	struct cipher_ft	*ft = obj->dc_algo;
+	const uint8_t		*in = src;
+	uint8_t			*out = dst;
+	const size_t		 bs = DAOS_CIPHER_BLOCK_SIZE;
+	uint8_t			 tw[DAOS_CIPHER_BLOCK_SIZE];
+	uint64_t		 unit;
+	uint32_t		 blk, nr, i, end;
+	size_t			 piece;
+	bool			 hole;
+	int			 rc;
+
+	if (off % bs != 0 || len % bs != 0)
+		return -DER_INVAL;
+
+	while (len > 0) {
+		unit = off / DAOS_CIPHER_UNIT_SIZE;
+		blk = (off % DAOS_CIPHER_UNIT_SIZE) / bs;
+		piece = min(len, DAOS_CIPHER_UNIT_SIZE -
+				 off % DAOS_CIPHER_UNIT_SIZE);
+		nr = piece / bs;
+		cipher_tweak_set(tw, tweak, unit);
+
+		/* split the unit into runs of data and of hole blocks */
+		for (i = 0; i < nr; i = end) {
+			hole = !encrypt && cipher_blk_is_zero(in + i * bs);
+			end = i + 1;
+			while (end < nr &&
+			       (encrypt ||
+				cipher_blk_is_zero(in + end * bs) == hole))
+				end++;
+
+			if (hole) {
+				if (out != in)
+					memset(out + i * bs, 0, (end - i) * bs);
+				continue;
+			}
+			rc = ft->cf_crypt(obj->dc_ctx, tw, blk + i, in + i * bs,
+					  out + i * bs, (end - i) * bs,
+					  encrypt);
+			if (rc != 0)
+				return rc;
+		}
+
+		in += piece;
+		out += piece;
+		off += piece;
+		len -= piece;
+	}
+	return 0;
+}
+
+int
+daos_cipherer_crypt_value(struct daos_cipherer *obj, uint64_t tweak,
+			  const void *src, void *dst, size_t len, bool encrypt)
+{
+	uint8_t	tw[DAOS_CIPHER_BLOCK_SIZE];
+
+	if (len == 0)
+		return 0;
+
+	/* array units never reach the last index */
+	cipher_tweak_set(tw, tweak, UINT64_MAX);
+	return obj->dc_algo->cf_crypt(obj->dc_ctx, tw, 0, src, dst, len,
+				      encrypt);
+}
@@ -12,6 +12,7 @@
 #include <stdint.h>
 
 #include <isa-l.h>
+#include <isa-l_crypto.h>
 #include <gurt/types.h>
 #include <daos/common.h>
 #include <daos/cipher.h>
@@ -22,14 +23,238 @@
  * ---------------------------------------------------------------------------
  */
 
+/** AES-XTS, the key is the data key followed by the tweak key */
+#define XTS_KEYS_SIZE	(16 * 15)
+
+struct xts_ctx {
+	/** expanded data key */
+	uint8_t		xc_k1_enc[XTS_KEYS_SIZE];
+	uint8_t		xc_k1_dec[XTS_KEYS_SIZE];
+	/** expanded tweak key */
+	uint8_t		xc_k2_enc[XTS_KEYS_SIZE];
+	uint8_t		xc_k2_dec[XTS_KEYS_SIZE];
+	bool		xc_256;
+};
+
+static int
+xts_init(void **daos_cipher_ctx, const uint8_t *key, bool aes256)
+{
+	struct xts_ctx	*ctx;
+
+	D_ALLOC_PTR(ctx);
+	if (ctx == NULL)
+		return -DER_NOMEM;
+
+	ctx->xc_256 = aes256;
+	if (aes256) {
+		aes_keyexp_256(key, ctx->xc_k1_enc, ctx->xc_k1_dec);
+		aes_keyexp_256(key + 32, ctx->xc_k2_enc, ctx->xc_k2_dec);
+	} else {
+		aes_keyexp_128(key, ctx->xc_k1_enc, ctx->xc_k1_dec);
+		aes_keyexp_128(key + 16, ctx->xc_k2_enc, ctx->xc_k2_dec);
+	}
+	*daos_cipher_ctx = ctx;
+	return 0;
+}
+
+static int
+xts128_init(void **daos_cipher_ctx, const uint8_t *key)
+{
+	return xts_init(daos_cipher_ctx, key, false);
+}
+
+static int
+xts256_init(void **daos_cipher_ctx, const uint8_t *key)
+{
+	return xts_init(daos_cipher_ctx, key, true);
+}
+
+static void
+xts_destroy(void *daos_cipher_ctx)
+{
+	D_FREE(daos_cipher_ctx);
+}
+
+/** Single block AES, i.e. CBC with a zero IV */
+static void
+xts_aes_block(struct xts_ctx *ctx, uint8_t *keys, uint8_t *in, uint8_t *out,
+	      bool encrypt)
+{
+	uint8_t	iv[DAOS_CIPHER_BLOCK_SIZE] = { 0 };
+
+	if (ctx->xc_256) {
+		if (encrypt)
+			aes_cbc_enc_256(in, iv, keys, out, sizeof(iv));
+		else
+			aes_cbc_dec_256(in, iv, keys, out, sizeof(iv));
+	} else {
+		if (encrypt)
+			aes_cbc_enc_128(in, iv, keys, out, sizeof(iv));
+		else
+			aes_cbc_dec_128(in, iv, keys, out, sizeof(iv));
+	}
+}
+
+/**
+ * ISA-L derives the tweak of the first block of a call from the initial
+ * tweak. To start in the middle of a data unit, compute the tweak of block
+ * \a blk_idx, T(0) * alpha ^ blk_idx, and pass its preimage by the tweak
+ * key as the initial tweak.
+ */
+static void
+xts_tweak_seek(struct xts_ctx *ctx, const uint8_t *tweak, uint32_t blk_idx,
+	       uint8_t *tw)
+{
+	uint64_t	t[2];
+	uint64_t	carry;
+
+	memcpy(tw, tweak, DAOS_CIPHER_BLOCK_SIZE);
+	if (blk_idx == 0)
+		return;
+
+	xts_aes_block(ctx, ctx->xc_k2_enc, tw, (uint8_t *)t, true);
+	while (blk_idx-- > 0) {
+		carry = t[1] >> 63;
+		t[1] = (t[1] << 1) | (t[0] >> 63);
+		t[0] = (t[0] << 1) ^ (carry ? 0x87 : 0);
+	}
+	xts_aes_block(ctx, ctx->xc_k2_dec, (uint8_t *)t, tw, false);
+}
+
+/** Rounds of the Feistel cipher of the values shorter than one block */
+#define XTS_SHORT_ROUNDS	10
+
+/**
+ * Round function of the short value cipher: AES under the data key of the
+ * encrypted tweak, mixed with the round, the value length and the half \a h.
+ */
+static void
+xts_short_round(struct xts_ctx *ctx, const uint8_t *tw, uint8_t round,
+		uint8_t len, const uint8_t *h, size_t h_len, uint8_t *out)
+{
+	uint8_t	blk[DAOS_CIPHER_BLOCK_SIZE];
+	size_t	i;
+
+	memcpy(blk, tw, sizeof(blk));
+	for (i = 0; i < h_len; i++)
+		blk[i] ^= h[i];
+	blk[DAOS_CIPHER_BLOCK_SIZE - 2] ^= round;
+	blk[DAOS_CIPHER_BLOCK_SIZE - 1] ^= len;
+	xts_aes_block(ctx, ctx->xc_k1_enc, blk, out, true);
+}
+
+/**
+ * XTS needs one full block, shorter values go through a balanced Feistel
+ * network instead, whose round function is AES under the data key. It is a
+ * pseudo random permutation of the values of that length for each tweak, so
+ * unlike a key stream, the ciphertexts of two values at the same tweak tell
+ * nothing about their difference. The value is split in two halves of bytes,
+ * or of nibbles for a single byte.
+ */
+static void
+xts_short_crypt(struct xts_ctx *ctx, const uint8_t *tweak, const uint8_t *src,
+		uint8_t *dst, size_t len, bool encrypt)
+{
+	uint8_t	tw[DAOS_CIPHER_BLOCK_SIZE];
+	uint8_t	f[DAOS_CIPHER_BLOCK_SIZE];
+	uint8_t	h[2][DAOS_CIPHER_BLOCK_SIZE / 2];
+	size_t	h_len[2];
+	uint8_t	mask;
+	int	round;
+	int	cur = 0;
+	size_t	i;
+
+	D_ASSERT(len > 0 && len < DAOS_CIPHER_BLOCK_SIZE);
+	if (len == 1) {
+		h[0][0] = src[0] >> 4;
+		h[1][0] = src[0] & 0xf;
+		h_len[0] = h_len[1] = 1;
+		mask = 0xf;
+	} else {
+		h_len[0] = len / 2;
+		h_len[1] = len - h_len[0];
+		memcpy(h[0], src, h_len[0]);
+		memcpy(h[1], src + h_len[0], h_len[1]);
+		mask = 0xff;
+	}
+	xts_aes_block(ctx, ctx->xc_k2_enc, (uint8_t *)tweak, tw, true);
+
+	/* round r always updates half r % 2 from the other half */
+	for (round = 0; round < XTS_SHORT_ROUNDS; round++) {
+		if (!encrypt)
+			cur ^= 1;
+		xts_short_round(ctx, tw,
+				encrypt ? round : XTS_SHORT_ROUNDS - 1 - round,
+				len, h[cur ^ 1], h_len[cur ^ 1], f);
+		for (i = 0; i < h_len[cur]; i++)
+			h[cur][i] ^= f[i] & mask;
+		if (encrypt)
+			cur ^= 1;
+	}
+
+	if (len == 1) {
+		dst[0] = (h[0][0] << 4) | h[1][0];
+	} else {
+		memcpy(dst, h[0], h_len[0]);
+		memcpy(dst + h_len[0], h[1], h_len[1]);
+	}
+}
+
+static int
+xts_crypt(void *daos_cipher_ctx, const uint8_t *tweak, uint32_t blk_idx,
+	  const uint8_t *src, uint8_t *dst, size_t len, bool encrypt)
+{
+	struct xts_ctx	*ctx = daos_cipher_ctx;
+	uint8_t		 tw[DAOS_CIPHER_BLOCK_SIZE];
+
+	if (len < DAOS_CIPHER_BLOCK_SIZE) {
+		D_ASSERT(blk_idx == 0);
+		xts_short_crypt(ctx, tweak, src, dst, len, encrypt);
+		return 0;
+	}
+
+	/* values which are not a multiple of the block use ciphertext
+	 * stealing of ISA-L for the last partial block
+	 */
+	xts_tweak_seek(ctx, tweak, blk_idx, tw);
+	if (ctx->xc_256) {
+		if (encrypt)
+			XTS_AES_256_enc_expanded_key(ctx->xc_k2_enc,
+						     ctx->xc_k1_enc, tw, len,
+						     src, dst);
+		else
+			XTS_AES_256_dec_expanded_key(ctx->xc_k2_enc,
+						     ctx->xc_k1_dec, tw, len,
+						     src, dst);
+	} else {
+		if (encrypt)
+			XTS_AES_128_enc_expanded_key(ctx->xc_k2_enc,
+						     ctx->xc_k1_enc, tw, len,
+						     src, dst);
+		else
+			XTS_AES_128_dec_expanded_key(ctx->xc_k2_enc,
+						     ctx->xc_k1_dec, tw, len,
+						     src, dst);
+	}
+	return 0;
+}
+
 struct cipher_ft aes_xts128_algo = {
-	.cf_name = "aes-xts128",
-	.cf_type = CIPHER_TYPE_AES_XTS128
+	.cf_init	= xts128_init,
+	.cf_crypt	= xts_crypt,
+	.cf_destroy	= xts_destroy,
+	.cf_key_len	= 32,
+	.cf_name	= "aes-xts128",
+	.cf_type	= CIPHER_TYPE_AES_XTS128
 };
 
 struct cipher_ft aes_xts256_algo = {
-	.cf_name = "aes-xts256",
-	.cf_type = CIPHER_TYPE_AES_XTS256
+	.cf_init	= xts256_init,
+	.cf_crypt	= xts_crypt,
+	.cf_destroy	= xts_destroy,
+	.cf_key_len	= 64,
+	.cf_name	= "aes-xts256",
+	.cf_type	= CIPHER_TYPE_AES_XTS256
 };
 
 struct cipher_ft aes_cbc128_algo = {
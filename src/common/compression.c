@@ -12,6 +12,7 @@
 #include <stdint.h>
 
 #include <gurt/types.h>
+#include <gurt/atomic.h>
 #include <daos/common.h>
 #include <daos/compression.h>
 #include <daos/cont_props.h>
@@ -105,6 +106,215 @@ daos_str2compresscontprop(const char *value)
 	return -DER_INVAL;
 }
 
+/**
+ * Software asynchronous mode
+ *
+ * Jobs are queued on their compressor, whose context is not thread safe, and
+ * a runner executes them one at a time, on the thread given by the executor
+ * or inline if there is none. Completed jobs are moved to the completion
+ * queue of the thread which submitted them, their callback is called when
+ * that thread polls.
+ */
+struct dc_async_queue {
+	pthread_mutex_t	aq_lock;
+	d_list_t	aq_done;
+	/** number of jobs on aq_done, read without the lock */
+	ATOMIC int	aq_done_nr;
+	bool		aq_inited;
+};
+
+struct dc_async {
+	struct daos_compressor	*da_obj;
+	pthread_mutex_t		 da_lock;
+	/** jobs waiting for the runner */
+	d_list_t		 da_pending;
+	/** jobs submitted but not polled yet, used by the owner only */
+	int			 da_inflight;
+	bool			 da_running;
+};
+
+struct dc_async_job {
+	d_list_t		 aj_link;
+	struct dc_async		*aj_async;
+	struct dc_async_queue	*aj_queue;
+	uint8_t			*aj_src;
+	size_t			 aj_src_len;
+	uint8_t			*aj_dst;
+	size_t			 aj_dst_len;
+	size_t			 aj_produced;
+	dc_callback_fn		 aj_cb_fn;
+	void			*aj_cb_data;
+	int			 aj_status;
+	bool			 aj_compress;
+};
+
+static dc_offload_fn			dc_offload;
+static __thread struct dc_async_queue	dc_queue;
+
+void
+daos_compressor_set_offload(dc_offload_fn fn)
+{
+	dc_offload = fn;
+}
+
+bool
+daos_compressor_offloaded(struct daos_compressor *obj)
+{
+	return dc_offload != NULL && obj->dc_algo->cf_compress_async == NULL;
+}
+
+static struct dc_async_queue *
+dc_async_queue_get(void)
+{
+	int	rc;
+
+	if (!dc_queue.aq_inited) {
+		rc = D_MUTEX_INIT(&dc_queue.aq_lock, NULL);
+		if (rc != 0)
+			return NULL;
+		D_INIT_LIST_HEAD(&dc_queue.aq_done);
+		dc_queue.aq_inited = true;
+	}
+	return &dc_queue;
+}
+
+static void
+dc_async_exec(struct daos_compressor *obj, struct dc_async_job *job)
+{
+	if (job->aj_compress)
+		job->aj_status = daos_compressor_compress(obj,
+				job->aj_src, job->aj_src_len,
+				job->aj_dst, job->aj_dst_len,
+				&job->aj_produced);
+	else
+		job->aj_status = daos_compressor_decompress(obj,
+				job->aj_src, job->aj_src_len,
+				job->aj_dst, job->aj_dst_len,
+				&job->aj_produced);
+}
+
+static void
+dc_async_complete(struct dc_async_job *job)
+{
+	struct dc_async_queue	*queue = job->aj_queue;
+
+	D_MUTEX_LOCK(&queue->aq_lock);
+	d_list_add_tail(&job->aj_link, &queue->aq_done);
+	atomic_fetch_add_relaxed(&queue->aq_done_nr, 1);
+	D_MUTEX_UNLOCK(&queue->aq_lock);
+}
+
+/** Run the pending jobs of a compressor until there is none left */
+static void
+dc_async_run(void *arg)
+{
+	struct dc_async		*async = arg;
+	struct dc_async_job	*job;
+
+	D_MUTEX_LOCK(&async->da_lock);
+	while ((job = d_list_pop_entry(&async->da_pending, struct dc_async_job,
+				       aj_link)) != NULL) {
+		D_MUTEX_UNLOCK(&async->da_lock);
+		dc_async_exec(async->da_obj, job);
+		D_MUTEX_LOCK(&async->da_lock);
+		/* under da_lock, so the owner can't free it after polling */
+		dc_async_complete(job);
+	}
+	async->da_running = false;
+	D_MUTEX_UNLOCK(&async->da_lock);
+}
+
+static int
+dc_async_submit(struct daos_compressor *obj, uint8_t *src_buf,
+		size_t src_len, uint8_t *dst_buf, size_t dst_len,
+		dc_callback_fn cb_fn, void *cb_data, bool compress)
+{
+	struct dc_async		*async = obj->dc_async;
+	struct dc_async_queue	*queue;
+	struct dc_async_job	*job;
+	bool			 run;
+	int			 rc;
+
+	queue = dc_async_queue_get();
+	if (queue == NULL)
+		return DC_STATUS_ERR;
+
+	if (async == NULL) {
+		D_ALLOC_PTR(async);
+		if (async == NULL)
+			return DC_STATUS_NOMEM;
+		rc = D_MUTEX_INIT(&async->da_lock, NULL);
+		if (rc != 0) {
+			D_FREE(async);
+			return DC_STATUS_ERR;
+		}
+		D_INIT_LIST_HEAD(&async->da_pending);
+		async->da_obj = obj;
+		obj->dc_async = async;
+	}
+
+	D_ALLOC_PTR(job);
+	if (job == NULL)
+		return DC_STATUS_NOMEM;
+
+	job->aj_async = async;
+	job->aj_queue = queue;
+	job->aj_src = src_buf;
+	job->aj_src_len = src_len;
+	job->aj_dst = dst_buf;
+	job->aj_dst_len = dst_len;
+	job->aj_cb_fn = cb_fn;
+	job->aj_cb_data = cb_data;
+	job->aj_compress = compress;
+	async->da_inflight++;
+
+	D_MUTEX_LOCK(&async->da_lock);
+	d_list_add_tail(&job->aj_link, &async->da_pending);
+	run = !async->da_running;
+	async->da_running = true;
+	D_MUTEX_UNLOCK(&async->da_lock);
+
+	if (run && (dc_offload == NULL || dc_offload(dc_async_run, async) != 0))
+		dc_async_run(async);
+
+	return DC_STATUS_OK;
+}
+
+int
+daos_compressor_progress(void)
+{
+	struct dc_async_job	*job;
+	d_list_t		 done;
+	int			 nr = 0;
+
+	if (!dc_queue.aq_inited ||
+	    atomic_load_relaxed(&dc_queue.aq_done_nr) == 0)
+		return 0;
+
+	D_INIT_LIST_HEAD(&done);
+	D_MUTEX_LOCK(&dc_queue.aq_lock);
+	d_list_splice_init(&dc_queue.aq_done, &done);
+	atomic_store_relaxed(&dc_queue.aq_done_nr, 0);
+	D_MUTEX_UNLOCK(&dc_queue.aq_lock);
+
+	while ((job = d_list_pop_entry(&done, struct dc_async_job,
+				       aj_link)) != NULL) {
+		job->aj_async->da_inflight--;
+		job->aj_cb_fn(job->aj_cb_data, job->aj_produced,
+			      job->aj_status);
+		D_FREE(job);
+		nr++;
+	}
+	return nr;
+}
+
+bool
+daos_compressor_pending(void)
+{
+	return dc_queue.aq_inited &&
+	       atomic_load_relaxed(&dc_queue.aq_done_nr) != 0;
+}
+
 /**
  * struct daos_compressor functions
  */
@@ -197,7 +407,8 @@ daos_compressor_compress_async(struct daos_compressor *obj,
 				dst_buf, dst_len,
 				cb_fn, cb_data);
 
-	return DC_STATUS_ERR;
+	return dc_async_submit(obj, src_buf, src_len, dst_buf, dst_len,
+			       cb_fn, cb_data, true);
 }
 
 int
@@ -210,7 +421,8 @@ daos_compressor_decompress_async(struct daos_compressor *obj,
 		return obj->dc_algo->cf_decompress_async(obj->dc_ctx,
 			src_buf, src_len, dst_buf, dst_len, cb_fn, cb_data);
 
-	return DC_STATUS_ERR;
+	return dc_async_submit(obj, src_buf, src_len, dst_buf, dst_len,
+			       cb_fn, cb_data, false);
 }
 
 int
@@ -219,7 +431,8 @@ daos_compressor_poll_response(struct daos_compressor *obj)
 	if (obj->dc_algo->cf_poll_response)
 		return obj->dc_algo->cf_poll_response(obj->dc_ctx);
 
-	return DC_STATUS_ERR;
+	daos_compressor_progress();
+	return obj->dc_async != NULL ? obj->dc_async->da_inflight : 0;
 }
 
 void
@@ -230,6 +443,18 @@ daos_compressor_destroy(struct daos_compressor **obj)
 	if (!*obj)
 		return;
 
+	if (compressor->dc_async != NULL) {
+		/* the owner polled all its jobs, so the runner has exited */
+		D_ASSERTF(compressor->dc_async->da_inflight == 0,
+			  "%d asynchronous jobs in flight\n",
+			  compressor->dc_async->da_inflight);
+		D_MUTEX_LOCK(&compressor->dc_async->da_lock);
+		D_ASSERT(!compressor->dc_async->da_running);
+		D_MUTEX_UNLOCK(&compressor->dc_async->da_lock);
+		D_MUTEX_DESTROY(&compressor->dc_async->da_lock);
+		D_FREE(compressor->dc_async);
+	}
+
 	if (compressor->dc_algo->cf_destroy)
 		compressor->dc_algo->cf_destroy(compressor->dc_ctx);
 
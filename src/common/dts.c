@@ -306,7 +306,7 @@ cont_init(struct dts_context *tsc)
 	} else if (tsc->tsc_mpi_rank == 0) { /* DAOS mode and rank zero */
 		if (tsc_create_cont(tsc)) {
 			rc = daos_cont_create(tsc->tsc_poh, tsc->tsc_cont_uuid,
-					      NULL, NULL);
+					      tsc->tsc_cont_prop, NULL);
 			if (rc != 0)
 				goto bcast;
 		}
@@ -87,6 +87,37 @@ daos_mhash_type2algo(enum DAOS_HASH_TYPE type)
 	return result;
 }
 
+int
+daos_mhash_batch(struct hash_ft *ft, void *ctx, struct daos_mhash_buf *bufs,
+		 uint32_t nr)
+{
+	uint16_t	len;
+	uint32_t	i;
+	int		rc;
+
+	if (ft->cf_batch != NULL)
+		return ft->cf_batch(ctx, bufs, nr);
+
+	len = ft->cf_get_size != NULL ? ft->cf_get_size(ctx) : ft->cf_hash_len;
+	for (i = 0; i < nr; i++) {
+		if (ft->cf_reset != NULL) {
+			rc = ft->cf_reset(ctx);
+			if (rc != 0)
+				return rc;
+		}
+		rc = ft->cf_update(ctx, bufs[i].mb_buf, bufs[i].mb_len);
+		if (rc != 0)
+			return rc;
+		if (ft->cf_finish != NULL) {
+			rc = ft->cf_finish(ctx, bufs[i].mb_hash, len);
+			if (rc != 0)
+				return rc;
+		}
+	}
+
+	return 0;
+}
+
 int
 daos_str2csumcontprop(const char *value)
 {
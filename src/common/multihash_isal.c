@@ -69,8 +69,20 @@ crc16_finish(void *daos_mhash_ctx, uint8_t *buf, size_t buf_len)
 	return 0;
 }
 
+static int
+crc16_batch(void *daos_mhash_ctx, struct daos_mhash_buf *bufs, uint32_t nr)
+{
+	uint32_t i;
+
+	for (i = 0; i < nr; i++)
+		*((uint16_t *)bufs[i].mb_hash) =
+			crc16_t10dif(0, bufs[i].mb_buf, (int)bufs[i].mb_len);
+	return 0;
+}
+
 struct hash_ft crc16_algo = {
 	.cf_update	= crc16_update,
+	.cf_batch	= crc16_batch,
 	.cf_init	= crc16_init,
 	.cf_reset	= crc16_reset,
 	.cf_destroy	= crc16_destroy,
@@ -126,8 +138,20 @@ crc32_finish(void *daos_mhash_ctx, uint8_t *buf, size_t buf_len)
 	return 0;
 }
 
+static int
+crc32_batch(void *daos_mhash_ctx, struct daos_mhash_buf *bufs, uint32_t nr)
+{
+	uint32_t i;
+
+	for (i = 0; i < nr; i++)
+		*((uint32_t *)bufs[i].mb_hash) =
+			crc32_iscsi(bufs[i].mb_buf, (int)bufs[i].mb_len, 0);
+	return 0;
+}
+
 struct hash_ft crc32_algo = {
 	.cf_update	= crc32_update,
+	.cf_batch	= crc32_batch,
 	.cf_init	= crc32_init,
 	.cf_reset	= crc32_reset,
 	.cf_destroy	= crc32_destroy,
@@ -180,8 +204,20 @@ adler32_finish(void *daos_mhash_ctx, uint8_t *buf, size_t buf_len)
 	return 0;
 }
 
+static int
+adler32_batch(void *daos_mhash_ctx, struct daos_mhash_buf *bufs, uint32_t nr)
+{
+	uint32_t i;
+
+	for (i = 0; i < nr; i++)
+		*((uint32_t *)bufs[i].mb_hash) =
+			isal_adler32(0, bufs[i].mb_buf, bufs[i].mb_len);
+	return 0;
+}
+
 struct hash_ft adler32_algo = {
 	.cf_update	= adler32_update,
+	.cf_batch	= adler32_batch,
 	.cf_init	= adler32_init,
 	.cf_reset	= adler32_reset,
 	.cf_destroy	= adler32_destroy,
@@ -237,8 +273,20 @@ crc64_finish(void *daos_mhash_ctx, uint8_t *buf, size_t buf_len)
 	return 0;
 }
 
+static int
+crc64_batch(void *daos_mhash_ctx, struct daos_mhash_buf *bufs, uint32_t nr)
+{
+	uint32_t i;
+
+	for (i = 0; i < nr; i++)
+		*((uint64_t *)bufs[i].mb_hash) =
+			crc64_ecma_refl(0, bufs[i].mb_buf, bufs[i].mb_len);
+	return 0;
+}
+
 struct hash_ft crc64_algo = {
 	.cf_update	= crc64_update,
+	.cf_batch	= crc64_batch,
 	.cf_init	= crc64_init,
 	.cf_reset	= crc64_reset,
 	.cf_destroy	= crc64_destroy,
@@ -383,9 +431,14 @@ struct hash_ft sha256_algo = {
 };
 
 /** SHA512 */
+
+/** Number of buffers hashed in parallel by the multi-buffer manager */
+#define SHA512_BATCH_NR	8
+
 struct sha512_ctx {
 	SHA512_HASH_CTX_MGR	s5_mgr;
 	SHA512_HASH_CTX		s5_ctx;
+	SHA512_HASH_CTX		s5_batch[SHA512_BATCH_NR];
 	bool			s5_updated;
 };
 
@@ -468,8 +521,44 @@ sha512_finish(void *daos_mhash_ctx, uint8_t *buf, size_t buf_len)
 	return 0;
 }
 
+/**
+ * Submit the buffers to the multi-buffer manager SHA512_BATCH_NR at a time,
+ * so the hashes of several buffers are computed together in SIMD lanes.
+ */
+static int
+sha512_batch(void *daos_mhash_ctx, struct daos_mhash_buf *bufs, uint32_t nr)
+{
+	struct sha512_ctx	*ctx = daos_mhash_ctx;
+	SHA512_HASH_CTX		*hctx;
+	uint32_t		 i, j, cnt;
+
+	for (i = 0; i < nr; i += cnt) {
+		cnt = min(nr - i, SHA512_BATCH_NR);
+		for (j = 0; j < cnt; j++) {
+			hctx = &ctx->s5_batch[j];
+			hash_ctx_init(hctx);
+			sha512_ctx_mgr_submit(&ctx->s5_mgr, hctx,
+					      bufs[i + j].mb_buf,
+					      bufs[i + j].mb_len, HASH_ENTIRE);
+		}
+		while (sha512_ctx_mgr_flush(&ctx->s5_mgr) != NULL)
+			;
+
+		for (j = 0; j < cnt; j++) {
+			hctx = &ctx->s5_batch[j];
+			if (hctx->error)
+				return hctx->error;
+			memcpy(bufs[i + j].mb_hash, hctx->job.result_digest,
+			       512 / 8);
+		}
+	}
+
+	return 0;
+}
+
 struct hash_ft sha512_algo = {
 	.cf_update	= sha512_update,
+	.cf_batch	= sha512_batch,
 	.cf_init	= sha512_init,
 	.cf_reset	= sha512_reset,
 	.cf_destroy	= sha512_destroy,
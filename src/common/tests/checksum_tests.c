@@ -1651,6 +1651,148 @@ test_verify_sv_data(void **state)
 	daos_csummer_destroy(&csummer);
 }
 
+static void
+test_copy_verify(void **state)
+{
+	struct daos_csummer	*csummer;
+	struct dcs_copy_verify	 cv;
+	daos_iod_t		 iod = {0};
+	daos_recx_t		 recxs[2];
+	d_sg_list_t		 sgl = {0};
+	struct dcs_iod_csums	*iod_csums = NULL;
+	char			*src;
+	char			 dst[32] = {0};
+	size_t			 len;
+	int			 rc;
+
+	daos_csummer_init_with_type(&csummer, HASH_TYPE_CRC32, 4, 0);
+	dts_sgl_init_with_strings(&sgl, 1, "0123456789abcdefghi");
+	src = sgl.sg_iovs[0].iov_buf;
+	len = daos_sgl_buf_size(&sgl);
+
+	/** 2 extents, the first one isn't aligned to the chunks */
+	recxs[0].rx_idx = 2;
+	recxs[0].rx_nr = 7;
+	recxs[1].rx_idx = 16;
+	recxs[1].rx_nr = len - 7;
+	iod.iod_size = 1;
+	iod.iod_nr = 2;
+	iod.iod_recxs = recxs;
+	iod.iod_type = DAOS_IOD_ARRAY;
+
+	rc = daos_csummer_calc_iods(csummer, &sgl, &iod, NULL, 1, 0, NULL, 0,
+				    &iod_csums);
+	assert_rc_equal(0, rc);
+
+	/** copy in pieces which don't match the chunks */
+	daos_csummer_copy_verify_init(&cv, csummer, &iod, iod_csums);
+	rc = daos_csummer_copy_verify(&cv, dst, src, 3, NULL, NULL);
+	assert_rc_equal(0, rc);
+	rc = daos_csummer_copy_verify(&cv, dst + 3, src + 3, len - 3, NULL,
+				      NULL);
+	assert_rc_equal(0, rc);
+	assert_rc_equal(0, daos_csummer_copy_verify_fini(&cv));
+	assert_memory_equal(dst, src, len);
+
+	/** not all the data is copied */
+	daos_csummer_copy_verify_init(&cv, csummer, &iod, iod_csums);
+	rc = daos_csummer_copy_verify(&cv, dst, src, len - 1, NULL, NULL);
+	assert_rc_equal(0, rc);
+	assert_rc_equal(-DER_CSUM, daos_csummer_copy_verify_fini(&cv));
+
+	/** more data than the iod describes */
+	daos_csummer_copy_verify_init(&cv, csummer, &iod, iod_csums);
+	rc = daos_csummer_copy_verify(&cv, dst, src, len, NULL, NULL);
+	assert_rc_equal(0, rc);
+	rc = daos_csummer_copy_verify(&cv, dst, src, 1, NULL, NULL);
+	assert_rc_equal(-DER_REC2BIG, rc);
+
+	/** corrupted data */
+	src[len - 2]++;
+	daos_csummer_copy_verify_init(&cv, csummer, &iod, iod_csums);
+	rc = daos_csummer_copy_verify(&cv, dst, src, len, NULL, NULL);
+	assert_rc_equal(-DER_CSUM, rc);
+
+	/** Clean up */
+	daos_csummer_free_ic(csummer, &iod_csums);
+	daos_csummer_destroy(&csummer);
+	d_sgl_fini(&sgl, true);
+}
+
+/**
+ * Chunks are hashed in batches when they are contiguous in the sgl, the
+ * checksums must be the same as when they are hashed one by one.
+ */
+static void
+test_calc_batch(void **state)
+{
+	struct daos_csummer	*csummer;
+	enum DAOS_HASH_TYPE	 type;
+	const uint32_t		 chunk = 8;
+	const uint32_t		 nr = 40;
+	uint8_t			 data[chunk * nr];
+	uint8_t			 csum[512 / 8];
+	d_iov_t			 iovs[2];
+	d_sg_list_t		 sgl;
+	daos_recx_t		 recx;
+	daos_iod_t		 iod = {0};
+	struct dcs_iod_csums	*iod_csums;
+	uint16_t		 csum_len;
+	uint32_t		 i;
+	int			 split;
+	int			 rc;
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = i;
+
+	recx.rx_idx = 0;
+	recx.rx_nr = sizeof(data);
+	iod.iod_size = 1;
+	iod.iod_nr = 1;
+	iod.iod_recxs = &recx;
+	iod.iod_type = DAOS_IOD_ARRAY;
+	sgl.sg_iovs = iovs;
+
+	for (type = HASH_TYPE_UNKNOWN + 1; type < HASH_TYPE_END; type++) {
+		rc = daos_csummer_init_with_type(&csummer, type, chunk, 0);
+		assert_rc_equal(0, rc);
+		csum_len = daos_csummer_get_csum_len(csummer);
+
+		/** one iov, then a chunk spanning two iovs */
+		for (split = 0; split < 2; split++) {
+			if (split) {
+				d_iov_set(&iovs[0], data, chunk * 5 + 3);
+				d_iov_set(&iovs[1], data + chunk * 5 + 3,
+					  sizeof(data) - chunk * 5 - 3);
+				sgl.sg_nr = sgl.sg_nr_out = 2;
+			} else {
+				d_iov_set(&iovs[0], data, sizeof(data));
+				sgl.sg_nr = sgl.sg_nr_out = 1;
+			}
+
+			rc = daos_csummer_calc_iods(csummer, &sgl, &iod, NULL,
+						    1, 0, NULL, 0, &iod_csums);
+			assert_rc_equal(0, rc);
+			assert_int_equal(nr, iod_csums->ic_data[0].cs_nr);
+
+			for (i = 0; i < nr; i++) {
+				memset(csum, 0, sizeof(csum));
+				daos_csummer_set_buffer(csummer, csum,
+							csum_len);
+				daos_csummer_reset(csummer);
+				daos_csummer_update(csummer, data + i * chunk,
+						    chunk);
+				daos_csummer_finish(csummer);
+				assert_memory_equal(csum,
+					ci_idx2csum(&iod_csums->ic_data[0], i),
+					csum_len);
+			}
+			daos_csummer_free_ic(csummer, &iod_csums);
+		}
+		daos_csummer_destroy(&csummer);
+	}
+}
+
 static void
 test_akey_csum(void **state)
 {
@@ -1836,6 +1978,10 @@ static const struct CMUnitTest tests[] = {
 	     test_compare_sv_checksums),
 	TEST("CSUM25: Verify single value data",
 	     test_verify_sv_data),
+	TEST("CSUM25.1: Verify array data while copying it",
+	     test_copy_verify),
+	TEST("CSUM25.2: Calc checksums of many chunks in batches",
+	     test_calc_batch),
 	TEST("CSUM26: iod csums includes 'a' key csum",
 	     test_akey_csum),
 	TEST("CSUM27: Calc record chunk size",
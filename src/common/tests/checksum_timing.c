@@ -18,6 +18,7 @@
 #include <gurt/common.h>
 
 static bool verbose;
+static bool fused;
 
 static int
 timebox(int (*cb)(void *), void *arg, uint64_t *nsec)
@@ -37,6 +38,8 @@ timebox(int (*cb)(void *), void *arg, uint64_t *nsec)
 struct csum_timing_args {
 	struct daos_csummer	*csummer;
 	uint8_t			*buf;
+	/** destination of the copy for the copy timings */
+	uint8_t			*dst;
 	size_t			 len;
 	uint32_t		 iterations;
 };
@@ -60,6 +63,48 @@ csum_timed_cb(void *arg)
 	return rc;
 }
 
+/** copy the data, then checksum the copy */
+static int
+copy_csum_timed_cb(void *arg)
+{
+	struct csum_timing_args	*timing_args = arg;
+	int			 i;
+	int			 rc = 0;
+
+	for (i = 0; i < timing_args->iterations; i++) {
+		memcpy(timing_args->dst, timing_args->buf, timing_args->len);
+		rc = daos_csummer_update(timing_args->csummer,
+					 timing_args->dst,
+					 timing_args->len);
+		if (rc)
+			return rc;
+	}
+
+	rc = daos_csummer_finish(timing_args->csummer);
+	return rc;
+}
+
+/** checksum and copy the data with the fused routine */
+static int
+fused_timed_cb(void *arg)
+{
+	struct csum_timing_args	*timing_args = arg;
+	int			 i;
+	int			 rc = 0;
+
+	for (i = 0; i < timing_args->iterations; i++) {
+		rc = daos_csummer_copy_update(timing_args->csummer,
+					      timing_args->dst,
+					      timing_args->buf,
+					      timing_args->len, NULL, NULL);
+		if (rc)
+			return rc;
+	}
+
+	rc = daos_csummer_finish(timing_args->csummer);
+	return rc;
+}
+
 /** Convert nanosec to human readable time */
 static void
 nsec_hr(double nsec, char *buf)
@@ -105,6 +150,39 @@ print_csum(uint8_t *csum_buf, uint32_t csum_buf_len)
 	printf("\n");
 }
 
+/**
+ * Time a copy followed by a checksum of the copy, as the server did before
+ * verifying while copying, against the fused copy and checksum.
+ */
+static int
+run_copy_timings(struct csum_timing_args *args)
+{
+	char	hr_str[20];
+	size_t	nsec;
+	int	rc;
+
+	D_ALLOC(args->dst, args->len);
+	if (args->dst == NULL)
+		return -DER_NOMEM;
+
+	rc = timebox(copy_csum_timed_cb, args, &nsec);
+	if (rc == 0) {
+		nsec_hr(nsec / args->iterations, hr_str);
+		printf("\t\tcopy + csum:\t%s\n", hr_str);
+		rc = timebox(fused_timed_cb, args, &nsec);
+	}
+	if (rc == 0) {
+		nsec_hr(nsec / args->iterations, hr_str);
+		printf("\t\tfused:\t\t%s\n", hr_str);
+	} else {
+		printf("\t%s: Error copying\n",
+		       daos_csummer_get_name(args->csummer));
+	}
+
+	D_FREE(args->dst);
+	return rc;
+}
+
 static int
 run_timings(struct hash_ft *fts[], const int types_count, const size_t *sizes,
 	    const int sizes_count, uint32_t iterations)
@@ -169,6 +247,9 @@ run_timings(struct hash_ft *fts[], const int types_count, const size_t *sizes,
 				       daos_csummer_get_name(csummer));
 			}
 
+			if (fused && rc == 0)
+				rc = run_copy_timings(&args);
+
 			D_FREE(csum_buf);
 			daos_csummer_destroy(&csummer);
 		}
@@ -294,16 +375,20 @@ print_usage(char *name)
 	printf("\t-c CHECKSUM, --csum=CSUM\t"
 			"Type of checksum (crc16, crc32, crc64, mcrc64)\n"
 		"\t\t\t\t\tDefault: Run through all checksums\n");
+	printf("\t-f, --fused\t\t\t"
+		"Also time a copy followed by a checksum\n\t\t\t\t\t"
+		"against the fused copy and checksum\n");
 	printf("\t-v, --verbose \t\t\tPrint more info\n");
 	printf("\t-h, --help\t\t\tShow this message\n");
 }
 
-const char *s_opts = "vhs:c:";
+const char *s_opts = "vfhs:c:";
 static int idx;
 
 static struct option l_opts[] = {
 	{"size",	required_argument,	NULL, 's'},
 	{"checksum",	required_argument,	NULL, 'c'},
+	{"fused",	no_argument,		NULL, 'f'},
 	{"verbose",	no_argument,		NULL, 'v'},
 	{"help",	no_argument,		NULL, 'h'}
 };
@@ -399,6 +484,9 @@ main(int argc, char *argv[])
 			sizes[sizes_count++] = size;
 		}
 			break;
+		case 'f':
+			fused = true;
+			break;
 		case 'v':
 			verbose = true;
 			break;
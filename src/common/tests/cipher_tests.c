@@ -0,0 +1,214 @@
+/**
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+#define D_LOGFAC        DD_FAC(tests)
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h> /** For cmocka.h */
+#include <stdint.h>
+#include <cmocka.h>
+#include <gurt/types.h>
+#include <daos/cipher.h>
+#include <daos/common.h>
+#include <daos/tests_lib.h>
+#include "common_test.h"
+
+#define BUF_SIZE	(4 * DAOS_CIPHER_UNIT_SIZE)
+
+static uint8_t	key[64];
+static uint8_t	plain_buf[BUF_SIZE];
+static uint8_t	cipher_buf[BUF_SIZE];
+static uint8_t	out_buf[BUF_SIZE];
+
+static struct daos_cipherer *
+cipherer_init(enum DAOS_CIPHER_TYPE type)
+{
+	struct daos_cipherer	*cipherer = NULL;
+	int			 i;
+
+	for (i = 0; i < sizeof(key); i++)
+		key[i] = i * 7 + 1;
+	for (i = 0; i < BUF_SIZE; i++)
+		plain_buf[i] = rand();
+
+	assert_success(daos_cipherer_init_with_type(&cipherer, type, key));
+	assert_non_null(cipherer);
+	return cipherer;
+}
+
+static void
+test_alg_range(enum DAOS_CIPHER_TYPE type)
+{
+	struct daos_cipherer	*cipherer = cipherer_init(type);
+	uint64_t		 off;
+
+	/** Whole buffer, out of place */
+	assert_success(daos_cipherer_crypt_range(cipherer, 42, 0, plain_buf,
+						 cipher_buf, BUF_SIZE, true));
+	assert_memory_not_equal(plain_buf, cipher_buf, BUF_SIZE);
+	assert_success(daos_cipherer_crypt_range(cipherer, 42, 0, cipher_buf,
+						 out_buf, BUF_SIZE, false));
+	assert_memory_equal(plain_buf, out_buf, BUF_SIZE);
+
+	/** Any block aligned range matches the whole buffer, in place */
+	for (off = 0; off < BUF_SIZE - 1000; off += 496) {
+		memcpy(out_buf, plain_buf + off, 1008);
+		assert_success(daos_cipherer_crypt_range(cipherer, 42, off,
+							 out_buf, out_buf,
+							 1008, true));
+		assert_memory_equal(cipher_buf + off, out_buf, 1008);
+		assert_success(daos_cipherer_crypt_range(cipherer, 42, off,
+							 out_buf, out_buf,
+							 1008, false));
+		assert_memory_equal(plain_buf + off, out_buf, 1008);
+	}
+
+	/** Another tweak gives another ciphertext */
+	assert_success(daos_cipherer_crypt_range(cipherer, 43, 0, plain_buf,
+						 out_buf, BUF_SIZE, true));
+	assert_memory_not_equal(cipher_buf, out_buf, BUF_SIZE);
+
+	/** Zero blocks are holes */
+	memset(cipher_buf + 64, 0, 32);
+	assert_success(daos_cipherer_crypt_range(cipherer, 42, 0, cipher_buf,
+						 out_buf, 128, false));
+	assert_memory_equal(plain_buf, out_buf, 64);
+	assert_memory_equal(plain_buf + 96, out_buf + 96, 32);
+	for (off = 64; off < 96; off++)
+		assert_int_equal(out_buf[off], 0);
+
+	/** Unaligned range */
+	assert_rc_equal(daos_cipherer_crypt_range(cipherer, 42, 8, plain_buf,
+						  out_buf, 16, true),
+			-DER_INVAL);
+
+	daos_cipherer_destroy(&cipherer);
+	assert_null(cipherer);
+}
+
+static void
+test_alg_value(enum DAOS_CIPHER_TYPE type)
+{
+	struct daos_cipherer	*cipherer = cipherer_init(type);
+	size_t			 sizes[] = { 1, 15, 16, 17, 100, 5000 };
+	int			 i;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		assert_success(daos_cipherer_crypt_value(cipherer, 7,
+							 plain_buf, cipher_buf,
+							 sizes[i], true));
+		assert_memory_not_equal(plain_buf, cipher_buf, sizes[i]);
+		assert_success(daos_cipherer_crypt_value(cipherer, 7,
+							 cipher_buf, out_buf,
+							 sizes[i], false));
+		assert_memory_equal(plain_buf, out_buf, sizes[i]);
+	}
+
+	daos_cipherer_destroy(&cipherer);
+}
+
+/** Values shorter than one block are permuted, not masked by a key stream */
+static void
+test_alg_short(enum DAOS_CIPHER_TYPE type)
+{
+	struct daos_cipherer	*cipherer = cipherer_init(type);
+	uint8_t			 seen[256] = { 0 };
+	uint8_t			 diff[DAOS_CIPHER_BLOCK_SIZE];
+	int			 i;
+
+	/** Every single byte value has its own ciphertext */
+	for (i = 0; i < 256; i++) {
+		plain_buf[0] = i;
+		assert_success(daos_cipherer_crypt_value(cipherer, 7,
+							 plain_buf, cipher_buf,
+							 1, true));
+		assert_int_equal(seen[cipher_buf[0]], 0);
+		seen[cipher_buf[0]] = 1;
+	}
+
+	/** The ciphertexts of two values do not reveal their difference */
+	memcpy(out_buf, plain_buf, 8);
+	out_buf[7] ^= 1;
+	assert_success(daos_cipherer_crypt_value(cipherer, 7, plain_buf,
+						 cipher_buf, 8, true));
+	assert_success(daos_cipherer_crypt_value(cipherer, 7, out_buf,
+						 cipher_buf + 8, 8, true));
+	for (i = 0; i < 8; i++)
+		diff[i] = cipher_buf[i] ^ cipher_buf[8 + i];
+	assert_memory_not_equal(diff, "\0\0\0\0\0\0\0\1", 8);
+	assert_success(daos_cipherer_crypt_value(cipherer, 7, cipher_buf + 8,
+						 cipher_buf + 8, 8, false));
+	assert_memory_equal(out_buf, cipher_buf + 8, 8);
+
+	daos_cipherer_destroy(&cipherer);
+}
+
+static void
+test_xts128_range(void **state)
+{
+	test_alg_range(CIPHER_TYPE_AES_XTS128);
+}
+
+static void
+test_xts256_range(void **state)
+{
+	test_alg_range(CIPHER_TYPE_AES_XTS256);
+}
+
+static void
+test_xts128_value(void **state)
+{
+	test_alg_value(CIPHER_TYPE_AES_XTS128);
+}
+
+static void
+test_xts256_value(void **state)
+{
+	test_alg_value(CIPHER_TYPE_AES_XTS256);
+}
+
+static void
+test_xts128_short(void **state)
+{
+	test_alg_short(CIPHER_TYPE_AES_XTS128);
+}
+
+static void
+test_xts256_short(void **state)
+{
+	test_alg_short(CIPHER_TYPE_AES_XTS256);
+}
+
+static void
+test_unsupported(void **state)
+{
+	struct daos_cipherer	*cipherer = NULL;
+
+	assert_rc_equal(daos_cipherer_init_with_type(&cipherer,
+						     CIPHER_TYPE_AES_GCM128,
+						     key),
+			-DER_NOSYS);
+	assert_null(cipherer);
+}
+
+static const struct CMUnitTest tests[] = {
+	{ "CIPHER01: AES-XTS128 ranges", test_xts128_range, NULL, NULL },
+	{ "CIPHER02: AES-XTS256 ranges", test_xts256_range, NULL, NULL },
+	{ "CIPHER03: AES-XTS128 single values", test_xts128_value, NULL,
+	  NULL },
+	{ "CIPHER04: AES-XTS256 single values", test_xts256_value, NULL,
+	  NULL },
+	{ "CIPHER05: Unsupported algorithms", test_unsupported, NULL, NULL },
+	{ "CIPHER06: AES-XTS128 short values", test_xts128_short, NULL, NULL },
+	{ "CIPHER07: AES-XTS256 short values", test_xts256_short, NULL, NULL },
+};
+
+int
+daos_cipher_tests_run(void)
+{
+	return cmocka_run_group_tests_name("DAOS Cipher Tests", tests,
+					   NULL, NULL);
+}
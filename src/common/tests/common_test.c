@@ -96,6 +96,7 @@ int main(int argc, char *argv[])
 	misc_tests_run();
 	daos_checksum_tests_run();
 	daos_compress_tests_run();
+	daos_cipher_tests_run();
 
 	return 0;
 }
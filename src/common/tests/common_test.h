@@ -10,6 +10,7 @@
 /** Test Suite Function Declarations */
 int daos_checksum_tests_run(void);
 int daos_compress_tests_run(void);
+int daos_cipher_tests_run(void);
 int misc_tests_run(void);
 
 #endif
@@ -6,6 +6,8 @@
 #define D_LOGFAC        DD_FAC(tests)
 #include <string.h>
 #include <stdarg.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stddef.h>
 #include <setjmp.h> /** For cmocka.h */
 #include <stdint.h>
@@ -177,6 +179,136 @@ test_deflate4_algo_basic(void **state)
 	test_alg_basic("deflate4");
 }
 
+struct async_result {
+	pthread_t	ar_thread;
+	int		ar_produced;
+	int		ar_status;
+	bool		ar_done;
+};
+
+static void
+async_cb(void *cb_data, int produced, int status)
+{
+	struct async_result *res = cb_data;
+
+	res->ar_thread = pthread_self();
+	res->ar_produced = produced;
+	res->ar_status = status;
+	res->ar_done = true;
+}
+
+#define OFFLOAD_THREADS_MAX	16
+static pthread_t	offload_threads[OFFLOAD_THREADS_MAX];
+static int		offload_thread_nr;
+
+struct offload_arg {
+	void	(*oa_func)(void *);
+	void	*oa_arg;
+};
+
+static void *
+offload_thread(void *arg)
+{
+	struct offload_arg oa = *(struct offload_arg *)arg;
+
+	D_FREE(arg);
+	oa.oa_func(oa.oa_arg);
+	return NULL;
+}
+
+static int
+test_offload(void (*func)(void *), void *arg)
+{
+	struct offload_arg	*oa;
+	int			 rc;
+
+	if (offload_thread_nr == OFFLOAD_THREADS_MAX)
+		return -DER_AGAIN;
+
+	D_ALLOC_PTR(oa);
+	if (oa == NULL)
+		return -DER_NOMEM;
+	oa->oa_func = func;
+	oa->oa_arg = arg;
+
+	rc = pthread_create(&offload_threads[offload_thread_nr], NULL,
+			    offload_thread, oa);
+	if (rc != 0) {
+		D_FREE(oa);
+		return -DER_AGAIN;
+	}
+	offload_thread_nr++;
+	return 0;
+}
+
+static void
+async_wait(struct daos_compressor *compressor, struct async_result *res)
+{
+	while (daos_compressor_poll_response(compressor) > 0)
+		sched_yield();
+
+	assert_true(res->ar_done);
+	/* callbacks are called by the thread which submitted the job */
+	assert_true(pthread_equal(res->ar_thread, pthread_self()));
+}
+
+static void
+test_alg_async(const char *alg_name, bool offload)
+{
+	struct daos_compressor	*compressor;
+	struct async_result	 cmp_res = { 0 };
+	struct async_result	 dcmp_res = { 0 };
+	int			 i;
+	int			 rc;
+
+	daos_compressor_set_offload(offload ? test_offload : NULL);
+	rc = daos_compressor_init_with_type(&compressor,
+					    daos_str2compresscontprop(alg_name),
+					    false, MAX_INPUT_SIZE);
+	assert_int_equal(DC_STATUS_OK, rc);
+	assert_int_equal(offload, daos_compressor_offloaded(compressor));
+
+	memset(decomp_buf, 0, sizeof(decomp_buf));
+	rc = daos_compressor_compress_async(compressor, origin_buf,
+					    sizeof(origin_buf), comp_buf,
+					    sizeof(comp_buf), async_cb,
+					    &cmp_res);
+	assert_int_equal(DC_STATUS_OK, rc);
+	async_wait(compressor, &cmp_res);
+	assert_int_equal(DC_STATUS_OK, cmp_res.ar_status);
+	assert_true(cmp_res.ar_produced < sizeof(origin_buf));
+
+	rc = daos_compressor_decompress_async(compressor, comp_buf,
+					      cmp_res.ar_produced, decomp_buf,
+					      sizeof(decomp_buf), async_cb,
+					      &dcmp_res);
+	assert_int_equal(DC_STATUS_OK, rc);
+	async_wait(compressor, &dcmp_res);
+	assert_int_equal(DC_STATUS_OK, dcmp_res.ar_status);
+	assert_int_equal(sizeof(origin_buf), dcmp_res.ar_produced);
+	assert_memory_equal(origin_buf, decomp_buf, sizeof(origin_buf));
+
+	daos_compressor_destroy(&compressor);
+	for (i = 0; i < offload_thread_nr; i++)
+		pthread_join(offload_threads[i], NULL);
+	offload_thread_nr = 0;
+	daos_compressor_set_offload(NULL);
+}
+
+static void
+test_lz4_algo_async(void **state)
+{
+	test_alg_async("lz4", false);
+	test_alg_async("lz4", true);
+}
+
+static void
+test_deflate_algo_async(void **state)
+{
+	test_alg_async("deflate", false);
+	test_alg_async("deflate", true);
+}
+
 static int
 compress_test_setup(void **state)
 {
@@ -205,6 +337,10 @@ static const struct CMUnitTest tests[] = {
 	     test_deflate3_algo_basic),
 	TEST("COMPRESS06: Test deflate4 compression basic functions",
 	     test_deflate4_algo_basic),
+	TEST("COMPRESS07: Test lz4 software asynchronous mode",
+	     test_lz4_algo_async),
+	TEST("COMPRESS08: Test deflate software asynchronous mode",
+	     test_deflate_algo_async),
 };
 
 int
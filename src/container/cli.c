@@ -11,17 +11,24 @@
  */
 #define D_LOGFAC	DD_FAC(container)
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <daos/cipher.h>
 #include <daos/container.h>
 #include <daos/cont_props.h>
 #include <daos/dedup.h>
 #include <daos/event.h>
 #include <daos/mgmt.h>
+#include <daos/placement.h>
 #include <daos/pool.h>
 #include <daos/rsvc.h>
 #include <daos_types.h>
 #include "cli_internal.h"
 #include "rpc.h"
 
+/** power2 of the max number of object layouts cached per container handle */
+static unsigned int	cont_layout_cache_bits = 10;
+
 /**
  * Initialize container interface
  */
@@ -30,6 +37,8 @@ dc_cont_init(void)
 {
 	int rc;
 
+	d_getenv_int("DAOS_LAYOUT_CACHE_BITS", &cont_layout_cache_bits);
+
 	rc = daos_rpc_register(&cont_proto_fmt, CONT_PROTO_CLI_COUNT,
 				NULL, DAOS_CONT_MODULE);
 	if (rc != 0)
@@ -421,6 +430,8 @@ void
 dc_cont_free(struct dc_cont *dc)
 {
 	D_ASSERT(daos_hhash_link_empty(&dc->dc_hlink));
+	pl_layout_cache_destroy(dc->dc_layout_cache);
+	daos_cipherer_destroy(&dc->dc_cipherer);
 	D_RWLOCK_DESTROY(&dc->dc_obj_list_lock);
 	D_ASSERT(d_list_empty(&dc->dc_po_list));
 	D_ASSERT(d_list_empty(&dc->dc_obj_list));
@@ -442,12 +453,78 @@ dc_cont_alloc(const uuid_t uuid)
 	D_INIT_LIST_HEAD(&dc->dc_po_list);
 	if (D_RWLOCK_INIT(&dc->dc_obj_list_lock, NULL) != 0) {
 		D_FREE(dc);
-		dc = NULL;
+		return NULL;
 	}
 
+	/* The layout cache is only an optimization, go ahead without it. */
+	if (cont_layout_cache_bits > 0 &&
+	    pl_layout_cache_create(cont_layout_cache_bits,
+				   &dc->dc_layout_cache) != 0)
+		D_WARN("failed to create layout cache for "DF_UUID"\n",
+		       DP_UUID(uuid));
+
 	return dc;
 }
 
+/**
+ * Load the data key of an encrypted container, from the file named by
+ * DAOS_CONT_ENCRYPT_KEY_FILE. The container can be opened without it, but
+ * its objects can be neither read nor written. Like ssh private keys, the key
+ * file is refused if any permission is granted to the group or to others.
+ */
+static void
+dc_cont_cipherer_init(struct dc_cont *cont)
+{
+	enum DAOS_CIPHER_TYPE	 type;
+	struct cipher_ft	*ft;
+	uint8_t			 key[64];
+	struct stat		 st;
+	char			*path;
+	ssize_t			 len = -1;
+	int			 fd;
+	int			 rc;
+
+	type = daos_contprop2ciphertype(cont->dc_props.dcp_encrypt_type);
+	ft = daos_cipher_type2algo(type);
+	if (ft == NULL || ft->cf_key_len > sizeof(key)) {
+		D_ERROR(DF_UUID": unknown cipher %u\n", DP_UUID(cont->dc_uuid),
+			cont->dc_props.dcp_encrypt_type);
+		return;
+	}
+
+	path = getenv("DAOS_CONT_ENCRYPT_KEY_FILE");
+	if (path == NULL) {
+		D_WARN(DF_UUID": encrypted container, but no key file\n",
+		       DP_UUID(cont->dc_uuid));
+		return;
+	}
+
+	fd = open(path, O_RDONLY);
+	if (fd >= 0) {
+		if (fstat(fd, &st) != 0 ||
+		    (st.st_mode & (S_IRWXG | S_IRWXO)) != 0) {
+			D_ERROR(DF_UUID": key file %s must only be accessible "
+				"by its owner\n", DP_UUID(cont->dc_uuid), path);
+			close(fd);
+			return;
+		}
+		len = read(fd, key, ft->cf_key_len);
+		close(fd);
+	}
+	if (len != ft->cf_key_len) {
+		D_ERROR(DF_UUID": cannot read a %u bytes %s key from %s\n",
+			DP_UUID(cont->dc_uuid), ft->cf_key_len, ft->cf_name,
+			path);
+		return;
+	}
+
+	rc = daos_cipherer_init_with_type(&cont->dc_cipherer, type, key);
+	memset(key, 0, sizeof(key));
+	if (rc != 0)
+		D_ERROR(DF_UUID": cannot init cipherer: "DF_RC"\n",
+			DP_UUID(cont->dc_uuid), DP_RC(rc));
+}
+
 static int
 dc_cont_props_init(struct dc_cont *cont)
 {
@@ -461,6 +538,8 @@ dc_cont_props_init(struct dc_cont *cont)
 			daos_cont_compress_prop_is_enabled(compress_type);
 	cont->dc_props.dcp_encrypt_enabled =
 			daos_cont_encrypt_prop_is_enabled(encrypt_type);
+	if (cont->dc_props.dcp_encrypt_enabled && cont->dc_cipherer == NULL)
+		dc_cont_cipherer_init(cont);
 
 	if (csum_type == DAOS_PROP_CO_CSUM_OFF) {
 		dedup_only = true;
@@ -2880,6 +2959,63 @@ dc_cont_hdl2csummer(daos_handle_t coh)
 
 }
 
+/**
+ * Compute the layout of the object @md by the placement map @map, the layout
+ * is shared via the layout cache of the container handle @coh.
+ */
+int
+dc_cont_obj_place(daos_handle_t coh, struct pl_map *map,
+		  struct daos_obj_md *md, struct pl_obj_layout **layout)
+{
+	struct dc_cont	*dc;
+	int		 rc;
+
+	dc = dc_hdl2cont(coh);
+	if (dc == NULL)
+		return -DER_NO_HDL;
+
+	rc = pl_obj_place_cached(dc->dc_layout_cache, map, md, layout);
+	dc_cont_put(dc);
+
+	return rc;
+}
+
+/** Query hit/miss counters of the layout cache of container handle @coh */
+int
+dc_cont_layout_cache_stats(daos_handle_t coh,
+			   struct pl_layout_cache_stats *stats)
+{
+	struct dc_cont	*dc;
+
+	dc = dc_hdl2cont(coh);
+	if (dc == NULL)
+		return -DER_NO_HDL;
+
+	if (dc->dc_layout_cache != NULL)
+		pl_layout_cache_stats_get(dc->dc_layout_cache, stats);
+	else
+		memset(stats, 0, sizeof(*stats));
+	dc_cont_put(dc);
+
+	return 0;
+}
+
+struct daos_cipherer *
+dc_cont_hdl2cipherer(daos_handle_t coh)
+{
+	struct dc_cont		*dc;
+	struct daos_cipherer	*cipherer;
+
+	dc = dc_hdl2cont(coh);
+	if (dc == NULL)
+		return NULL;
+
+	cipherer = dc->dc_cipherer;
+	dc_cont_put(dc);
+
+	return cipherer;
+}
+
 struct cont_props
 dc_cont_hdl2props(daos_handle_t coh)
 {
@@ -28,7 +28,11 @@ struct dc_cont {
 	/* pool handler of the container */
 	daos_handle_t		dc_pool_hdl;
 	struct daos_csummer    *dc_csummer;
+	/* data cipherer of encrypted containers, NULL without a key */
+	struct daos_cipherer   *dc_cipherer;
 	struct cont_props	dc_props;
+	/* object layouts shared by all objects opened via this handle */
+	struct pl_layout_cache *dc_layout_cache;
 	/* minimal pmap version */
 	uint32_t		dc_min_ver;
 	uint32_t		dc_closing:1,
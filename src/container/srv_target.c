@@ -23,6 +23,8 @@
 
 #include <daos_srv/container.h>
 
+#include <gurt/telemetry_common.h>
+#include <gurt/telemetry_producer.h>
 #include <daos/checksum.h>
 #include <daos/rpc.h>
 #include <daos_srv/pool.h>
@@ -33,6 +35,7 @@
 #include "srv_internal.h"
 #include <daos/cont_props.h>
 #include <daos/dedup.h>
+#include <daos/compression.h>
 
 /* Per VOS container aggregation ULT ***************************************/
 
@@ -160,6 +163,19 @@ ds_cont_csummer_init(struct ds_cont_child *cont)
 		if (dedup_only)
 			dedup_configure_csummer(cont->sc_csummer, cont_props);
 	}
+
+	/** Array data is compressed inline by VOS */
+	if (rc == 0 && cont_props->dcp_compress_enabled) {
+		int	ret;
+
+		ret = vos_cont_set_compress(cont->sc_hdl,
+				daos_contprop2compresstype(
+					cont_props->dcp_compress_type));
+		if (ret != 0)
+			D_WARN(DF_CONT": data won't be compressed: "DF_RC"\n",
+			       DP_CONT(cont->sc_pool->spc_uuid, cont->sc_uuid),
+			       DP_RC(ret));
+	}
 done:
 	return rc;
 }
@@ -708,6 +724,31 @@ cont_child_started(struct ds_cont_child *cont_child)
 	return !d_list_empty(&cont_child->sc_link);
 }
 
+/** Remove the compression gauges published by obj_cmp_stats_update() */
+static void
+cont_child_metrics_fini(struct ds_cont_child *cont_child)
+{
+	char	*path;
+	int	 rc;
+
+	if (cont_child->sc_cmp_ratio == NULL)
+		return;
+
+	D_ASPRINTF(path, "io/%u/compress/"DF_UUIDF,
+		   dss_get_module_info()->dmi_tgt_id,
+		   DP_UUID(cont_child->sc_uuid));
+	if (path == NULL)
+		return;
+
+	rc = d_tm_del_metric(path);
+	if (rc != 0 && rc != -DER_UNINIT && rc != -DER_METRIC_NOT_FOUND)
+		D_WARN("Failed to remove compression sensors %s: "DF_RC"\n",
+		       path, DP_RC(rc));
+	D_FREE(path);
+	cont_child->sc_cmp_ratio = NULL;
+	cont_child->sc_cmp_cpu = NULL;
+}
+
 static void
 cont_child_stop(struct ds_cont_child *cont_child)
 {
@@ -722,6 +763,7 @@ cont_child_stop(struct ds_cont_child *cont_child)
 
 		/* cont_stop_agg_ult() may yield */
 		cont_stop_agg_ult(cont_child);
+		cont_child_metrics_fini(cont_child);
 		ds_cont_child_put(cont_child);
 	} else {
 		D_ASSERT(!cont_child_started(cont_child));
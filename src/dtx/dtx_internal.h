@@ -26,8 +26,8 @@
  * OPCODE, flags, FMT, handler, corpc_hdlr,
  */
 #define DTX_PROTO_SRV_RPC_LIST(X)				\
-	X(DTX_COMMIT, 0, &CQF_dtx, dtx_handler, NULL),		\
-	X(DTX_ABORT, 0, &CQF_dtx, dtx_handler, NULL),		\
+	X(DTX_COMMIT, CRT_RPC_FEAT_BATCH, &CQF_dtx, dtx_handler, NULL),	\
+	X(DTX_ABORT, CRT_RPC_FEAT_BATCH, &CQF_dtx, dtx_handler, NULL),	\
 	X(DTX_CHECK, 0, &CQF_dtx, dtx_handler, NULL),		\
 	X(DTX_REFRESH, 0, &CQF_dtx, dtx_handler, NULL)
 
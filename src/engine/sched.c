@@ -8,6 +8,7 @@
 
 #include <abt.h>
 #include <daos/common.h>
+#include <daos/compression.h>
 #include <daos_errno.h>
 #include <daos_srv/vos.h>
 #include "srv_internal.h"
@@ -36,6 +37,8 @@ struct sched_pool_info {
 	int			spi_gc_sleeping;
 	int			spi_ref;
 	uint32_t		spi_req_cnt;
+	/* Moving average of IO requests queueing delay, in msecs */
+	uint32_t		spi_io_delay;
 };
 
 struct sched_request {
@@ -81,6 +84,8 @@ enum {
 static int	sched_policy;
 
 #define SCHED_DELAY_THRESH	20000	/* msecs */
+/* Stop scrubbing while IO requests are queued for longer, in msecs */
+#define SCHED_SCRUB_BACKOFF	10
 
 static unsigned int max_delay_msecs[SCHED_REQ_MAX] = {
 	20000,	/* SCHED_REQ_UPDATE */
@@ -685,6 +690,11 @@ process_req(struct dss_xstream *dx, struct sched_request *req)
 	/* Remaining requests are not expired */
 	return 1;
 kickoff:
+	if (req_type == SCHED_REQ_UPDATE || req_type == SCHED_REQ_FETCH) {
+		D_ASSERT(info->si_cur_ts >= req->sr_enqueue_ts);
+		spi->spi_io_delay = (spi->spi_io_delay * 7 +
+				     info->si_cur_ts - req->sr_enqueue_ts) / 8;
+	}
 	sri->sri_req_kicked++;
 	req_kickoff(dx, req);
 	return 0;
@@ -760,15 +770,16 @@ process_pool_cb(d_list_t *rlink, void *arg)
 	struct sched_pool_info	*spi;
 	unsigned int		 u_max, f_max, io_max, gc_max, scrub_max,
 				 mig_max;
-	unsigned int		 gc_thr, mig_thr;
+	unsigned int		 gc_thr, scrub_thr, mig_thr;
 	struct pressure_ratio	*pr;
 	int			 press;
 
 	spi = sched_rlink2spi(rlink);
 
 	gc_thr	= req_throttle[SCHED_REQ_GC];
+	scrub_thr = req_throttle[SCHED_REQ_SCRUB];
 	mig_thr	= req_throttle[SCHED_REQ_MIGRATE];
-	D_ASSERT(gc_thr < 100 && mig_thr < 100);
+	D_ASSERT(gc_thr < 100 && scrub_thr < 100 && mig_thr < 100);
 
 	u_max	= pool2req_cnt(spi, SCHED_REQ_UPDATE);
 	f_max	= pool2req_cnt(spi, SCHED_REQ_FETCH);
@@ -821,6 +832,18 @@ out:
 		mig_max = min(mig_max, mig_thr);
 	}
 
+	/*
+	 * Throttle scrubbing, and stop it as long as IO requests are
+	 * delayed, it can always be done later.
+	 */
+	if (scrub_max && io_max) {
+		if (spi->spi_io_delay > SCHED_SCRUB_BACKOFF)
+			scrub_max = 0;
+		else if (scrub_thr)
+			scrub_max = min(scrub_max,
+					max(1, io_max * scrub_thr / 100));
+	}
+
 	reset_req_limit(dx, spi, SCHED_REQ_UPDATE, u_max);
 	reset_req_limit(dx, spi, SCHED_REQ_FETCH, f_max);
 	reset_req_limit(dx, spi, SCHED_REQ_GC, gc_max);
@@ -1328,6 +1351,10 @@ need_nvme_poll(struct dss_xstream *dx, struct sched_cycle *cycle)
 	if (info->si_stop)
 		return false;
 
+	/* Offloaded compression jobs are done, wake up their ULTs early */
+	if (daos_compressor_pending())
+		return true;
+
 	dmi = dss_get_module_info();
 	D_ASSERT(dmi != NULL);
 	return bio_need_nvme_poll(dmi->dmi_nvme_ctxt);
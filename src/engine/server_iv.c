@@ -11,6 +11,8 @@
 #include <abt.h>
 #include <daos/common.h>
 #include <gurt/list.h>
+#include <gurt/telemetry_common.h>
+#include <gurt/telemetry_producer.h>
 #include <cart/iv.h>
 #include <daos_srv/iv.h>
 #include <daos_prop.h>
@@ -383,6 +385,7 @@ ivc_on_fetch(crt_iv_namespace_t ivns, crt_iv_key_t *iv_key,
 	ns = iv_ns_lookup_by_ivns(ivns);
 	if (!ns)
 		return -DER_NONEXIST;
+	d_tm_increment_counter(&ns->iv_tm_on_fetch, NULL);
 
 	iv_key_unpack(&key, iv_key);
 	if (priv_entry == NULL) {
@@ -451,6 +454,8 @@ iv_on_update_internal(crt_iv_namespace_t ivns, crt_iv_key_t *iv_key,
 	ns = iv_ns_lookup_by_ivns(ivns);
 	if (!ns)
 		return -DER_NONEXIST;
+	d_tm_increment_counter(refresh ? &ns->iv_tm_on_refresh :
+			       &ns->iv_tm_on_update, NULL);
 
 	iv_key_unpack(&key, iv_key);
 	if (priv_entry == NULL || priv_entry->entry == NULL) {
@@ -688,9 +693,28 @@ iv_ns_destroy_cb(crt_iv_namespace_t iv_ns, void *arg)
 	D_FREE(ns);
 }
 
+/* Remove the iv/<pool> metrics, a new namespace of the pool starts over. */
+static void
+iv_ns_metrics_fini(struct ds_iv_ns *ns)
+{
+	char	*path;
+	int	 rc;
+
+	D_ASPRINTF(path, "iv/"DF_UUIDF, DP_UUID(ns->iv_pool_uuid));
+	if (path == NULL)
+		return;
+
+	rc = d_tm_del_metric(path);
+	if (rc != 0 && rc != -DER_UNINIT && rc != -DER_METRIC_NOT_FOUND)
+		D_WARN("Failed to remove IV sensors %s: "DF_RC"\n", path,
+		       DP_RC(rc));
+	D_FREE(path);
+}
+
 static void
 iv_ns_destroy_internal(struct ds_iv_ns *ns)
 {
+	iv_ns_metrics_fini(ns);
 	if (ns->iv_ns)
 		crt_iv_namespace_destroy(ns->iv_ns, iv_ns_destroy_cb, ns);
 }
@@ -708,6 +732,44 @@ ds_iv_ns_lookup(unsigned int ns_id)
 	return NULL;
 }
 
+static void
+iv_ns_metric_add(struct ds_iv_ns *ns, struct d_tm_node_t **node,
+		 const char *name, char *desc)
+{
+	char	*path;
+	int	 rc;
+
+	D_ASPRINTF(path, "iv/"DF_UUIDF"/%s", DP_UUID(ns->iv_pool_uuid), name);
+	if (path == NULL)
+		return;
+
+	rc = d_tm_add_metric(node, path, D_TM_COUNTER, desc, "");
+	if (rc)
+		D_WARN("Failed to create IV sensor %s: "DF_RC"\n", path,
+		       DP_RC(rc));
+	D_FREE(path);
+}
+
+/* Count the IV traffic of the pool, so that refresh storms show up */
+static void
+iv_ns_metrics_init(struct ds_iv_ns *ns)
+{
+	iv_ns_metric_add(ns, &ns->iv_tm_fetch, "ops/fetch_cnt",
+			 "total number of IV fetches issued");
+	iv_ns_metric_add(ns, &ns->iv_tm_update, "ops/update_cnt",
+			 "total number of IV updates issued");
+	iv_ns_metric_add(ns, &ns->iv_tm_invalidate, "ops/invalidate_cnt",
+			 "total number of IV invalidations issued");
+	iv_ns_metric_add(ns, &ns->iv_tm_coalesced, "ops/coalesced_cnt",
+			 "total number of lazy IV ops queued behind another");
+	iv_ns_metric_add(ns, &ns->iv_tm_on_fetch, "handled/fetch_cnt",
+			 "total number of IV fetches handled");
+	iv_ns_metric_add(ns, &ns->iv_tm_on_update, "handled/update_cnt",
+			 "total number of IV updates handled");
+	iv_ns_metric_add(ns, &ns->iv_tm_on_refresh, "handled/refresh_cnt",
+			 "total number of IV refreshes handled");
+}
+
 static int
 iv_ns_create_internal(unsigned int ns_id, uuid_t pool_uuid,
 		      d_rank_t master_rank, struct ds_iv_ns **pns)
@@ -725,6 +787,7 @@ iv_ns_create_internal(unsigned int ns_id, uuid_t pool_uuid,
 
 	uuid_copy(ns->iv_pool_uuid, pool_uuid);
 	D_INIT_LIST_HEAD(&ns->iv_entry_list);
+	D_INIT_LIST_HEAD(&ns->iv_lazy_list);
 	ns->iv_ns_id = ns_id;
 	ns->iv_master_rank = master_rank;
 	rc = ABT_eventual_create(0, &ns->iv_done_eventual);
@@ -733,6 +796,7 @@ iv_ns_create_internal(unsigned int ns_id, uuid_t pool_uuid,
 		return dss_abterr2der(rc);
 	}
 
+	iv_ns_metrics_init(ns);
 	d_list_add(&ns->iv_ns_link, &ds_iv_ns_list);
 	ns->iv_refcount = 1;
 	*pns = ns;
@@ -962,10 +1026,32 @@ out:
 	return rc;
 }
 
+/*
+ * A lazy update or invalidation in flight. A lazy op of the same key issued
+ * while it is in flight is not sent, but queued here, a later one replacing
+ * the value queued by an earlier one, and the queued op is sent once the one
+ * in flight completes. So however often a key is refreshed, e.g. the EC
+ * aggregation epoch of each container after a pool map change, it has at
+ * most one sync in flight and one pending, and the latest value wins.
+ */
+struct iv_lazy_op {
+	d_list_t		il_link;
+	struct ds_iv_ns		*il_ns;
+	struct ds_iv_key	il_key;
+	d_sg_list_t		il_value;
+	crt_iv_sync_t		il_sync;
+	unsigned int		il_shortcut;
+	int			il_opc;
+	bool			il_retry;
+	/* another op is queued, with its value in il_value */
+	bool			il_queued;
+};
+
 struct sync_comp_cb_arg {
 	d_sg_list_t	iv_value;
 	struct ds_iv_key iv_key;
 	struct ds_iv_ns	*ns;
+	struct iv_lazy_op *lazy;
 	unsigned int	shortcut;
 	crt_iv_sync_t	iv_sync;
 	int		opc;
@@ -976,24 +1062,158 @@ static int
 iv_op(struct ds_iv_ns *ns, struct ds_iv_key *key, d_sg_list_t *value,
       crt_iv_sync_t *sync, unsigned int shortcut, bool retry, int opc);
 
+static struct iv_lazy_op *
+iv_lazy_lookup(struct ds_iv_ns *ns, struct ds_iv_key *key,
+	       crt_iv_sync_t *sync, unsigned int shortcut, int opc)
+{
+	struct iv_lazy_op *lazy;
+
+	D_ASSERT(dss_get_module_info()->dmi_xs_id == 0);
+	d_list_for_each_entry(lazy, &ns->iv_lazy_list, il_link) {
+		/* Not all classes compare keys, so compare the whole key */
+		if (lazy->il_opc == opc && lazy->il_shortcut == shortcut &&
+		    lazy->il_sync.ivs_event == sync->ivs_event &&
+		    lazy->il_sync.ivs_flags == sync->ivs_flags &&
+		    lazy->il_key.class_id == key->class_id &&
+		    memcmp(lazy->il_key.key_buf, key->key_buf,
+			   sizeof(key->key_buf)) == 0)
+			return lazy;
+	}
+
+	return NULL;
+}
+
+static int
+iv_lazy_alloc(struct ds_iv_ns *ns, struct ds_iv_key *key,
+	      crt_iv_sync_t *sync, unsigned int shortcut, int opc,
+	      struct iv_lazy_op **p_lazy)
+{
+	struct iv_lazy_op *lazy;
+
+	D_ALLOC_PTR(lazy);
+	if (lazy == NULL)
+		return -DER_NOMEM;
+
+	memcpy(&lazy->il_key, key, sizeof(*key));
+	lazy->il_sync = *sync;
+	lazy->il_sync.ivs_comp_cb = NULL;
+	lazy->il_sync.ivs_comp_cb_arg = NULL;
+	lazy->il_shortcut = shortcut;
+	lazy->il_opc = opc;
+	ds_iv_ns_get(ns);
+	lazy->il_ns = ns;
+	d_list_add_tail(&lazy->il_link, &ns->iv_lazy_list);
+
+	*p_lazy = lazy;
+	return 0;
+}
+
+static void
+iv_lazy_free(struct iv_lazy_op *lazy)
+{
+	d_list_del(&lazy->il_link);
+	d_sgl_fini(&lazy->il_value, true);
+	ds_iv_ns_put(lazy->il_ns);
+	D_FREE(lazy);
+}
+
+/* Queue a lazy op behind the one of the same key in flight */
+static int
+iv_lazy_queue(struct iv_lazy_op *lazy, d_sg_list_t *value, bool retry)
+{
+	int rc;
+
+	d_sgl_fini(&lazy->il_value, true);
+	lazy->il_queued = false;
+	if (value != NULL) {
+		rc = daos_sgl_alloc_copy_data(&lazy->il_value, value);
+		if (rc)
+			return rc;
+	}
+
+	lazy->il_queued = true;
+	lazy->il_retry = retry;
+	d_tm_increment_counter(&lazy->il_ns->iv_tm_coalesced, NULL);
+	D_DEBUG(DB_MD, "coalesce class %d opc %d\n", lazy->il_key.class_id,
+		lazy->il_opc);
+	return 0;
+}
+
+static void
+iv_lazy_resend(void *arg)
+{
+	struct iv_lazy_op	*lazy = arg;
+	int			 rc;
+
+	/* Unlink it, so that the queued op goes out as a lazy op of its own,
+	 * and the ops issued meanwhile queue behind that one.
+	 */
+	d_list_del_init(&lazy->il_link);
+	rc = iv_op(lazy->il_ns, &lazy->il_key,
+		   lazy->il_opc == IV_INVALIDATE ? NULL : &lazy->il_value,
+		   &lazy->il_sync, lazy->il_shortcut, lazy->il_retry,
+		   lazy->il_opc);
+	if (rc)
+		D_CDEBUG(rc == -DER_SHUTDOWN, DB_MD, DLOG_ERR,
+			 "lazy IV class %d opc %d failed: "DF_RC"\n",
+			 lazy->il_key.class_id, lazy->il_opc, DP_RC(rc));
+	iv_lazy_free(lazy);
+}
+
+/* The lazy op in flight completed, send the one queued if any */
+static void
+iv_lazy_complete(struct iv_lazy_op *lazy)
+{
+	int rc;
+
+	if (!lazy->il_queued) {
+		iv_lazy_free(lazy);
+		return;
+	}
+
+	/* Not from the completion callback, which may run in the progress
+	 * ULT or under iv_op().
+	 */
+	rc = dss_ult_create(iv_lazy_resend, lazy, DSS_XS_SELF, 0, 0, NULL);
+	if (rc) {
+		D_ERROR("failed to resend lazy IV class %d opc %d: "DF_RC"\n",
+			lazy->il_key.class_id, lazy->il_opc, DP_RC(rc));
+		iv_lazy_free(lazy);
+	}
+}
+
 static int
 sync_comp_cb(void *arg, int rc)
 {
 	struct sync_comp_cb_arg *cb_arg = arg;
+	struct iv_lazy_op	*lazy;
 
 	if (cb_arg == NULL)
 		return rc;
 
+	lazy = cb_arg->lazy;
 	/* Let's retry asynchronous IV only for GRPVER for the moment */
 	if (cb_arg->retry && rc == -DER_GRPVER && !cb_arg->ns->iv_stop) {
 		int rc1;
 
+		D_WARN("retry upon %d for class %d opc %d\n", rc,
+		       cb_arg->iv_key.class_id, cb_arg->opc);
+		if (lazy != NULL) {
+			/* Resend it, unless a later op is queued already */
+			if (!lazy->il_queued) {
+				lazy->il_value = cb_arg->iv_value;
+				memset(&cb_arg->iv_value, 0,
+				       sizeof(cb_arg->iv_value));
+				lazy->il_retry = true;
+				lazy->il_queued = true;
+			}
+			D_GOTO(out, rc);
+		}
+
 		/* If the IV ns leader has been changed, then it will retry
 		 * in the mean time, it will rely on others to update the
 		 * ns for it.
 		 */
-		D_WARN("retry upon %d for class %d opc %d\n", rc,
-		       cb_arg->iv_key.class_id, IV_UPDATE);
 		rc1 = iv_op(cb_arg->ns, &cb_arg->iv_key, &cb_arg->iv_value,
 			    &cb_arg->iv_sync, cb_arg->shortcut, cb_arg->retry,
 			    cb_arg->opc);
@@ -1003,6 +1223,9 @@ sync_comp_cb(void *arg, int rc)
 		}
 	}
 
+out:
+	if (lazy != NULL)
+		iv_lazy_complete(lazy);
 	ds_iv_ns_put(cb_arg->ns);
 	d_sgl_fini(&cb_arg->iv_value, true);
 	D_FREE(cb_arg);
@@ -1015,6 +1238,7 @@ iv_op(struct ds_iv_ns *ns, struct ds_iv_key *key, d_sg_list_t *value,
 {
 	struct ds_iv_key *_key = key;
 	d_sg_list_t	 *_value = value;
+	bool		  retried = false;
 	int rc;
 
 	if (ns->iv_stop)
@@ -1022,11 +1246,31 @@ iv_op(struct ds_iv_ns *ns, struct ds_iv_key *key, d_sg_list_t *value,
 retry:
 	if (sync && sync->ivs_mode == CRT_IV_SYNC_LAZY) {
 		struct sync_comp_cb_arg *arg = NULL;
+		struct iv_lazy_op	*lazy = NULL;
+
+		/* Bidirectional sync does not call the completion callback
+		 * once done, so only coalesce the others.
+		 */
+		if (!(sync->ivs_flags & CRT_IV_SYNC_BIDIRECTIONAL)) {
+			lazy = iv_lazy_lookup(ns, key, sync, shortcut, opc);
+			/* A later op of the key went out while retrying */
+			if (lazy != NULL && retried)
+				return 0;
+			if (lazy != NULL)
+				return iv_lazy_queue(lazy, value, retry);
+
+			rc = iv_lazy_alloc(ns, key, sync, shortcut, opc, &lazy);
+			if (rc)
+				return rc;
+		}
 
 		/* Register asynchronous sync(lazy mode) callback */
 		D_ALLOC_PTR(arg);
-		if (arg == NULL)
+		if (arg == NULL) {
+			if (lazy != NULL)
+				iv_lazy_free(lazy);
 			return -DER_NOMEM;
+		}
 
 		/* Asynchronous mode, let's realloc the value and key, since
 		 * the input parameters will be invalid after the call.
@@ -1034,6 +1278,8 @@ retry:
 		if (value) {
 			rc = daos_sgl_alloc_copy_data(&arg->iv_value, value);
 			if (rc) {
+				if (lazy != NULL)
+					iv_lazy_free(lazy);
 				D_FREE(arg);
 				return -DER_NOMEM;
 			}
@@ -1045,6 +1291,7 @@ retry:
 		arg->retry = retry;
 		ds_iv_ns_get(ns);
 		arg->ns = ns;
+		arg->lazy = lazy;
 		arg->opc = opc;
 
 		sync->ivs_comp_cb = sync_comp_cb;
@@ -1054,6 +1301,13 @@ retry:
 		_key = &arg->iv_key;
 	}
 
+	if (opc == IV_FETCH)
+		d_tm_increment_counter(&ns->iv_tm_fetch, NULL);
+	else if (opc == IV_UPDATE)
+		d_tm_increment_counter(&ns->iv_tm_update, NULL);
+	else
+		d_tm_increment_counter(&ns->iv_tm_invalidate, NULL);
+
 	rc = iv_op_internal(ns, _key, _value, sync, shortcut, opc);
 	if (retry && !ns->iv_stop &&
 	    (daos_rpc_retryable_rc(rc) || rc == -DER_NOTLEADER)) {
@@ -1065,6 +1319,7 @@ retry:
 		       key->class_id, opc);
 		/* Yield to avoid hijack the cycle if IV RPC is not sent */
 		ABT_thread_yield();
+		retried = true;
 		goto retry;
 	}
 	return rc;
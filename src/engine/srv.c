@@ -17,6 +17,7 @@
 
 #include <abt.h>
 #include <daos/common.h>
+#include <daos/compression.h>
 #include <daos/event.h>
 #include <daos_errno.h>
 #include <daos_mgmt.h>
@@ -265,6 +266,8 @@ dss_nvme_poll_ult(void *args)
 	D_ASSERT(dx->dx_main_xs);
 	while (!dss_xstream_exiting(dx)) {
 		bio_nvme_poll(dmi->dmi_nvme_ctxt);
+		/* Complete the compression jobs done on offload xstreams */
+		daos_compressor_progress();
 		ABT_thread_yield();
 	}
 }
@@ -1119,6 +1122,7 @@ dss_srv_fini(bool force)
 		drpc_listener_fini();
 		/* fall through */
 	case XD_INIT_XSTREAMS:
+		daos_compressor_set_offload(NULL);
 		dss_xstreams_fini(force);
 		/* fall through */
 	case XD_INIT_NVME:
@@ -1221,6 +1225,17 @@ dss_srv_init(void)
 	rc = bio_nvme_ctl(BIO_CTL_NOTIFY_STARTED, &started);
 	D_ASSERT(rc == 0);
 
+	/* Run software compression jobs on the offload xstreams */
+	if (dss_tgt_offload_xs_nr > 0) {
+		bool	offload = true;
+
+		d_getenv_bool("DAOS_COMPRESS_OFFLOAD", &offload);
+		if (offload)
+			daos_compressor_set_offload(dss_compress_offload);
+		D_INFO("Compression offloading is %s.\n",
+		       offload ? "enabled" : "disabled");
+	}
+
 	/* start up drpc listener */
 	rc = drpc_listener_init();
 	if (rc != 0)
@@ -118,6 +118,7 @@ int dss_module_cleanup_all(void);
 extern struct dss_module_key daos_srv_modkey;
 int dss_srv_init(void);
 int dss_srv_fini(bool force);
+int dss_compress_offload(void (*func)(void *), void *arg);
 void dss_dump_ABT_state(FILE *fp);
 void dss_xstreams_open_barrier(void);
 struct dss_xstream *dss_get_xstream(int stream_id);
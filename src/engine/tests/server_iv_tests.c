@@ -0,0 +1,402 @@
+/*
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+
+/*
+ * Unit tests for the lazy IV updates of server_iv
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <abt.h>
+#include <daos/common.h>
+#include <cart/iv.h>
+#include <daos_srv/iv.h>
+#include "../srv_internal.h"
+
+#define TEST_IV_CLASS	1
+#define TEST_MAX_OPS	16
+
+/*
+ * Mocks
+ */
+
+/* dss_get_module_info() of the main xstream */
+pthread_key_t			 dss_tls_key;
+struct dss_module_key		*dss_module_keys[DAOS_MODULE_KEYS_NR];
+struct dss_module_key		 daos_srv_modkey = {
+	.dmk_tags	= DAOS_SERVER_TAG,
+	.dmk_index	= 0,
+};
+static struct dss_module_info	 test_dmi;
+static void			*test_dtls_values[DAOS_MODULE_KEYS_NR];
+static struct dss_thread_local_storage test_dtls = {
+	.dtls_tag	= DAOS_SERVER_TAG,
+	.dtls_values	= test_dtls_values,
+};
+
+d_rank_t
+dss_self_rank(void)
+{
+	return 0;
+}
+
+/* ULTs created, run by ult_run_all() */
+static void	(*ult_funcs[TEST_MAX_OPS])(void *);
+static void	*ult_args[TEST_MAX_OPS];
+static int	ult_nr;
+
+int
+dss_ult_create(void (*func)(void *), void *arg, int ult_type, int tgt_idx,
+	       size_t stack_size, ABT_thread *ult)
+{
+	assert_true(ult_nr < TEST_MAX_OPS);
+	ult_funcs[ult_nr] = func;
+	ult_args[ult_nr] = arg;
+	ult_nr++;
+	return 0;
+}
+
+int
+dss_ult_periodic(void (*func)(void *), void *arg, int ult_type, int tgt_idx,
+		 size_t stack_size, ABT_thread *ult)
+{
+	return -DER_NOSYS;
+}
+
+static int	test_ivns;
+
+int
+crt_iv_namespace_create(crt_context_t crt_ctx, crt_group_t *grp, int tree_topo,
+			struct crt_iv_class *iv_classes, uint32_t num_classes,
+			uint32_t iv_ns_id, crt_iv_namespace_t *ivns)
+{
+	*ivns = &test_ivns;
+	return 0;
+}
+
+int
+crt_iv_namespace_destroy(crt_iv_namespace_t ivns,
+			 crt_iv_namespace_destroy_cb_t cb, void *cb_arg)
+{
+	cb(ivns, cb_arg);
+	return 0;
+}
+
+int
+crt_iv_fetch(crt_iv_namespace_t ivns, uint32_t class_id,
+	     crt_iv_key_t *iv_key, crt_iv_ver_t *iv_ver,
+	     crt_iv_shortcut_t shortcut,
+	     crt_iv_comp_cb_t fetch_comp_cb, void *cb_arg)
+{
+	return -DER_NOSYS;
+}
+
+/*
+ * The updates sent, their lazy sync completes when the test calls
+ * update_complete().
+ */
+struct test_update {
+	uint64_t	tu_value;
+	crt_iv_sync_t	tu_sync;
+	bool		tu_completed;
+};
+
+static struct test_update	updates[TEST_MAX_OPS];
+static int			update_nr;
+/* fail the next update with this error */
+static int			update_fail_rc;
+
+int
+crt_iv_update(crt_iv_namespace_t ivns, uint32_t class_id,
+	      crt_iv_key_t *iv_key, crt_iv_ver_t *iv_ver,
+	      d_sg_list_t *iv_value, crt_iv_shortcut_t shortcut,
+	      crt_iv_sync_t sync_type, crt_iv_comp_cb_t update_comp_cb,
+	      void *cb_arg)
+{
+	struct test_update	*update;
+	int			 rc;
+
+	assert_true(update_nr < TEST_MAX_OPS);
+	update = &updates[update_nr++];
+	update->tu_value = *(uint64_t *)iv_value->sg_iovs[0].iov_buf;
+	update->tu_sync = sync_type;
+
+	/* as cart, the sync is completed on failure */
+	rc = update_fail_rc;
+	update_fail_rc = 0;
+	if (rc != 0) {
+		update->tu_completed = true;
+		if (sync_type.ivs_comp_cb)
+			sync_type.ivs_comp_cb(sync_type.ivs_comp_cb_arg, rc);
+		return rc;
+	}
+
+	update_comp_cb(ivns, class_id, iv_key, NULL, iv_value, 0, cb_arg);
+	return 0;
+}
+
+int
+crt_iv_invalidate(crt_iv_namespace_t ivns, uint32_t class_id,
+		  crt_iv_key_t *iv_key, crt_iv_ver_t *iv_ver,
+		  crt_iv_shortcut_t shortcut, crt_iv_sync_t sync_type,
+		  crt_iv_comp_cb_t invali_comp_cb, void *cb_arg)
+{
+	return -DER_NOSYS;
+}
+
+/*
+ * Helpers
+ */
+static struct ds_iv_class_ops	test_class_ops;
+static struct crt_iv_ops	test_crt_ops;
+static struct ds_iv_ns		*test_ns;
+
+static void
+ult_run_all(void)
+{
+	int i;
+
+	/* a ULT may create others */
+	for (i = 0; i < ult_nr; i++)
+		ult_funcs[i](ult_args[i]);
+	ult_nr = 0;
+}
+
+static void
+update_complete(int idx, int rc)
+{
+	struct test_update *update = &updates[idx];
+
+	assert_true(idx < update_nr);
+	assert_false(update->tu_completed);
+	update->tu_completed = true;
+	update->tu_sync.ivs_comp_cb(update->tu_sync.ivs_comp_cb_arg, rc);
+}
+
+static int
+lazy_update(uint64_t value)
+{
+	struct ds_iv_key	key = { 0 };
+	d_sg_list_t		sgl;
+	d_iov_t			iov;
+
+	key.class_id = TEST_IV_CLASS;
+	key.key_buf[0] = 1;
+	d_iov_set(&iov, &value, sizeof(value));
+	sgl.sg_nr = 1;
+	sgl.sg_nr_out = 1;
+	sgl.sg_iovs = &iov;
+
+	return ds_iv_update(test_ns, &key, &sgl, CRT_IV_SHORTCUT_NONE,
+			    CRT_IV_SYNC_LAZY, 0, true);
+}
+
+/* All the syncs completed, with nothing left behind */
+static void
+assert_all_done(void)
+{
+	int i;
+
+	for (i = 0; i < update_nr; i++)
+		assert_true(updates[i].tu_completed);
+	assert_int_equal(ult_nr, 0);
+	assert_true(d_list_empty(&test_ns->iv_lazy_list));
+	assert_int_equal(test_ns->iv_refcount, 1);
+}
+
+/*
+ * Setup and teardown
+ */
+static int
+server_iv_test_setup(void **state)
+{
+	unsigned int	ns_id;
+	uuid_t		pool_uuid;
+	int		rc;
+
+	memset(updates, 0, sizeof(updates));
+	update_nr = 0;
+	update_fail_rc = 0;
+	ult_nr = 0;
+
+	uuid_generate(pool_uuid);
+	rc = ds_iv_ns_create(NULL, pool_uuid, NULL, &ns_id, &test_ns);
+	assert_int_equal(rc, 0);
+	return 0;
+}
+
+static int
+server_iv_test_teardown(void **state)
+{
+	ds_iv_ns_destroy(test_ns);
+	test_ns = NULL;
+	return 0;
+}
+
+static int
+server_iv_group_setup(void **state)
+{
+	int rc;
+
+	rc = ABT_init(0, NULL);
+	assert_int_equal(rc, ABT_SUCCESS);
+
+	rc = pthread_key_create(&dss_tls_key, NULL);
+	assert_int_equal(rc, 0);
+	test_dmi.dmi_xs_id = 0;
+	test_dtls_values[daos_srv_modkey.dmk_index] = &test_dmi;
+	dss_module_keys[daos_srv_modkey.dmk_index] = &daos_srv_modkey;
+	rc = pthread_setspecific(dss_tls_key, &test_dtls);
+	assert_int_equal(rc, 0);
+
+	ds_iv_init();
+	rc = ds_iv_class_register(TEST_IV_CLASS, &test_crt_ops,
+				  &test_class_ops);
+	assert_int_equal(rc, 0);
+	return 0;
+}
+
+static int
+server_iv_group_teardown(void **state)
+{
+	ds_iv_class_unregister(TEST_IV_CLASS);
+	ds_iv_fini();
+	pthread_key_delete(dss_tls_key);
+	ABT_finalize();
+	return 0;
+}
+
+/*
+ * Unit tests
+ */
+static void
+test_lazy_update_one(void **state)
+{
+	assert_int_equal(lazy_update(1), 0);
+	assert_int_equal(update_nr, 1);
+	assert_int_equal(updates[0].tu_value, 1);
+	assert_int_equal(updates[0].tu_sync.ivs_mode, CRT_IV_SYNC_LAZY);
+	assert_non_null(updates[0].tu_sync.ivs_comp_cb);
+
+	update_complete(0, 0);
+	assert_int_equal(ult_nr, 0);
+	assert_all_done();
+}
+
+static void
+test_lazy_update_coalesce(void **state)
+{
+	assert_int_equal(lazy_update(1), 0);
+
+	/* queued behind the one in flight, the latest value wins */
+	assert_int_equal(lazy_update(2), 0);
+	assert_int_equal(lazy_update(3), 0);
+	assert_int_equal(update_nr, 1);
+
+	/* the queued value is sent once the first one completes */
+	update_complete(0, 0);
+	assert_int_equal(update_nr, 1);
+	assert_int_equal(ult_nr, 1);
+	ult_run_all();
+	assert_int_equal(update_nr, 2);
+	assert_int_equal(updates[1].tu_value, 3);
+
+	/* an update issued meanwhile queues behind the resent one */
+	assert_int_equal(lazy_update(4), 0);
+	assert_int_equal(update_nr, 2);
+
+	update_complete(1, 0);
+	ult_run_all();
+	assert_int_equal(update_nr, 3);
+	assert_int_equal(updates[2].tu_value, 4);
+
+	update_complete(2, 0);
+	assert_int_equal(update_nr, 3);
+	assert_all_done();
+}
+
+static void
+test_lazy_update_grpver(void **state)
+{
+	assert_int_equal(lazy_update(1), 0);
+
+	/* the same value is resent once */
+	update_complete(0, -DER_GRPVER);
+	assert_int_equal(ult_nr, 1);
+	ult_run_all();
+	assert_int_equal(update_nr, 2);
+	assert_int_equal(updates[1].tu_value, 1);
+
+	update_complete(1, 0);
+	assert_int_equal(update_nr, 2);
+	assert_all_done();
+}
+
+static void
+test_lazy_update_grpver_queued(void **state)
+{
+	assert_int_equal(lazy_update(1), 0);
+	assert_int_equal(lazy_update(2), 0);
+
+	/* the value queued is sent instead of the stale one */
+	update_complete(0, -DER_GRPVER);
+	ult_run_all();
+	assert_int_equal(update_nr, 2);
+	assert_int_equal(updates[1].tu_value, 2);
+
+	update_complete(1, 0);
+	assert_int_equal(update_nr, 2);
+	assert_all_done();
+}
+
+static void
+test_lazy_update_send_failure(void **state)
+{
+	/*
+	 * The sync is completed by the failed send, and the retry of
+	 * ds_iv_update() does not send it a second time.
+	 */
+	update_fail_rc = -DER_GRPVER;
+	assert_int_equal(lazy_update(1), 0);
+	assert_int_equal(update_nr, 1);
+	assert_int_equal(ult_nr, 1);
+
+	ult_run_all();
+	assert_int_equal(update_nr, 2);
+	assert_int_equal(updates[1].tu_value, 1);
+
+	update_complete(1, 0);
+	assert_int_equal(update_nr, 2);
+	assert_all_done();
+}
+
+int
+main(void)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_lazy_update_one,
+						server_iv_test_setup,
+						server_iv_test_teardown),
+		cmocka_unit_test_setup_teardown(test_lazy_update_coalesce,
+						server_iv_test_setup,
+						server_iv_test_teardown),
+		cmocka_unit_test_setup_teardown(test_lazy_update_grpver,
+						server_iv_test_setup,
+						server_iv_test_teardown),
+		cmocka_unit_test_setup_teardown(test_lazy_update_grpver_queued,
+						server_iv_test_setup,
+						server_iv_test_teardown),
+		cmocka_unit_test_setup_teardown(test_lazy_update_send_failure,
+						server_iv_test_setup,
+						server_iv_test_teardown),
+	};
+
+	return cmocka_run_group_tests_name("engine_server_iv", tests,
+					   server_iv_group_setup,
+					   server_iv_group_teardown);
+}
@@ -423,6 +423,25 @@ dss_ult_periodic(void (*func)(void *), void *arg, int xs_type, int tgt_idx,
 				   ult, DSS_ULT_FL_PERIODIC);
 }
 
+/**
+ * Executor of the software asynchronous (de)compression, it runs the jobs on
+ * the offload xstream of the calling target. The job is declined, and so run
+ * by the caller, if the target has no offload xstream of its own.
+ */
+int
+dss_compress_offload(void (*func)(void *), void *arg)
+{
+	struct dss_module_info	*dmi = dss_get_module_info();
+
+	if (dmi == NULL || dmi->dmi_tgt_id < 0 ||
+	    sched_ult2xs(DSS_XS_OFFLOAD, dmi->dmi_tgt_id) ==
+	    DSS_MAIN_XS_ID(dmi->dmi_tgt_id))
+		return -DER_NOSYS;
+
+	return dss_ult_create(func, arg, DSS_XS_OFFLOAD, dmi->dmi_tgt_id, 0,
+			      NULL);
+}
+
 static void
 ult_execute_cb(void *data)
 {
@@ -1824,6 +1824,81 @@ failure:
 	return rc;
 }
 
+/**
+ * Removes the metric or directory at the specified path, with all the metrics
+ * below it.  The node is unlinked from its parent, a later d_tm_add_metric()
+ * of the same path creates a new metric.  The shared memory of the node is not
+ * reclaimed, a consumer that still holds a pointer to it reads stale values.
+ *
+ * \param[in]	path	Full path name of the metric or directory to remove
+ *
+ * \return		D_TM_SUCCESS		Success
+ *			-DER_INVAL		Bad path given
+ *			-DER_METRIC_NOT_FOUND	No metric at this path
+ *			-DER_UNINIT		API not initialized
+ */
+int
+d_tm_del_metric(char *path)
+{
+	struct d_tm_node_t	*parent_node;
+	struct d_tm_node_t	*node;
+	struct d_tm_node_t	*prev;
+	struct d_tm_node_t	*temp;
+	char			str[D_TM_MAX_NAME_LEN];
+	char			*token;
+	char			*rest = str;
+	int			rc;
+
+	if (d_tm_shmem_root == NULL)
+		return -DER_UNINIT;
+
+	if (path == NULL)
+		return -DER_INVAL;
+
+	rc = D_MUTEX_LOCK(&d_tm_add_lock);
+	if (rc != 0) {
+		D_ERROR("Failed to get mutex: " DF_RC "\n", DP_RC(rc));
+		return rc;
+	}
+
+	node = NULL;
+	parent_node = d_tm_get_root(d_tm_shmem_root);
+	snprintf(str, sizeof(str), "%s", path);
+	token = strtok_r(rest, "/", &rest);
+	while (token != NULL) {
+		if (node != NULL)
+			parent_node = node;
+		node = d_tm_find_child(d_tm_shmem_root, parent_node, token);
+		if (node == NULL)
+			break;
+		token = strtok_r(rest, "/", &rest);
+	}
+
+	if (node == NULL) {
+		rc = -DER_METRIC_NOT_FOUND;
+		goto out;
+	}
+
+	/** unlink the node from the children of its parent */
+	if (parent_node->dtn_child == node) {
+		parent_node->dtn_child = node->dtn_sibling;
+	} else {
+		prev = parent_node->dtn_child;
+		temp = prev->dtn_sibling;
+		while (temp != node) {
+			prev = temp;
+			temp = temp->dtn_sibling;
+		}
+		prev->dtn_sibling = node->dtn_sibling;
+	}
+	node->dtn_sibling = NULL;
+
+	D_DEBUG(DB_TRACE, "successfully removed item: [%s]\n", path);
+out:
+	D_MUTEX_UNLOCK(&d_tm_add_lock);
+	return rc;
+}
+
 /**
  * Client function to read the specified counter.  If the node is provided,
  * that pointer is used for the read.  Otherwise, a lookup by the metric name
@@ -18,6 +18,7 @@
 #include "gurt/common.h"
 #include "gurt/list.h"
 #include "gurt/heap.h"
+#include "gurt/twheel.h"
 #include "gurt/dlog.h"
 #include "gurt/hash.h"
 #include "gurt/atomic.h"
@@ -623,6 +624,62 @@ test_binheap(void **state)
 	d_binheap_destroy(h);
 }
 
+static void
+test_twheel(void **state)
+{
+	struct d_twheel		 w;
+	struct d_twheel_node	 n1, n2, n3, n4;
+	struct d_twheel_node	*n_tmp;
+	d_list_t		 expired;
+	uint64_t		 now = 1000000;
+	uint32_t		 nr;
+	int			 rc;
+
+	(void)state;
+
+	rc = d_twheel_init(&w, 0, now);
+	assert_int_equal(rc, -DER_INVAL);
+	rc = d_twheel_init(&w, 10, now);
+	assert_int_equal(rc, 0);
+	D_INIT_LIST_HEAD(&expired);
+
+	/* one node per level, and one already expired */
+	d_twheel_insert(&w, &n1, now + 100);
+	d_twheel_insert(&w, &n2, now + 100000);
+	d_twheel_insert(&w, &n3, now + 10000000000ULL);
+	d_twheel_insert(&w, &n4, now - 100);
+	assert_int_equal(d_twheel_size(&w), 4);
+
+	nr = d_twheel_expire(&w, now, &expired);
+	assert_int_equal(nr, 1);
+	n_tmp = d_list_pop_entry(&expired, struct d_twheel_node, tn_link);
+	assert_true(n_tmp == &n4);
+
+	/* never expires early */
+	nr = d_twheel_expire(&w, now + 99, &expired);
+	assert_int_equal(nr, 0);
+	nr = d_twheel_expire(&w, now + 100, &expired);
+	assert_int_equal(nr, 1);
+	n_tmp = d_list_pop_entry(&expired, struct d_twheel_node, tn_link);
+	assert_true(n_tmp == &n1);
+
+	d_twheel_remove(&w, &n2);
+	assert_int_equal(d_twheel_size(&w), 1);
+	nr = d_twheel_expire(&w, now + 1000000, &expired);
+	assert_int_equal(nr, 0);
+
+	/* cascaded down from the overflow list */
+	nr = d_twheel_expire(&w, now + 10000000000ULL - 1, &expired);
+	assert_int_equal(nr, 0);
+	nr = d_twheel_expire(&w, now + 10000000000ULL, &expired);
+	assert_int_equal(nr, 1);
+	n_tmp = d_list_pop_entry(&expired, struct d_twheel_node, tn_link);
+	assert_true(n_tmp == &n3);
+	assert_true(d_twheel_is_empty(&w));
+
+	d_twheel_fini(&w);
+}
+
 #define LOG_DEBUG(fac, ...) \
 	do {								\
 		if (d_log_check((fac) | DLOG_DBG))			\
@@ -2001,6 +2058,7 @@ main(int argc, char **argv)
 		cmocka_unit_test(test_gurt_hlist),
 		cmocka_unit_test(test_gurt_circular_list),
 		cmocka_unit_test(test_binheap),
+		cmocka_unit_test(test_twheel),
 		cmocka_unit_test(test_log),
 		cmocka_unit_test(test_gurt_hash_empty),
 		cmocka_unit_test(test_gurt_hash_insert_lookup_delete),
@@ -211,6 +211,49 @@ test_input_validation(void **state)
 	D_FREE_PTR(path);
 }
 
+static void
+test_del_metric(void **state)
+{
+	struct d_tm_node_t	*first;
+	struct d_tm_node_t	*second;
+	struct d_tm_node_t	*node;
+	int			rc;
+
+	rc = d_tm_add_metric(&first, "gurt/tests/telem/del/first",
+			     D_TM_COUNTER, "", "");
+	assert_int_equal(rc, D_TM_SUCCESS);
+	rc = d_tm_add_metric(&second, "gurt/tests/telem/del/second",
+			     D_TM_COUNTER, "", "");
+	assert_int_equal(rc, D_TM_SUCCESS);
+
+	/** a metric unlinked from its siblings */
+	rc = d_tm_del_metric("gurt/tests/telem/del/first");
+	assert_int_equal(rc, D_TM_SUCCESS);
+	rc = d_tm_del_metric("gurt/tests/telem/del/first");
+	assert_int_equal(rc, -DER_METRIC_NOT_FOUND);
+
+	/** the others are still found */
+	rc = d_tm_add_metric(&node, "gurt/tests/telem/del/second",
+			     D_TM_COUNTER, "", "");
+	assert_int_equal(rc, D_TM_SUCCESS);
+	assert_ptr_equal(node, second);
+
+	/** adding it again creates a new metric */
+	rc = d_tm_add_metric(&node, "gurt/tests/telem/del/first",
+			     D_TM_COUNTER, "", "");
+	assert_int_equal(rc, D_TM_SUCCESS);
+	assert_ptr_not_equal(node, first);
+
+	/** a whole directory, the consumer does not see any of them */
+	rc = d_tm_del_metric("gurt/tests/telem/del");
+	assert_int_equal(rc, D_TM_SUCCESS);
+	rc = d_tm_del_metric("gurt/tests/telem/del/second");
+	assert_int_equal(rc, -DER_METRIC_NOT_FOUND);
+
+	rc = d_tm_del_metric(NULL);
+	assert_int_equal(rc, -DER_INVAL);
+}
+
 static void
 test_shared_memory_cleanup(void **state)
 {
@@ -318,6 +361,7 @@ main(int argc, char **argv)
 		cmocka_unit_test(test_input_validation),
 		cmocka_unit_test(test_gauge_stats),
 		cmocka_unit_test(test_duration_stats),
+		cmocka_unit_test(test_del_metric),
 		cmocka_unit_test(test_shared_memory_cleanup),
 	};
 
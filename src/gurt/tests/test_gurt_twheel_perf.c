@@ -0,0 +1,249 @@
+/*
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/*
+ * This file compares the timing wheel and the bin heap of GURT as timeout
+ * trackers, with the pattern of the RPC timeouts of CaRT: many inflight
+ * nodes with about the same timeout, most of them removed before expiring,
+ * and an expiry check every millisecond.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "wrap_cmocka.h"
+#include "gurt/common.h"
+#include "gurt/heap.h"
+#include "gurt/twheel.h"
+
+/* times are in us, as for CaRT */
+#define PERF_TIMEOUT	(60 * 1000000ULL)
+#define PERF_JITTER	(1000000)
+#define PERF_TICK	(1000)
+/* the last node expires at most two ticks after the last timeout */
+#define PERF_END	(PERF_TIMEOUT + PERF_JITTER + 2 * PERF_TICK)
+/* one node out of PERF_EXPIRE_RATIO expires, the others are removed */
+#define PERF_EXPIRE_RATIO	(10)
+
+struct perf_node {
+	struct d_binheap_node	pn_bh_node;
+	struct d_twheel_node	pn_tw_node;
+	uint64_t		pn_expire;
+};
+
+struct perf_result {
+	uint64_t	pr_insert_ns;
+	uint64_t	pr_remove_ns;
+	uint64_t	pr_expire_ns;
+};
+
+static uint32_t	perf_counts[] = { 10000, 100000, 1000000 };
+
+static bool
+perf_bh_cmp(struct d_binheap_node *a, struct d_binheap_node *b)
+{
+	struct perf_node	*na;
+	struct perf_node	*nb;
+
+	na = container_of(a, struct perf_node, pn_bh_node);
+	nb = container_of(b, struct perf_node, pn_bh_node);
+
+	return na->pn_expire < nb->pn_expire;
+}
+
+static struct d_binheap_ops perf_bh_ops = {
+	.hop_enter	= NULL,
+	.hop_exit	= NULL,
+	.hop_compare	= perf_bh_cmp,
+};
+
+static uint64_t
+perf_ns(struct timespec *start)
+{
+	struct timespec	now;
+
+	d_gettime(&now);
+	return d_timediff_ns(start, &now);
+}
+
+static struct perf_node *
+perf_nodes_alloc(uint32_t count, uint64_t now)
+{
+	struct perf_node	*nodes;
+	uint32_t		 i;
+
+	D_ALLOC_ARRAY(nodes, count);
+	assert_non_null(nodes);
+
+	srand(count);
+	for (i = 0; i < count; i++)
+		nodes[i].pn_expire = now + PERF_TIMEOUT + rand() % PERF_JITTER;
+
+	return nodes;
+}
+
+static void
+perf_binheap(struct perf_node *nodes, uint32_t count, uint64_t now,
+	     struct perf_result *res)
+{
+	struct d_binheap	 h;
+	struct d_binheap_node	*root;
+	struct perf_node	*node;
+	struct timespec		 start;
+	uint64_t		 end = now + PERF_END;
+	uint32_t		 expired = 0;
+	uint32_t		 i;
+	int			 rc;
+
+	rc = d_binheap_create_inplace(DBH_FT_NOLOCK, count, NULL, &perf_bh_ops,
+				      &h);
+	assert_int_equal(rc, 0);
+
+	d_gettime(&start);
+	for (i = 0; i < count; i++) {
+		rc = d_binheap_insert(&h, &nodes[i].pn_bh_node);
+		assert_int_equal(rc, 0);
+	}
+	res->pr_insert_ns = perf_ns(&start);
+
+	d_gettime(&start);
+	for (i = 0; i < count; i++) {
+		if (i % PERF_EXPIRE_RATIO != 0)
+			d_binheap_remove(&h, &nodes[i].pn_bh_node);
+	}
+	res->pr_remove_ns = perf_ns(&start);
+
+	d_gettime(&start);
+	for (; now <= end; now += PERF_TICK) {
+		while ((root = d_binheap_root(&h)) != NULL) {
+			node = container_of(root, struct perf_node,
+					    pn_bh_node);
+			if (node->pn_expire > now)
+				break;
+			d_binheap_remove(&h, root);
+			expired++;
+		}
+	}
+	res->pr_expire_ns = perf_ns(&start);
+
+	assert_int_equal(expired, (count + PERF_EXPIRE_RATIO - 1) /
+				  PERF_EXPIRE_RATIO);
+	assert_true(d_binheap_is_empty(&h));
+	d_binheap_destroy_inplace(&h);
+}
+
+static void
+perf_twheel(struct perf_node *nodes, uint32_t count, uint64_t now,
+	    struct perf_result *res)
+{
+	struct d_twheel		*w;
+	struct perf_node	*node;
+	struct timespec		 start;
+	d_list_t		 list;
+	uint64_t		 end = now + PERF_END;
+	uint32_t		 expired = 0;
+	uint32_t		 i;
+	int			 rc;
+
+	D_ALLOC_PTR(w);
+	assert_non_null(w);
+	rc = d_twheel_init(w, PERF_TICK, now);
+	assert_int_equal(rc, 0);
+	D_INIT_LIST_HEAD(&list);
+
+	d_gettime(&start);
+	for (i = 0; i < count; i++)
+		d_twheel_insert(w, &nodes[i].pn_tw_node, nodes[i].pn_expire);
+	res->pr_insert_ns = perf_ns(&start);
+
+	d_gettime(&start);
+	for (i = 0; i < count; i++) {
+		if (i % PERF_EXPIRE_RATIO != 0)
+			d_twheel_remove(w, &nodes[i].pn_tw_node);
+	}
+	res->pr_remove_ns = perf_ns(&start);
+
+	d_gettime(&start);
+	for (; now <= end; now += PERF_TICK) {
+		if (d_twheel_expire(w, now, &list) == 0)
+			continue;
+		/* never early, at most one tick and one check interval late */
+		d_list_for_each_entry(node, &list, pn_tw_node.tn_link) {
+			assert_true(node->pn_expire <= now);
+			assert_true(node->pn_expire + 2 * PERF_TICK > now);
+			expired++;
+		}
+		D_INIT_LIST_HEAD(&list);
+	}
+	res->pr_expire_ns = perf_ns(&start);
+
+	assert_int_equal(expired, (count + PERF_EXPIRE_RATIO - 1) /
+				  PERF_EXPIRE_RATIO);
+	assert_true(d_twheel_is_empty(w));
+	d_twheel_fini(w);
+	D_FREE(w);
+}
+
+static void
+perf_print(const char *name, uint32_t count, struct perf_result *res)
+{
+	uint32_t	nr_rm = count - (count + PERF_EXPIRE_RATIO - 1) /
+				PERF_EXPIRE_RATIO;
+
+	print_message("%-8s %8u nodes: insert %6.1f ns/op, remove %6.1f "
+		      "ns/op, expire %8.3f ms total\n", name, count,
+		      (double)res->pr_insert_ns / count,
+		      (double)res->pr_remove_ns / nr_rm,
+		      (double)res->pr_expire_ns / 1e6);
+}
+
+static void
+test_twheel_vs_binheap(void **state)
+{
+	struct perf_node	*nodes;
+	struct perf_result	 res;
+	uint64_t		 now;
+	int			 i;
+
+	(void)state;
+
+	for (i = 0; i < ARRAY_SIZE(perf_counts); i++) {
+		now = d_timeus_secdiff(0);
+		nodes = perf_nodes_alloc(perf_counts[i], now);
+
+		perf_binheap(nodes, perf_counts[i], now, &res);
+		perf_print("binheap", perf_counts[i], &res);
+
+		perf_twheel(nodes, perf_counts[i], now, &res);
+		perf_print("twheel", perf_counts[i], &res);
+
+		D_FREE(nodes);
+	}
+}
+
+static int
+init_tests(void **state)
+{
+	return d_log_init();
+}
+
+static int
+fini_tests(void **state)
+{
+	d_log_fini();
+
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	const struct CMUnitTest	tests[] = {
+		cmocka_unit_test(test_twheel_vs_binheap),
+	};
+
+	d_register_alt_assert(mock_assert);
+
+	return cmocka_run_group_tests_name("test_gurt_twheel_perf", tests,
+					   init_tests, fini_tests);
+}
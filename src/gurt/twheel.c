@@ -0,0 +1,175 @@
+/*
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * This file is part of gurt, it implements the gurt timing wheel functions.
+ */
+#define D_LOGFAC	DD_FAC(mem)
+
+#include <gurt/common.h>
+#include <gurt/twheel.h>
+
+/** index of the slot of tick \a t in level \a l */
+#define dtw_slot_idx(t, l)	(((t) >> ((l) * D_TW_BITS)) & D_TW_MASK)
+
+int
+d_twheel_init(struct d_twheel *w, uint64_t gran, uint64_t now)
+{
+	int	i;
+	int	j;
+
+	if (w == NULL || gran == 0) {
+		D_ERROR("invalid parameter, w %p, gran "DF_U64".\n", w, gran);
+		return -DER_INVAL;
+	}
+
+	memset(w->tw_nr, 0, sizeof(w->tw_nr));
+	w->tw_count = 0;
+	w->tw_gran = gran;
+	w->tw_tick = now / gran;
+	D_INIT_LIST_HEAD(&w->tw_overflow);
+	for (i = 0; i < D_TW_LEVELS; i++)
+		for (j = 0; j < D_TW_SLOTS; j++)
+			D_INIT_LIST_HEAD(&w->tw_slots[i][j]);
+
+	return 0;
+}
+
+void
+d_twheel_fini(struct d_twheel *w)
+{
+	if (w->tw_count != 0)
+		D_WARN("%u nodes are still in the timing wheel.\n",
+		       w->tw_count);
+}
+
+/** link \a e in the slot matching its expiry tick */
+static void
+dtw_link(struct d_twheel *w, struct d_twheel_node *e)
+{
+	uint64_t	diff;
+	d_list_t	*head;
+	int		l;
+
+	if (e->tn_expire < w->tw_tick)
+		e->tn_expire = w->tw_tick;
+
+	/*
+	 * Level N holds the nodes which are in the same D_TW_SLOTS^(N+1) ticks
+	 * block as the current tick, so they reach level 0 before expiring.
+	 */
+	diff = e->tn_expire ^ w->tw_tick;
+	for (l = 0; l < D_TW_LEVELS; l++) {
+		if ((diff >> ((l + 1) * D_TW_BITS)) == 0)
+			break;
+	}
+
+	if (l < D_TW_LEVELS)
+		head = &w->tw_slots[l][dtw_slot_idx(e->tn_expire, l)];
+	else
+		head = &w->tw_overflow;
+
+	e->tn_level = l;
+	w->tw_nr[l]++;
+	d_list_add_tail(&e->tn_link, head);
+}
+
+void
+d_twheel_insert(struct d_twheel *w, struct d_twheel_node *e, uint64_t expire)
+{
+	/* round up, a node never expires early */
+	e->tn_expire = expire / w->tw_gran + (expire % w->tw_gran != 0);
+	dtw_link(w, e);
+	w->tw_count++;
+}
+
+void
+d_twheel_remove(struct d_twheel *w, struct d_twheel_node *e)
+{
+	D_ASSERT(w->tw_count > 0);
+	D_ASSERT(w->tw_nr[e->tn_level] > 0);
+
+	d_list_del_init(&e->tn_link);
+	w->tw_nr[e->tn_level]--;
+	w->tw_count--;
+}
+
+/** move the nodes of \a head down to the lower levels */
+static void
+dtw_cascade(struct d_twheel *w, d_list_t *head, int level)
+{
+	struct d_twheel_node	*e;
+	struct d_twheel_node	*tmp;
+	d_list_t		 list;
+
+	if (d_list_empty(head))
+		return;
+
+	D_INIT_LIST_HEAD(&list);
+	d_list_splice_init(head, &list);
+	d_list_for_each_entry_safe(e, tmp, &list, tn_link) {
+		d_list_del(&e->tn_link);
+		w->tw_nr[level]--;
+		dtw_link(w, e);
+	}
+}
+
+uint32_t
+d_twheel_expire(struct d_twheel *w, uint64_t now, d_list_t *expired)
+{
+	struct d_twheel_node	*e;
+	d_list_t		*head;
+	uint64_t		 end = now / w->tw_gran + 1;
+	uint64_t		 next;
+	uint32_t		 nr = 0;
+	int			 l;
+
+	while (w->tw_tick < end) {
+		if (w->tw_count == 0) {
+			w->tw_tick = end;
+			break;
+		}
+
+		/* entering a new block, move its nodes down, top level first */
+		if ((w->tw_tick & (((uint64_t)1 << (D_TW_LEVELS * D_TW_BITS))
+				   - 1)) == 0)
+			dtw_cascade(w, &w->tw_overflow, D_TW_LEVELS);
+		for (l = D_TW_LEVELS - 1; l > 0; l--) {
+			if ((w->tw_tick & (((uint64_t)1 << (l * D_TW_BITS))
+					   - 1)) != 0)
+				continue;
+			dtw_cascade(w, &w->tw_slots[l][dtw_slot_idx(w->tw_tick,
+								    l)], l);
+		}
+
+		head = &w->tw_slots[0][dtw_slot_idx(w->tw_tick, 0)];
+		if (!d_list_empty(head)) {
+			d_list_for_each_entry(e, head, tn_link) {
+				w->tw_nr[0]--;
+				w->tw_count--;
+				nr++;
+			}
+			/* append to the tail of the expired list */
+			d_list_splice_init(head, expired->prev);
+		}
+
+		/*
+		 * Skip the blocks of ticks which have no node, up to the next
+		 * block start of the lowest non-empty level.
+		 */
+		for (l = 0; l < D_TW_LEVELS; l++) {
+			if (w->tw_nr[l] != 0)
+				break;
+		}
+		if (l == 0) {
+			w->tw_tick++;
+			continue;
+		}
+		next = w->tw_tick | (((uint64_t)1 << (l * D_TW_BITS)) - 1);
+		w->tw_tick = min(next + 1, end);
+	}
+
+	return nr;
+}
@@ -106,6 +106,41 @@ crt_context_create(crt_context_t *crt_ctx);
 int
 crt_context_set_timeout(crt_context_t crt_ctx, uint32_t timeout_sec);
 
+/**
+ * Start \a nr helper threads progressing the specified context, in addition
+ * to the threads calling crt_progress() on it. Network progress and the RPC
+ * callbacks and handlers of the context are then run by all of them, so that
+ * a burst of RPCs to one context can use several cores.
+ *
+ * The RPC handlers of the context, and the callback registered by
+ * crt_context_register_rpc_task() if any, must be thread-safe. Timeouts and
+ * progress callbacks are still processed by crt_progress() only.
+ *
+ * This is an optional function, it replaces the helper threads started by a
+ * previous call. The threads are stopped by crt_context_destroy(), and
+ * restarted if the context cannot be destroyed yet.
+ *
+ * \param[in] crt_ctx          CaRT context
+ * \param[in] nr               number of helper threads, 0 to stop them
+ *
+ * \return                     DER_SUCCESS on success, negative value if error
+ */
+int
+crt_context_set_progress_threads(crt_context_t crt_ctx, uint32_t nr);
+
+/**
+ * Query the statistics of the pool of RPC handles of the specified context.
+ * The pool adapts its size to the number of RPCs in flight.
+ *
+ * \param[in] crt_ctx          CaRT context
+ * \param[out] stats           returned statistics
+ *
+ * \return                     DER_SUCCESS on success, negative value if error
+ */
+int
+crt_context_hdl_pool_stats(crt_context_t crt_ctx,
+			   struct crt_hdl_pool_stats *stats);
+
 /**
  * Destroy CRT transport context.
  *
@@ -165,6 +200,20 @@ crt_context_flush(crt_context_t crt_ctx, uint64_t timeout);
 int
 crt_context_idx(crt_context_t crt_ctx, int *ctx_idx);
 
+/**
+ * Query the max size of the RPC input and output buffers that the transport
+ * of the context can send eagerly, i.e. without an extra RDMA transfer.
+ * Upper layers can use it to decide whether to pack payload inline or to
+ * transfer it with bulk.
+ *
+ * \param[in] crt_ctx          CRT transport context
+ * \param[out] size            pointer to the returned size in bytes
+ *
+ * \return                     DER_SUCCESS on success, negative value if error
+ */
+int
+crt_context_eager_size(crt_context_t crt_ctx, size_t *size);
+
 /**
  * Query the total number of the transport contexts.
  *
@@ -1052,7 +1101,14 @@ enum crt_tree_type {
 	CRT_TREE_FLAT		= 1,
 	CRT_TREE_KARY		= 2,
 	CRT_TREE_KNOMIAL	= 3,
-	CRT_TREE_MAX		= 3,
+	/*
+	 * two-level tree following the fault domains of the group (see
+	 * crt_group_domains_set), one rank per domain receives the RPC over a
+	 * knomial tree of the domains, and forwards it over a knomial tree of
+	 * its domain, so that each domain is entered once.
+	 */
+	CRT_TREE_DOMAIN		= 4,
+	CRT_TREE_MAX		= 4,
 };
 
 #define CRT_TREE_TYPE_SHIFT	(16U)
@@ -1064,7 +1120,7 @@ enum crt_tree_type {
  *
  * \param[in] tree_type        tree type
  * \param[in] branch_ratio     branch ratio, be ignored for CRT_TREE_FLAT.
- *                             for KNOMIAL tree or KARY tree, the valid value
+ *                             for KNOMIAL, KARY or DOMAIN tree, the valid value
  *                             should within the range of
  *                             [CRT_TREE_MIN_RATIO, CRT_TREE_MAX_RATIO], or
  *                             will be treated as invalid parameter.
@@ -1375,6 +1431,25 @@ crt_group_version(crt_group_t *grp, uint32_t *version);
 int
 crt_group_version_set(crt_group_t *grp, uint32_t version);
 
+/**
+ * Set the fault domains of the group members, used to build the trees of type
+ * CRT_TREE_DOMAIN. They replace the previous ones, and should be set the same
+ * on all the members for a given group version, otherwise the collective RPCs
+ * may skip or duplicate some ranks.
+ *
+ * \param[in] grp              CRT group handle, NULL means the local
+ *                             primary/global group
+ * \param[in] ranks            ranks of the group, the ranks not listed are
+ *                             in no domain
+ * \param[in] domains          fault domain ID of each rank of \a ranks,
+ *                             CRT_NO_DOMAIN if it is unknown
+ *
+ * \return                     DER_SUCCESS on success, negative value on error
+ */
+int
+crt_group_domains_set(crt_group_t *grp, d_rank_list_t *ranks,
+		      uint32_t *domains);
+
 /**
  * Query number of group members.
  *
@@ -1427,6 +1502,34 @@ crt_proc_get_op(crt_proc_t proc, crt_proc_op_t *proc_op);
 int
 crt_proc_memcpy(crt_proc_t proc, void *data, size_t data_size);
 
+/**
+ * Proc routine for a buffer or an array of plain data which can be decoded in
+ * place. The buffer is aligned on \a align bytes in the RPC buffer.
+ *
+ * When decoding the input of an RPC on a server with CRT_PROC_INPLACE enabled
+ * (the default), \a *buf points directly into the RPC buffer and stays valid
+ * until the RPC is destroyed, it must not be freed or reallocated by the
+ * handler. Otherwise it is allocated, and released on CRT_PROC_FREE.
+ *
+ * \param[in,out] proc         abstract processor object
+ * \param[in,out] buf          pointer to the buffer
+ * \param[in] size             buffer size
+ * \param[in] align            alignment of the buffer, a power of 2
+ *
+ * \return                     DER_SUCCESS on success, negative value if error
+ */
+int
+crt_proc_buf(crt_proc_t proc, void **buf, size_t size, size_t align);
+
+/**
+ * Release a buffer decoded by crt_proc_buf(), if it was allocated, and reset
+ * \a *buf to NULL. Only to be called from a proc routine.
+ *
+ * \param[in,out] buf          pointer to the buffer
+ */
+void
+crt_proc_buf_free(void **buf);
+
 /**
  * Generic processing routine.
  *
@@ -45,6 +45,10 @@ struct swim_member_state {
 struct swim_member_update {
 	uint64_t		 smu_id;
 	struct swim_member_state smu_state;
+	/** member which suspected smu_id, for SWIM_MEMBER_SUSPECT updates,
+	 *  SWIM_ID_INVALID otherwise
+	 */
+	uint64_t		 smu_origin;
 };
 
 /** opaque SWIM context type */
@@ -80,6 +80,9 @@ typedef d_string_t	crt_group_id_t;
 /** Indicates rank not being set */
 #define CRT_NO_RANK 0xFFFFFFFF
 
+/** Indicates the fault domain of a rank is unknown */
+#define CRT_NO_DOMAIN 0xFFFFFFFF
+
 typedef struct crt_group {
 	/** the group ID of this group */
 	crt_group_id_t	cg_grpid;
@@ -266,6 +269,15 @@ typedef enum {
  */
 #define CRT_RPC_FEAT_QUEUE_FRONT	(1U << 3)
 
+/**
+ * The RPC may be packed with other RPCs to the same endpoint in one envelope
+ * message, sent when it is full or at the latest CRT_BATCH_DELAY us later.
+ * The target unpacks them and runs the handlers as usual. Only meant for
+ * small RPCs with small replies: a request which does not fit is sent alone,
+ * a reply which does not fit fails with -DER_OVERFLOW.
+ */
+#define CRT_RPC_FEAT_BATCH		(1U << 4)
+
 typedef void *crt_bulk_opid_t;
 
 /** Bulk transfer permissions */
@@ -289,6 +301,16 @@ struct crt_bulk_desc {
 	size_t		 bd_len; /**< length of the bulk transferring */
 };
 
+/** Statistics of the RPC handle pool of a context */
+struct crt_hdl_pool_stats {
+	uint64_t	hps_hits; /**< handles reused from the pool */
+	/** hits on a handle last bound to the same address */
+	uint64_t	hps_addr_hits;
+	uint64_t	hps_misses; /**< handles created on an empty pool */
+	uint32_t	hps_num; /**< idle handles in the pool */
+	uint32_t	hps_max_num; /**< current max of idle handles */
+};
+
 /** Callback info structure */
 struct crt_cb_info {
 	crt_rpc_t		*cci_rpc; /**< rpc struct */
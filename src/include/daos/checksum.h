@@ -294,6 +294,82 @@ daos_csummer_verify_iod(struct daos_csummer *obj, daos_iod_t *iod,
 			struct dcs_layout *singv_lo, int singv_idx,
 			daos_iom_t *map);
 
+/** Copy routine of the fused copy and checksum functions */
+typedef void (*daos_csum_copy_fn_t)(void *dst, void *src, size_t len,
+				    void *arg);
+
+/**
+ * Copy \a len bytes from \a src to \a dst and update the checksum with them.
+ * The data is processed in pieces small enough to still be in the CPU cache
+ * when they are copied after being checksummed, so the source is read from
+ * memory only once.
+ *
+ * @param obj		the daos_csummer obj, set up as for
+ *			daos_csummer_update()
+ * @param dst		destination buffer
+ * @param src		source buffer
+ * @param len		number of bytes to copy
+ * @param copy_fn	copy routine, memcpy() if NULL
+ * @param arg		argument of \a copy_fn
+ *
+ * @return		0 for success, or an error code
+ */
+int
+daos_csummer_copy_update(struct daos_csummer *obj, void *dst, void *src,
+			 size_t len, daos_csum_copy_fn_t copy_fn, void *arg);
+
+/** Largest checksum produced by the supported algorithms (SHA512) */
+#define DAOS_CSUM_MAX_LEN	64
+
+/**
+ * State of the verification of the data of an iod while it is copied, see
+ * daos_csummer_copy_verify().
+ */
+struct dcs_copy_verify {
+	struct daos_csummer	*cv_csummer;
+	daos_iod_t		*cv_iod;
+	struct dcs_iod_csums	*cv_iod_csum;
+	/** chunk size in bytes for the record size of the iod */
+	uint32_t		 cv_rec_chunksize;
+	/** current extent, and current chunk in this extent */
+	uint32_t		 cv_recx_idx;
+	uint32_t		 cv_chunk_idx;
+	/** bytes of the current chunk not copied yet, 0 between chunks */
+	daos_size_t		 cv_chunk_left;
+	/** checksum of the current chunk */
+	uint8_t			 cv_csum[DAOS_CSUM_MAX_LEN];
+};
+
+/**
+ * Prepare the verification of the data of \a iod against \a iod_csum as the
+ * data is copied by daos_csummer_copy_verify(). Single values are verified
+ * as a whole, as daos_csummer_verify_iod() does without a layout.
+ */
+void
+daos_csummer_copy_verify_init(struct dcs_copy_verify *cv,
+			      struct daos_csummer *obj, daos_iod_t *iod,
+			      struct dcs_iod_csums *iod_csum);
+
+/**
+ * Copy the next \a len bytes of the data of the iod from \a src to \a dst,
+ * with daos_csummer_copy_update(), and compare the checksum of every chunk
+ * completed by them with the expected one.
+ *
+ * @return		0 for success, -DER_CSUM if corruption is detected,
+ *			-DER_REC2BIG if the data is longer than the iod
+ */
+int
+daos_csummer_copy_verify(struct dcs_copy_verify *cv, void *dst, void *src,
+			 size_t len, daos_csum_copy_fn_t copy_fn, void *arg);
+
+/**
+ * Check that all the data of the iod has been copied and verified.
+ *
+ * @return		0 for success, -DER_CSUM if some data wasn't verified
+ */
+int
+daos_csummer_copy_verify_fini(struct dcs_copy_verify *cv);
+
 /**
  * Verify a key to a checksum
  *
@@ -46,9 +46,69 @@ enum DAOS_CIPHER_TYPE {
 /** Lookup the appropriate CIPHER_TYPE given daos container property */
 enum DAOS_CIPHER_TYPE daos_contprop2ciphertype(int contprop_encrypt_val);
 
+/** Size of the cipher blocks, array extents are encrypted in whole blocks */
+#define DAOS_CIPHER_BLOCK_SIZE	16
+/** Size of the data units of array values, each one has its own tweak */
+#define DAOS_CIPHER_UNIT_SIZE	4096
+
 struct cipher_ft {
+	/** Expand \a key into a new context, NULL if not supported */
+	int		(*cf_init)(void **daos_cipher_ctx, const uint8_t *key);
+	/**
+	 * Encrypt (or decrypt) \a len bytes of the data unit identified by
+	 * the 16 bytes \a tweak, starting from its block \a blk_idx.
+	 */
+	int		(*cf_crypt)(void *daos_cipher_ctx, const uint8_t *tweak,
+				    uint32_t blk_idx, const uint8_t *src,
+				    uint8_t *dst, size_t len, bool encrypt);
+	void		(*cf_destroy)(void *daos_cipher_ctx);
+	/** Size of the key in bytes */
+	uint16_t	cf_key_len;
 	char		*cf_name;
 	enum DAOS_CIPHER_TYPE	cf_type;
 };
 
+struct cipher_ft *daos_cipher_type2algo(enum DAOS_CIPHER_TYPE type);
+
+struct daos_cipherer {
+	/** Pointer to the function table to be used for encryption */
+	struct cipher_ft	*dc_algo;
+	/** Pointer to function table specific contexts */
+	void			*dc_ctx;
+};
+
+/**
+ * Initialize a cipherer of algorithm \a type with \a key, which must be
+ * daos_cipher_type2algo(type)->cf_key_len bytes long.
+ *
+ * \return		0 on success, -DER_NOSYS if the algorithm can't be
+ *			used for object data.
+ */
+int
+daos_cipherer_init_with_type(struct daos_cipherer **obj,
+			     enum DAOS_CIPHER_TYPE type, const uint8_t *key);
+
+void
+daos_cipherer_destroy(struct daos_cipherer **obj);
+
+/**
+ * Encrypt or decrypt the bytes [\a off, \a off + \a len) of an array value,
+ * \a off and \a len must be multiples of DAOS_CIPHER_BLOCK_SIZE. Each data
+ * unit of DAOS_CIPHER_UNIT_SIZE bytes is encrypted with a tweak made of
+ * \a tweak and of its index, so any block aligned range can be processed
+ * independently of the rest of the value. \a src and \a dst may be equal.
+ *
+ * On decryption, blocks which are all zero are holes never written, they
+ * are left as zero.
+ */
+int
+daos_cipherer_crypt_range(struct daos_cipherer *obj, uint64_t tweak,
+			  uint64_t off, const void *src, void *dst, size_t len,
+			  bool encrypt);
+
+/** Encrypt or decrypt a whole single value of any size */
+int
+daos_cipherer_crypt_value(struct daos_cipherer *obj, uint64_t tweak,
+			  const void *src, void *dst, size_t len, bool encrypt);
+
 #endif /** __DAOS_CIPHER_H */
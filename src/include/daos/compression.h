@@ -52,15 +52,25 @@ enum DAOS_COMPRESS_TYPE {
 enum DAOS_COMPRESS_TYPE daos_contprop2compresstype(int contprop_compress_val);
 
 struct compress_ft;
+struct dc_async;
 struct daos_compressor {
 	/** Pointer to the function table to be used for compression */
 	struct compress_ft *dc_algo;
 	/** Pointer to function table specific contexts */
 	void *dc_ctx;
+	/** Software asynchronous jobs, allocated on first use */
+	struct dc_async *dc_async;
 };
 
 typedef void (*dc_callback_fn)(void *cb_data, int produced, int status);
 
+/**
+ * Executor of the software asynchronous (de)compression, it should call
+ * \a func with \a arg on another thread and return 0, or return an error if
+ * it can't, in which case the job is run by the caller.
+ */
+typedef int (*dc_offload_fn)(void (*func)(void *), void *arg);
+
 struct compress_ft {
 	int		(*cf_init)(
 				void **daos_dc_ctx,
@@ -208,11 +218,52 @@ daos_compressor_decompress_async(
 /**
  * Poll response on asynchronous mode.
  *
+ * For algorithms without hardware offload, this calls the callbacks of the
+ * completed jobs submitted by the calling thread and returns the number of
+ * jobs of \a obj still in flight.
+ *
  * \param[in]	obj		compressor.
  */
 int
 daos_compressor_poll_response(struct daos_compressor *obj);
 
+/**
+ * Set the executor of the software asynchronous mode, which is used by the
+ * algorithms without hardware offload. Without executor, asynchronous jobs
+ * are run by the caller on submission and complete on the next poll.
+ *
+ * Jobs of a compressor are run one at a time, in submission order, so they
+ * must not be mixed with synchronous calls in the same direction on the same
+ * compressor. Callbacks are always called by the thread which submitted the
+ * job, from daos_compressor_poll_response() or daos_compressor_progress().
+ *
+ * \param[in]	fn		executor, NULL to disable offloading.
+ */
+void
+daos_compressor_set_offload(dc_offload_fn fn);
+
+/**
+ * Does \a obj run its asynchronous jobs on the software executor?
+ *
+ * \param[in]	obj		compressor.
+ */
+bool
+daos_compressor_offloaded(struct daos_compressor *obj);
+
+/**
+ * Call the callbacks of all the completed software asynchronous jobs
+ * submitted by the calling thread, and return how many were called.
+ */
+int
+daos_compressor_progress(void);
+
+/**
+ * Are there completed software asynchronous jobs submitted by the calling
+ * thread whose callbacks are yet to be called?
+ */
+bool
+daos_compressor_pending(void);
+
 /**
  * Destroy and release the compressor.
  *
@@ -26,9 +26,19 @@ int dc_cont_node_id2ptr(daos_handle_t coh, uint32_t node_id,
 int dc_cont_hdl2uuid(daos_handle_t coh, uuid_t *hdl_uuid, uuid_t *con_uuid);
 daos_handle_t dc_cont_hdl2pool_hdl(daos_handle_t coh);
 struct daos_csummer *dc_cont_hdl2csummer(daos_handle_t coh);
+struct daos_cipherer *dc_cont_hdl2cipherer(daos_handle_t coh);
 struct cont_props dc_cont_hdl2props(daos_handle_t coh);
 int dc_cont_hdl2redunfac(daos_handle_t coh);
 
+struct pl_map;
+struct pl_obj_layout;
+struct pl_layout_cache_stats;
+struct daos_obj_md;
+int dc_cont_obj_place(daos_handle_t coh, struct pl_map *map,
+		      struct daos_obj_md *md, struct pl_obj_layout **layout);
+int dc_cont_layout_cache_stats(daos_handle_t coh,
+			       struct pl_layout_cache_stats *stats);
+
 int dc_cont_local2global(daos_handle_t coh, d_iov_t *glob);
 int dc_cont_global2local(daos_handle_t poh, d_iov_t glob,
 			 daos_handle_t *coh);
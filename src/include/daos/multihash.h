@@ -35,6 +35,13 @@ enum DAOS_HASH_TYPE {
 /** Lookup the appropriate HASH_TYPE given daos container property */
 enum DAOS_HASH_TYPE daos_contprop2hashtype(int contprop_csum_val);
 
+/** A buffer to hash, and where its hash is written */
+struct daos_mhash_buf {
+	uint8_t		*mb_buf;
+	size_t		 mb_len;
+	uint8_t		*mb_hash;
+};
+
 struct hash_ft {
 	int		(*cf_init)(void **daos_mhash_ctx);
 	void		(*cf_destroy)(void *daos_mhash_ctx);
@@ -48,6 +55,9 @@ struct hash_ft {
 	bool		(*cf_compare)(void *daos_mhash_ctx,
 				      uint8_t *buf1, uint8_t *buf2,
 				      size_t buf_len);
+	/** Optional, hash each of \a nr buffers on its own in one call */
+	int		(*cf_batch)(void *daos_mhash_ctx,
+				    struct daos_mhash_buf *bufs, uint32_t nr);
 
 	/** Len in bytes. Ft can either statically set csum_len or provide
 	 *  a get_len function
@@ -60,4 +70,19 @@ struct hash_ft {
 struct hash_ft *
 daos_mhash_type2algo(enum DAOS_HASH_TYPE type);
 
+/**
+ * Hash each of the \a nr buffers on its own, with the multi-buffer
+ * implementation of \a ft if it has one, or else one buffer after the other.
+ *
+ * @param ft		function table of the hash algorithm
+ * @param ctx		context created by ft->cf_init
+ * @param bufs		buffers to hash and where to write their hashes
+ * @param nr		number of buffers
+ *
+ * @return		0 for success, or an error code
+ */
+int
+daos_mhash_batch(struct hash_ft *ft, void *ctx, struct daos_mhash_buf *bufs,
+		 uint32_t nr);
+
 #endif /** __DAOS_MULTIHASH_H */
@@ -389,6 +389,23 @@ daos_size_t daos_iods_len(daos_iod_t *iods, int nr);
 
 int dc_obj_init(void);
 void dc_obj_fini(void);
+/* Release the bulk buffers cached on the global client context */
+void dc_obj_bulk_cache_purge(void);
+/* Hits and misses of the bulk buffer cache, and the bytes it copied */
+void dc_obj_bulk_cache_stats(uint64_t *hits, uint64_t *misses,
+			     uint64_t *copied);
+/*
+ * Commits (CPD RPCs) of coalesced update batches, updates attached to them,
+ * and updates submitted again on their own after their batch failed
+ */
+void dc_obj_coalesce_stats(uint64_t *commits, uint64_t *updates,
+			   uint64_t *resubmits);
+/*
+ * Hits and misses of the cache of stripes reconstructed by degraded EC
+ * fetches, and the stripes dropped because the pool map changed
+ */
+void dc_obj_ec_recov_cache_stats(uint64_t *hits, uint64_t *misses,
+				 uint64_t *dropped);
 
 int dc_obj_register_class(tse_task_t *task);
 int dc_obj_query_class(tse_task_t *task);
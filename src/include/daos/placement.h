@@ -128,6 +128,26 @@ int pl_obj_place(struct pl_map *map,
 		 struct daos_obj_shard_md *shard_md,
 		 struct pl_obj_layout **layout_pp);
 
+/** Cache of computed object layouts, see pl_obj_place_cached() */
+struct pl_layout_cache;
+
+struct pl_layout_cache_stats {
+	/** lookups served by a cached layout */
+	uint64_t	lcs_hits;
+	/** lookups that computed the layout */
+	uint64_t	lcs_misses;
+	/** cached layouts invalidated by placement map refresh */
+	uint64_t	lcs_evicts;
+};
+
+int pl_layout_cache_create(int bits, struct pl_layout_cache **cache_p);
+void pl_layout_cache_destroy(struct pl_layout_cache *cache);
+int pl_obj_place_cached(struct pl_layout_cache *cache, struct pl_map *map,
+			struct daos_obj_md *md,
+			struct pl_obj_layout **layout_pp);
+void pl_layout_cache_stats_get(struct pl_layout_cache *cache,
+			       struct pl_layout_cache_stats *stats);
+
 int pl_obj_find_rebuild(struct pl_map *map,
 			struct daos_obj_md *md,
 			struct daos_obj_shard_md *shard_md,
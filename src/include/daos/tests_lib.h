@@ -155,6 +155,8 @@ struct dts_context {
 	/** if pool/cont already created then can skip internal creation */
 	bool			 tsc_skip_pool_create;
 	bool			 tsc_skip_cont_create;
+	/** optional, properties of the created container, only for DAOS test */
+	daos_prop_t		*tsc_cont_prop;
 	/** INPUT END */
 
 	/** OUTPUT: initialized within \a dts_ctx_init() */
@@ -28,7 +28,16 @@ typedef struct {
 	/* Is the address a hole ? */
 	uint16_t	ba_hole;
 	uint16_t	ba_dedup;
-	uint16_t	ba_padding;
+	/*
+	 * Is the extent stored compressed (SCM array records only)? For
+	 * fetch, it also means the data has been decompressed into bi_buf.
+	 */
+	uint8_t		ba_compressed;
+	/*
+	 * Is the extent shared by several records (NVMe only)? Shared extents
+	 * are reference counted by the dedup index of the VOS pool.
+	 */
+	uint8_t		ba_shared;
 } bio_addr_t;
 
 struct sys_db;
@@ -587,6 +596,26 @@ int bio_iod_prep(struct bio_desc *biod);
  */
 int bio_iod_post(struct bio_desc *biod);
 
+/*
+ * Start writing back the DMA buffer of an update io descriptor while the
+ * RDMA transfer into it is still in progress.
+ *
+ * All the data before offset \a iov_off of IOV \a iov_idx in SG list \a sgl_idx
+ * must be in place, including that of the prior IOVs and SG lists, whose
+ * transfers have to be completed by the caller first. The NVMe writes of the
+ * DMA pages holding only such data are submitted without waiting,
+ * bio_iod_post() writes the rest and waits for all of them.
+ *
+ * \param biod       [IN]	io descriptor
+ * \param sgl_idx    [IN]	SG list of the first byte not transferred
+ * \param iov_idx    [IN]	IOV of the first byte not transferred
+ * \param iov_off    [IN]	Offset of the first byte not transferred
+ *
+ * \return			Zero on success, negative value on error
+ */
+int bio_iod_post_partial(struct bio_desc *biod, unsigned int sgl_idx,
+			 unsigned int iov_idx, uint64_t iov_off);
+
 /*
  * Helper function to copy data between SG lists of io descriptor and user
  * specified DRAM SG lists.
@@ -599,6 +628,49 @@ int bio_iod_post(struct bio_desc *biod);
  */
 int bio_iod_copy(struct bio_desc *biod, d_sg_list_t *sgls, unsigned int nr_sgl);
 
+struct dcs_copy_verify;
+
+/*
+ * Same as bio_iod_copy() for an update, and verify the checksums of the data
+ * of each SG list as it is copied, see daos_csummer_copy_verify(), so the
+ * data is read from DRAM only once.
+ *
+ * \param biod       [IN]	io descriptor of an update
+ * \param sgls       [IN]	DRAM SG lists
+ * \param nr_sgl     [IN]	Number of SG lists
+ * \param cvs        [IN]	Verification states, one per SG list
+ *
+ * \return			Zero on success, -DER_CSUM on corruption,
+ *				negative value on other errors
+ */
+int bio_iod_copy_verify(struct bio_desc *biod, d_sg_list_t *sgls,
+			unsigned int nr_sgl, struct dcs_copy_verify *cvs);
+
+/* Accounting of fetched data copied by the CPU */
+struct bio_copy_stats {
+	/* Bytes of non-hole data fetched from SCM or NVMe */
+	uint64_t	bcs_fetched;
+	/* Bytes of fetched data copied into DRAM SG lists by bio_iod_copy() */
+	uint64_t	bcs_copied;
+	/*
+	 * Bytes of fetched data never copied by bio_iod_copy(), consumed in
+	 * place through bio_iod_sgl(), e.g. by a zero-copy bulk transfer
+	 */
+	uint64_t	bcs_zero_copy;
+	/* Bytes of fetched data read from NVMe into DMA buffers */
+	uint64_t	bcs_dma;
+};
+
+/*
+ * Helper function to query the process wide fetch copy statistics
+ *
+ * \param stats      [OUT]	Returned statistics
+ * \param reset      [IN]	Reset the statistics after query
+ *
+ * \return			N/A
+ */
+void bio_copy_stats_get(struct bio_copy_stats *stats, bool reset);
+
 /*
  * Helper function to flush memory vectors in SG lists of io descriptor
  *
@@ -115,6 +115,11 @@ struct ds_cont_child {
 	d_list_t		 sc_dtx_cos_list;
 	/* The pool map version for the latest DTX resync on the container. */
 	uint32_t		 sc_dtx_resync_ver;
+	/* Inline compression ratio (percent) and CPU time (us) gauges */
+	struct d_tm_node_t	*sc_cmp_ratio;
+	struct d_tm_node_t	*sc_cmp_cpu;
+	/* Last time (seconds) the compression gauges were refreshed */
+	uint64_t		 sc_cmp_stats_ts;
 };
 
 /*
@@ -30,6 +30,18 @@ struct ds_iv_ns {
 	/* pool uuid */
 	uuid_t		iv_pool_uuid;
 
+	/* lazy updates and invalidations in flight (iv_lazy_op) */
+	d_list_t	iv_lazy_list;
+
+	/* IV ops issued, coalesced, and IV requests handled by this rank */
+	struct d_tm_node_t	*iv_tm_fetch;
+	struct d_tm_node_t	*iv_tm_update;
+	struct d_tm_node_t	*iv_tm_invalidate;
+	struct d_tm_node_t	*iv_tm_coalesced;
+	struct d_tm_node_t	*iv_tm_on_fetch;
+	struct d_tm_node_t	*iv_tm_on_update;
+	struct d_tm_node_t	*iv_tm_on_refresh;
+
 	ABT_eventual	iv_done_eventual;
 	int		iv_refcount;
 	/**
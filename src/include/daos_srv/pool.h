@@ -105,6 +105,14 @@ struct ds_pool_child {
 	 * with the aggregation full scan start HLC to know whether the
 	 * aggregation needs to be restarted from 0. */
 	uint64_t	spc_rebuild_end_hlc;
+	/* The SCM mapping of the VOS pool and its bulk handle, registered
+	 * on first use for zero-copy fetch.
+	 */
+	d_iov_t		spc_scm_window;
+	crt_bulk_t	spc_scm_bulk;
+	/* Content defined chunking dedup metrics of the target */
+	struct d_tm_node_t	*spc_dedup_ratio;
+	struct d_tm_node_t	*spc_dedup_index;
 	uint32_t	spc_map_version;
 	int		spc_ref;
 };
@@ -112,6 +120,8 @@ struct ds_pool_child {
 struct ds_pool_child *ds_pool_child_lookup(const uuid_t uuid);
 struct ds_pool_child *ds_pool_child_get(struct ds_pool_child *child);
 void ds_pool_child_put(struct ds_pool_child *child);
+int ds_pool_child_scm_bulk(struct ds_pool_child *child, crt_bulk_t *bulk,
+			   d_iov_t *window);
 
 int ds_pool_bcast_create(crt_context_t ctx, struct ds_pool *pool,
 			 enum daos_module_id module, crt_opcode_t opcode,
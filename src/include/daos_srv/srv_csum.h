@@ -50,4 +50,55 @@ ds_csum_add2iod(daos_iod_t *iod, struct daos_csummer *csummer,
 		struct bio_sglist *bsgl, struct dcs_csum_info *biov_csums,
 		size_t *biov_csums_used, struct dcs_iod_csums *iod_csums);
 
+/**
+ * Verify the data fetched in the bsgl against the checksums stored with it.
+ * Each extent is verified over its raw (chunk aligned) range, so no new
+ * checksum is needed.
+ *
+ * @param iod[in]			I/O Descriptor the bsgl was fetched for
+ * @param csummer[in]			csummer object
+ * @param bsgl[in]			bio scatter gather list with the data
+ * @param biov_csums[in]		list csum info for each \bsgl
+ * @param biov_csums_used[in/out]	track the number of csums used
+ * @return				0 or -DER_CSUM if corruption is found
+ */
+int
+ds_csum_verify_fetch(daos_iod_t *iod, struct daos_csummer *csummer,
+		     struct bio_sglist *bsgl, struct dcs_csum_info *biov_csums,
+		     size_t *biov_csums_used);
+
+/**
+ * Sample one out of \a rate calls, used to verify only a fraction of the
+ * fetches.
+ *
+ * @param cnt[in/out]		calls since the last sampled one
+ * @param rate[in]		sample one call every \a rate, 0 never samples
+ * @return			true if this call is sampled
+ */
+bool
+ds_csum_sample(unsigned int *cnt, unsigned int rate);
+
+/**
+ * Number of msec a checksum scanner which processed \a bytes and \a csums
+ * in \a elapsed msec is ahead of its bandwidth and checksums per second
+ * budgets. A budget of 0 is unlimited.
+ */
+static inline uint64_t
+ds_csum_budget_wait(uint64_t elapsed, uint64_t bytes, uint64_t bytes_per_sec,
+		    uint64_t csums, uint64_t csums_per_sec)
+{
+	uint64_t	msec = 0;
+	uint64_t	cmsec;
+
+	if (bytes_per_sec != 0)
+		msec = bytes * 1000 / bytes_per_sec;
+	if (csums_per_sec != 0) {
+		cmsec = csums * 1000 / csums_per_sec;
+		if (cmsec > msec)
+			msec = cmsec;
+	}
+
+	return msec > elapsed ? msec - elapsed : 0;
+}
+
 #endif
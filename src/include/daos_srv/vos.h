@@ -282,6 +282,19 @@ vos_pool_close(daos_handle_t poh);
 int
 vos_pool_query(daos_handle_t poh, vos_pool_info_t *pinfo);
 
+/**
+ * Query the content defined chunking dedup statistics of the pool, the byte
+ * counters are accumulated since the pool is opened.
+ *
+ * \param poh	[IN]	Pool open handle
+ * \param stats	[OUT]	Returned statistics, all zero if the pool has no
+ *			dedup index
+ *
+ * \return		Zero on success, negative value if error
+ */
+int
+vos_pool_dedup_query(daos_handle_t poh, struct vos_dedup_stats *stats);
+
 /**
  * Query pool space by pool UUID
  *
@@ -295,6 +308,19 @@ vos_pool_query(daos_handle_t poh, vos_pool_info_t *pinfo);
 int
 vos_pool_query_space(uuid_t pool_id, struct vos_pool_space *vps);
 
+/**
+ * Query the address range where the pool SCM file is mapped, the caller can
+ * register this range with the network transport once and then move SCM
+ * resident data without any intermediate copy.
+ *
+ * \param poh	[IN]	Pool open handle
+ * \param iov	[OUT]	Returned start address and size of the mapping
+ *
+ * \return		Zero on success, negative value if error
+ */
+int
+vos_pool_scm_window(daos_handle_t poh, d_iov_t *iov);
+
 /**
  * Set aside additional "system reserved" space in pool SCM and NVMe
  * (additive to any existing reserved space by vos)
@@ -369,6 +395,22 @@ vos_cont_close(daos_handle_t coh);
 int
 vos_cont_query(daos_handle_t coh, vos_cont_info_t *cinfo);
 
+/**
+ * Enable or disable inline compression of the array records of a container.
+ * When enabled, array records landed on SCM are compressed chunk by chunk
+ * at the end of update if that saves enough space, and are decompressed
+ * transparently on fetch. Records compressed before remain readable after
+ * compression is disabled.
+ *
+ * \param coh		[IN]	Container open handle.
+ * \param type		[IN]	enum DAOS_COMPRESS_TYPE, COMPRESS_TYPE_UNKNOWN
+ *				disables compression.
+ *
+ * \return		Zero on success, negative value if error
+ */
+int
+vos_cont_set_compress(daos_handle_t coh, int type);
+
 /**
  * Aggregates all epochs within the epoch range \a epr.
  * Data in all these epochs will be aggregated to the last epoch
@@ -702,6 +744,21 @@ vos_update_begin(daos_handle_t coh, daos_unit_oid_t oid, daos_epoch_t epoch,
 		 bool dedup, uint32_t dedup_th, daos_handle_t *ioh,
 		 struct dtx_handle *dth);
 
+/**
+ * Cut the NVMe extents of an update with dedup enabled into content defined
+ * chunks and fingerprint them, when chunking is enabled (DAOS_DEDUP_CDC).
+ * The data is read from the bio buffers, so this must be called once they
+ * are filled and before \a bio_iod_post. Chunks matching existing extents
+ * reference them when the update ends.
+ *
+ * \param ioh	[IN]	The I/O handle created by \a vos_update_begin
+ *
+ * \return		Zero on success, negative value if error, the update
+ *			is then stored without chunking
+ */
+int
+vos_dedup_scan(daos_handle_t ioh);
+
 /**
  * Finish the current update and release the responding resources.
  *
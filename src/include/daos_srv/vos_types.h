@@ -88,6 +88,26 @@ struct vos_gc_stat {
 	uint64_t	gs_recxs;	/**< GCed array values */
 };
 
+/**
+ * VOS inline compression statistics
+ */
+struct vos_cmp_stats {
+	uint64_t	cs_in;		/**< bytes of compressed records */
+	uint64_t	cs_out;		/**< bytes stored for them */
+	uint64_t	cs_cmp_ns;	/**< compression time on the target xstream */
+	uint64_t	cs_dcmp_ns;	/**< time spent on decompression */
+};
+
+/**
+ * VOS content defined chunking dedup statistics of a pool
+ */
+struct vos_dedup_stats {
+	uint64_t	ds_in;		/**< bytes of chunked records */
+	uint64_t	ds_stored;	/**< bytes of new extents for them */
+	uint64_t	ds_extents;	/**< extents in the dedup index */
+	uint64_t	ds_index_bytes;	/**< DRAM used by the dedup index */
+};
+
 struct vos_pool_space {
 	/** Total & free space */
 	struct daos_space	vps_space;
@@ -129,6 +149,8 @@ typedef struct {
 	daos_size_t		ci_used;
 	/** Highest (Last) aggregated epoch */
 	daos_epoch_t		ci_hae;
+	/** Inline compression statistics since the container is loaded */
+	struct vos_cmp_stats	ci_cmp_stats;
 	/** TODO */
 } vos_cont_info_t;
 
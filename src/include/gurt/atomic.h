@@ -37,6 +37,14 @@
 #define atomic_fetch_add_relaxed(ptr, value)			\
 	atomic_fetch_add_explicit(ptr, value, memory_order_relaxed)
 
+/* Sequentially consistent variants, for lock-free lists and handoffs */
+#define atomic_compare_exchange_seq_cst(ptr, oldvalue, newvalue) \
+	atomic_compare_exchange_strong(ptr, &oldvalue, newvalue)
+
+#define atomic_exchange_seq_cst(ptr, value) atomic_exchange(ptr, value)
+
+#define atomic_load_seq_cst(ptr) atomic_load(ptr)
+
 #else
 
 #define atomic_fetch_sub __sync_fetch_and_sub
@@ -58,6 +66,14 @@
  */
 #define atomic_load_consume(ptr) atomic_fetch_add(ptr, 0)
 #define atomic_load_relaxed(ptr) atomic_fetch_add(ptr, 0)
+#define atomic_compare_exchange_seq_cst __sync_bool_compare_and_swap
+/* __sync_lock_test_and_set() is only an acquire barrier */
+#define atomic_exchange_seq_cst(ptr, value)			\
+	({							\
+		__sync_synchronize();				\
+		__sync_lock_test_and_set(ptr, value);		\
+	})
+#define atomic_load_seq_cst(ptr) atomic_fetch_add(ptr, 0)
 #define ATOMIC
 
 #endif
@@ -25,5 +25,6 @@ int d_tm_decrement_gauge(struct d_tm_node_t **metric, uint64_t value,
 int d_tm_init(int id, uint64_t mem_size, int flags);
 int d_tm_add_metric(struct d_tm_node_t **node, char *metric, int metric_type,
 		    char *sh_desc, char *lng_desc);
+int d_tm_del_metric(char *path);
 void d_tm_fini(void);
 #endif /* __TELEMETRY_PRODUCER_H__ */
@@ -0,0 +1,168 @@
+/*
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+
+/* GURT timing wheel APIs. */
+
+#ifndef __GURT_TWHEEL_H__
+#define __GURT_TWHEEL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <gurt/common.h>
+#include <gurt/list.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * \file
+ *
+ * Hierarchical timing wheel
+ *
+ * The timing wheel tracks a large set of objects by expiry time, with O(1)
+ * insertion and removal, and hands back all the objects which are due in one
+ * batch. Time is cut in ticks of a granularity chosen by the user, the wheel
+ * has D_TW_LEVELS levels of D_TW_SLOTS lists each, level N covering
+ * D_TW_SLOTS^(N+1) ticks, objects further away wait in an overflow list.
+ * Objects are moved down one level when the wheel reaches the start of their
+ * slot, so each of them is moved at most D_TW_LEVELS times.
+ *
+ * Objects never expire before their expiry time, but can expire up to one
+ * tick later than it.
+ *
+ * Users of the wheel should embed a d_twheel_node object instance in every
+ * object of the set. The wheel has no lock, it is protected by the lock of
+ * the user or only accessed by a single thread.
+ */
+
+/** @addtogroup GURT
+ * @{
+ */
+
+#define D_TW_BITS	(8)
+#define D_TW_SLOTS	(1U << D_TW_BITS)	/* #lists per level */
+#define D_TW_MASK	(D_TW_SLOTS - 1)
+#define D_TW_LEVELS	(4)
+
+/**
+ * Timing wheel node.
+ *
+ * Objects of this type are embedded into objects of the set that is to be
+ * maintained by a struct d_twheel instance.
+ */
+struct d_twheel_node {
+	/** link in a slot of the wheel */
+	d_list_t	tn_link;
+	/** expiry tick */
+	uint64_t	tn_expire;
+	/** level of the wheel, D_TW_LEVELS for the overflow list */
+	uint32_t	tn_level;
+};
+
+/**
+ * Timing wheel.
+ */
+struct d_twheel {
+	/** time units per tick */
+	uint64_t	tw_gran;
+	/** next tick to expire */
+	uint64_t	tw_tick;
+	/** # nodes per level, the last one is the overflow list */
+	uint32_t	tw_nr[D_TW_LEVELS + 1];
+	/** # nodes in the wheel */
+	uint32_t	tw_count;
+	/** nodes expiring more than D_TW_SLOTS^D_TW_LEVELS ticks later */
+	d_list_t	tw_overflow;
+	/** slots of each level */
+	d_list_t	tw_slots[D_TW_LEVELS][D_TW_SLOTS];
+};
+
+/**
+ * Initializes a timing wheel instance inplace.
+ *
+ * \param[in] w		The timing wheel
+ * \param[in] gran	The tick granularity, in the time unit of the user
+ * \param[in] now	The current time
+ *
+ * \return		zero on success, negative value if error
+ */
+int d_twheel_init(struct d_twheel *w, uint64_t gran, uint64_t now);
+
+/**
+ * Finalizes a timing wheel instance, the wheel should be empty.
+ *
+ * \param[in] w		The timing wheel
+ */
+void d_twheel_fini(struct d_twheel *w);
+
+/**
+ * Inserts a node into the timing wheel. A node whose expiry time has already
+ * passed expires on the next call of d_twheel_expire().
+ *
+ * \param[in] w		The timing wheel
+ * \param[in] e		The node
+ * \param[in] expire	The expiry time of the node
+ */
+void d_twheel_insert(struct d_twheel *w, struct d_twheel_node *e,
+		     uint64_t expire);
+
+/**
+ * Removes a node from the timing wheel.
+ *
+ * \param[in] w		The timing wheel
+ * \param[in] e		The node
+ */
+void d_twheel_remove(struct d_twheel *w, struct d_twheel_node *e);
+
+/**
+ * Removes all the nodes which are due at \a now from the timing wheel, and
+ * appends them to \a expired through their tn_link.
+ *
+ * \param[in] w		The timing wheel
+ * \param[in] now	The current time
+ * \param[in,out] expired
+ *			The list of expired nodes
+ *
+ * \return		number of expired nodes
+ */
+uint32_t d_twheel_expire(struct d_twheel *w, uint64_t now, d_list_t *expired);
+
+/**
+ * Queries the number of nodes in the timing wheel.
+ *
+ * \param[in] w		The timing wheel
+ *
+ * \return		number of nodes
+ */
+static inline uint32_t
+d_twheel_size(struct d_twheel *w)
+{
+	return w->tw_count;
+}
+
+/**
+ * Queries if the timing wheel is empty.
+ *
+ * \param[in] w		The timing wheel
+ *
+ * \retval		true	wheel is empty,
+ * \retval		false	wheel is non-empty.
+ */
+static inline bool
+d_twheel_is_empty(struct d_twheel *w)
+{
+	return w->tw_count == 0;
+}
+
+#if defined(__cplusplus)
+}
+#endif
+
+/** @}
+ */
+#endif /* __GURT_TWHEEL_H__ */
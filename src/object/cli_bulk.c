@@ -0,0 +1,494 @@
+/**
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * This file is part of daos_sr
+ *
+ * src/object/cli_bulk.c
+ *
+ * Client side inline threshold and cache of pre-registered bulk buffers.
+ *
+ * I/O payloads which fit into the eager message of the transport are packed
+ * into the RPC. Instead of the fixed OBJ_BULK_LIMIT, the threshold is derived
+ * from the eager size reported by the transport of the context, so that
+ * providers with larger eager messages inline more I/Os. The space taken by
+ * the RPC header of each I/O, the input struct and its dkey and iods, is
+ * deducted from the eager size, nothing is inlined if the header alone does
+ * not fit. The threshold can be bounded by DAOS_OBJ_INLINE_LIMIT. The eager
+ * size is queried once on the first I/O, the threshold does not adapt to the
+ * load or to the measured transfer costs.
+ *
+ * For medium size payloads, registering the user buffers for each I/O costs
+ * more than the transfer itself. Payloads up to DAOS_OBJ_BULK_CACHE_MAX bytes
+ * are copied from/to buffers which are registered once with the global
+ * client context and recycled by a per-size-class cache. A buffer is
+ * registered with the exact size of the sgl it serves and only reused for
+ * sgls of that size, so that the server checks the data against the real
+ * user buffer size, as for a registered user buffer. At most
+ * DAOS_OBJ_BULK_CACHE_NR idle buffers are kept per size class, the least
+ * recently used ones are released first.
+ *
+ * The cache is not used for encrypted containers: their update data is already
+ * copied once by the encryption into a buffer which is registered as is, and
+ * fetched data is decrypted in place in the user buffers, so going through a
+ * cached buffer would copy the whole payload a second time.
+ */
+#define D_LOGFAC	DD_FAC(object)
+
+#include <daos/event.h>
+#include "obj_rpc.h"
+#include "obj_internal.h"
+
+#define OBJ_INLINE_LIMIT_ENV		"DAOS_OBJ_INLINE_LIMIT"
+#define OBJ_BULK_CACHE_MAX_ENV		"DAOS_OBJ_BULK_CACHE_MAX"
+#define OBJ_BULK_CACHE_NR_ENV		"DAOS_OBJ_BULK_CACHE_NR"
+
+/* The smallest buffer class is 4KiB, the largest one is 512KiB */
+#define OBJ_BULK_CLASS_SHIFT		(12)
+#define OBJ_BULK_CLASS_NR		(8)
+#define OBJ_BULK_CACHE_MAX_DEF		(1 << 16)
+#define OBJ_BULK_CACHE_NR_DEF		(32)
+
+struct obj_bulk_buf {
+	/* link in the free list of the size class */
+	d_list_t		 bb_link;
+	crt_bulk_t		 bb_bulk;
+	void			*bb_buf;
+	/* registered size, the buffer size of the sgls it serves */
+	daos_size_t		 bb_size;
+	unsigned int		 bb_class;
+};
+
+static struct {
+	pthread_mutex_t		 bc_lock;
+	/* the context which the buffers are registered with */
+	crt_context_t		 bc_ctx;
+	d_list_t		 bc_free[OBJ_BULK_CLASS_NR];
+	unsigned int		 bc_free_nr[OBJ_BULK_CLASS_NR];
+	/* max payload size served by the cache, zero to disable it */
+	unsigned int		 bc_max_size;
+	/* max number of idle buffers kept per size class */
+	unsigned int		 bc_max_nr;
+	uint64_t		 bc_hits;
+	uint64_t		 bc_misses;
+	/* bytes copied from/to the cached buffers */
+	uint64_t		 bc_copied;
+} obj_bulk_cache;
+
+/* Eager message size of the transport, zero until the first query */
+static size_t		obj_eager_size;
+/* The transport cannot report its eager size, use OBJ_BULK_LIMIT */
+static bool		obj_eager_unknown;
+/* User bound of the inline threshold, zero for no bound */
+static unsigned int	obj_inline_max;
+
+/**
+ * Size of the RPC header of an I/O: the input struct returned by
+ * crt_req_get(), or the output one which carries the fetched data, plus the
+ * dkey and iods packed with it.
+ */
+static daos_size_t
+obj_rpc_hdr_size(daos_key_t *dkey, daos_iod_t *iods, unsigned int nr)
+{
+	daos_size_t	size;
+	int		i;
+
+	size = max(sizeof(struct obj_rw_in), sizeof(struct obj_rw_out));
+	if (dkey != NULL)
+		size += dkey->iov_len;
+
+	for (i = 0; iods != NULL && i < nr; i++) {
+		size += sizeof(iods[i]) + iods[i].iod_name.iov_len;
+		if (iods[i].iod_type == DAOS_IOD_ARRAY)
+			size += iods[i].iod_nr * sizeof(daos_recx_t);
+		/* orw_iod_sizes, orw_data_sizes and orw_nrs of the reply */
+		size += 2 * sizeof(daos_size_t) + sizeof(uint32_t);
+	}
+
+	return size;
+}
+
+/**
+ * Return the max payload size of the I/O on \a dkey and \a iods which can be
+ * inlined in the RPC, zero if its header does not fit the eager message.
+ */
+daos_size_t
+obj_inline_limit(crt_context_t ctx, daos_key_t *dkey, daos_iod_t *iods,
+		 unsigned int nr)
+{
+	daos_size_t	limit;
+	daos_size_t	hdr;
+	size_t		eager = obj_eager_size;
+	int		rc;
+
+	if (eager == 0 && !obj_eager_unknown) {
+		rc = crt_context_eager_size(ctx, &eager);
+		/* Same result for all callers, no need to serialize them */
+		if (rc != 0 || eager == 0) {
+			D_DEBUG(DB_IO, "Cannot get eager size: "DF_RC"\n",
+				DP_RC(rc));
+			obj_eager_unknown = true;
+		} else {
+			D_DEBUG(DB_IO, "Eager size of object I/O: %zu\n",
+				eager);
+			obj_eager_size = eager;
+		}
+	}
+
+	if (obj_eager_unknown) {
+		limit = OBJ_BULK_LIMIT;
+	} else {
+		hdr = obj_rpc_hdr_size(dkey, iods, nr);
+		if (hdr >= eager)
+			return 0;
+		limit = eager - hdr;
+	}
+
+	if (obj_inline_max != 0 && limit > obj_inline_max)
+		limit = obj_inline_max;
+
+	return limit;
+}
+
+/**
+ * Allocate the bulk array of an object I/O with \a nr iods. The handles are
+ * allocated with the slots of the cached buffers if \a cached is set,
+ * otherwise they are left to obj_bulk_prep().
+ */
+int
+obj_bulk_array_alloc(unsigned int nr, bool cached,
+		     struct obj_bulk_array **p_bulks)
+{
+	struct obj_bulk_array	*bulks;
+
+	D_ALLOC_PTR(bulks);
+	if (bulks == NULL)
+		return -DER_NOMEM;
+
+	bulks->oba_nr = nr;
+	if (cached) {
+		D_ALLOC_ARRAY(bulks->oba_bulks, nr);
+		D_ALLOC_ARRAY(bulks->oba_bufs, nr);
+		if (bulks->oba_bulks == NULL || bulks->oba_bufs == NULL) {
+			obj_bulk_array_free(bulks);
+			return -DER_NOMEM;
+		}
+	}
+
+	*p_bulks = bulks;
+	return 0;
+}
+
+/** Release the handles, the cached buffers and the bulk array itself */
+void
+obj_bulk_array_free(struct obj_bulk_array *bulks)
+{
+	int	i;
+
+	for (i = 0; bulks->oba_bulks != NULL && i < bulks->oba_nr; i++) {
+		if (bulks->oba_bufs != NULL && bulks->oba_bufs[i] != NULL)
+			obj_bulk_cache_put(bulks->oba_bufs[i]);
+		else if (bulks->oba_bulks[i] != CRT_BULK_NULL)
+			crt_bulk_free(bulks->oba_bulks[i]);
+	}
+
+	D_FREE(bulks->oba_bufs);
+	D_FREE(bulks->oba_bulks);
+	D_FREE(bulks);
+}
+
+static int
+obj_bulk_class(daos_size_t size)
+{
+	int	idx = 0;
+
+	while (((daos_size_t)1 << (idx + OBJ_BULK_CLASS_SHIFT)) < size)
+		idx++;
+
+	return idx < OBJ_BULK_CLASS_NR ? idx : -1;
+}
+
+static void
+obj_bulk_buf_free(struct obj_bulk_buf *buf)
+{
+	if (buf->bb_bulk != CRT_BULK_NULL)
+		crt_bulk_free(buf->bb_bulk);
+	D_FREE(buf->bb_buf);
+	D_FREE(buf);
+}
+
+static int
+obj_bulk_buf_get(daos_size_t size, struct obj_bulk_buf **p_buf)
+{
+	struct obj_bulk_buf	*buf;
+	d_sg_list_t		 sgl;
+	d_iov_t			 iov;
+	int			 idx;
+	int			 rc;
+
+	idx = obj_bulk_class(size);
+	D_ASSERT(idx >= 0);
+
+	D_MUTEX_LOCK(&obj_bulk_cache.bc_lock);
+	d_list_for_each_entry(buf, &obj_bulk_cache.bc_free[idx], bb_link) {
+		if (buf->bb_size == size) {
+			d_list_del_init(&buf->bb_link);
+			obj_bulk_cache.bc_free_nr[idx]--;
+			obj_bulk_cache.bc_hits++;
+			D_MUTEX_UNLOCK(&obj_bulk_cache.bc_lock);
+			goto out;
+		}
+	}
+	obj_bulk_cache.bc_misses++;
+	D_MUTEX_UNLOCK(&obj_bulk_cache.bc_lock);
+
+	D_ALLOC_PTR(buf);
+	if (buf == NULL)
+		return -DER_NOMEM;
+
+	D_INIT_LIST_HEAD(&buf->bb_link);
+	buf->bb_class = idx;
+	buf->bb_size = size;
+	D_ALLOC(buf->bb_buf, size);
+	if (buf->bb_buf == NULL)
+		D_GOTO(failed, rc = -DER_NOMEM);
+
+	/* Only the exact size, the server checks the data against it */
+	d_iov_set(&iov, buf->bb_buf, size);
+	sgl.sg_nr = 1;
+	sgl.sg_nr_out = 1;
+	sgl.sg_iovs = &iov;
+	/* RW, the same buffer serves both update and fetch later */
+	rc = crt_bulk_create(obj_bulk_cache.bc_ctx, &sgl, CRT_BULK_RW,
+			     &buf->bb_bulk);
+	if (rc != 0)
+		D_GOTO(failed, rc);
+out:
+	*p_buf = buf;
+	return 0;
+failed:
+	obj_bulk_buf_free(buf);
+	return rc;
+}
+
+void
+obj_bulk_cache_put(struct obj_bulk_buf *buf)
+{
+	unsigned int	idx = buf->bb_class;
+
+	D_MUTEX_LOCK(&obj_bulk_cache.bc_lock);
+	if (obj_bulk_cache.bc_max_size != 0 && obj_bulk_cache.bc_max_nr != 0) {
+		/* Most recently used first, release the least recent one */
+		d_list_add(&buf->bb_link, &obj_bulk_cache.bc_free[idx]);
+		if (obj_bulk_cache.bc_free_nr[idx] < obj_bulk_cache.bc_max_nr) {
+			obj_bulk_cache.bc_free_nr[idx]++;
+			buf = NULL;
+		} else {
+			buf = d_list_entry(obj_bulk_cache.bc_free[idx].prev,
+					   struct obj_bulk_buf, bb_link);
+			d_list_del_init(&buf->bb_link);
+		}
+	}
+	D_MUTEX_UNLOCK(&obj_bulk_cache.bc_lock);
+
+	if (buf != NULL)
+		obj_bulk_buf_free(buf);
+}
+
+static void
+obj_bulk_cache_copied(daos_size_t size)
+{
+	if (size == 0)
+		return;
+
+	D_MUTEX_LOCK(&obj_bulk_cache.bc_lock);
+	obj_bulk_cache.bc_copied += size;
+	D_MUTEX_UNLOCK(&obj_bulk_cache.bc_lock);
+}
+
+/**
+ * Prepare bulk handles from cached buffers for the sgls. The data of update
+ * is copied into the buffers with the same layout as the user buffers would
+ * have been registered, fetched data is copied back by
+ * obj_bulk_cache_copy_out() on completion.
+ *
+ * \a p_bulks is set to NULL if the cache cannot be used, for example if the
+ * payload is too large or the task is not on the global context.
+ */
+int
+obj_bulk_cache_prep(d_sg_list_t *sgls, unsigned int nr, bool update,
+		    tse_task_t *task, struct obj_bulk_array **p_bulks)
+{
+	struct obj_bulk_array	*bulks;
+	daos_size_t		 size = 0;
+	daos_size_t		 copied = 0;
+	int			 i;
+	int			 rc;
+
+	*p_bulks = NULL;
+	if (obj_bulk_cache.bc_max_size == 0 ||
+	    daos_task2ctx(task) != obj_bulk_cache.bc_ctx)
+		return 0;
+
+	for (i = 0; i < nr; i++) {
+		if (daos_sgl_buf_size(&sgls[i]) > obj_bulk_cache.bc_max_size)
+			return 0;
+		size += daos_sgl_buf_size(&sgls[i]);
+	}
+	if (size == 0)
+		return 0;
+
+	rc = obj_bulk_array_alloc(nr, true, &bulks);
+	if (rc != 0)
+		return rc;
+
+	for (i = 0; i < nr; i++) {
+		d_sg_list_t	*sgl = &sgls[i];
+		char		*addr;
+		int		 j;
+
+		if (sgl->sg_iovs == NULL || sgl->sg_iovs[0].iov_buf == NULL ||
+		    daos_sgl_buf_size(sgl) == 0)
+			continue;
+
+		rc = obj_bulk_buf_get(daos_sgl_buf_size(sgl),
+				      &bulks->oba_bufs[i]);
+		if (rc != 0) {
+			obj_bulk_array_free(bulks);
+			return rc;
+		}
+
+		bulks->oba_bulks[i] = bulks->oba_bufs[i]->bb_bulk;
+		addr = bulks->oba_bufs[i]->bb_buf;
+		if (!update) {
+			/* holes are skipped by server, return zeros for them */
+			memset(addr, 0, daos_sgl_buf_size(sgl));
+			continue;
+		}
+
+		for (j = 0; j < sgl->sg_nr; j++) {
+			if (sgl->sg_iovs[j].iov_len != 0)
+				memcpy(addr, sgl->sg_iovs[j].iov_buf,
+				       sgl->sg_iovs[j].iov_len);
+			addr += sgl->sg_iovs[j].iov_buf_len;
+			copied += sgl->sg_iovs[j].iov_len;
+		}
+	}
+
+	obj_bulk_cache_copied(copied);
+	*p_bulks = bulks;
+	return 0;
+}
+
+/**
+ * Copy \a size bytes of fetched data from the cached buffer to the user sgl,
+ * in the layout of the sgl as if its buffers were registered directly.
+ */
+int
+obj_bulk_cache_copy_out(struct obj_bulk_buf *buf, d_sg_list_t *sgl,
+			daos_size_t size)
+{
+	char	*addr = buf->bb_buf;
+	int	 i;
+
+	/* Already checked by the server against the exact buffer size */
+	if (size > buf->bb_size)
+		return -DER_REC2BIG;
+
+	obj_bulk_cache_copied(size);
+	for (i = 0; i < sgl->sg_nr && size > 0; i++) {
+		daos_size_t len = min(size, sgl->sg_iovs[i].iov_buf_len);
+
+		memcpy(sgl->sg_iovs[i].iov_buf, addr, len);
+		addr += len;
+		size -= len;
+	}
+
+	return 0;
+}
+
+void
+dc_obj_bulk_cache_stats(uint64_t *hits, uint64_t *misses, uint64_t *copied)
+{
+	D_MUTEX_LOCK(&obj_bulk_cache.bc_lock);
+	*hits = obj_bulk_cache.bc_hits;
+	*misses = obj_bulk_cache.bc_misses;
+	*copied = obj_bulk_cache.bc_copied;
+	D_MUTEX_UNLOCK(&obj_bulk_cache.bc_lock);
+}
+
+void
+dc_obj_bulk_cache_purge(void)
+{
+	struct obj_bulk_buf	*buf;
+	int			 i;
+
+	D_MUTEX_LOCK(&obj_bulk_cache.bc_lock);
+	for (i = 0; i < OBJ_BULK_CLASS_NR; i++) {
+		while ((buf = d_list_pop_entry(&obj_bulk_cache.bc_free[i],
+					       struct obj_bulk_buf,
+					       bb_link)) != NULL) {
+			obj_bulk_cache.bc_free_nr[i]--;
+			obj_bulk_buf_free(buf);
+		}
+	}
+	/* Nothing can be cached after the context is gone */
+	obj_bulk_cache.bc_max_size = 0;
+	D_MUTEX_UNLOCK(&obj_bulk_cache.bc_lock);
+
+	D_DEBUG(DB_IO, "Bulk cache hits "DF_U64", misses "DF_U64", copied "
+		DF_U64" bytes\n", obj_bulk_cache.bc_hits,
+		obj_bulk_cache.bc_misses, obj_bulk_cache.bc_copied);
+}
+
+int
+obj_bulk_cache_init(void)
+{
+	int	i;
+	int	rc;
+
+	obj_eager_size = 0;
+	obj_eager_unknown = false;
+	obj_inline_max = 0;
+	d_getenv_int(OBJ_INLINE_LIMIT_ENV, &obj_inline_max);
+
+	obj_bulk_cache.bc_ctx = daos_get_crt_ctx();
+	obj_bulk_cache.bc_max_size = OBJ_BULK_CACHE_MAX_DEF;
+	obj_bulk_cache.bc_max_nr = OBJ_BULK_CACHE_NR_DEF;
+	d_getenv_int(OBJ_BULK_CACHE_MAX_ENV, &obj_bulk_cache.bc_max_size);
+	d_getenv_int(OBJ_BULK_CACHE_NR_ENV, &obj_bulk_cache.bc_max_nr);
+
+	if (obj_bulk_cache.bc_max_size >
+	    1U << (OBJ_BULK_CLASS_NR - 1 + OBJ_BULK_CLASS_SHIFT))
+		obj_bulk_cache.bc_max_size =
+			1U << (OBJ_BULK_CLASS_NR - 1 + OBJ_BULK_CLASS_SHIFT);
+	if (obj_bulk_cache.bc_ctx == NULL)
+		obj_bulk_cache.bc_max_size = 0;
+
+	rc = D_MUTEX_INIT(&obj_bulk_cache.bc_lock, NULL);
+	if (rc != 0)
+		return rc;
+
+	for (i = 0; i < OBJ_BULK_CLASS_NR; i++) {
+		D_INIT_LIST_HEAD(&obj_bulk_cache.bc_free[i]);
+		obj_bulk_cache.bc_free_nr[i] = 0;
+	}
+	obj_bulk_cache.bc_hits = 0;
+	obj_bulk_cache.bc_misses = 0;
+	obj_bulk_cache.bc_copied = 0;
+
+	return 0;
+}
+
+void
+obj_bulk_cache_fini(void)
+{
+	int	i;
+
+	for (i = 0; i < OBJ_BULK_CLASS_NR; i++)
+		D_ASSERT(d_list_empty(&obj_bulk_cache.bc_free[i]));
+
+	D_MUTEX_DESTROY(&obj_bulk_cache.bc_lock);
+}
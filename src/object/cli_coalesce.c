@@ -0,0 +1,524 @@
+/**
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * This file is part of daos_sr
+ *
+ * src/object/cli_coalesce.c
+ *
+ * Client side coalescing of small object updates.
+ *
+ * Applications issuing many small asynchronous updates against different
+ * objects generate one RPC per update. When enabled, small standalone updates
+ * on the same scheduler whose leader shards live on the same engine target
+ * are attached to a batch, and the batch is committed as one internal
+ * transaction, i.e. one compound (CPD) RPC to that target. The batch is
+ * flushed when it reaches DAOS_OBJ_COALESCE_NR updates or
+ * DAOS_OBJ_COALESCE_SIZE bytes, or DAOS_OBJ_COALESCE_USEC microseconds after
+ * the first update was attached, whichever comes first.
+ *
+ * Coalescing is disabled unless DAOS_OBJ_COALESCE_NR is set to more than 1.
+ * Since all updates in a batch are committed atomically, one failed update
+ * fails the whole batch. The updates of a failed batch are then submitted
+ * again one by one, so that each caller gets the result of its own update.
+ */
+#define D_LOGFAC	DD_FAC(object)
+
+#include <daos/object.h>
+#include <daos/container.h>
+#include <daos/pool.h>
+#include <daos/task.h>
+#include <daos_task.h>
+#include "obj_rpc.h"
+#include "obj_internal.h"
+
+#define OBJ_COALESCE_NR_ENV	"DAOS_OBJ_COALESCE_NR"
+#define OBJ_COALESCE_SIZE_ENV	"DAOS_OBJ_COALESCE_SIZE"
+#define OBJ_COALESCE_USEC_ENV	"DAOS_OBJ_COALESCE_USEC"
+
+#define OBJ_COALESCE_SIZE_DEF	(1 << 16)
+#define OBJ_COALESCE_USEC_DEF	(50)
+#define OBJ_COALESCE_BUCKETS	(64)
+
+struct obj_coalesce_batch {
+	/* link in the coalesce bucket while the batch is open */
+	d_list_t		 ocb_link;
+	tse_sched_t		*ocb_sched;
+	daos_handle_t		 ocb_coh;
+	/* pool map target ID of the leader shards */
+	uint32_t		 ocb_tgt_id;
+	/* references held by the commit task, the flush timer and updates */
+	int			 ocb_ref;
+	/* internal TX carrying the batched updates */
+	daos_handle_t		 ocb_th;
+	tse_task_t		*ocb_commit_task;
+	/*
+	 * batched update tasks, they depend on ocb_commit_task and hold a
+	 * reference each until they are completed
+	 */
+	tse_task_t		**ocb_tasks;
+	uint32_t		 ocb_nr;
+	uint32_t		 ocb_cap;
+	daos_size_t		 ocb_size;
+};
+
+static struct obj_coalesce {
+	pthread_mutex_t		 oc_lock;
+	d_list_t		 oc_buckets[OBJ_COALESCE_BUCKETS];
+	/* max number of updates in one batch, 0 or 1 means disabled */
+	unsigned int		 oc_max_nr;
+	/* max total data size of one batch */
+	unsigned int		 oc_max_size;
+	/* max time (in microseconds) an update waits in the batch */
+	unsigned int		 oc_usec;
+	/* commits of batches, i.e. CPD RPCs, including restarts */
+	uint64_t		 oc_commits;
+	/* updates attached to a batch */
+	uint64_t		 oc_updates;
+	/* updates submitted again on their own after the batch failed */
+	uint64_t		 oc_resubmits;
+} obj_coalesce;
+
+static inline bool
+obj_coalesce_enabled(void)
+{
+	return obj_coalesce.oc_max_nr > 1;
+}
+
+static inline d_list_t *
+obj_coalesce_bucket(tse_sched_t *sched, daos_handle_t coh, uint32_t tgt_id)
+{
+	uint64_t	key;
+
+	key = (uint64_t)sched ^ coh.cookie ^ ((uint64_t)tgt_id << 32) ^ tgt_id;
+
+	return &obj_coalesce.oc_buckets[key % OBJ_COALESCE_BUCKETS];
+}
+
+/* Caller must hold oc_lock */
+static void
+obj_coalesce_batch_put(struct obj_coalesce_batch *ocb)
+{
+	D_ASSERT(ocb->ocb_ref > 0);
+	if (--ocb->ocb_ref > 0)
+		return;
+
+	D_ASSERT(d_list_empty(&ocb->ocb_link));
+	D_FREE(ocb->ocb_tasks);
+	D_FREE(ocb);
+}
+
+/**
+ * Detach the batch from the bucket so that no more updates can be attached,
+ * return true if the caller is the one who needs to schedule the commit.
+ * Caller must hold oc_lock.
+ */
+static bool
+obj_coalesce_batch_detach(struct obj_coalesce_batch *ocb)
+{
+	if (d_list_empty(&ocb->ocb_link))
+		return false;
+
+	d_list_del_init(&ocb->ocb_link);
+	return true;
+}
+
+static int
+obj_coalesce_comp_cb(tse_task_t *task, void *data)
+{
+	struct obj_coalesce_batch	*ocb;
+	daos_obj_update_t		*up;
+	uint32_t			 backoff = 0;
+	uint32_t			 i;
+	int				 rc = task->dt_result;
+
+	ocb = *(struct obj_coalesce_batch **)data;
+
+	if (rc == -DER_TX_RESTART) {
+		rc = dc_tx_batch_restart(ocb->ocb_th, &backoff);
+		if (rc != 0) {
+			D_ERROR("Fail to restart batch TX: "DF_RC"\n",
+				DP_RC(rc));
+			goto out;
+		}
+
+		for (i = 0; i < ocb->ocb_nr; i++) {
+			up = dc_task_get_args(ocb->ocb_tasks[i]);
+			rc = dc_tx_batch_add(ocb->ocb_th, up);
+			if (rc != 0) {
+				D_ERROR("Fail to re-attach batch TX: "
+					DF_RC"\n", DP_RC(rc));
+				goto out;
+			}
+		}
+
+		rc = tse_task_register_comp_cb(task, obj_coalesce_comp_cb,
+					       &ocb, sizeof(ocb));
+		if (rc != 0) {
+			D_ERROR("Fail to re-add CB for batch TX: "DF_RC"\n",
+				DP_RC(rc));
+			goto out;
+		}
+
+		D_MUTEX_LOCK(&obj_coalesce.oc_lock);
+		obj_coalesce.oc_commits++;
+		D_MUTEX_UNLOCK(&obj_coalesce.oc_lock);
+
+		return tse_task_reinit_with_delay(task, backoff);
+	}
+
+out:
+	if (rc != 0)
+		task->dt_result = rc;
+
+	D_DEBUG(DB_IO, "batch of %u updates ("DF_U64" bytes) to tgt %u done: "
+		DF_RC"\n", ocb->ocb_nr, ocb->ocb_size, ocb->ocb_tgt_id,
+		DP_RC(rc));
+
+	dc_tx_batch_close(ocb->ocb_th);
+
+	D_MUTEX_LOCK(&obj_coalesce.oc_lock);
+	obj_coalesce_batch_put(ocb);
+	D_MUTEX_UNLOCK(&obj_coalesce.oc_lock);
+
+	return rc;
+}
+
+/**
+ * Completion of a batched update. If the batch failed, which may be caused by
+ * another update of the batch, submit the update again on its own and
+ * complete it with that result instead.
+ */
+static int
+obj_coalesce_update_comp_cb(tse_task_t *task, void *data)
+{
+	struct obj_coalesce_batch	*ocb;
+	daos_obj_update_t		*args = dc_task_get_args(task);
+	tse_task_t			*retry;
+	bool				 resubmit;
+	int				 rc;
+
+	ocb = *(struct obj_coalesce_batch **)data;
+
+	D_MUTEX_LOCK(&obj_coalesce.oc_lock);
+	resubmit = task->dt_result != 0 && ocb->ocb_nr > 1;
+	if (resubmit)
+		obj_coalesce.oc_resubmits++;
+	obj_coalesce_batch_put(ocb);
+	D_MUTEX_UNLOCK(&obj_coalesce.oc_lock);
+
+	if (!resubmit)
+		return 0;
+
+	D_DEBUG(DB_IO, "batch failed, resubmit update %p: "DF_RC"\n", task,
+		DP_RC(task->dt_result));
+
+	rc = dc_task_create(dc_obj_update_direct_task, tse_task2sched(task),
+			    NULL, &retry);
+	if (rc != 0)
+		goto failed;
+
+	*(daos_obj_update_t *)dc_task_get_args(retry) = *args;
+	rc = tse_task_register_deps(task, 1, &retry);
+	if (rc != 0) {
+		tse_task_complete(retry, rc);
+		goto failed;
+	}
+
+	/* the task is completed with the result of the resubmitted update */
+	task->dt_result = 0;
+	return dc_task_schedule(retry, true);
+
+failed:
+	/* keep the result of the batch */
+	D_ERROR("Fail to resubmit update %p: "DF_RC"\n", task, DP_RC(rc));
+	return 0;
+}
+
+static void
+obj_coalesce_batch_flush(struct obj_coalesce_batch *ocb)
+{
+	D_DEBUG(DB_IO, "flush batch of %u updates ("DF_U64" bytes) to tgt %u\n",
+		ocb->ocb_nr, ocb->ocb_size, ocb->ocb_tgt_id);
+
+	D_MUTEX_LOCK(&obj_coalesce.oc_lock);
+	obj_coalesce.oc_commits++;
+	D_MUTEX_UNLOCK(&obj_coalesce.oc_lock);
+
+	/* The batched update tasks will be completed with the commit result
+	 * via the dependency on the commit task.
+	 */
+	dc_task_schedule(ocb->ocb_commit_task, true);
+}
+
+static int
+obj_coalesce_timer(tse_task_t *task)
+{
+	struct obj_coalesce_batch	*ocb = tse_task_get_priv(task);
+	bool				 flush;
+
+	D_MUTEX_LOCK(&obj_coalesce.oc_lock);
+	flush = obj_coalesce_batch_detach(ocb);
+	obj_coalesce_batch_put(ocb);
+	D_MUTEX_UNLOCK(&obj_coalesce.oc_lock);
+
+	/* the reference held by the commit task keeps ocb valid */
+	if (flush)
+		obj_coalesce_batch_flush(ocb);
+
+	tse_task_complete(task, 0);
+	return 0;
+}
+
+static int
+obj_coalesce_batch_create(tse_sched_t *sched, daos_handle_t coh,
+			  uint32_t tgt_id, struct obj_coalesce_batch **p_ocb)
+{
+	struct obj_coalesce_batch	*ocb;
+	tse_task_t			*timer = NULL;
+	int				 rc;
+
+	D_ALLOC_PTR(ocb);
+	if (ocb == NULL)
+		return -DER_NOMEM;
+
+	D_ALLOC_ARRAY(ocb->ocb_tasks, obj_coalesce.oc_max_nr);
+	if (ocb->ocb_tasks == NULL)
+		D_GOTO(out, rc = -DER_NOMEM);
+
+	D_INIT_LIST_HEAD(&ocb->ocb_link);
+	ocb->ocb_cap = obj_coalesce.oc_max_nr;
+	ocb->ocb_sched = sched;
+	ocb->ocb_coh = coh;
+	ocb->ocb_tgt_id = tgt_id;
+
+	rc = dc_tx_batch_open(coh, sched, &ocb->ocb_th, &ocb->ocb_commit_task);
+	if (rc != 0)
+		goto out;
+
+	rc = tse_task_create(obj_coalesce_timer, sched, ocb, &timer);
+	if (rc != 0)
+		goto out_tx;
+
+	rc = tse_task_register_comp_cb(ocb->ocb_commit_task,
+				       obj_coalesce_comp_cb, &ocb, sizeof(ocb));
+	if (rc != 0) {
+		tse_task_complete(timer, rc);
+		goto out_tx;
+	}
+
+	/* one for the commit task, one for the flush timer */
+	ocb->ocb_ref = 2;
+	tse_task_schedule_with_delay(timer, false, obj_coalesce.oc_usec);
+
+	*p_ocb = ocb;
+	return 0;
+
+out_tx:
+	tse_task_complete(ocb->ocb_commit_task, rc);
+	dc_tx_batch_close(ocb->ocb_th);
+out:
+	D_FREE(ocb->ocb_tasks);
+	D_FREE(ocb);
+	return rc;
+}
+
+static struct obj_coalesce_batch *
+obj_coalesce_batch_find(d_list_t *bucket, tse_sched_t *sched,
+			daos_handle_t coh, uint32_t tgt_id)
+{
+	struct obj_coalesce_batch	*ocb;
+
+	d_list_for_each_entry(ocb, bucket, ocb_link) {
+		if (ocb->ocb_sched == sched && ocb->ocb_tgt_id == tgt_id &&
+		    ocb->ocb_coh.cookie == coh.cookie)
+			return ocb;
+	}
+
+	return NULL;
+}
+
+/* Check whether the update can be coalesced, return its leader target. */
+static bool
+obj_coalesce_eligible(daos_obj_update_t *args, daos_size_t *size,
+		      uint32_t *tgt_id)
+{
+	struct dc_object	*obj;
+	uint64_t		 dkey_hash;
+	unsigned int		 map_ver;
+	int			 grp_idx;
+	bool			 rc = false;
+
+	/* conditional updates need the existence check of dc_tx_attach */
+	if (args->flags & DAOS_COND_MASK || args->nr == 0 ||
+	    args->dkey == NULL || args->iods == NULL || args->sgls == NULL)
+		return false;
+
+	*size = daos_sgls_packed_size(args->sgls, args->nr, NULL);
+	if (*size > OBJ_BULK_LIMIT || *size > obj_coalesce.oc_max_size)
+		return false;
+
+	obj = obj_hdl2ptr(args->oh);
+	if (obj == NULL)
+		return false;
+
+	/* EC update is split to all shards of the stripe anyway */
+	if (obj_is_ec(obj) || daos_obj_is_echo(obj->cob_md.omd_id))
+		goto out;
+
+	map_ver = obj->cob_version;
+	dkey_hash = obj_dkey2hash(obj->cob_md.omd_id, args->dkey);
+	grp_idx = obj_dkey2grpidx(obj, dkey_hash, map_ver);
+	if (grp_idx < 0)
+		goto out;
+
+	if (obj_grp_leader_tgt(obj, grp_idx, map_ver, tgt_id) != 0)
+		goto out;
+
+	rc = true;
+out:
+	obj_decref(obj);
+	return rc;
+}
+
+/**
+ * Try to attach the update @task to a batch. Return true if the update has
+ * been attached, then it will be completed together with the batch; return
+ * false if the update is not eligible and should be submitted directly.
+ */
+bool
+obj_coalesce_update(tse_task_t *task, daos_obj_update_t *args)
+{
+	struct obj_coalesce_batch	*ocb;
+	tse_sched_t			*sched = tse_task2sched(task);
+	daos_handle_t			 coh;
+	daos_size_t			 size;
+	d_list_t			*bucket;
+	uint32_t			 tgt_id;
+	bool				 flush = false;
+	int				 rc;
+
+	if (!obj_coalesce_enabled() || srv_io_mode != DIM_DTX_FULL_ENABLED)
+		return false;
+
+	if (!obj_coalesce_eligible(args, &size, &tgt_id))
+		return false;
+
+	coh = dc_obj_hdl2cont_hdl(args->oh);
+	if (daos_handle_is_inval(coh))
+		return false;
+
+	/* encryption is done by the update itself, don't bypass it */
+	if (dc_cont_hdl2props(coh).dcp_encrypt_enabled)
+		return false;
+
+	bucket = obj_coalesce_bucket(sched, coh, tgt_id);
+
+	D_MUTEX_LOCK(&obj_coalesce.oc_lock);
+	ocb = obj_coalesce_batch_find(bucket, sched, coh, tgt_id);
+	if (ocb == NULL) {
+		rc = obj_coalesce_batch_create(sched, coh, tgt_id, &ocb);
+		if (rc != 0) {
+			D_DEBUG(DB_IO, "cannot create batch: "DF_RC"\n",
+				DP_RC(rc));
+			D_GOTO(out, rc);
+		}
+		d_list_add_tail(&ocb->ocb_link, bucket);
+	}
+
+	rc = dc_tx_batch_add(ocb->ocb_th, args);
+	if (rc != 0)
+		goto out;
+
+	rc = tse_task_register_deps(task, 1, &ocb->ocb_commit_task);
+	if (rc != 0) {
+		/* The update has been cached in the TX and cannot be detached,
+		 * report the failure to the caller anyway.
+		 */
+		D_ERROR("Fail to add dep on batch TX: "DF_RC"\n", DP_RC(rc));
+		D_MUTEX_UNLOCK(&obj_coalesce.oc_lock);
+		tse_task_complete(task, rc);
+		return true;
+	}
+
+	/* without it, the update is completed with the result of the batch */
+	if (tse_task_register_comp_cb(task, obj_coalesce_update_comp_cb, &ocb,
+				      sizeof(ocb)) == 0)
+		ocb->ocb_ref++;
+
+	D_ASSERT(ocb->ocb_nr < ocb->ocb_cap);
+	ocb->ocb_tasks[ocb->ocb_nr++] = task;
+	ocb->ocb_size += size;
+	obj_coalesce.oc_updates++;
+	if (ocb->ocb_nr >= ocb->ocb_cap ||
+	    ocb->ocb_size >= obj_coalesce.oc_max_size)
+		flush = obj_coalesce_batch_detach(ocb);
+out:
+	D_MUTEX_UNLOCK(&obj_coalesce.oc_lock);
+	if (rc != 0)
+		return false;
+
+	if (flush)
+		obj_coalesce_batch_flush(ocb);
+
+	return true;
+}
+
+void
+dc_obj_coalesce_stats(uint64_t *commits, uint64_t *updates,
+		      uint64_t *resubmits)
+{
+	D_MUTEX_LOCK(&obj_coalesce.oc_lock);
+	*commits = obj_coalesce.oc_commits;
+	*updates = obj_coalesce.oc_updates;
+	*resubmits = obj_coalesce.oc_resubmits;
+	D_MUTEX_UNLOCK(&obj_coalesce.oc_lock);
+}
+
+int
+obj_coalesce_init(void)
+{
+	int	i;
+	int	rc;
+
+	obj_coalesce.oc_max_nr = 0;
+	obj_coalesce.oc_max_size = OBJ_COALESCE_SIZE_DEF;
+	obj_coalesce.oc_usec = OBJ_COALESCE_USEC_DEF;
+	obj_coalesce.oc_commits = 0;
+	obj_coalesce.oc_updates = 0;
+	obj_coalesce.oc_resubmits = 0;
+
+	d_getenv_int(OBJ_COALESCE_NR_ENV, &obj_coalesce.oc_max_nr);
+	d_getenv_int(OBJ_COALESCE_SIZE_ENV, &obj_coalesce.oc_max_size);
+	d_getenv_int(OBJ_COALESCE_USEC_ENV, &obj_coalesce.oc_usec);
+
+	if (obj_coalesce.oc_max_size == 0)
+		obj_coalesce.oc_max_nr = 0;
+
+	rc = D_MUTEX_INIT(&obj_coalesce.oc_lock, NULL);
+	if (rc != 0)
+		return rc;
+
+	for (i = 0; i < OBJ_COALESCE_BUCKETS; i++)
+		D_INIT_LIST_HEAD(&obj_coalesce.oc_buckets[i]);
+
+	if (obj_coalesce_enabled())
+		D_INFO("Coalesce small updates: nr %u, size %u, usec %u\n",
+		       obj_coalesce.oc_max_nr, obj_coalesce.oc_max_size,
+		       obj_coalesce.oc_usec);
+
+	return 0;
+}
+
+void
+obj_coalesce_fini(void)
+{
+	int	i;
+
+	for (i = 0; i < OBJ_COALESCE_BUCKETS; i++)
+		D_ASSERT(d_list_empty(&obj_coalesce.oc_buckets[i]));
+
+	D_MUTEX_DESTROY(&obj_coalesce.oc_lock);
+}
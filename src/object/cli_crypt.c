@@ -0,0 +1,375 @@
+/**
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * This file is part of daos_sr
+ *
+ * src/object/cli_crypt.c
+ *
+ * Client side encryption of object data, for containers with the encryption
+ * property set.
+ *
+ * Values are encrypted with AES-XTS. The tweak of a data unit is made of a
+ * hash of (oid, dkey, akey) and of the index of the unit in the array, so any
+ * block aligned extent can be encrypted and decrypted on its own. Array
+ * extents must therefore be aligned on DAOS_CIPHER_BLOCK_SIZE bytes, single
+ * values can have any size.
+ *
+ * Update encrypts the user buffers into one new buffer, which replaces the
+ * user sgls for the rest of the request: EC parity and checksums are computed
+ * over the ciphertext and it is this buffer which is registered for bulk, so
+ * the plaintext is never copied. Updates cached by a transaction are encrypted
+ * the same way into their private copy. Fetch decrypts in place in the user
+ * buffers once the request is complete, which the server filled directly as
+ * the bulk cache is bypassed. Blocks which are all zero on fetch are holes.
+ *
+ * The encryption is deterministic for a given location: it hides the data but
+ * not whether the same data was written again at the same place, and it does
+ * not protect the integrity of the data against the servers.
+ */
+#define D_LOGFAC	DD_FAC(object)
+
+#include <daos/cipher.h>
+#include <daos/container.h>
+#include "obj_internal.h"
+
+/** Encrypted copy of the sgls of an update */
+struct obj_crypt_sgls {
+	/** the user sgls, restored on completion */
+	d_sg_list_t	*ocs_usgls;
+	d_sg_list_t	 ocs_sgls[0];
+	/* followed by one iov per sgl, and by the ciphertext */
+};
+
+/** Position in a sgl, only the first \a cc_nr iovs hold data */
+struct obj_crypt_cursor {
+	d_sg_list_t	*cc_sgl;
+	uint32_t	 cc_nr;
+	uint32_t	 cc_idx;
+	size_t		 cc_off;
+};
+
+static uint64_t
+obj_crypt_tweak(daos_obj_id_t oid, daos_key_t *dkey, daos_key_t *akey)
+{
+	uint64_t	hash;
+
+	hash = d_hash_murmur64((unsigned char *)&oid, sizeof(oid), 0);
+	hash = d_hash_murmur64(dkey->iov_buf, dkey->iov_len, hash);
+	return d_hash_murmur64(akey->iov_buf, akey->iov_len, hash);
+}
+
+static daos_size_t
+obj_crypt_iod_size(daos_iod_t *iod)
+{
+	daos_size_t	size = 0;
+	int		i;
+
+	if (iod->iod_type == DAOS_IOD_SINGLE)
+		return iod->iod_size;
+
+	for (i = 0; i < iod->iod_nr; i++)
+		size += iod->iod_recxs[i].rx_nr * iod->iod_size;
+	return size;
+}
+
+/** Return the contiguous bytes at the cursor, up to \a len, and skip them */
+static void *
+obj_crypt_cursor_next(struct obj_crypt_cursor *cur, size_t len, size_t *avail)
+{
+	d_iov_t	*iov;
+	void	*addr;
+
+	while (cur->cc_idx < cur->cc_nr) {
+		iov = &cur->cc_sgl->sg_iovs[cur->cc_idx];
+		if (cur->cc_off < iov->iov_len) {
+			addr = iov->iov_buf + cur->cc_off;
+			*avail = min(len, iov->iov_len - cur->cc_off);
+			cur->cc_off += *avail;
+			return addr;
+		}
+		cur->cc_idx++;
+		cur->cc_off = 0;
+	}
+
+	*avail = 0;
+	return NULL;
+}
+
+/**
+ * Copy \a len bytes between the cursor and \a buf, return the number of bytes
+ * copied, which is smaller if the sgl holds less data.
+ */
+static size_t
+obj_crypt_cursor_copy(struct obj_crypt_cursor *cur, void *buf, size_t len,
+		      bool to_buf)
+{
+	size_t	 done = 0;
+	size_t	 avail;
+	void	*addr;
+
+	while (done < len) {
+		addr = obj_crypt_cursor_next(cur, len - done, &avail);
+		if (addr == NULL)
+			break;
+		if (to_buf)
+			memcpy(buf + done, addr, avail);
+		else
+			memcpy(addr, buf + done, avail);
+		done += avail;
+	}
+	return done;
+}
+
+/**
+ * Encrypt (decrypt) the next \a len bytes of the cursor, at byte \a off of
+ * the value, into \a dst, or in place if \a dst is NULL. Data crossing iovs
+ * goes through \a scratch.
+ */
+static int
+obj_crypt_extent(struct daos_cipherer *cipherer, uint64_t tweak, bool single,
+		 uint64_t off, size_t len, struct obj_crypt_cursor *cur,
+		 void *dst, d_iov_t *scratch, bool encrypt)
+{
+	struct obj_crypt_cursor	 start = *cur;
+	size_t			 avail;
+	void			*src;
+	void			*buf;
+	int			 rc;
+
+	src = obj_crypt_cursor_next(cur, len, &avail);
+	if (src == NULL)
+		return encrypt ? -DER_REC2BIG : 0;
+
+	if (avail < len) {
+		if (scratch->iov_buf_len < len) {
+			D_REALLOC(buf, scratch->iov_buf, len);
+			if (buf == NULL)
+				return -DER_NOMEM;
+			d_iov_set(scratch, buf, len);
+		}
+		*cur = start;
+		avail = obj_crypt_cursor_copy(cur, scratch->iov_buf, len,
+					      true);
+		if (avail < len && encrypt)
+			return -DER_REC2BIG;
+		/* the rest was not fetched, treat it as a hole */
+		memset(scratch->iov_buf + avail, 0, len - avail);
+		src = scratch->iov_buf;
+	}
+
+	buf = dst != NULL ? dst : src;
+	if (single)
+		rc = daos_cipherer_crypt_value(cipherer, tweak, src, buf, len,
+					       encrypt);
+	else
+		rc = daos_cipherer_crypt_range(cipherer, tweak, off, src, buf,
+					       len, encrypt);
+	if (rc != 0 || dst != NULL || src != scratch->iov_buf)
+		return rc;
+
+	/* decrypted in the scratch buffer, scatter it back */
+	*cur = start;
+	obj_crypt_cursor_copy(cur, scratch->iov_buf, avail, false);
+	return 0;
+}
+
+/**
+ * Encrypt (decrypt) the data of \a sgls described by \a iods, into the
+ * contiguous buffer \a dst, or in place if \a dst is NULL.
+ */
+int
+obj_crypt_sgls(struct daos_cipherer *cipherer, daos_obj_id_t oid,
+	       daos_key_t *dkey, daos_iod_t *iods, d_sg_list_t *sgls,
+	       unsigned int nr, void *dst, bool encrypt)
+{
+	struct obj_crypt_cursor	 cur;
+	d_iov_t			 scratch = { 0 };
+	daos_iod_t		*iod;
+	uint64_t		 tweak;
+	size_t			 len;
+	int			 i, j;
+	int			 rc = 0;
+
+	for (i = 0; i < nr && rc == 0; i++) {
+		iod = &iods[i];
+		if (iod->iod_size == 0 || iod->iod_size == DAOS_REC_ANY)
+			continue;
+
+		cur.cc_sgl = &sgls[i];
+		cur.cc_nr = encrypt ? sgls[i].sg_nr : sgls[i].sg_nr_out;
+		cur.cc_idx = 0;
+		cur.cc_off = 0;
+		tweak = obj_crypt_tweak(oid, dkey, &iod->iod_name);
+
+		if (iod->iod_type == DAOS_IOD_SINGLE) {
+			rc = obj_crypt_extent(cipherer, tweak, true, 0,
+					      iod->iod_size, &cur, dst,
+					      &scratch, encrypt);
+			if (dst != NULL)
+				dst += iod->iod_size;
+			continue;
+		}
+
+		for (j = 0; j < iod->iod_nr && rc == 0; j++) {
+			len = iod->iod_recxs[j].rx_nr * iod->iod_size;
+			rc = obj_crypt_extent(cipherer, tweak, false,
+					      iod->iod_recxs[j].rx_idx *
+					      iod->iod_size, len, &cur, dst,
+					      &scratch, encrypt);
+			if (dst != NULL)
+				dst += len;
+		}
+	}
+
+	D_FREE(scratch.iov_buf);
+	return rc;
+}
+
+/**
+ * Encrypt the data of \a sgls described by \a iods into new sgls \a dsts, of
+ * one buffer each. The buffers are freed by d_sgl_fini().
+ */
+int
+obj_crypt_sgls_dup(struct daos_cipherer *cipherer, daos_obj_id_t oid,
+		   daos_key_t *dkey, daos_iod_t *iods, d_sg_list_t *sgls,
+		   d_sg_list_t *dsts, unsigned int nr)
+{
+	daos_size_t	size;
+	int		i;
+	int		rc;
+
+	for (i = 0; i < nr; i++) {
+		size = obj_crypt_iod_size(&iods[i]);
+		if (sgls[i].sg_nr == 0 || size == 0 || size == DAOS_REC_ANY)
+			continue;
+
+		rc = d_sgl_init(&dsts[i], 1);
+		if (rc != 0)
+			return rc;
+
+		D_ALLOC(dsts[i].sg_iovs[0].iov_buf, size);
+		if (dsts[i].sg_iovs[0].iov_buf == NULL)
+			return -DER_NOMEM;
+		dsts[i].sg_iovs[0].iov_buf_len = size;
+		dsts[i].sg_iovs[0].iov_len = size;
+
+		rc = obj_crypt_sgls(cipherer, oid, dkey, &iods[i], &sgls[i], 1,
+				    dsts[i].sg_iovs[0].iov_buf, true);
+		if (rc != 0)
+			return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Return the cipherer of the container of \a obj in \a p_cipherer, NULL if
+ * it is not encrypted, and check that the extents of \a iods can be
+ * encrypted.
+ */
+int
+obj_crypt_prep(struct dc_object *obj, daos_iod_t *iods, unsigned int nr,
+	       struct daos_cipherer **p_cipherer)
+{
+	struct daos_cipherer	*cipherer;
+	daos_iod_t		*iod;
+	int			 i, j;
+
+	*p_cipherer = NULL;
+	if (!dc_cont_hdl2props(obj->cob_coh).dcp_encrypt_enabled)
+		return 0;
+
+	cipherer = dc_cont_hdl2cipherer(obj->cob_coh);
+	if (cipherer == NULL) {
+		D_ERROR(DF_OID": no key for the encrypted container\n",
+			DP_OID(obj->cob_md.omd_id));
+		return -DER_NO_PERM;
+	}
+
+	for (i = 0; i < nr; i++) {
+		iod = &iods[i];
+		if (iod->iod_type == DAOS_IOD_SINGLE ||
+		    iod->iod_size == DAOS_REC_ANY)
+			continue;
+
+		for (j = 0; j < iod->iod_nr; j++) {
+			if ((iod->iod_recxs[j].rx_idx * iod->iod_size) %
+			    DAOS_CIPHER_BLOCK_SIZE == 0 &&
+			    (iod->iod_recxs[j].rx_nr * iod->iod_size) %
+			    DAOS_CIPHER_BLOCK_SIZE == 0)
+				continue;
+
+			D_ERROR(DF_OID": extent "DF_RECX" of encrypted array "
+				"isn't aligned on %u bytes\n",
+				DP_OID(obj->cob_md.omd_id),
+				DP_RECX(iod->iod_recxs[j]),
+				DAOS_CIPHER_BLOCK_SIZE);
+			return -DER_INVAL;
+		}
+	}
+
+	*p_cipherer = cipherer;
+	return 0;
+}
+
+/**
+ * Replace the sgls of the update by an encrypted copy of them, the user sgls
+ * are restored by obj_crypt_update_fini().
+ */
+int
+obj_crypt_update(struct daos_cipherer *cipherer, struct dc_object *obj,
+		 daos_obj_update_t *args)
+{
+	struct obj_crypt_sgls	*ocs;
+	d_iov_t			*iovs;
+	char			*data;
+	daos_size_t		 size = 0;
+	daos_size_t		 len;
+	int			 i;
+	int			 rc;
+
+	for (i = 0; i < args->nr; i++)
+		size += obj_crypt_iod_size(&args->iods[i]);
+
+	D_ALLOC(ocs, sizeof(*ocs) +
+		     args->nr * (sizeof(d_sg_list_t) + sizeof(d_iov_t)) + size);
+	if (ocs == NULL)
+		return -DER_NOMEM;
+
+	iovs = (d_iov_t *)&ocs->ocs_sgls[args->nr];
+	data = (char *)&iovs[args->nr];
+	rc = obj_crypt_sgls(cipherer, obj->cob_md.omd_id, args->dkey,
+			    args->iods, args->sgls, args->nr, data, true);
+	if (rc != 0) {
+		D_ERROR(DF_OID": encryption failed: "DF_RC"\n",
+			DP_OID(obj->cob_md.omd_id), DP_RC(rc));
+		D_FREE(ocs);
+		return rc;
+	}
+
+	for (i = 0; i < args->nr; i++) {
+		len = obj_crypt_iod_size(&args->iods[i]);
+		d_iov_set(&iovs[i], data, len);
+		ocs->ocs_sgls[i].sg_nr = 1;
+		ocs->ocs_sgls[i].sg_nr_out = 1;
+		ocs->ocs_sgls[i].sg_iovs = &iovs[i];
+		data += len;
+	}
+
+	ocs->ocs_usgls = args->sgls;
+	args->sgls = ocs->ocs_sgls;
+	return 0;
+}
+
+void
+obj_crypt_update_fini(daos_obj_update_t *args)
+{
+	struct obj_crypt_sgls	*ocs;
+
+	ocs = container_of(args->sgls, struct obj_crypt_sgls, ocs_sgls[0]);
+	args->sgls = ocs->ocs_usgls;
+	D_FREE(ocs);
+}
@@ -539,11 +539,12 @@ obj_ec_recx_encode(daos_obj_id_t oid, daos_iod_t *iod, d_sg_list_t *sgl,
 	struct obj_ec_recx	*ec_recx;
 	unsigned int		 p = oca->u.ec.e_p;
 	unsigned char		*parity_buf[p];
+	unsigned char		*from;
 	uint64_t		 cell_bytes, stripe_bytes;
 	uint32_t		 iov_idx = 0;
 	uint64_t		 iov_off = 0, last_off = 0;
 	uint32_t		 encoded_nr = 0;
-	uint32_t		 recx_nr, stripe_nr;
+	uint32_t		 recx_nr, stripe_nr, batch_nr;
 	uint32_t		 i, j, m;
 	bool			 singv;
 	int			 rc = 0;
@@ -585,6 +586,26 @@ obj_ec_recx_encode(daos_obj_id_t oid, daos_iod_t *iod, d_sg_list_t *sgl,
 			for (m = 0; m < p; m++)
 				parity_buf[m] = recx_array->oer_pbufs[m] +
 						encoded_nr * cell_bytes;
+			/* stripes lying in one iov are encoded as one run */
+			batch_nr = 0;
+			if (!singv && iov_idx < sgl->sg_nr)
+				batch_nr = min(stripe_nr - j,
+					       daos_iov_left(sgl, iov_idx,
+							     iov_off) /
+					       stripe_bytes);
+			if (batch_nr > 1) {
+				from = sgl->sg_iovs[iov_idx].iov_buf;
+				obj_ec_stripes_encode(codec, oca->u.ec.e_k, p,
+						      cell_bytes,
+						      &from[iov_off], batch_nr,
+						      parity_buf);
+				encoded_nr += batch_nr;
+				j += batch_nr - 1;
+				daos_sgl_move(sgl, iov_idx, iov_off,
+					      batch_nr * stripe_bytes);
+				last_off += batch_nr * stripe_bytes;
+				continue;
+			}
 #if EC_DEBUG
 			D_PRINT("encode %d rec_offset "DF_U64", rec_nr "
 				DF_U64".\n", j, iov_off / iod->iod_size,
@@ -2311,6 +2332,80 @@ obj_ec_fail_info_free(struct obj_reasb_req *reasb_req)
 	reasb_req->orr_fail = NULL;
 }
 
+static void
+obj_ec_stripe_key_init(struct obj_ec_stripe_key *key,
+		       struct obj_ec_fail_info *fail_info, daos_obj_id_t oid,
+		       daos_iod_t *iod)
+{
+	key->esk_coh = fail_info->efi_coh;
+	key->esk_oid = oid;
+	key->esk_dkey = fail_info->efi_dkey;
+	key->esk_akey = &iod->iod_name;
+	key->esk_rsize = iod->iod_size;
+	key->esk_map_ver = fail_info->efi_map_ver;
+}
+
+/**
+ * Fill the stripe buffers of the recovery tasks from the recovery cache, a
+ * task does not need to fetch anything if all of its stripes are cached.
+ */
+static void
+obj_ec_recov_cache_fill(struct obj_reasb_req *reasb_req, daos_obj_id_t oid,
+			daos_iod_t *iods, uint32_t iod_nr)
+{
+	struct obj_ec_fail_info		*fail_info = reasb_req->orr_fail;
+	struct daos_oclass_attr		*oca = reasb_req->orr_oca;
+	uint64_t			 stripe_rec_nr =
+						obj_ec_stripe_rec_nr(oca);
+	struct daos_recx_ep_list	*stripe_list;
+	struct daos_recx_ep		*recx_ep;
+	struct obj_ec_recov_task	*rtask;
+	struct obj_ec_stripe_key	 key;
+	daos_iod_t			*iod;
+	void				*buf;
+	uint64_t			 cell_sz, stripe_total_sz;
+	uint64_t			 stripe_nr, s;
+	uint32_t			 i, j, tidx = 0;
+
+	if (reasb_req->orr_singv_only || fail_info->efi_dkey == NULL)
+		return;
+
+	for (i = 0; i < iod_nr; i++) {
+		stripe_list = &fail_info->efi_stripe_lists[i];
+		if (stripe_list->re_nr == 0)
+			continue;
+		iod = &iods[i];
+		if (iod->iod_type == DAOS_IOD_SINGLE || iod->iod_size == 0) {
+			tidx += iod->iod_type == DAOS_IOD_SINGLE ?
+				1 : stripe_list->re_nr;
+			continue;
+		}
+
+		obj_ec_stripe_key_init(&key, fail_info, oid, iod);
+		cell_sz = obj_ec_cell_rec_nr(oca) * iod->iod_size;
+		stripe_total_sz = cell_sz * obj_ec_tgt_nr(oca);
+		for (j = 0; j < stripe_list->re_nr; j++) {
+			D_ASSERT(tidx < fail_info->efi_recov_ntasks);
+			rtask = &fail_info->efi_recov_tasks[tidx++];
+			if (rtask->ert_cached)
+				continue;
+			recx_ep = &stripe_list->re_items[j];
+			key.esk_epoch = recx_ep->re_ep;
+			buf = rtask->ert_sgl.sg_iovs[0].iov_buf;
+			stripe_nr = recx_ep->re_recx.rx_nr / stripe_rec_nr;
+			for (s = 0; s < stripe_nr; s++) {
+				key.esk_stripe = recx_ep->re_recx.rx_idx /
+						 stripe_rec_nr + s;
+				if (!obj_ec_recov_cache_get(&key,
+						buf + s * stripe_total_sz,
+						cell_sz * oca->u.ec.e_k))
+					break;
+			}
+			rtask->ert_cached = (s == stripe_nr);
+		}
+	}
+}
+
 int
 obj_ec_recov_prep(struct obj_reasb_req *reasb_req, daos_obj_id_t oid,
 		  daos_iod_t *iods, uint32_t iod_nr)
@@ -2338,6 +2433,8 @@ obj_ec_recov_prep(struct obj_reasb_req *reasb_req, daos_obj_id_t oid,
 	if (rc)
 		goto out;
 
+	obj_ec_recov_cache_fill(reasb_req, oid, iods, iod_nr);
+
 out:
 	if (rc)
 		D_ERROR(DF_OID" obj_ec_recov_prep failed, "DF_RC".\n",
@@ -2517,8 +2614,11 @@ obj_ec_recov_data(struct obj_reasb_req *reasb_req, daos_obj_id_t oid,
 						fail_info->efi_stripe_sgls;
 	d_sg_list_t			*stripe_sgl, *sgl;
 	daos_iod_t			*iod;
+	struct obj_ec_stripe_key	 key;
+	struct obj_ec_recov_task	*rtask;
 	void				*buf_stripe;
 	uint32_t			 i, j, sidx, stripe_nr, recx_nr;
+	uint32_t			 tidx = 0;
 	uint64_t			 cell_sz, stripe_total_sz;
 	uint64_t			 stripe_rec_nr =
 						obj_ec_stripe_rec_nr(oca);
@@ -2548,7 +2648,8 @@ obj_ec_recov_data(struct obj_reasb_req *reasb_req, daos_obj_id_t oid,
 		stripe_total_sz = cell_sz * obj_ec_tgt_nr(oca);
 		buf_stripe = stripe_sgl->sg_iovs[0].iov_buf;
 		recx_nr = singv ? 1 : stripe_list->re_nr;
-		for (j = 0; j < recx_nr; j++) {
+		obj_ec_stripe_key_init(&key, fail_info, oid, iod);
+		for (j = 0; j < recx_nr; j++, tidx++) {
 			if (singv) {
 				stripe_nr = 1;
 				if (obj_ec_singv_one_tgt(iod->iod_size,
@@ -2558,10 +2659,25 @@ obj_ec_recov_data(struct obj_reasb_req *reasb_req, daos_obj_id_t oid,
 				recx_ep = &stripe_list->re_items[j];
 				stripe_nr = recx_ep->re_recx.rx_nr /
 					    stripe_rec_nr;
+				rtask = &fail_info->efi_recov_tasks[tidx];
+				if (rtask->ert_cached) {
+					buf_stripe += stripe_nr *
+						      stripe_total_sz;
+					continue;
+				}
 			}
 			for (sidx = 0; sidx < stripe_nr; sidx++) {
 				obj_ec_recov_stripe(codec, oca, buf_stripe,
 						    cell_sz);
+				if (!singv && fail_info->efi_dkey != NULL) {
+					key.esk_epoch = recx_ep->re_ep;
+					key.esk_stripe =
+						recx_ep->re_recx.rx_idx /
+						stripe_rec_nr + sidx;
+					obj_ec_recov_cache_put(&key,
+						buf_stripe,
+						cell_sz * oca->u.ec.e_k);
+				}
 				buf_stripe += stripe_total_sz;
 			}
 		}
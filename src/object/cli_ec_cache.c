@@ -0,0 +1,301 @@
+/**
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * This file is part of daos_sr
+ *
+ * src/object/cli_ec_cache.c
+ *
+ * Client side cache of EC stripes reconstructed by degraded fetches.
+ *
+ * While a data shard is unavailable, each fetch of its cells fetches and
+ * decodes the full stripe, although sequential readers usually hit the same
+ * stripe several times in a row. The data cells of every decoded stripe are
+ * kept in a byte bounded LRU cache, keyed by (container handle, oid, dkey,
+ * akey, stripe, record size, epoch). The epoch is the shadow epoch reported
+ * by the servers for the stripe, i.e. the parity epoch the stripe has been
+ * rebuilt from, so the cached content is immutable: any later update or
+ * aggregation of the stripe changes the epoch of the key.
+ *
+ * The pool map version the stripe has been reconstructed at is kept too but
+ * is not part of the key, a lookup at another version drops the stripe, as
+ * the targets it has been rebuilt from may have been excluded or
+ * reintegrated meanwhile.
+ *
+ * The size of the cache is controlled by DAOS_EC_RECOV_CACHE_SIZE in bytes
+ * (32MiB by default), zero disables it.
+ */
+#define D_LOGFAC	DD_FAC(object)
+
+#include <daos/common.h>
+#include "obj_ec.h"
+
+#define EC_RECOV_CACHE_SIZE_ENV		"DAOS_EC_RECOV_CACHE_SIZE"
+#define EC_RECOV_CACHE_SIZE_DEF		(32U << 20)
+#define EC_RECOV_CACHE_BITS		(10)
+
+struct ec_stripe_rec {
+	/* link in the hash table */
+	d_list_t		 esr_hlink;
+	/* link in the LRU list, the most recently used first */
+	d_list_t		 esr_lru;
+	uint32_t		 esr_hash;
+	daos_handle_t		 esr_coh;
+	daos_obj_id_t		 esr_oid;
+	uint64_t		 esr_stripe;
+	daos_epoch_t		 esr_epoch;
+	daos_size_t		 esr_rsize;
+	uint32_t		 esr_map_ver;
+	uint32_t		 esr_dkey_len;
+	uint32_t		 esr_akey_len;
+	uint64_t		 esr_size;
+	/* dkey, akey and then stripe data */
+	unsigned char		 esr_buf[0];
+};
+
+static struct {
+	pthread_mutex_t		 ec_lock;
+	struct d_hash_table	 ec_htable;
+	d_list_t		 ec_lru;
+	/* bytes of cached stripe data, and upper bound of it */
+	uint64_t		 ec_bytes;
+	uint64_t		 ec_max_bytes;
+	uint64_t		 ec_hits;
+	uint64_t		 ec_misses;
+	uint64_t		 ec_dropped;
+	bool			 ec_enabled;
+} ec_cache = {
+	.ec_lock	= PTHREAD_MUTEX_INITIALIZER,
+};
+
+static inline struct ec_stripe_rec *
+ec_hlink2rec(d_list_t *link)
+{
+	return container_of(link, struct ec_stripe_rec, esr_hlink);
+}
+
+static uint32_t
+ec_stripe_key_hash(struct obj_ec_stripe_key *key)
+{
+	uint64_t	hash;
+
+	hash = d_hash_murmur64((unsigned char *)&key->esk_oid,
+			       sizeof(key->esk_oid), key->esk_coh.cookie);
+	hash = d_hash_murmur64((unsigned char *)&key->esk_stripe,
+			       sizeof(key->esk_stripe), hash);
+	hash = d_hash_murmur64((unsigned char *)&key->esk_epoch,
+			       sizeof(key->esk_epoch), hash);
+	hash = d_hash_murmur64(key->esk_dkey->iov_buf,
+			       key->esk_dkey->iov_len, hash);
+	hash = d_hash_murmur64(key->esk_akey->iov_buf,
+			       key->esk_akey->iov_len, hash);
+	return (uint32_t)(hash ^ (hash >> 32));
+}
+
+static bool
+ec_stripe_key_cmp(struct d_hash_table *htable, d_list_t *link,
+		  const void *k, unsigned int ksize)
+{
+	struct ec_stripe_rec		*rec = ec_hlink2rec(link);
+	const struct obj_ec_stripe_key	*key = k;
+
+	D_ASSERT(ksize == sizeof(*key));
+	return rec->esr_coh.cookie == key->esk_coh.cookie &&
+	       daos_oid_cmp(rec->esr_oid, key->esk_oid) == 0 &&
+	       rec->esr_stripe == key->esk_stripe &&
+	       rec->esr_epoch == key->esk_epoch &&
+	       rec->esr_rsize == key->esk_rsize &&
+	       rec->esr_dkey_len == key->esk_dkey->iov_len &&
+	       rec->esr_akey_len == key->esk_akey->iov_len &&
+	       memcmp(rec->esr_buf, key->esk_dkey->iov_buf,
+		      rec->esr_dkey_len) == 0 &&
+	       memcmp(rec->esr_buf + rec->esr_dkey_len, key->esk_akey->iov_buf,
+		      rec->esr_akey_len) == 0;
+}
+
+static uint32_t
+ec_stripe_key_hash_op(struct d_hash_table *htable, const void *key,
+		      unsigned int ksize)
+{
+	return ec_stripe_key_hash((struct obj_ec_stripe_key *)key);
+}
+
+static uint32_t
+ec_stripe_rec_hash(struct d_hash_table *htable, d_list_t *link)
+{
+	return ec_hlink2rec(link)->esr_hash;
+}
+
+static d_hash_table_ops_t ec_stripe_hops = {
+	.hop_key_cmp	= ec_stripe_key_cmp,
+	.hop_key_hash	= ec_stripe_key_hash_op,
+	.hop_rec_hash	= ec_stripe_rec_hash,
+};
+
+static inline unsigned char *
+ec_stripe_rec_data(struct ec_stripe_rec *rec)
+{
+	return rec->esr_buf + rec->esr_dkey_len + rec->esr_akey_len;
+}
+
+static void
+ec_stripe_rec_delete(struct ec_stripe_rec *rec)
+{
+	d_hash_rec_delete_at(&ec_cache.ec_htable, &rec->esr_hlink);
+	d_list_del(&rec->esr_lru);
+	ec_cache.ec_bytes -= rec->esr_size;
+	D_FREE(rec);
+}
+
+/**
+ * Copy the data cells of the stripe identified by \a key to \a buf if the
+ * stripe is cached. Return true on hit, a stripe cached at another pool map
+ * version is dropped.
+ */
+bool
+obj_ec_recov_cache_get(struct obj_ec_stripe_key *key, void *buf,
+		       uint64_t size)
+{
+	struct ec_stripe_rec	*rec;
+	d_list_t		*link;
+	bool			 hit = false;
+
+	if (!ec_cache.ec_enabled)
+		return false;
+
+	D_MUTEX_LOCK(&ec_cache.ec_lock);
+	link = d_hash_rec_find(&ec_cache.ec_htable, key, sizeof(*key));
+	if (link != NULL) {
+		rec = ec_hlink2rec(link);
+		if (rec->esr_map_ver != key->esk_map_ver) {
+			ec_stripe_rec_delete(rec);
+			ec_cache.ec_dropped++;
+		} else if (rec->esr_size == size) {
+			memcpy(buf, ec_stripe_rec_data(rec), size);
+			d_list_move(&rec->esr_lru, &ec_cache.ec_lru);
+			hit = true;
+		}
+	}
+	if (hit)
+		ec_cache.ec_hits++;
+	else
+		ec_cache.ec_misses++;
+	D_MUTEX_UNLOCK(&ec_cache.ec_lock);
+
+	return hit;
+}
+
+/**
+ * Add the data cells (\a size bytes in \a buf) of a reconstructed stripe to
+ * the cache, the least recently used stripes are evicted to make room.
+ */
+void
+obj_ec_recov_cache_put(struct obj_ec_stripe_key *key, void *buf,
+		       uint64_t size)
+{
+	struct ec_stripe_rec	*rec;
+	struct ec_stripe_rec	*victim;
+	int			 rc;
+
+	/* a stripe should not flush most of the cache */
+	if (!ec_cache.ec_enabled || size > ec_cache.ec_max_bytes / 4)
+		return;
+
+	D_ALLOC(rec, sizeof(*rec) + key->esk_dkey->iov_len +
+		     key->esk_akey->iov_len + size);
+	if (rec == NULL)
+		return;
+
+	rec->esr_hash		= ec_stripe_key_hash(key);
+	rec->esr_coh		= key->esk_coh;
+	rec->esr_oid		= key->esk_oid;
+	rec->esr_stripe		= key->esk_stripe;
+	rec->esr_epoch		= key->esk_epoch;
+	rec->esr_rsize		= key->esk_rsize;
+	rec->esr_map_ver	= key->esk_map_ver;
+	rec->esr_dkey_len	= key->esk_dkey->iov_len;
+	rec->esr_akey_len	= key->esk_akey->iov_len;
+	rec->esr_size		= size;
+	memcpy(rec->esr_buf, key->esk_dkey->iov_buf, rec->esr_dkey_len);
+	memcpy(rec->esr_buf + rec->esr_dkey_len, key->esk_akey->iov_buf,
+	       rec->esr_akey_len);
+	memcpy(ec_stripe_rec_data(rec), buf, size);
+
+	D_MUTEX_LOCK(&ec_cache.ec_lock);
+	while (ec_cache.ec_bytes + size > ec_cache.ec_max_bytes) {
+		victim = d_list_entry(ec_cache.ec_lru.prev,
+				      struct ec_stripe_rec, esr_lru);
+		ec_stripe_rec_delete(victim);
+	}
+
+	rc = d_hash_rec_insert(&ec_cache.ec_htable, key, sizeof(*key),
+			       &rec->esr_hlink, true);
+	if (rc == 0) {
+		d_list_add(&rec->esr_lru, &ec_cache.ec_lru);
+		ec_cache.ec_bytes += size;
+	}
+	D_MUTEX_UNLOCK(&ec_cache.ec_lock);
+
+	/* -DER_EEXIST: another fetch cached the same stripe meanwhile */
+	if (rc != 0)
+		D_FREE(rec);
+}
+
+void
+dc_obj_ec_recov_cache_stats(uint64_t *hits, uint64_t *misses,
+			    uint64_t *dropped)
+{
+	D_MUTEX_LOCK(&ec_cache.ec_lock);
+	*hits = ec_cache.ec_hits;
+	*misses = ec_cache.ec_misses;
+	*dropped = ec_cache.ec_dropped;
+	D_MUTEX_UNLOCK(&ec_cache.ec_lock);
+}
+
+int
+obj_ec_recov_cache_init(void)
+{
+	unsigned int	size = EC_RECOV_CACHE_SIZE_DEF;
+	int		rc;
+
+	d_getenv_int(EC_RECOV_CACHE_SIZE_ENV, &size);
+	if (size == 0)
+		return 0;
+
+	rc = d_hash_table_create_inplace(D_HASH_FT_NOLOCK, EC_RECOV_CACHE_BITS,
+					 NULL, &ec_stripe_hops,
+					 &ec_cache.ec_htable);
+	if (rc != 0)
+		return rc;
+
+	D_INIT_LIST_HEAD(&ec_cache.ec_lru);
+	ec_cache.ec_bytes = 0;
+	ec_cache.ec_max_bytes = size;
+	ec_cache.ec_enabled = true;
+	return 0;
+}
+
+void
+obj_ec_recov_cache_fini(void)
+{
+	struct ec_stripe_rec	*rec;
+
+	if (!ec_cache.ec_enabled)
+		return;
+
+	D_DEBUG(DB_IO, "EC recovery cache: hits "DF_U64", misses "DF_U64
+		", dropped "DF_U64"\n", ec_cache.ec_hits, ec_cache.ec_misses,
+		ec_cache.ec_dropped);
+
+	ec_cache.ec_enabled = false;
+	while ((rec = d_list_pop_entry(&ec_cache.ec_lru, struct ec_stripe_rec,
+				       esr_lru)) != NULL) {
+		d_hash_rec_delete_at(&ec_cache.ec_htable, &rec->esr_hlink);
+		ec_cache.ec_bytes -= rec->esr_size;
+		D_FREE(rec);
+	}
+	D_ASSERT(ec_cache.ec_bytes == 0);
+	d_hash_table_destroy_inplace(&ec_cache.ec_htable, true);
+}
@@ -0,0 +1,257 @@
+/**
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * object client: EC encoding of runs of contiguous full stripes.
+ *
+ * Large sequential updates are handed over as runs of full stripes lying back
+ * to back in the user buffer, without walking the sgl for every stripe. When
+ * a run is big enough it is split across a small per-process pool of worker
+ * threads, the calling thread encodes its own share and helps with queued
+ * pieces while it waits, so a single large write is not bound to one core.
+ *
+ * The codec is still called once per stripe: the cells of consecutive
+ * stripes are interleaved in the user buffer while the codec takes each data
+ * cell as one contiguous source, so a single call over the run would first
+ * have to gather the cells into a copy of the data.
+ */
+#define D_LOGFAC	DD_FAC(object)
+
+#include <pthread.h>
+#include <daos/common.h>
+#include "obj_ec.h"
+
+/** Default minimal size in bytes of a run to be split across the pool */
+#define EC_ENCODE_PARALLEL_MIN	(1 << 20)
+/** Upper bound of the number of encoding threads */
+#define EC_ENCODE_THREADS_MAX	64
+
+/** A run of contiguous full stripes to be encoded */
+struct ec_encode_job {
+	struct obj_ec_codec	 *ej_codec;
+	unsigned char		 *ej_data;
+	unsigned char		**ej_pbufs;
+	uint64_t		  ej_cell_bytes;
+	unsigned int		  ej_k;
+	unsigned int		  ej_p;
+	/** number of queued pieces not completed yet, protected by ep_lock */
+	unsigned int		  ej_pending;
+};
+
+/** A slice of a job, handed to a worker thread */
+struct ec_encode_piece {
+	d_list_t		 epc_link;
+	struct ec_encode_job	*epc_job;
+	uint32_t		 epc_start;
+	uint32_t		 epc_nr;
+};
+
+static struct {
+	pthread_mutex_t		 ep_lock;
+	/** signaled when pieces are queued or the pool is stopping */
+	pthread_cond_t		 ep_work_cond;
+	/** signaled when a queued piece is completed */
+	pthread_cond_t		 ep_done_cond;
+	d_list_t		 ep_queue;
+	pthread_t		*ep_threads;
+	unsigned int		 ep_thread_nr;
+	bool			 ep_stop;
+} ec_pool = {
+	.ep_lock	= PTHREAD_MUTEX_INITIALIZER,
+	.ep_work_cond	= PTHREAD_COND_INITIALIZER,
+	.ep_done_cond	= PTHREAD_COND_INITIALIZER,
+};
+
+static unsigned int ec_parallel_min = EC_ENCODE_PARALLEL_MIN;
+
+static void
+ec_stripes_encode_range(struct ec_encode_job *job, uint32_t start,
+			uint32_t nr)
+{
+	unsigned char	*data[OBJ_EC_MAX_K];
+	unsigned char	*parity[OBJ_EC_MAX_P];
+	unsigned char	*stripe;
+	uint64_t	 cell_bytes = job->ej_cell_bytes;
+	uint32_t	 s;
+	unsigned int	 i;
+
+	for (s = start; s < start + nr; s++) {
+		stripe = job->ej_data + s * cell_bytes * job->ej_k;
+		for (i = 0; i < job->ej_k; i++)
+			data[i] = &stripe[i * cell_bytes];
+		for (i = 0; i < job->ej_p; i++)
+			parity[i] = job->ej_pbufs[i] + s * cell_bytes;
+		ec_encode_data(cell_bytes, job->ej_k, job->ej_p,
+			       job->ej_codec->ec_gftbls, data, parity);
+	}
+}
+
+/** Run the head of the queue, called and returns with ep_lock held. */
+static void
+ec_piece_run_locked(void)
+{
+	struct ec_encode_piece	*piece;
+	struct ec_encode_job	*job;
+
+	piece = d_list_pop_entry(&ec_pool.ep_queue, struct ec_encode_piece,
+				 epc_link);
+	D_ASSERT(piece != NULL);
+	job = piece->epc_job;
+
+	D_MUTEX_UNLOCK(&ec_pool.ep_lock);
+	ec_stripes_encode_range(job, piece->epc_start, piece->epc_nr);
+	D_MUTEX_LOCK(&ec_pool.ep_lock);
+
+	D_ASSERT(job->ej_pending > 0);
+	if (--job->ej_pending == 0)
+		pthread_cond_broadcast(&ec_pool.ep_done_cond);
+}
+
+static void *
+ec_encode_worker(void *arg)
+{
+	D_MUTEX_LOCK(&ec_pool.ep_lock);
+	while (!ec_pool.ep_stop) {
+		if (d_list_empty(&ec_pool.ep_queue)) {
+			pthread_cond_wait(&ec_pool.ep_work_cond,
+					  &ec_pool.ep_lock);
+			continue;
+		}
+		ec_piece_run_locked();
+	}
+	D_MUTEX_UNLOCK(&ec_pool.ep_lock);
+	return NULL;
+}
+
+/**
+ * Encode \a stripe_nr full stripes lying back to back in \a data, stripe by
+ * stripe, the parity cells of stripe \a s are stored at
+ * parity_bufs[i] + s * cell_bytes.
+ */
+void
+obj_ec_stripes_encode(struct obj_ec_codec *codec, unsigned int k,
+		      unsigned int p, uint64_t cell_bytes, unsigned char *data,
+		      uint32_t stripe_nr, unsigned char *parity_bufs[])
+{
+	struct ec_encode_job	 job = { 0 };
+	struct ec_encode_piece	*pieces = NULL;
+	uint32_t		 piece_nr;
+	uint32_t		 start, nr;
+	unsigned int		 i;
+
+	D_ASSERT(k <= OBJ_EC_MAX_K && p <= OBJ_EC_MAX_P);
+	job.ej_codec		= codec;
+	job.ej_data		= data;
+	job.ej_pbufs		= parity_bufs;
+	job.ej_cell_bytes	= cell_bytes;
+	job.ej_k		= k;
+	job.ej_p		= p;
+
+	piece_nr = min(stripe_nr, ec_pool.ep_thread_nr + 1);
+	if (piece_nr > 1 && stripe_nr * cell_bytes * k >= ec_parallel_min)
+		D_ALLOC_ARRAY(pieces, piece_nr);
+	if (pieces == NULL) {
+		ec_stripes_encode_range(&job, 0, stripe_nr);
+		return;
+	}
+
+	for (i = 0, start = 0; i < piece_nr; i++) {
+		nr = stripe_nr / piece_nr + (i < stripe_nr % piece_nr);
+		pieces[i].epc_job	= &job;
+		pieces[i].epc_start	= start;
+		pieces[i].epc_nr	= nr;
+		start += nr;
+	}
+	D_ASSERT(start == stripe_nr);
+
+	/* keep the first piece for the calling thread */
+	D_MUTEX_LOCK(&ec_pool.ep_lock);
+	for (i = 1; i < piece_nr; i++)
+		d_list_add_tail(&pieces[i].epc_link, &ec_pool.ep_queue);
+	job.ej_pending = piece_nr - 1;
+	pthread_cond_broadcast(&ec_pool.ep_work_cond);
+	D_MUTEX_UNLOCK(&ec_pool.ep_lock);
+
+	ec_stripes_encode_range(&job, pieces[0].epc_start, pieces[0].epc_nr);
+
+	/* help with whatever is still queued, then wait for the rest */
+	D_MUTEX_LOCK(&ec_pool.ep_lock);
+	while (job.ej_pending > 0) {
+		if (!d_list_empty(&ec_pool.ep_queue))
+			ec_piece_run_locked();
+		else
+			pthread_cond_wait(&ec_pool.ep_done_cond,
+					  &ec_pool.ep_lock);
+	}
+	D_MUTEX_UNLOCK(&ec_pool.ep_lock);
+
+	D_FREE(pieces);
+}
+
+/**
+ * Start the encoding threads, DAOS_EC_ENCODE_THREADS of them (none by
+ * default). Runs smaller than DAOS_EC_ENCODE_PARALLEL_MIN bytes are always
+ * encoded by the calling thread.
+ */
+int
+obj_ec_encode_pool_init(void)
+{
+	unsigned int	thread_nr = 0;
+	unsigned int	i;
+	int		rc;
+
+	d_getenv_int("DAOS_EC_ENCODE_PARALLEL_MIN", &ec_parallel_min);
+	d_getenv_int("DAOS_EC_ENCODE_THREADS", &thread_nr);
+	if (thread_nr == 0)
+		return 0;
+	if (thread_nr > EC_ENCODE_THREADS_MAX) {
+		D_WARN("DAOS_EC_ENCODE_THREADS %u is too large, use %u\n",
+		       thread_nr, EC_ENCODE_THREADS_MAX);
+		thread_nr = EC_ENCODE_THREADS_MAX;
+	}
+
+	D_ALLOC_ARRAY(ec_pool.ep_threads, thread_nr);
+	if (ec_pool.ep_threads == NULL)
+		return -DER_NOMEM;
+
+	D_INIT_LIST_HEAD(&ec_pool.ep_queue);
+	ec_pool.ep_stop = false;
+	for (i = 0; i < thread_nr; i++) {
+		rc = pthread_create(&ec_pool.ep_threads[i], NULL,
+				    ec_encode_worker, NULL);
+		if (rc != 0) {
+			D_ERROR("failed to create EC encoding thread: %d\n",
+				rc);
+			rc = daos_errno2der(rc);
+			obj_ec_encode_pool_fini();
+			return rc;
+		}
+		ec_pool.ep_thread_nr++;
+	}
+	D_DEBUG(DB_IO, "%u EC encoding threads, parallel min %u bytes\n",
+		ec_pool.ep_thread_nr, ec_parallel_min);
+	return 0;
+}
+
+void
+obj_ec_encode_pool_fini(void)
+{
+	unsigned int	i;
+
+	if (ec_pool.ep_threads == NULL)
+		return;
+
+	D_MUTEX_LOCK(&ec_pool.ep_lock);
+	ec_pool.ep_stop = true;
+	pthread_cond_broadcast(&ec_pool.ep_work_cond);
+	D_MUTEX_UNLOCK(&ec_pool.ep_lock);
+
+	for (i = 0; i < ec_pool.ep_thread_nr; i++)
+		pthread_join(ec_pool.ep_threads[i], NULL);
+
+	D_ASSERT(d_list_empty(&ec_pool.ep_queue));
+	D_FREE(ec_pool.ep_threads);
+	ec_pool.ep_thread_nr = 0;
+}
@@ -54,12 +54,49 @@ dc_obj_init(void)
 	rc = obj_ec_codec_init();
 	if (rc) {
 		D_ERROR("failed to obj_ec_codec_init: "DF_RC"\n", DP_RC(rc));
-		daos_rpc_unregister(&obj_proto_fmt);
-		D_GOTO(out_class, rc);
+		D_GOTO(out_rpc, rc);
+	}
+
+	rc = obj_ec_encode_pool_init();
+	if (rc) {
+		D_ERROR("failed to obj_ec_encode_pool_init: "DF_RC"\n",
+			DP_RC(rc));
+		obj_ec_codec_fini();
+		D_GOTO(out_rpc, rc);
+	}
+
+	rc = obj_ec_recov_cache_init();
+	if (rc) {
+		D_ERROR("failed to obj_ec_recov_cache_init: "DF_RC"\n",
+			DP_RC(rc));
+		obj_ec_encode_pool_fini();
+		obj_ec_codec_fini();
+		D_GOTO(out_rpc, rc);
+	}
+
+	rc = obj_coalesce_init();
+	if (rc) {
+		D_ERROR("failed to obj_coalesce_init: "DF_RC"\n", DP_RC(rc));
+		obj_ec_recov_cache_fini();
+		obj_ec_encode_pool_fini();
+		obj_ec_codec_fini();
+		D_GOTO(out_rpc, rc);
+	}
+
+	rc = obj_bulk_cache_init();
+	if (rc) {
+		D_ERROR("failed to obj_bulk_cache_init: "DF_RC"\n", DP_RC(rc));
+		obj_coalesce_fini();
+		obj_ec_recov_cache_fini();
+		obj_ec_encode_pool_fini();
+		obj_ec_codec_fini();
+		D_GOTO(out_rpc, rc);
 	}
 
 	D_GOTO(out, rc = 0);
 
+out_rpc:
+	daos_rpc_unregister(&obj_proto_fmt);
 out_class:
 	obj_class_fini();
 out_utils:
@@ -74,7 +111,11 @@ out:
 void
 dc_obj_fini(void)
 {
+	obj_bulk_cache_fini();
+	obj_coalesce_fini();
 	daos_rpc_unregister(&obj_proto_fmt);
+	obj_ec_recov_cache_fini();
+	obj_ec_encode_pool_fini();
 	obj_ec_codec_fini();
 	obj_class_fini();
 	obj_utils_fini();
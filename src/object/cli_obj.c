@@ -72,6 +72,7 @@ struct obj_auxi_args {
 	/* flags for the obj IO task.
 	 * ec_wait_recov -- obj fetch wait another EC recovery task,
 	 * ec_in_recov -- a EC recovery task
+	 * crypt_sgls -- update sgls replaced by encrypted ones
 	 */
 	uint32_t			 io_retry:1,
 					 args_initialized:1,
@@ -86,12 +87,13 @@ struct obj_auxi_args {
 					 ec_wait_recov:1,
 					 ec_in_recov:1,
 					 new_shard_tasks:1,
-					 reset_param:1;
+					 reset_param:1,
+					 crypt_sgls:1;
 	/* request flags. currently only: ORF_RESEND */
 	uint32_t			 flags;
 	uint32_t			 specified_shard;
 	struct obj_req_tgts		 req_tgts;
-	crt_bulk_t			*bulks;
+	struct obj_bulk_array		*bulks;
 	uint32_t			 iod_nr;
 	uint32_t			 initial_shard;
 	d_list_t			 shard_task_head;
@@ -320,7 +322,7 @@ obj_layout_create(struct dc_object *obj, bool refresh)
 	}
 
 	obj->cob_md.omd_ver = dc_pool_get_version(pool);
-	rc = pl_obj_place(map, &obj->cob_md, NULL, &layout);
+	rc = dc_cont_obj_place(obj->cob_coh, map, &obj->cob_md, &layout);
 	pl_map_decref(map);
 	if (rc != 0) {
 		D_DEBUG(DB_PL, "Failed to generate object layout\n");
@@ -586,6 +588,31 @@ obj_grp_leader_get(struct dc_object *obj, int idx, unsigned int map_ver)
 	return rc;
 }
 
+/**
+ * Get the pool map target ID of the leader shard for the redundancy group
+ * @grp_idx, used to group requests that will be sent to the same target.
+ */
+int
+obj_grp_leader_tgt(struct dc_object *obj, int grp_idx, unsigned int map_ver,
+		   uint32_t *tgt_id)
+{
+	int	rc = -DER_STALE;
+
+	D_RWLOCK_RDLOCK(&obj->cob_lock);
+	if (obj->cob_version == map_ver) {
+		rc = pl_select_leader(obj->cob_md.omd_id, grp_idx,
+				      obj->cob_grp_size, false,
+				      obj_get_shard, obj);
+		if (rc >= 0) {
+			*tgt_id = obj_get_shard(obj, rc)->po_target;
+			rc = 0;
+		}
+	}
+	D_RWLOCK_UNLOCK(&obj->cob_lock);
+
+	return rc;
+}
+
 /* If the client has been asked to fetch (list/query) from leader replica,
  * then means that related data is associated with some prepared DTX that
  * may be committable on the leader replica. According to our current DTX
@@ -1587,6 +1614,9 @@ obj_ec_recov_cb(tse_task_t *task, struct dc_object *obj,
 	uint32_t			 i;
 	int				 rc;
 
+	fail_info->efi_coh = coh;
+	fail_info->efi_dkey = args->dkey;
+	fail_info->efi_map_ver = obj_auxi->map_ver_req;
 	rc = obj_ec_recov_prep(&obj_auxi->reasb_req, obj->cob_md.omd_id,
 			       args->iods, args->nr);
 	if (rc) {
@@ -1600,6 +1630,8 @@ obj_ec_recov_cb(tse_task_t *task, struct dc_object *obj,
 	D_INIT_LIST_HEAD(&task_list);
 	for (i = 0; i < fail_info->efi_recov_ntasks; i++) {
 		recov_task = &fail_info->efi_recov_tasks[i];
+		if (recov_task->ert_cached)
+			continue;
 		rc = dc_tx_local_open(coh, recov_task->ert_epoch, 0, &th);
 		if (rc) {
 			D_ERROR("task %p "DF_OID" dc_tx_local_open failed "
@@ -1704,25 +1736,18 @@ out:
 static void
 obj_bulk_fini(struct obj_auxi_args *obj_auxi)
 {
-	crt_bulk_t	*bulks = obj_auxi->bulks;
-	unsigned int	 nr = obj_auxi->iod_nr;
-	int		 i;
-
-	if (bulks == NULL)
+	if (obj_auxi->bulks == NULL)
 		return;
 
-	for (i = 0; i < nr; i++)
-		if (bulks[i] != CRT_BULK_NULL)
-			crt_bulk_free(bulks[i]);
-
-	D_FREE(bulks);
+	obj_bulk_array_free(obj_auxi->bulks);
 	obj_auxi->bulks = NULL;
 }
 
 static int
-obj_rw_bulk_prep(struct dc_object *obj, daos_iod_t *iods, d_sg_list_t *sgls,
-		 unsigned int nr, bool update, bool bulk_bind,
-		 tse_task_t *task, struct obj_auxi_args *obj_auxi)
+obj_rw_bulk_prep(struct dc_object *obj, daos_key_t *dkey, daos_iod_t *iods,
+		 d_sg_list_t *sgls, unsigned int nr, bool update,
+		 bool bulk_bind, tse_task_t *task,
+		 struct obj_auxi_args *obj_auxi)
 {
 	daos_size_t		sgls_size;
 	crt_bulk_perm_t		bulk_perm;
@@ -1736,11 +1761,35 @@ obj_rw_bulk_prep(struct dc_object *obj, daos_iod_t *iods, d_sg_list_t *sgls,
 	 * if need bulk transferring.
 	 */
 	sgls_size = daos_sgls_packed_size(sgls, nr, NULL);
-	if (sgls_size >= OBJ_BULK_LIMIT || obj_auxi->reasb_req.orr_tgt_nr > 1) {
+	if ((sgls_size != 0 &&
+	     sgls_size >= obj_inline_limit(daos_task2ctx(task), dkey, iods,
+					   nr)) ||
+	    obj_auxi->reasb_req.orr_tgt_nr > 1) {
+		/* Medium size I/O to one target avoids the registration of
+		 * user buffers with the pre-registered buffers, unless the
+		 * data is encrypted, which would then be copied twice.
+		 */
+		if (!obj_auxi->is_ec_obj && !bulk_bind &&
+		    !dc_cont_hdl2props(obj->cob_coh).dcp_encrypt_enabled) {
+			rc = obj_bulk_cache_prep(sgls, nr, update, task,
+						 &obj_auxi->bulks);
+			if (rc != 0 || obj_auxi->bulks != NULL)
+				goto out;
+		}
+
+		rc = obj_bulk_array_alloc(nr, false, &obj_auxi->bulks);
+		if (rc != 0)
+			goto out;
+
 		bulk_perm = update ? CRT_BULK_RO : CRT_BULK_RW;
 		rc = obj_bulk_prep(sgls, nr, bulk_bind, bulk_perm, task,
-				   &obj_auxi->bulks);
+				   &obj_auxi->bulks->oba_bulks);
+		if (rc != 0) {
+			obj_bulk_array_free(obj_auxi->bulks);
+			obj_auxi->bulks = NULL;
+		}
 	}
+out:
 	obj_auxi->reasb_req.orr_size_fetched = 0;
 
 	return rc;
@@ -3534,6 +3583,28 @@ obj_size_fetch_cb(const struct dc_object *obj, struct obj_auxi_args *obj_auxi)
 	}
 }
 
+/** Decrypt the data of a completed fetch of an encrypted container */
+static void
+obj_crypt_fetch_comp(tse_task_t *task, struct obj_auxi_args *obj_auxi)
+{
+	daos_obj_fetch_t	*args = dc_task_get_args(task);
+	struct daos_cipherer	*cipherer;
+	int			 rc;
+
+	if (obj_auxi->opc != DAOS_OBJ_RPC_FETCH || task->dt_result != 0 ||
+	    obj_auxi->ec_in_recov || args->sgls == NULL ||
+	    (args->extra_flags & DIOF_CHECK_EXISTENCE))
+		return;
+
+	rc = obj_crypt_prep(obj_auxi->obj, args->iods, args->nr, &cipherer);
+	if (rc == 0 && cipherer != NULL)
+		rc = obj_crypt_sgls(cipherer, obj_auxi->obj->cob_md.omd_id,
+				    args->dkey, args->iods, args->sgls,
+				    args->nr, NULL, false);
+	if (rc != 0)
+		task->dt_result = rc;
+}
+
 static int
 obj_comp_cb(tse_task_t *task, void *data)
 {
@@ -3641,6 +3712,8 @@ obj_comp_cb(tse_task_t *task, void *data)
 			D_ASSERT(daos_handle_is_inval(obj_auxi->th));
 
 			obj_rw_csum_destroy(obj, obj_auxi);
+			if (obj_auxi->crypt_sgls)
+				obj_crypt_update_fini(dc_task_get_args(task));
 			break;
 		case DAOS_OBJ_RPC_FETCH: {
 			daos_obj_fetch_t	*args = dc_task_get_args(task);
@@ -3715,6 +3788,7 @@ obj_comp_cb(tse_task_t *task, void *data)
 
 				obj_ec_recov_data(&obj_auxi->reasb_req,
 					obj->cob_md.omd_id, args->nr);
+				obj_crypt_fetch_comp(task, obj_auxi);
 
 				obj_auxi_free_failed_tgt_list(obj_auxi);
 				obj_reasb_req_fini(&obj_auxi->reasb_req,
@@ -3735,6 +3809,7 @@ obj_comp_cb(tse_task_t *task, void *data)
 				obj_ec_update_iod_size(&obj_auxi->reasb_req,
 						       args->nr);
 			}
+			obj_crypt_fetch_comp(task, obj_auxi);
 
 			obj_bulk_fini(obj_auxi);
 			obj_reasb_req_fini(&obj_auxi->reasb_req,
@@ -4050,6 +4125,7 @@ dc_obj_fetch_task(tse_task_t *task)
 	uint32_t		 shard = 0;
 	int			 rc;
 	uint8_t                  csum_bitmap = 0;
+	struct daos_cipherer	*cipherer;
 
 	rc = obj_req_valid(task, args, DAOS_OBJ_RPC_FETCH, &epoch, &map_ver,
 			   &obj);
@@ -4077,6 +4153,13 @@ dc_obj_fetch_task(tse_task_t *task)
 	if (args->extra_flags & DIOF_CHECK_EXISTENCE) {
 		obj_auxi->flags |= ORF_CHECK_EXISTENCE;
 	} else {
+		if (!obj_auxi->ec_in_recov) {
+			rc = obj_crypt_prep(obj, args->iods, args->nr,
+					    &cipherer);
+			if (rc != 0)
+				goto out_task;
+		}
+
 		rc = obj_rw_req_reassemb(obj, args, &epoch, obj_auxi);
 		if (rc != 0) {
 			D_ERROR(DF_OID" obj_req_reassemb failed %d.\n",
@@ -4140,8 +4223,8 @@ dc_obj_fetch_task(tse_task_t *task)
 		obj_auxi->initial_shard =
 			obj_auxi->req_tgts.ort_shard_tgts[0].st_shard;
 
-	rc = obj_rw_bulk_prep(obj, args->iods, args->sgls, args->nr,
-			      false, false, task, obj_auxi);
+	rc = obj_rw_bulk_prep(obj, args->dkey, args->iods, args->sgls,
+			      args->nr, false, false, task, obj_auxi);
 	if (rc != 0)
 		goto out_task;
 
@@ -4160,6 +4243,7 @@ dc_obj_update(tse_task_t *task, struct dtx_epoch *epoch, uint32_t map_ver,
 {
 	struct obj_auxi_args	*obj_auxi;
 	struct dc_object	*obj;
+	struct daos_cipherer	*cipherer;
 	uint64_t		 dkey_hash;
 	int			 rc;
 
@@ -4170,6 +4254,21 @@ dc_obj_update(tse_task_t *task, struct dtx_epoch *epoch, uint32_t map_ver,
 
 	obj_task_init_common(task, DAOS_OBJ_RPC_UPDATE, map_ver, args->th,
 			     &obj_auxi, obj);
+
+	/* encrypt once, EC parity and checksums cover the ciphertext */
+	if (!obj_auxi->crypt_sgls) {
+		rc = obj_crypt_prep(obj, args->iods, args->nr, &cipherer);
+		if (rc == 0 && cipherer != NULL) {
+			rc = obj_crypt_update(cipherer, obj, args);
+			if (rc == 0)
+				obj_auxi->crypt_sgls = 1;
+		}
+		if (rc) {
+			obj_comp_cb(task, NULL);
+			goto out_task;
+		}
+	}
+
 	rc = obj_rw_req_reassemb(obj, args, NULL, obj_auxi);
 	if (rc) {
 		D_ERROR(DF_OID" obj_req_reassemb failed %d.\n",
@@ -4216,8 +4315,9 @@ dc_obj_update(tse_task_t *task, struct dtx_epoch *epoch, uint32_t map_ver,
 	D_DEBUG(DB_IO, "update "DF_OID" dkey_hash "DF_U64"\n",
 		DP_OID(obj->cob_md.omd_id), dkey_hash);
 
-	rc = obj_rw_bulk_prep(obj, args->iods, args->sgls, args->nr, true,
-			      obj_auxi->req_tgts.ort_srv_disp, task, obj_auxi);
+	rc = obj_rw_bulk_prep(obj, args->dkey, args->iods, args->sgls,
+			      args->nr, true, obj_auxi->req_tgts.ort_srv_disp,
+			      task, obj_auxi);
 	if (rc != 0)
 		goto out_task;
 
@@ -4244,6 +4344,10 @@ dc_obj_update_task(tse_task_t *task)
 		goto comp;
 	}
 
+	/* piggyback small update on a batch to the same target if enabled */
+	if (obj_coalesce_update(task, args))
+		return 0;
+
 	/* submit the update */
 	return dc_obj_update(task, &epoch, map_ver, args);
 comp:
@@ -4252,6 +4356,16 @@ comp:
 	return rc > 0 ? 0 : rc;
 }
 
+/* Submit the update on its own, bypassing the coalescing */
+int
+dc_obj_update_direct_task(tse_task_t *task)
+{
+	daos_obj_update_t	*args = dc_task_get_args(task);
+	struct dtx_epoch	 epoch = {0};
+
+	return dc_obj_update(task, &epoch, 0, args);
+}
+
 static void
 shard_anchors_free(daos_anchor_t *anchor)
 {
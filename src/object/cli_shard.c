@@ -819,6 +819,7 @@ dc_rw_cb(tse_task_t *task, void *arg)
 		} else if (rw_args->rwaa_sgls != NULL) {
 			/* for bulk transfer it needs to update sg_nr_out */
 			d_sg_list_t	*sgls = rw_args->rwaa_sgls;
+			struct obj_bulk_buf **bufs = NULL;
 			uint32_t	*nrs;
 			uint32_t	 nrs_count;
 			daos_size_t	*replied_sizes;
@@ -833,6 +834,8 @@ dc_rw_cb(tse_task_t *task, void *arg)
 					orw->orw_nr);
 				D_GOTO(out, rc = -DER_PROTO);
 			}
+			if (rw_args->shard_args->bulks != NULL)
+				bufs = rw_args->shard_args->bulks->oba_bufs;
 
 			/*  For EC obj, record the daos_sizes from shards and
 			 *  obj layer will handle it (obj_ec_fetch_set_sgl).
@@ -867,6 +870,12 @@ dc_rw_cb(tse_task_t *task, void *arg)
 				}
 				data_size = replied_sizes[i];
 				D_ASSERT(data_size <= size_in_iod);
+				if (bufs != NULL && bufs[i] != NULL) {
+					rc = obj_bulk_cache_copy_out(bufs[i],
+							&sgls[i], data_size);
+					if (rc != 0)
+						goto out;
+				}
 				dc_sgl_out_set(&sgls[i], data_size);
 			}
 		}
@@ -1024,7 +1033,7 @@ dc_obj_shard_rw(struct dc_obj_shard *shard, enum obj_rpc_opc opc,
 		orw->orw_sgls.ca_count = 0;
 		orw->orw_sgls.ca_arrays = NULL;
 		orw->orw_bulks.ca_count = nr;
-		orw->orw_bulks.ca_arrays = args->bulks;
+		orw->orw_bulks.ca_arrays = args->bulks->oba_bulks;
 		if (fw_shard_tgts != NULL)
 			orw->orw_flags |= ORF_BULK_BIND;
 	} else {
@@ -222,6 +222,8 @@ struct obj_ec_recov_task {
 	d_sg_list_t		ert_sgl;
 	daos_epoch_t		ert_epoch;
 	daos_handle_t		ert_th; /* read-only tx handle */
+	/* all stripes of the task are filled from the recovery cache */
+	bool			ert_cached;
 };
 
 /** EC obj IO failure information */
@@ -251,6 +253,26 @@ struct obj_ec_fail_info {
 	 */
 	struct obj_ec_recov_task	*efi_recov_tasks;
 	uint32_t			 efi_recov_ntasks;
+	/* container handle and dkey of the fetch, key the recovery cache */
+	daos_handle_t			 efi_coh;
+	daos_key_t			*efi_dkey;
+	/* pool map version of the fetch */
+	uint32_t			 efi_map_ver;
+};
+
+/** Identifies a reconstructed EC stripe in the recovery cache */
+struct obj_ec_stripe_key {
+	daos_handle_t		 esk_coh;
+	daos_obj_id_t		 esk_oid;
+	daos_key_t		*esk_dkey;
+	daos_key_t		*esk_akey;
+	/* stripe index in the akey */
+	uint64_t		 esk_stripe;
+	/* shadow epoch the stripe is reconstructed at */
+	daos_epoch_t		 esk_epoch;
+	daos_size_t		 esk_rsize;
+	/* pool map version, a stripe cached at another version is dropped */
+	uint32_t		 esk_map_ver;
 };
 
 struct obj_reasb_req;
@@ -625,6 +647,22 @@ obj_id2ec_codec(daos_obj_id_t id)
 	return obj_ec_codec_get(daos_obj_id2class(id));
 }
 
+/* cli_ec_cache.c */
+int obj_ec_recov_cache_init(void);
+void obj_ec_recov_cache_fini(void);
+bool obj_ec_recov_cache_get(struct obj_ec_stripe_key *key, void *buf,
+			    uint64_t size);
+void obj_ec_recov_cache_put(struct obj_ec_stripe_key *key, void *buf,
+			    uint64_t size);
+
+/* cli_ec_encode.c */
+int obj_ec_encode_pool_init(void);
+void obj_ec_encode_pool_fini(void);
+void obj_ec_stripes_encode(struct obj_ec_codec *codec, unsigned int k,
+			   unsigned int p, uint64_t cell_bytes,
+			   unsigned char *data, uint32_t stripe_nr,
+			   unsigned char *parity_bufs[]);
+
 /* cli_ec.c */
 int obj_ec_req_reasb(daos_iod_t *iods, d_sg_list_t *sgls, daos_obj_id_t oid,
 		     struct daos_oclass_attr *oca,
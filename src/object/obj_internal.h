@@ -43,6 +43,17 @@
 extern bool	cli_bypass_rpc;
 /** Switch of server-side IO dispatch */
 extern unsigned int	srv_io_mode;
+/** Fetch SCM resident data through the pre-registered pool SCM window */
+extern bool		srv_scm_zero_copy;
+/** Fold partial EC stripes via parity delta when it moves less data */
+extern bool		srv_ec_agg_delta;
+/** Verify the data of 1 in N fetches against the stored checksums, 0: never */
+extern unsigned int	srv_csum_verify_read;
+/**
+ * Pull update data larger than this in chunks of this size, and write each
+ * chunk to NVMe while the next ones are transferred, 0: one transfer
+ */
+extern unsigned int	srv_bulk_chunk;
 
 /** client object shard */
 struct dc_obj_shard {
@@ -258,6 +269,14 @@ struct obj_tls {
 	struct d_tm_node_t	*ot_update_restart;
 	/** Total number of resent update operations */
 	struct d_tm_node_t	*ot_update_resent;
+	/** Total number of fetches verified against the stored checksums */
+	struct d_tm_node_t	*ot_csum_read_verified;
+	/** EC aggregation: stripes skipped as their parity is fresh */
+	struct d_tm_node_t	*ot_ec_agg_fresh;
+	/** EC aggregation: full stripes fetched and encoded again */
+	struct d_tm_node_t	*ot_ec_agg_encoded;
+	/** Fetches since the last verified one */
+	unsigned int		 ot_csum_read_cnt;
 };
 
 struct obj_ec_parity {
@@ -296,12 +315,25 @@ struct shard_auxi_args {
 	uint32_t		 flags;
 };
 
+struct obj_bulk_buf;
+
+/** Bulk handles of an object I/O, one per iod */
+struct obj_bulk_array {
+	unsigned int		  oba_nr;
+	crt_bulk_t		 *oba_bulks;
+	/*
+	 * The cached buffer behind each handle, or NULL if the handle
+	 * registers the user buffers. NULL if no buffer comes from the cache.
+	 */
+	struct obj_bulk_buf	**oba_bufs;
+};
+
 struct shard_rw_args {
 	struct shard_auxi_args	 auxi;
 	daos_obj_rw_t		*api_args;
 	struct dtx_id		 dti;
 	uint64_t		 dkey_hash;
-	crt_bulk_t		*bulks;
+	struct obj_bulk_array	*bulks;
 	struct obj_io_desc	*oiods;
 	uint64_t		*offs;
 	struct dcs_csum_info	*dkey_csum;
@@ -470,6 +502,8 @@ int obj_get_replicas(struct dc_object *obj);
 int obj_shard_open(struct dc_object *obj, unsigned int shard,
 		   unsigned int map_ver, struct dc_obj_shard **shard_ptr);
 int obj_dkey2grpidx(struct dc_object *obj, uint64_t hash, unsigned int map_ver);
+int obj_grp_leader_tgt(struct dc_object *obj, int grp_idx, unsigned int map_ver,
+		       uint32_t *tgt_id);
 int obj_pool_query_task(tse_sched_t *sched, struct dc_object *obj,
 			tse_task_t **taskp);
 
@@ -817,6 +851,74 @@ dc_tx_attach(daos_handle_t th, enum obj_rpc_opc opc, tse_task_t *task);
 int
 dc_tx_convert(enum obj_rpc_opc opc, tse_task_t *task);
 
+int
+dc_tx_batch_open(daos_handle_t coh, tse_sched_t *sched, daos_handle_t *th,
+		 tse_task_t **commit_task);
+
+int
+dc_tx_batch_add(daos_handle_t th, daos_obj_update_t *up);
+
+int
+dc_tx_batch_restart(daos_handle_t th, uint32_t *backoff);
+
+void
+dc_tx_batch_close(daos_handle_t th);
+
+/* cli_bulk.c */
+daos_size_t
+obj_inline_limit(crt_context_t ctx, daos_key_t *dkey, daos_iod_t *iods,
+		 unsigned int nr);
+int
+obj_bulk_array_alloc(unsigned int nr, bool cached,
+		     struct obj_bulk_array **p_bulks);
+void
+obj_bulk_array_free(struct obj_bulk_array *bulks);
+int
+obj_bulk_cache_prep(d_sg_list_t *sgls, unsigned int nr, bool update,
+		    tse_task_t *task, struct obj_bulk_array **p_bulks);
+int
+obj_bulk_cache_copy_out(struct obj_bulk_buf *buf, d_sg_list_t *sgl,
+			daos_size_t size);
+void
+obj_bulk_cache_put(struct obj_bulk_buf *buf);
+int
+obj_bulk_cache_init(void);
+void
+obj_bulk_cache_fini(void);
+
+/* cli_crypt.c */
+struct daos_cipherer;
+
+int
+obj_crypt_sgls(struct daos_cipherer *cipherer, daos_obj_id_t oid,
+	       daos_key_t *dkey, daos_iod_t *iods, d_sg_list_t *sgls,
+	       unsigned int nr, void *dst, bool encrypt);
+int
+obj_crypt_sgls_dup(struct daos_cipherer *cipherer, daos_obj_id_t oid,
+		   daos_key_t *dkey, daos_iod_t *iods, d_sg_list_t *sgls,
+		   d_sg_list_t *dsts, unsigned int nr);
+int
+obj_crypt_prep(struct dc_object *obj, daos_iod_t *iods, unsigned int nr,
+	       struct daos_cipherer **p_cipherer);
+int
+obj_crypt_update(struct daos_cipherer *cipherer, struct dc_object *obj,
+		 daos_obj_update_t *args);
+void
+obj_crypt_update_fini(daos_obj_update_t *args);
+
+/* cli_coalesce.c */
+int
+obj_coalesce_init(void);
+
+void
+obj_coalesce_fini(void);
+
+bool
+obj_coalesce_update(tse_task_t *task, daos_obj_update_t *args);
+
+int
+dc_obj_update_direct_task(tse_task_t *task);
+
 /* obj_enum.c */
 int
 fill_oid(daos_unit_oid_t oid, struct dss_enum_arg *arg);
@@ -130,6 +130,7 @@ crt_proc_daos_iod_and_csum(crt_proc_t proc, crt_proc_op_t proc_op,
 			   daos_iod_t *iod, struct dcs_iod_csums *iod_csum,
 			   struct obj_io_desc *oiod)
 {
+	daos_recx_t	*recxs;
 	uint32_t	start, nr;
 	bool		proc_one = false;
 	bool		singv = false;
@@ -205,25 +206,16 @@ crt_proc_daos_iod_and_csum(crt_proc_t proc, crt_proc_op_t proc_op,
 	if (unlikely(rc))
 		return rc;
 
-	if (DECODING(proc_op)) {
-		if (existing_flags & IOD_REC_EXIST) {
-			D_ALLOC_ARRAY(iod->iod_recxs, nr);
-			if (iod->iod_recxs == NULL)
-				D_GOTO(out_free, rc = -DER_NOMEM);
-		}
-	}
-
-	if (existing_flags & IOD_REC_EXIST) {
-		D_ASSERT(iod->iod_recxs != NULL || nr == 0);
-		if (nr > 0) {
-			rc = crt_proc_memcpy(proc, &iod->iod_recxs[start],
-					     nr * sizeof(*iod->iod_recxs));
-			if (unlikely(rc)) {
-				if (DECODING(proc_op))
-					D_GOTO(out_free, rc);
-				return rc;
-			}
-		}
+	/* the recxs are decoded in place in the RPC buffer when possible */
+	if ((existing_flags & IOD_REC_EXIST) && !FREEING(proc_op)) {
+		D_ASSERT(iod->iod_recxs != NULL || DECODING(proc_op));
+		recxs = ENCODING(proc_op) ? &iod->iod_recxs[start] : NULL;
+		rc = crt_proc_buf(proc, (void **)&recxs, nr * sizeof(*recxs),
+				  sizeof(uint64_t));
+		if (unlikely(rc))
+			return rc;
+		if (DECODING(proc_op))
+			iod->iod_recxs = recxs;
 	}
 
 	if (iod_csum) {
@@ -248,7 +240,7 @@ crt_proc_daos_iod_and_csum(crt_proc_t proc, crt_proc_op_t proc_op,
 	if (FREEING(proc_op)) {
 out_free:
 		if (existing_flags & IOD_REC_EXIST)
-			D_FREE(iod->iod_recxs);
+			crt_proc_buf_free((void **)&iod->iod_recxs);
 	}
 
 	return rc;
@@ -635,7 +627,7 @@ crt_proc_daos_iod_t(crt_proc_t proc, daos_iod_t *iod)
 
 	if (FREEING(proc_op)) {
 		/* NB: don't need free in crt_proc_d_iov_t() */
-		D_FREE(iod->iod_recxs);
+		crt_proc_buf_free((void **)&iod->iod_recxs);
 		return 0;
 	}
 
@@ -662,26 +654,9 @@ crt_proc_daos_iod_t(crt_proc_t proc, daos_iod_t *iod)
 	if (iod->iod_nr == 0)
 		return 0;
 
-	switch (proc_op) {
-	case CRT_PROC_DECODE:
-		D_ALLOC_ARRAY(iod->iod_recxs, iod->iod_nr);
-		if (iod->iod_recxs == NULL)
-			return -DER_NOMEM;
-		/* fall through to fill iod_recxs */
-	case CRT_PROC_ENCODE:
-		rc = crt_proc_memcpy(proc, iod->iod_recxs,
-				     iod->iod_nr * sizeof(*iod->iod_recxs));
-		if (unlikely(rc)) {
-			if (DECODING(proc_op))
-				D_FREE(iod->iod_recxs);
-			return rc;
-		}
-		break;
-	default:
-		return -DER_INVAL;
-	}
-
-	return 0;
+	return crt_proc_buf(proc, (void **)&iod->iod_recxs,
+			    iod->iod_nr * sizeof(*iod->iod_recxs),
+			    sizeof(uint64_t));
 }
 
 static int
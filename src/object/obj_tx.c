@@ -360,6 +360,7 @@ dc_tx_cleanup_one(struct dc_tx *tx, struct daos_cpd_sub_req *dcsr)
 		struct daos_cpd_update	*dcu = &dcsr->dcsr_update;
 		struct obj_iod_array	*iod_array = &dcu->dcu_iod_array;
 		struct daos_csummer	*csummer;
+		bool			 free_buf;
 
 		csummer = dc_cont_hdl2csummer(tx->tx_coh);
 
@@ -398,10 +399,12 @@ dc_tx_cleanup_one(struct dc_tx *tx, struct daos_cpd_sub_req *dcsr)
 		daos_csummer_free_ic(csummer, &iod_array->oia_iod_csums);
 		D_ASSERT(iod_array->oia_offs == NULL);
 
+		/* encrypted data is always in a private copy */
+		free_buf = !(tx->tx_flags & DAOS_TF_ZERO_COPY) ||
+			   dc_cont_hdl2props(tx->tx_coh).dcp_encrypt_enabled;
 		if (dcsr->dcsr_sgls != NULL) {
 			for (i = 0; i < dcsr->dcsr_nr; i++)
-				d_sgl_fini(&dcsr->dcsr_sgls[i],
-					   !(tx->tx_flags & DAOS_TF_ZERO_COPY));
+				d_sgl_fini(&dcsr->dcsr_sgls[i], free_buf);
 
 			D_FREE(dcsr->dcsr_sgls);
 		}
@@ -2158,6 +2161,7 @@ dc_tx_add_update(struct dc_tx *tx, daos_handle_t oh, uint64_t flags,
 	struct dc_object	*obj = NULL;
 	struct daos_cpd_update	*dcu = NULL;
 	struct obj_iod_array	*iod_array;
+	struct daos_cipherer	*cipherer = NULL;
 	int			 rc;
 	int			 i;
 
@@ -2213,11 +2217,19 @@ dc_tx_add_update(struct dc_tx *tx, daos_handle_t oh, uint64_t flags,
 		       sizeof(daos_recx_t) * iods[i].iod_nr);
 	}
 
+	rc = obj_crypt_prep(obj, iods, nr, &cipherer);
+	if (rc != 0)
+		D_GOTO(fail, rc);
+
 	D_ALLOC_ARRAY(dcsr->dcsr_sgls, nr);
 	if (dcsr->dcsr_sgls == NULL)
 		D_GOTO(fail, rc = -DER_NOMEM);
 
-	if (tx->tx_flags & DAOS_TF_ZERO_COPY)
+	/* encrypted into the private copy, user buffers must be left as is */
+	if (cipherer != NULL)
+		rc = obj_crypt_sgls_dup(cipherer, obj->cob_md.omd_id, dkey,
+					iods, sgls, dcsr->dcsr_sgls, nr);
+	else if (tx->tx_flags & DAOS_TF_ZERO_COPY)
 		rc = daos_sgls_copy_ptr(dcsr->dcsr_sgls, nr, sgls, nr);
 	else
 		rc = daos_sgls_copy_all(dcsr->dcsr_sgls, nr, sgls, nr);
@@ -2247,8 +2259,8 @@ fail:
 		if (dcsr->dcsr_sgls != NULL) {
 			for (i = 0; i < nr; i++)
 				d_sgl_fini(&dcsr->dcsr_sgls[i],
-					      !(tx->tx_flags &
-						DAOS_TF_ZERO_COPY));
+					   cipherer != NULL ||
+					   !(tx->tx_flags & DAOS_TF_ZERO_COPY));
 
 			D_FREE(dcsr->dcsr_sgls);
 		}
@@ -2991,3 +3003,112 @@ out:
 
 	return rc;
 }
+
+/**
+ * Open an internal TX to carry a batch of coalesced updates (see
+ * cli_coalesce.c). The commit task is created on @sched but not scheduled,
+ * the caller makes the batched update tasks depend on it and schedules it
+ * when the batch is flushed.
+ */
+int
+dc_tx_batch_open(daos_handle_t coh, tse_sched_t *sched, daos_handle_t *th,
+		 tse_task_t **commit_task)
+{
+	daos_tx_commit_t	*args;
+	tse_task_t		*task = NULL;
+	struct dc_tx		*tx = NULL;
+	int			 rc;
+
+	rc = dc_tx_alloc(coh, 0, DAOS_TF_ZERO_COPY, false, &tx);
+	if (rc != 0) {
+		D_ERROR("Fail to open TX for batch: "DF_RC"\n", DP_RC(rc));
+		return rc;
+	}
+
+	tx->tx_pm_ver = dc_pool_get_version(tx->tx_pool);
+
+	rc = dc_task_create(dc_tx_commit, sched, NULL, &task);
+	if (rc != 0) {
+		D_ERROR("Fail to create TX batch task: "DF_RC"\n", DP_RC(rc));
+		dc_tx_close_internal(tx);
+		return rc;
+	}
+
+	args = dc_task_get_args(task);
+	args->th = dc_tx_ptr2hdl(tx);
+	args->flags = 0;
+
+	*th = args->th;
+	*commit_task = task;
+
+	return 0;
+}
+
+/** Attach the update described by @up to the batch TX @th. */
+int
+dc_tx_batch_add(daos_handle_t th, daos_obj_update_t *up)
+{
+	struct dc_tx	*tx;
+	int		 rc;
+
+	tx = dc_tx_hdl2ptr(th);
+	if (tx == NULL)
+		return -DER_NO_HDL;
+
+	D_MUTEX_LOCK(&tx->tx_lock);
+	rc = dc_tx_add_update(tx, up->oh, up->flags, up->dkey, up->nr,
+			      up->iods, up->sgls);
+	D_MUTEX_UNLOCK(&tx->tx_lock);
+
+	/* -1 for hdl2ptr */
+	dc_tx_decref(tx);
+
+	return rc;
+}
+
+/**
+ * Restart the batch TX @th after its commit failed with -DER_TX_RESTART. All
+ * the cached sub requests are dropped, the caller needs to re-attach them via
+ * dc_tx_batch_add() and then re-commit after @backoff microseconds.
+ */
+int
+dc_tx_batch_restart(daos_handle_t th, uint32_t *backoff)
+{
+	struct dc_tx	*tx;
+	int		 rc;
+
+	tx = dc_tx_hdl2ptr(th);
+	if (tx == NULL)
+		return -DER_NO_HDL;
+
+	D_MUTEX_LOCK(&tx->tx_lock);
+	rc = dc_tx_restart_begin(tx, backoff);
+	if (rc == 0) {
+		/*
+		 * Since tx is internal, it is okay to end the restart before
+		 * the backoff.
+		 */
+		dc_tx_restart_end(tx);
+		tx->tx_pm_ver = dc_pool_get_version(tx->tx_pool);
+	}
+	D_MUTEX_UNLOCK(&tx->tx_lock);
+
+	/* -1 for hdl2ptr */
+	dc_tx_decref(tx);
+
+	return rc;
+}
+
+void
+dc_tx_batch_close(daos_handle_t th)
+{
+	struct dc_tx	*tx;
+
+	tx = dc_tx_hdl2ptr(th);
+	if (tx == NULL)
+		return;
+
+	dc_tx_close_internal(tx);
+	/* -1 for hdl2ptr */
+	dc_tx_decref(tx);
+}
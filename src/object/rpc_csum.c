@@ -35,7 +35,7 @@ proc_struct_dcs_csum_info_adv(crt_proc_t proc, crt_proc_op_t proc_op,
 		return 0;
 
 	if (FREEING(proc_op)) {
-		D_FREE(csum->cs_csum);
+		crt_proc_buf_free((void **)&csum->cs_csum);
 		return 0;
 	}
 
@@ -68,16 +68,12 @@ proc_struct_dcs_csum_info_adv(crt_proc_t proc, crt_proc_op_t proc_op,
 			return rc;
 	}
 
+	/* decoded in place in the RPC buffer when possible */
 	if (DECODING(proc_op)) {
-		D_ALLOC(csum->cs_csum, csum->cs_buf_len);
-		if (csum->cs_csum == NULL)
-			return -DER_NOMEM;
-
-		rc = crt_proc_memcpy(proc, csum->cs_csum, csum->cs_buf_len);
-		if (unlikely(rc)) {
-			D_FREE(csum->cs_csum);
+		rc = crt_proc_buf(proc, (void **)&csum->cs_csum,
+				  csum->cs_buf_len, 1);
+		if (unlikely(rc))
 			return rc;
-		}
 	}
 
 	return 0;
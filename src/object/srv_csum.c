@@ -668,3 +668,118 @@ ds_csum_add2iod(daos_iod_t *iod, struct daos_csummer *csummer,
 	return ds_csum_add2iod_array(iod, csummer, bsgl, biov_csums,
 				     biov_csums_used, iod_csums);
 }
+
+/** Verify the chunks of \a buf, holding the records of \a recx, with \a ci */
+static int
+csum_verify_extent(struct daos_csummer *csummer, daos_recx_t *recx,
+		   uint64_t rec_len, uint8_t *buf, struct dcs_csum_info *ci)
+{
+	uint16_t		csum_len = daos_csummer_get_csum_len(csummer);
+	uint32_t		chunksize;
+	struct daos_csum_range	chunk;
+	uint8_t			csum[csum_len];
+	uint8_t			*stored;
+	uint64_t		nr;
+	uint64_t		i;
+
+	chunksize = daos_csummer_get_rec_chunksize(csummer, rec_len);
+	nr = daos_recx_calc_chunks(*recx, rec_len, chunksize);
+	for (i = 0; i < nr; i++) {
+		stored = ci_idx2csum(ci, i);
+		if (stored == NULL)
+			break;
+
+		chunk = csum_recx_chunkidx2range(recx, rec_len, chunksize, i);
+		memset(csum, 0, csum_len);
+		daos_csummer_set_buffer(csummer, csum, csum_len);
+		daos_csummer_reset(csummer);
+		daos_csummer_update(csummer, buf +
+				    (chunk.dcr_lo - recx->rx_idx) * rec_len,
+				    chunk.dcr_nr * rec_len);
+		daos_csummer_finish(csummer);
+
+		if (!daos_csummer_csum_compare(csummer, csum, stored,
+					       csum_len)) {
+			D_ERROR("Extent "DF_RECX" corrupted. Calculated "
+				"("DF_CI_BUF") != Stored ("DF_CI_BUF")\n",
+				DP_RECX(*recx), DP_CI_BUF(csum, csum_len),
+				DP_CI_BUF(stored, csum_len));
+			return -DER_CSUM;
+		}
+	}
+
+	return 0;
+}
+
+int
+ds_csum_verify_fetch(daos_iod_t *iod, struct daos_csummer *csummer,
+		     struct bio_sglist *bsgl, struct dcs_csum_info *biov_csums,
+		     size_t *biov_csums_used)
+{
+	struct bio_iov	*biov;
+	daos_recx_t	 raw;
+	uint64_t	 rec_len = iod->iod_size;
+	uint64_t	 idx;
+	uint32_t	 i, j = 0, k = 0;
+	int		 rc = 0;
+
+	*biov_csums_used = 0;
+	if (!(daos_csummer_initialized(csummer) && bsgl))
+		return 0;
+
+	if (!csum_iod_is_supported(iod) || bsgl->bs_nr_out == 0)
+		return 0;
+
+	if (iod->iod_type == DAOS_IOD_SINGLE) {
+		biov = bio_sgl_iov(bsgl, 0);
+		*biov_csums_used = 1;
+		if (bio_addr_is_hole(&biov->bi_addr) ||
+		    bio_iov2raw_buf(biov) == NULL ||
+		    bio_iov2raw_len(biov) == 0)
+			return 0;
+
+		raw.rx_idx = 0;
+		raw.rx_nr = 1;
+		return csum_verify_extent(csummer, &raw,
+					  bio_iov2raw_len(biov),
+					  bio_iov2raw_buf(biov),
+					  &biov_csums[0]);
+	}
+
+	/** the biovs of each extent follow each other in the bsgl */
+	for (i = 0; i < iod->iod_nr && rc == 0; i++) {
+		idx = iod->iod_recxs[i].rx_idx;
+		while (idx < iod->iod_recxs[i].rx_idx +
+			     iod->iod_recxs[i].rx_nr && rc == 0) {
+			biov = bio_sgl_iov(bsgl, k++);
+			if (biov == NULL)
+				goto out;
+
+			if (!bio_addr_is_hole(&biov->bi_addr)) {
+				raw.rx_idx = idx - biov->bi_prefix_len /
+						   rec_len;
+				raw.rx_nr = bio_iov2raw_len(biov) / rec_len;
+				if (bio_iov2raw_buf(biov) != NULL &&
+				    ci_is_valid(&biov_csums[j]))
+					rc = csum_verify_extent(csummer, &raw,
+						rec_len, bio_iov2raw_buf(biov),
+						&biov_csums[j]);
+				j++;
+			}
+			idx += bio_iov2req_len(biov) / rec_len;
+		}
+	}
+out:
+	*biov_csums_used = j;
+	return rc;
+}
+
+bool
+ds_csum_sample(unsigned int *cnt, unsigned int rate)
+{
+	if (rate == 0 || ++(*cnt) < rate)
+		return false;
+
+	*cnt = 0;
+	return true;
+}
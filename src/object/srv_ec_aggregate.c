@@ -38,7 +38,9 @@
  *	  and from VOS on peer parity targets.
  *
  * If replicas exist that are older than the latest parity, they are removed
- * from parity targets.
+ * from parity targets. When the parity is as new as every replica of the
+ * stripe, e.g. the stripe was rewritten in full and encoded by the client,
+ * the stripe is neither fetched nor encoded again.
  *
  * If checksums are supported for the container, checksums are verified for
  * all read data, and they are calculated for generated parity. Re-replicated
@@ -127,6 +129,11 @@ struct ec_agg_param {
 	void			*ap_yield_arg;   /* yield argument            */
 	uint32_t		 ap_credits_max; /* # of tight loops to yield */
 	uint32_t		 ap_credits;     /* # of tight loops          */
+	uint64_t		 ap_fresh_cnt;   /* stripes w/ fresh parity   */
+	uint64_t		 ap_encode_cnt;  /* full stripes encoded      */
+	uint64_t		 ap_delta_cnt;   /* stripes folded by delta   */
+	uint64_t		 ap_recalc_cnt;  /* stripes recalculated      */
+	uint64_t		 ap_cells_fetched; /* remote cells fetched    */
 };
 
 /* Struct used to drive offloaded stripe update.
@@ -668,16 +675,36 @@ out:
 static int
 agg_encode_local_parity(struct ec_agg_entry *entry)
 {
-	int rc = 0;
+	struct ec_agg_param	*agg_param;
+	int			 rc = 0;
 
 	rc = agg_fetch_data_stripe(entry);
 	if (rc)
 		goto out;
-	agg_encode_full_stripe(entry);
+	rc = agg_encode_full_stripe(entry);
+	if (rc)
+		goto out;
+
+	agg_param = container_of(entry, struct ec_agg_param, ap_agg_entry);
+	agg_param->ap_encode_cnt++;
+	d_tm_increment_counter(&obj_tls_get()->ot_ec_agg_encoded, NULL);
 out:
 	return rc;
 }
 
+/* True if the parity of the stripe is as new, or newer, than all of the
+ * replicas (and holes) of the stripe, e.g. the stripe was later rewritten
+ * in full and encoded by the client. The parity, local and peer, already
+ * covers the stripe, so it is neither fetched nor encoded again.
+ */
+static bool
+agg_parity_is_fresh(struct ec_agg_entry *entry)
+{
+	return entry->ae_par_extent.ape_epoch != ~(0ULL) &&
+	       entry->ae_par_extent.ape_epoch >=
+	       entry->ae_cur_stripe.as_hi_epoch;
+}
+
 /* True if all extents within the stripe are at a higher epoch than
  * the parity for the stripe.
  */
@@ -973,7 +1000,48 @@ out:
 	return rc;
 }
 
+/* Clears the bytes of a cell's data delta that no replica extent covers.
+ * The local copy of a partially replicated cell reads back as zeroes outside
+ * the replicated ranges, so XOR against the old data would be wrong there;
+ * only the bytes actually rewritten may contribute to the parity delta.
+ * Relies on the stripe's extent list being sorted by offset.
+ */
+static void
+agg_delta_mask(struct ec_agg_entry *entry, unsigned int cell,
+	       unsigned char *diff)
+{
+	struct ec_agg_extent	*extent;
+	unsigned int		 len = ec_age2cs(entry);
+	unsigned int		 k = ec_age2k(entry);
+	daos_off_t		 ss;
+	daos_off_t		 cs = cell * len;
+	daos_off_t		 ce = cs + len;
+	daos_off_t		 pos = cs;
+	daos_off_t		 es, ee;
+
+	ss = k * len * entry->ae_cur_stripe.as_stripenum;
+	d_list_for_each_entry(extent, &entry->ae_cur_stripe.as_dextents,
+			      ae_link) {
+		if (extent->ae_epoch <= entry->ae_par_extent.ape_epoch)
+			continue;
+		es = extent->ae_recx.rx_idx - ss;
+		ee = es + extent->ae_recx.rx_nr;
+		if (ee <= pos || es >= ce)
+			continue;
+		if (es > pos)
+			memset(&diff[(pos - cs) * entry->ae_rsize], 0,
+			       (es - pos) * entry->ae_rsize);
+		pos = min(ee, ce);
+		if (pos == ce)
+			return;
+	}
+	memset(&diff[(pos - cs) * entry->ae_rsize], 0,
+	       (ce - pos) * entry->ae_rsize);
+}
+
 /* Performs an incremental update of the existing parity for the stripe.
+ * The delta of each replicated cell is applied to the parity directly, so
+ * only the touched cells (and the peer parity) have to be fetched.
  */
 static int
 agg_update_parity(struct ec_agg_entry *entry, uint8_t *bit_map,
@@ -1011,7 +1079,8 @@ agg_update_parity(struct ec_agg_entry *entry, uint8_t *bit_map,
 			goto out;
 		while (!isset(bit_map, j))
 			j++;
-		ec_encode_data_update(cell_bytes, k, p, j,
+		agg_delta_mask(entry, j, diff);
+		ec_encode_data_update(cell_bytes, k, p, j++,
 				      entry->ae_codec->ec_gftbls, diff,
 				      parity_bufs);
 	}
@@ -1097,12 +1166,15 @@ agg_process_partial_stripe(struct ec_agg_entry *entry)
 {
 	struct ec_agg_stripe_ud	 stripe_ud = { 0 };
 	struct ec_agg_extent	*extent;
+	struct ec_agg_param	*agg_param;
 	int			*status;
 	uint8_t			*bit_map = NULL;
 	uint8_t			 fcbit_map[OBJ_TGT_BITMAP_LEN] = {0};
 	uint8_t			 tbit_map[OBJ_TGT_BITMAP_LEN] = {0};
 	unsigned int		 len = ec_age2cs(entry);
 	unsigned int		 k = ec_age2k(entry);
+	unsigned int		 p = ec_age2p(entry);
+	unsigned int		 fetch_cnt;
 	unsigned long            ss;
 	unsigned int		 i, full_cell_cnt = 0;
 	unsigned int		 cell_cnt = 0;
@@ -1144,12 +1216,25 @@ agg_process_partial_stripe(struct ec_agg_entry *entry)
 				    entry->ae_cur_stripe.as_stripenum,
 				    &full_cell_cnt);
 
-	if (full_cell_cnt >= k / 2 || cell_cnt == k || has_old_replicas) {
+	if (cell_cnt == k || has_old_replicas)
 		stripe_ud.asu_recalc = true;
+	else if (srv_ec_agg_delta)
+		/* Parity delta pulls the old copy of every touched cell plus
+		 * the peer parity cells, recalc pulls every cell that is not
+		 * fully replicated here. Pick whichever moves fewer cells.
+		 */
+		stripe_ud.asu_recalc = k - full_cell_cnt <= cell_cnt + p - 1;
+	else
+		stripe_ud.asu_recalc = full_cell_cnt >= k / 2;
+
+	if (stripe_ud.asu_recalc) {
+		fetch_cnt = k - full_cell_cnt;
 		cell_cnt = full_cell_cnt;
 		bit_map = fcbit_map;
-	} else
+	} else {
+		fetch_cnt = cell_cnt + p - 1;
 		bit_map = tbit_map;
+	}
 
 	rc = agg_prep_sgl(entry);
 	if (rc)
@@ -1195,6 +1280,13 @@ agg_process_partial_stripe(struct ec_agg_entry *entry)
 		goto ev_out;
 	}
 
+	agg_param = container_of(entry, struct ec_agg_param, ap_agg_entry);
+	if (stripe_ud.asu_recalc)
+		agg_param->ap_recalc_cnt++;
+	else
+		agg_param->ap_delta_cnt++;
+	agg_param->ap_cells_fetched += fetch_cnt;
+
 ev_out:
 	ABT_eventual_free(&stripe_ud.asu_eventual);
 
@@ -1628,6 +1720,7 @@ agg_process_stripe(struct dtx_handle *dth, struct ec_agg_entry *entry)
 {
 	vos_iter_param_t	iter_param = { 0 };
 	struct vos_iter_anchors	anchors = { 0 };
+	struct ec_agg_param	*ap;
 	bool			update_vos = true;
 	bool			write_parity = true;
 	bool			process_holes = false;
@@ -1656,10 +1749,12 @@ agg_process_stripe(struct dtx_handle *dth, struct ec_agg_entry *entry)
 	if (rc != 0)
 		goto out;
 
-	if (entry->ae_par_extent.ape_epoch >= entry->ae_cur_stripe.as_hi_epoch
-	    && entry->ae_par_extent.ape_epoch != ~(0ULL)) {
+	if (agg_parity_is_fresh(entry)) {
 		/* Parity is as new, or newer than data, so delete the replicas.
 		 */
+		ap = container_of(entry, struct ec_agg_param, ap_agg_entry);
+		ap->ap_fresh_cnt++;
+		d_tm_increment_counter(&obj_tls_get()->ot_ec_agg_fresh, NULL);
 		update_vos = true;
 		write_parity = false;
 		goto out;
@@ -2250,6 +2345,17 @@ again:
 	if (rc == 0 && is_current)
 		cont->sc_ec_agg_eph = epr->epr_hi;
 
+	if (agg_param.ap_fresh_cnt + agg_param.ap_encode_cnt > 0)
+		D_DEBUG(DB_EPC, DF_UUID": stripes skipped (fresh parity) "
+			DF_U64", full stripes encoded "DF_U64"\n",
+			DP_UUID(cont->sc_uuid), agg_param.ap_fresh_cnt,
+			agg_param.ap_encode_cnt);
+	if (agg_param.ap_delta_cnt + agg_param.ap_recalc_cnt > 0)
+		D_DEBUG(DB_EPC, DF_UUID": partial stripes delta "DF_U64
+			", recalc "DF_U64", remote cells fetched "DF_U64"\n",
+			DP_UUID(cont->sc_uuid), agg_param.ap_delta_cnt,
+			agg_param.ap_recalc_cnt, agg_param.ap_cells_fetched);
+
 	dsc_cont_close(ph, agg_param.ap_pool_info.api_cont_hdl);
 out:
 	daos_prop_free(agg_param.ap_prop);
@@ -15,6 +15,11 @@
 #include "obj_rpc.h"
 #include "obj_internal.h"
 
+bool srv_scm_zero_copy;
+bool srv_ec_agg_delta = true;
+unsigned int srv_csum_verify_read;
+unsigned int srv_bulk_chunk;
+
 /**
  * Switch of enable DTX or not, enabled by default.
  */
@@ -23,6 +28,11 @@ obj_mod_init(void)
 {
 	int	rc;
 
+	d_getenv_bool("DAOS_SCM_ZERO_COPY", &srv_scm_zero_copy);
+	d_getenv_bool("DAOS_EC_AGG_DELTA", &srv_ec_agg_delta);
+	d_getenv_int("DAOS_CSUM_VERIFY_READ", &srv_csum_verify_read);
+	d_getenv_int("DAOS_BULK_CHUNK", &srv_bulk_chunk);
+
 	rc = obj_utils_init();
 	if (rc)
 		goto out;
@@ -145,6 +155,36 @@ obj_tls_init(int xs_id, int tgt_id)
 		       DP_RC(rc));
 	D_FREE(path);
 
+	/** Total number of fetches verified on read, of type counter */
+	D_ASPRINTF(path, "io/%u/ops/%s/csum_verified_cnt", tgt_id,
+		   obj_opc_to_str(DAOS_OBJ_RPC_FETCH));
+	rc = d_tm_add_metric(&tls->ot_csum_read_verified, path, D_TM_COUNTER,
+			     "total number of fetches verified on the server",
+			     "");
+	if (rc)
+		D_WARN("Failed to create csum verified cnt sensor: "DF_RC"\n",
+		       DP_RC(rc));
+	D_FREE(path);
+
+	/** EC aggregation stripes with fresh parity, of type counter */
+	D_ASPRINTF(path, "io/%u/ec_agg/fresh_parity_cnt", tgt_id);
+	rc = d_tm_add_metric(&tls->ot_ec_agg_fresh, path, D_TM_COUNTER,
+			     "EC aggregation stripes skipped, parity is fresh",
+			     "");
+	if (rc)
+		D_WARN("Failed to create fresh parity cnt sensor: "DF_RC"\n",
+		       DP_RC(rc));
+	D_FREE(path);
+
+	/** EC aggregation full stripes encoded, of type counter */
+	D_ASPRINTF(path, "io/%u/ec_agg/full_encode_cnt", tgt_id);
+	rc = d_tm_add_metric(&tls->ot_ec_agg_encoded, path, D_TM_COUNTER,
+			     "EC aggregation full stripes encoded", "");
+	if (rc)
+		D_WARN("Failed to create full encode cnt sensor: "DF_RC"\n",
+		       DP_RC(rc));
+	D_FREE(path);
+
 	return tls;
 }
 
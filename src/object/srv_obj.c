@@ -33,6 +33,11 @@ static int
 obj_verify_bio_csum(daos_obj_id_t oid, daos_iod_t *iods,
 		    struct dcs_iod_csums *iod_csums, struct bio_desc *biod,
 		    struct daos_csummer *csummer, uint32_t iods_nr);
+static int
+obj_copy_verify_bio_csum(daos_obj_id_t oid, daos_iod_t *iods,
+			 struct dcs_iod_csums *iod_csums, struct bio_desc *biod,
+			 struct daos_csummer *csummer, d_sg_list_t *sgls,
+			 uint32_t iods_nr);
 
 /* For single RDG based DTX, parse DTX participants information
  * from the client given dispatch targets information that does
@@ -194,6 +199,8 @@ struct obj_bulk_args {
 	int		result;
 	bool		inited;
 	ABT_eventual	eventual;
+	/* Pre-registered SCM window, shouldn't be freed on completion */
+	crt_bulk_t	scm_bulk;
 };
 
 static int
@@ -224,7 +231,8 @@ obj_bulk_comp_cb(const struct crt_bulk_cb_info *cb_info)
 		ABT_eventual_set(arg->eventual, &arg->result,
 				 sizeof(arg->result));
 
-	crt_bulk_free(local_bulk_hdl);
+	if (local_bulk_hdl != arg->scm_bulk)
+		crt_bulk_free(local_bulk_hdl);
 	crt_req_decref(rpc);
 	return cb_info->bci_rc;
 }
@@ -268,16 +276,227 @@ obj_bulk_bypass(d_sg_list_t *sgl, crt_bulk_op_t bulk_op)
 	}
 }
 
+static bool
+obj_sgl_in_window(d_sg_list_t *sgl, d_iov_t *window)
+{
+	char	*start = window->iov_buf;
+	char	*end = start + window->iov_len;
+	int	 i;
+
+	for (i = 0; i < sgl->sg_nr; i++) {
+		char *buf = sgl->sg_iovs[i].iov_buf;
+
+		if (buf < start || buf + sgl->sg_iovs[i].iov_len > end)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Push SCM resident data to the client straight from the pre-registered SCM
+ * window of the pool, without registering the fetched extents one by one.
+ * Adjacent extents are merged into one transfer.
+ */
+static int
+obj_bulk_scm_transfer(crt_rpc_t *rpc, bool bulk_bind, crt_bulk_t remote_bulk,
+		      daos_size_t remote_off, d_sg_list_t *sgl,
+		      d_iov_t *window, struct obj_bulk_args *p_arg)
+{
+	struct crt_bulk_desc	bulk_desc;
+	crt_bulk_opid_t		bulk_opid;
+	unsigned int		i = 0;
+	int			rc = 0;
+
+	while (i < sgl->sg_nr) {
+		char		*start = sgl->sg_iovs[i].iov_buf;
+		daos_size_t	 length = 0;
+
+		while (i < sgl->sg_nr &&
+		       (char *)sgl->sg_iovs[i].iov_buf == start + length) {
+			length += sgl->sg_iovs[i].iov_len;
+			i++;
+		}
+
+		crt_req_addref(rpc);
+
+		bulk_desc.bd_rpc	= rpc;
+		bulk_desc.bd_bulk_op	= CRT_BULK_PUT;
+		bulk_desc.bd_remote_hdl	= remote_bulk;
+		bulk_desc.bd_local_hdl	= p_arg->scm_bulk;
+		bulk_desc.bd_len	= length;
+		bulk_desc.bd_remote_off	= remote_off;
+		bulk_desc.bd_local_off	= start - (char *)window->iov_buf;
+
+		p_arg->bulks_inflight++;
+		if (bulk_bind)
+			rc = crt_bulk_bind_transfer(&bulk_desc,
+				obj_bulk_comp_cb, p_arg, &bulk_opid);
+		else
+			rc = crt_bulk_transfer(&bulk_desc,
+				obj_bulk_comp_cb, p_arg, &bulk_opid);
+		if (rc < 0) {
+			D_ERROR("crt_bulk_transfer on SCM window error (%d).\n",
+				rc);
+			p_arg->bulks_inflight--;
+			crt_req_decref(rpc);
+			break;
+		}
+		remote_off += length;
+	}
+	return rc;
+}
+
+/**
+ * Wait for the bulk transfers issued so far with \a p_arg to complete, and
+ * rearm it for the following ones. A pipelined run writes back all the DMA
+ * buffer before its own position, the data of the prior runs must be there.
+ */
+static int
+obj_bulk_drain(struct obj_bulk_args *p_arg)
+{
+	int	*status;
+	int	 rc;
+
+	/* Only the reference held by obj_bulk_transfer() itself */
+	if (p_arg->bulks_inflight == 1)
+		return p_arg->result;
+
+	p_arg->bulks_inflight--;
+	rc = ABT_eventual_wait(p_arg->eventual, (void **)&status);
+	rc = rc ? dss_abterr2der(rc) : *status;
+
+	ABT_eventual_reset(p_arg->eventual);
+	p_arg->bulks_inflight = 1;
+	return rc;
+}
+
+/* Number of chunks in flight when pulling update data in chunks */
+#define OBJ_BULK_PIPELINE_DEPTH	2
+
+/**
+ * Pull a run of update data from the client in chunks of srv_bulk_chunk
+ * bytes, and start writing each chunk to NVMe once it is in the DMA buffer,
+ * so the NVMe writes overlap with the RDMA of the following chunks instead
+ * of waiting for the whole transfer. The run starts at IOV \a iov_idx of
+ * SG list \a sgl_idx of \a biod, the reference of \a local_bulk is consumed.
+ */
+static int
+obj_bulk_pipeline(crt_rpc_t *rpc, bool bulk_bind, crt_bulk_t remote_bulk,
+		  daos_size_t remote_off, d_sg_list_t *sgl,
+		  crt_bulk_t local_bulk, struct bio_desc *biod,
+		  unsigned int sgl_idx, unsigned int iov_idx)
+{
+	struct obj_bulk_args	args[OBJ_BULK_PIPELINE_DEPTH] = { 0 };
+	daos_size_t		ends[OBJ_BULK_PIPELINE_DEPTH];
+	struct crt_bulk_desc	bulk_desc;
+	crt_bulk_opid_t		bulk_opid;
+	daos_size_t		length = 0;
+	daos_size_t		issued = 0;
+	daos_size_t		iov_off;
+	unsigned int		head = 0;
+	unsigned int		inflight = 0;
+	unsigned int		slot;
+	unsigned int		i;
+	int			rc = 0;
+	int			*status;
+	int			ret;
+
+	for (i = 0; i < sgl->sg_nr; i++)
+		length += sgl->sg_iovs[i].iov_len;
+
+	while (1) {
+		/* Keep the pipeline full */
+		while (rc == 0 && issued < length &&
+		       inflight < OBJ_BULK_PIPELINE_DEPTH) {
+			slot = (head + inflight) % OBJ_BULK_PIPELINE_DEPTH;
+			rc = ABT_eventual_create(sizeof(*status),
+						 &args[slot].eventual);
+			if (rc != 0) {
+				rc = dss_abterr2der(rc);
+				break;
+			}
+			args[slot].result = 0;
+			args[slot].bulks_inflight = 1;
+			args[slot].scm_bulk = CRT_BULK_NULL;
+
+			/* Dropped by obj_bulk_comp_cb() */
+			rc = crt_bulk_addref(local_bulk);
+			if (rc != 0) {
+				ABT_eventual_free(&args[slot].eventual);
+				break;
+			}
+			crt_req_addref(rpc);
+
+			bulk_desc.bd_rpc	= rpc;
+			bulk_desc.bd_bulk_op	= CRT_BULK_GET;
+			bulk_desc.bd_remote_hdl	= remote_bulk;
+			bulk_desc.bd_local_hdl	= local_bulk;
+			bulk_desc.bd_len	= min(length - issued,
+						      srv_bulk_chunk);
+			bulk_desc.bd_remote_off	= remote_off + issued;
+			bulk_desc.bd_local_off	= issued;
+
+			if (bulk_bind)
+				rc = crt_bulk_bind_transfer(&bulk_desc,
+					obj_bulk_comp_cb, &args[slot],
+					&bulk_opid);
+			else
+				rc = crt_bulk_transfer(&bulk_desc,
+					obj_bulk_comp_cb, &args[slot],
+					&bulk_opid);
+			if (rc < 0) {
+				D_ERROR("crt_bulk_transfer chunk error (%d).\n",
+					rc);
+				ABT_eventual_free(&args[slot].eventual);
+				crt_bulk_free(local_bulk);
+				crt_req_decref(rpc);
+				break;
+			}
+			issued += bulk_desc.bd_len;
+			ends[slot] = issued;
+			inflight++;
+		}
+
+		if (inflight == 0)
+			break;
+
+		/* Wait for the oldest chunk, then write it back */
+		ret = ABT_eventual_wait(args[head].eventual, (void **)&status);
+		if (rc == 0)
+			rc = ret ? dss_abterr2der(ret) : *status;
+		ABT_eventual_free(&args[head].eventual);
+		inflight--;
+
+		if (rc == 0) {
+			/* Locate the first byte not transferred yet */
+			iov_off = ends[head];
+			for (i = 0; i < sgl->sg_nr &&
+			     iov_off >= sgl->sg_iovs[i].iov_len; i++)
+				iov_off -= sgl->sg_iovs[i].iov_len;
+
+			rc = bio_iod_post_partial(biod, sgl_idx, iov_idx + i,
+						  iov_off);
+		}
+		head = (head + 1) % OBJ_BULK_PIPELINE_DEPTH;
+	}
+
+	crt_bulk_free(local_bulk);
+	return rc;
+}
+
 static int
 obj_bulk_transfer(crt_rpc_t *rpc, crt_bulk_op_t bulk_op, bool bulk_bind,
 		  crt_bulk_t *remote_bulks, uint64_t *remote_offs,
-		  daos_handle_t ioh, d_sg_list_t **sgls,
+		  daos_handle_t ioh, struct ds_pool_child *scm_pool,
+		  d_sg_list_t **sgls,
 		  struct bio_sglist *bsgls_dup, int sgl_nr,
 		  struct obj_bulk_args *p_arg)
 {
 	struct obj_bulk_args	arg = { 0 };
 	crt_bulk_opid_t		bulk_opid;
 	crt_bulk_perm_t		bulk_perm;
+	d_iov_t			scm_window = { 0 };
+	struct bio_desc		*biod = NULL;
 	int			i, rc, *status, ret;
 	bool			async = true;
 
@@ -297,8 +516,20 @@ obj_bulk_transfer(crt_rpc_t *rpc, crt_bulk_op_t bulk_op, bool bulk_bind,
 		return dss_abterr2der(rc);
 
 	p_arg->inited = true;
+	p_arg->scm_bulk = CRT_BULK_NULL;
 	D_DEBUG(DB_IO, "bulk_op %d sgl_nr %d\n", bulk_op, sgl_nr);
 
+	/* Fetched SCM data can be sent from the pre-registered SCM window */
+	if (srv_scm_zero_copy && scm_pool != NULL && bulk_op == CRT_BULK_PUT &&
+	    ds_pool_child_scm_bulk(scm_pool, &p_arg->scm_bulk,
+				   &scm_window) != 0)
+		p_arg->scm_bulk = CRT_BULK_NULL;
+
+	/* Large updates can be written to NVMe while they are transferred */
+	if (srv_bulk_chunk != 0 && bulk_op == CRT_BULK_GET && !async &&
+	    sgls == NULL && bsgls_dup == NULL)
+		biod = vos_ioh2desc(ioh);
+
 	p_arg->bulks_inflight++;
 	for (i = 0; i < sgl_nr; i++) {
 		d_sg_list_t		*sgl, tmp_sgl;
@@ -394,6 +625,17 @@ obj_bulk_transfer(crt_rpc_t *rpc, crt_bulk_op_t bulk_op, bool bulk_bind,
 			sgl_sent.sg_nr = idx - start;
 			sgl_sent.sg_nr_out = idx - start;
 
+			if (p_arg->scm_bulk != CRT_BULK_NULL &&
+			    obj_sgl_in_window(&sgl_sent, &scm_window)) {
+				rc = obj_bulk_scm_transfer(rpc, bulk_bind,
+						remote_bulks[i], offset,
+						&sgl_sent, &scm_window, p_arg);
+				if (rc)
+					break;
+				offset += length;
+				continue;
+			}
+
 			rc = crt_bulk_create(rpc->cr_ctx, &sgl_sent,
 					     bulk_perm, &local_bulk_hdl);
 			if (rc != 0) {
@@ -402,6 +644,21 @@ obj_bulk_transfer(crt_rpc_t *rpc, crt_bulk_op_t bulk_op, bool bulk_bind,
 				break;
 			}
 
+			if (biod != NULL && length > srv_bulk_chunk) {
+				rc = obj_bulk_drain(p_arg);
+				if (rc == 0)
+					rc = obj_bulk_pipeline(rpc, bulk_bind,
+						remote_bulks[i], offset,
+						&sgl_sent, local_bulk_hdl,
+						biod, i, start);
+				else
+					crt_bulk_free(local_bulk_hdl);
+				if (rc)
+					break;
+				offset += length;
+				continue;
+			}
+
 			crt_req_addref(rpc);
 
 			bulk_desc.bd_rpc	= rpc;
@@ -679,7 +936,8 @@ obj_echo_rw(crt_rpc_t *rpc, daos_iod_t *split_iods, uint64_t *split_offs)
 	bulk_bind = orw->orw_flags & ORF_BULK_BIND;
 	rc = obj_bulk_transfer(rpc, bulk_op, bulk_bind,
 			       orw->orw_bulks.ca_arrays, off,
-			       DAOS_HDL_INVAL, &p_sgl, NULL, orw->orw_nr, NULL);
+			       DAOS_HDL_INVAL, NULL, &p_sgl, NULL, orw->orw_nr,
+			       NULL);
 out:
 	orwo->orw_ret = rc;
 	orwo->orw_map_version = orw->orw_map_ver;
@@ -757,6 +1015,54 @@ csum_add2iods(daos_handle_t ioh, daos_iod_t *iods, uint32_t iods_nr,
 	return rc;
 }
 
+/**
+ * Sampled verification on read: with DAOS_CSUM_VERIFY_READ=N, 1 in N fetches
+ * of the containers with server side verification enabled is verified
+ * against the stored checksums before being returned.
+ */
+static bool
+csum_verify_fetch_sampled(struct daos_csummer *csummer)
+{
+	struct obj_tls	*tls;
+
+	if (srv_csum_verify_read == 0 || !daos_csummer_initialized(csummer) ||
+	    !csummer->dcs_srv_verify || csummer->dcs_skip_data_verify)
+		return false;
+
+	tls = obj_tls_get();
+	if (!ds_csum_sample(&tls->ot_csum_read_cnt, srv_csum_verify_read))
+		return false;
+
+	d_tm_increment_counter(&tls->ot_csum_read_verified, NULL);
+	return true;
+}
+
+static int
+csum_verify_fetch(daos_handle_t ioh, daos_iod_t *iods, uint32_t iods_nr,
+		  struct daos_csummer *csummer)
+{
+	struct bio_desc		*biod = vos_ioh2desc(ioh);
+	struct dcs_csum_info	*csum_infos = vos_ioh2ci(ioh);
+	uint32_t		 csum_info_nr = vos_ioh2ci_nr(ioh);
+	uint32_t		 biov_csums_idx = 0;
+	size_t			 biov_csums_used = 0;
+	int			 i;
+	int			 rc = 0;
+
+	for (i = 0; i < iods_nr && rc == 0; i++) {
+		if (biov_csums_idx >= csum_info_nr)
+			break;
+
+		rc = ds_csum_verify_fetch(&iods[i], csummer,
+					  bio_iod_sgl(biod, i),
+					  &csum_infos[biov_csums_idx],
+					  &biov_csums_used);
+		biov_csums_idx += biov_csums_used;
+	}
+
+	return rc;
+}
+
 static int
 csum_verify_keys(struct daos_csummer *csummer, daos_key_t *dkey,
 		 struct dcs_csum_info *dci, struct obj_iod_array *oia)
@@ -1250,6 +1556,7 @@ obj_local_rw_internal(crt_rpc_t *rpc, struct obj_io_context *ioc,
 	bool				bulk_bind;
 	bool				create_map;
 	bool				spec_fetch = false;
+	bool				verified = false;
 	struct daos_recx_ep_list	*recov_lists = NULL;
 	daos_iod_t			*iods;
 	uint64_t			*offs;
@@ -1458,6 +1765,23 @@ obj_local_rw_internal(crt_rpc_t *rpc, struct obj_io_context *ioc,
 				goto post;
 
 			}
+
+			if (csum_verify_fetch_sampled(
+						ioc->ioc_coc->sc_csummer)) {
+				rc = csum_verify_fetch(ioh,
+						orw->orw_iod_array.oia_iods,
+						orw->orw_iod_array.oia_iod_nr,
+						ioc->ioc_coc->sc_csummer);
+				if (rc) {
+					D_ERROR(DF_UOID" fetch data corrupted: "
+						DF_RC"\n",
+						DP_UOID(orw->orw_oid),
+						DP_RC(rc));
+					if (rc == -DER_CSUM)
+						obj_log_csum_err();
+					goto post;
+				}
+			}
 		}
 	}
 
@@ -1465,9 +1789,19 @@ obj_local_rw_internal(crt_rpc_t *rpc, struct obj_io_context *ioc,
 		bulk_bind = orw->orw_flags & ORF_BULK_BIND;
 		rc = obj_bulk_transfer(rpc, bulk_op, bulk_bind,
 				       orw->orw_bulks.ca_arrays, offs,
-				       ioh, NULL, bsgls_dup, orw->orw_nr, NULL);
+				       ioh, ioc->ioc_coc->sc_pool, NULL,
+				       bsgls_dup, orw->orw_nr, NULL);
 		if (!rc)
 			bio_iod_flush(biod);
+	} else if (orw->orw_sgls.ca_arrays != NULL &&
+		   obj_rpc_is_update(rpc)) {
+		/* verify the checksums while copying the inline data */
+		rc = obj_copy_verify_bio_csum(orw->orw_oid.id_pub, iods,
+					      iod_csums, biod,
+					      ioc->ioc_coc->sc_csummer,
+					      orw->orw_sgls.ca_arrays,
+					      orw->orw_nr);
+		verified = true;
 	} else if (orw->orw_sgls.ca_arrays != NULL) {
 		rc = bio_iod_copy(biod, orw->orw_sgls.ca_arrays, orw->orw_nr);
 	}
@@ -1479,6 +1813,8 @@ obj_local_rw_internal(crt_rpc_t *rpc, struct obj_io_context *ioc,
 		D_CDEBUG(rc == -DER_REC2BIG, DLOG_DBG, DLOG_ERR,
 			 DF_UOID" data transfer failed, dma %d rc "DF_RC"",
 			 DP_UOID(orw->orw_oid), rma, DP_RC(rc));
+		if (rc == -DER_CSUM)
+			obj_log_csum_err();
 		D_GOTO(post, rc);
 	}
 
@@ -1488,9 +1824,23 @@ obj_local_rw_internal(crt_rpc_t *rpc, struct obj_io_context *ioc,
 			D_GOTO(post, rc);
 		}
 
-		rc = obj_verify_bio_csum(orw->orw_oid.id_pub, iods, iod_csums,
-					 biod, ioc->ioc_coc->sc_csummer,
-					 orw->orw_iod_array.oia_iod_nr);
+		if (!verified)
+			rc = obj_verify_bio_csum(orw->orw_oid.id_pub, iods,
+						 iod_csums, biod,
+						 ioc->ioc_coc->sc_csummer,
+						 orw->orw_iod_array.oia_iod_nr);
+
+		/*
+		 * Chunk the data for dedup while it is in the bio buffers,
+		 * VOS only chunks the updates of single modification DTXs.
+		 */
+		if (rc == 0 && ioc->ioc_coc->sc_props.dcp_dedup_enabled) {
+			err = vos_dedup_scan(ioh);
+			if (err != 0)
+				D_DEBUG(DB_IO, DF_UOID" stored without "
+					"chunking: "DF_RC"\n",
+					DP_UOID(orw->orw_oid), DP_RC(err));
+		}
 		/** CSUM Verified on update, now corrupt to fake corruption
 		 * on disk
 		 */
@@ -1527,6 +1877,100 @@ out:
 	return rc;
 }
 
+/**
+ * Publish the inline compression statistics of the container, the gauges are
+ * refreshed at most once per second instead of on every I/O.
+ */
+static void
+obj_cmp_stats_update(struct ds_cont_child *cont)
+{
+	vos_cont_info_t		 info;
+	struct vos_cmp_stats	*stats = &info.ci_cmp_stats;
+	uint64_t		 now = 0;
+	char			*path;
+	int			 rc;
+
+	daos_gettime_coarse(&now);
+	if (now == cont->sc_cmp_stats_ts)
+		return;
+	cont->sc_cmp_stats_ts = now;
+
+	if (cont->sc_cmp_ratio == NULL) {
+		D_ASPRINTF(path, "io/%u/compress/"DF_UUIDF"/ratio_pct",
+			   dss_get_module_info()->dmi_tgt_id,
+			   DP_UUID(cont->sc_uuid));
+		if (path == NULL)
+			return;
+		rc = d_tm_add_metric(&cont->sc_cmp_ratio, path, D_TM_GAUGE,
+				     "compressed size over raw size", "%");
+		D_FREE(path);
+		if (rc)
+			return;
+
+		D_ASPRINTF(path, "io/%u/compress/"DF_UUIDF"/cpu_us",
+			   dss_get_module_info()->dmi_tgt_id,
+			   DP_UUID(cont->sc_uuid));
+		if (path == NULL)
+			return;
+		rc = d_tm_add_metric(&cont->sc_cmp_cpu, path, D_TM_GAUGE,
+				     "(de)compression time on the target xstream",
+				     "us");
+		D_FREE(path);
+		if (rc)
+			return;
+	}
+
+	rc = vos_cont_query(cont->sc_hdl, &info);
+	if (rc != 0 || stats->cs_in == 0)
+		return;
+
+	d_tm_set_gauge(&cont->sc_cmp_ratio, stats->cs_out * 100 / stats->cs_in,
+		       NULL);
+	d_tm_set_gauge(&cont->sc_cmp_cpu,
+		       (stats->cs_cmp_ns + stats->cs_dcmp_ns) / 1000, NULL);
+}
+
+/** Publish the content defined chunking dedup statistics of the target */
+static void
+obj_dedup_stats_update(struct ds_pool_child *pool)
+{
+	struct vos_dedup_stats	 stats;
+	char			*path;
+	int			 rc;
+
+	if (pool->spc_dedup_ratio == NULL) {
+		D_ASPRINTF(path, "io/%u/dedup/"DF_UUIDF"/ratio_pct",
+			   dss_get_module_info()->dmi_tgt_id,
+			   DP_UUID(pool->spc_uuid));
+		if (path == NULL)
+			return;
+		rc = d_tm_add_metric(&pool->spc_dedup_ratio, path, D_TM_GAUGE,
+				     "stored size over chunked size", "%");
+		D_FREE(path);
+		if (rc)
+			return;
+
+		D_ASPRINTF(path, "io/%u/dedup/"DF_UUIDF"/index_bytes",
+			   dss_get_module_info()->dmi_tgt_id,
+			   DP_UUID(pool->spc_uuid));
+		if (path == NULL)
+			return;
+		rc = d_tm_add_metric(&pool->spc_dedup_index, path, D_TM_GAUGE,
+				     "DRAM used by the dedup index", "bytes");
+		D_FREE(path);
+		if (rc)
+			return;
+	}
+
+	rc = vos_pool_dedup_query(pool->spc_hdl, &stats);
+	if (rc != 0 || stats.ds_in == 0)
+		return;
+
+	d_tm_set_gauge(&pool->spc_dedup_ratio,
+		       stats.ds_stored * 100 / stats.ds_in, NULL);
+	d_tm_set_gauge(&pool->spc_dedup_index, stats.ds_index_bytes, NULL);
+}
+
 static int
 obj_local_rw(crt_rpc_t *rpc, struct obj_io_context *ioc,
 	     daos_iod_t *split_iods, struct dcs_iod_csums *split_csums,
@@ -1543,6 +1987,12 @@ again:
 			goto again;
 	}
 
+	if (rc == 0 && ioc->ioc_coc->sc_props.dcp_compress_enabled)
+		obj_cmp_stats_update(ioc->ioc_coc);
+	if (rc == 0 && ioc->ioc_coc->sc_props.dcp_dedup_enabled &&
+	    obj_rpc_is_update(rpc))
+		obj_dedup_stats_update(ioc->ioc_coc->sc_pool);
+
 	return rc;
 }
 
@@ -1821,7 +2271,7 @@ ds_obj_ec_rep_handler(crt_rpc_t *rpc)
 		goto out;
 	}
 	rc = obj_bulk_transfer(rpc, CRT_BULK_PUT, false, &oer->er_bulk, NULL,
-			       ioh, NULL, NULL, 1, NULL);
+			       ioh, NULL, NULL, NULL, 1, NULL);
 	if (rc) {
 		D_ERROR(DF_UOID" bulk transfer failed: "DF_RC".\n",
 			DP_UOID(oer->er_oid), DP_RC(rc));
@@ -1902,7 +2352,7 @@ ds_obj_ec_agg_handler(crt_rpc_t *rpc)
 			goto out;
 		}
 		rc = obj_bulk_transfer(rpc, CRT_BULK_GET, false, &oea->ea_bulk,
-				       NULL, ioh, NULL, NULL, 1, NULL);
+				       NULL, ioh, NULL, NULL, NULL, 1, NULL);
 		if (rc) {
 			D_ERROR(DF_UOID" bulk transfer failed: "DF_RC".\n",
 				DP_UOID(oea->ea_oid), DP_RC(rc));
@@ -2697,7 +3147,7 @@ obj_enum_reply_bulk(crt_rpc_t *rpc)
 		return 0;
 
 	rc = obj_bulk_transfer(rpc, CRT_BULK_PUT, false, bulks, NULL,
-			       DAOS_HDL_INVAL, sgls, NULL, idx, NULL);
+			       DAOS_HDL_INVAL, NULL, sgls, NULL, idx, NULL);
 	if (oei->oei_kds_bulk) {
 		D_FREE(oeo->oeo_kds.ca_arrays);
 		oeo->oeo_kds.ca_arrays = NULL;
@@ -3437,6 +3887,54 @@ obj_verify_bio_csum(daos_obj_id_t oid, daos_iod_t *iods,
 	return rc;
 }
 
+/**
+ * Copy the inline data of an update into the bio buffers of \a biod, and
+ * verify its checksums while it is copied, rather than reading it again from
+ * the bio buffers (possibly SCM) afterwards as obj_verify_bio_csum() does.
+ */
+static int
+obj_copy_verify_bio_csum(daos_obj_id_t oid, daos_iod_t *iods,
+			 struct dcs_iod_csums *iod_csums, struct bio_desc *biod,
+			 struct daos_csummer *csummer, d_sg_list_t *sgls,
+			 uint32_t iods_nr)
+{
+	struct dcs_copy_verify	*cvs;
+	unsigned int		 i;
+	int			 rc;
+
+	if (!daos_csummer_initialized(csummer) ||
+	    csummer->dcs_skip_data_verify ||
+	    !csummer->dcs_srv_verify)
+		return bio_iod_copy(biod, sgls, iods_nr);
+
+	for (i = 0; i < iods_nr; i++) {
+		if (!ci_is_valid(iod_csums[i].ic_data)) {
+			D_ERROR("Checksums is enabled but the csum info is "
+				"invalid.");
+			return -DER_CSUM;
+		}
+	}
+
+	D_ALLOC_ARRAY(cvs, iods_nr);
+	if (cvs == NULL)
+		return -DER_NOMEM;
+
+	for (i = 0; i < iods_nr; i++)
+		daos_csummer_copy_verify_init(&cvs[i], csummer, &iods[i],
+					      &iod_csums[i]);
+
+	rc = bio_iod_copy_verify(biod, sgls, iods_nr, cvs);
+	for (i = 0; i < iods_nr && rc == 0; i++)
+		rc = daos_csummer_copy_verify_fini(&cvs[i]);
+
+	if (rc == -DER_CSUM)
+		D_ERROR("Data Verification failed (object: "DF_OID"): %d\n",
+			DP_OID(oid), rc);
+
+	D_FREE(cvs);
+	return rc;
+}
+
 static inline void
 ds_obj_cpd_set_sub_result(struct obj_cpd_out *oco, int idx,
 			  int result, daos_epoch_t epoch)
@@ -3654,7 +4152,7 @@ ds_obj_dtx_handle_one(crt_rpc_t *rpc, struct daos_cpd_sub_head *dcsh,
 
 			rc = obj_bulk_transfer(rpc, CRT_BULK_GET,
 				dcu->dcu_flags & ORF_BULK_BIND, dcu->dcu_bulks,
-				offs, iohs[i], NULL,
+				offs, iohs[i], NULL, NULL,
 				bsgls_dups != NULL ? bsgls_dups[i] : NULL,
 				dcsr->dcsr_nr, &bulks[i]);
 			if (rc != 0) {
@@ -3667,9 +4165,14 @@ ds_obj_dtx_handle_one(crt_rpc_t *rpc, struct daos_cpd_sub_head *dcsh,
 
 			rma++;
 		} else if (dcu->dcu_sgls != NULL) {
-			rc = bio_iod_copy(biods[i], dcu->dcu_sgls,
-					  dcsr->dcsr_nr);
+			rc = obj_copy_verify_bio_csum(dcsr->dcsr_oid.id_pub,
+						      iods, csums, biods[i],
+						      ioc->ioc_coc->sc_csummer,
+						      dcu->dcu_sgls,
+						      dcsr->dcsr_nr);
 			if (rc != 0) {
+				if (rc == -DER_CSUM)
+					obj_log_csum_err();
 				D_ERROR("Non-bulk transfer failed for obj "
 					DF_UOID", DTX "DF_DTI": "DF_RC"\n",
 					DP_UOID(dcsr->dcsr_oid),
@@ -3734,7 +4237,9 @@ ds_obj_dtx_handle_one(crt_rpc_t *rpc, struct daos_cpd_sub_head *dcsh,
 
 					goto out;
 				}
-			} else {
+			} else if (dcu->dcu_flags & ORF_CPD_BULK ||
+				   dcu->dcu_sgls == NULL) {
+				/* inline data is verified while copied */
 				rc = obj_verify_bio_csum(dcsr->dcsr_oid.id_pub,
 						iods, csums, biods[i],
 						ioc->ioc_coc->sc_csummer,
@@ -3747,6 +4252,14 @@ ds_obj_dtx_handle_one(crt_rpc_t *rpc, struct daos_cpd_sub_head *dcsh,
 				}
 			}
 
+			/* Chunk the data for dedup, as obj_local_rw_internal() */
+			if (ioc->ioc_coc->sc_props.dcp_dedup_enabled &&
+			    vos_dedup_scan(iohs[i]) != 0)
+				D_DEBUG(DB_IO, DF_UOID" stored without "
+					"chunking, DTX "DF_DTI"\n",
+					DP_UOID(dcsr->dcsr_oid),
+					DP_DTI(&dcsh->dcsh_xid));
+
 			rc = bio_iod_post(biods[i]);
 			biods[i] = NULL;
 			if (rc != 0) {
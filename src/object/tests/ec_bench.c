@@ -0,0 +1,196 @@
+/**
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * Microbenchmark of the client EC encoding path (obj_ec_stripes_encode),
+ * reports the encoding bandwidth for common k+p layouts.
+ */
+#define D_LOGFAC	DD_FAC(tests)
+
+#include <getopt.h>
+#include <daos/common.h>
+#include "../obj_ec.h"
+
+static struct {
+	unsigned int	k;
+	unsigned int	p;
+} ec_layouts[] = {
+	{ 2, 1 }, { 4, 1 }, { 4, 2 }, { 8, 1 }, { 8, 2 }, { 16, 2 },
+};
+
+static void
+print_usage(const char *prog)
+{
+	D_PRINT("Usage: %s [options]\n"
+		"  -k <num>   number of data cells, with -p (default: run\n"
+		"             2+1, 4+1, 4+2, 8+1, 8+2 and 16+2)\n"
+		"  -p <num>   number of parity cells\n"
+		"  -c <KiB>   cell size in KiB (default 64)\n"
+		"  -s <MiB>   data size encoded per iteration in MiB "
+		"(default 64)\n"
+		"  -i <num>   number of iterations (default 10)\n"
+		"  -t <num>   number of encoding threads, set\n"
+		"             DAOS_EC_ENCODE_THREADS (default 0)\n", prog);
+}
+
+static int
+ec_bench_codec_init(struct obj_ec_codec *codec, unsigned int k,
+		    unsigned int p)
+{
+	D_ALLOC(codec->ec_en_matrix, (k + p) * k);
+	D_ALLOC(codec->ec_gftbls, k * p * 32);
+	if (codec->ec_en_matrix == NULL || codec->ec_gftbls == NULL)
+		return -DER_NOMEM;
+
+	gf_gen_cauchy1_matrix(codec->ec_en_matrix, k + p, k);
+	ec_init_tables(k, p, &codec->ec_en_matrix[k * k], codec->ec_gftbls);
+	return 0;
+}
+
+static void
+ec_bench_codec_fini(struct obj_ec_codec *codec)
+{
+	D_FREE(codec->ec_en_matrix);
+	D_FREE(codec->ec_gftbls);
+}
+
+static int
+ec_bench_run(unsigned int k, unsigned int p, uint64_t cell_bytes,
+	     uint64_t size, unsigned int iters, unsigned int thread_nr)
+{
+	struct obj_ec_codec	 codec = { 0 };
+	unsigned char		*data = NULL;
+	unsigned char		*parity[OBJ_EC_MAX_P] = { 0 };
+	struct timespec		 start, end;
+	uint32_t		 stripe_nr;
+	uint64_t		 off;
+	double			 secs, gbps;
+	unsigned int		 i;
+	int			 rc;
+
+	stripe_nr = size / (cell_bytes * k);
+	if (stripe_nr == 0)
+		stripe_nr = 1;
+
+	rc = ec_bench_codec_init(&codec, k, p);
+	if (rc)
+		goto out;
+
+	D_ALLOC(data, stripe_nr * cell_bytes * k);
+	if (data == NULL)
+		D_GOTO(out, rc = -DER_NOMEM);
+	for (off = 0; off < stripe_nr * cell_bytes * k; off++)
+		data[off] = rand();
+	for (i = 0; i < p; i++) {
+		D_ALLOC(parity[i], stripe_nr * cell_bytes);
+		if (parity[i] == NULL)
+			D_GOTO(out, rc = -DER_NOMEM);
+	}
+
+	/* warm up */
+	obj_ec_stripes_encode(&codec, k, p, cell_bytes, data, stripe_nr,
+			      parity);
+
+	d_gettime(&start);
+	for (i = 0; i < iters; i++)
+		obj_ec_stripes_encode(&codec, k, p, cell_bytes, data,
+				      stripe_nr, parity);
+	d_gettime(&end);
+
+	secs = d_timediff_ns(&start, &end) / 1e9;
+	gbps = (double)stripe_nr * cell_bytes * k * iters / secs / 1e9;
+	D_PRINT("%3u+%-2u %8"PRIu64" %8u %10.2f %10.2f\n", k, p,
+		cell_bytes >> 10, stripe_nr, gbps, gbps / (thread_nr + 1));
+out:
+	for (i = 0; i < p; i++)
+		D_FREE(parity[i]);
+	D_FREE(data);
+	ec_bench_codec_fini(&codec);
+	return rc;
+}
+
+int
+main(int argc, char **argv)
+{
+	static struct option	long_ops[] = {
+		{ "data",	required_argument,	NULL,	'k' },
+		{ "parity",	required_argument,	NULL,	'p' },
+		{ "cell",	required_argument,	NULL,	'c' },
+		{ "size",	required_argument,	NULL,	's' },
+		{ "iterations",	required_argument,	NULL,	'i' },
+		{ "threads",	required_argument,	NULL,	't' },
+		{ "help",	no_argument,		NULL,	'h' },
+		{ NULL,		0,			NULL,	0 },
+	};
+	unsigned int	k = 0, p = 0;
+	uint64_t	cell_bytes = 64 << 10;
+	uint64_t	size = 64 << 20;
+	unsigned int	iters = 10;
+	unsigned int	thread_nr = 0;
+	char		threads[16];
+	unsigned int	i;
+	int		c, rc;
+
+	while ((c = getopt_long(argc, argv, "k:p:c:s:i:t:h", long_ops,
+				NULL)) != -1) {
+		switch (c) {
+		case 'k':
+			k = atoi(optarg);
+			break;
+		case 'p':
+			p = atoi(optarg);
+			break;
+		case 'c':
+			cell_bytes = strtoull(optarg, NULL, 0) << 10;
+			break;
+		case 's':
+			size = strtoull(optarg, NULL, 0) << 20;
+			break;
+		case 'i':
+			iters = atoi(optarg);
+			break;
+		case 't':
+			thread_nr = atoi(optarg);
+			break;
+		default:
+			print_usage(argv[0]);
+			return c == 'h' ? 0 : -1;
+		}
+	}
+
+	if ((k == 0) != (p == 0) || k > OBJ_EC_MAX_K || p > OBJ_EC_MAX_P ||
+	    p > k || cell_bytes == 0 || iters == 0) {
+		print_usage(argv[0]);
+		return -1;
+	}
+
+	rc = daos_debug_init(DAOS_LOG_DEFAULT);
+	if (rc)
+		return rc;
+
+	/* the pool reads its tunables from the environment */
+	snprintf(threads, sizeof(threads), "%u", thread_nr);
+	setenv("DAOS_EC_ENCODE_THREADS", threads, 1);
+	rc = obj_ec_encode_pool_init();
+	if (rc)
+		goto out;
+
+	D_PRINT("%-6s %8s %8s %10s %10s\n", "k+p", "cell(KiB)", "stripes",
+		"GB/s", "GB/s/core");
+	if (k != 0) {
+		rc = ec_bench_run(k, p, cell_bytes, size, iters, thread_nr);
+	} else {
+		for (i = 0; i < ARRAY_SIZE(ec_layouts) && rc == 0; i++)
+			rc = ec_bench_run(ec_layouts[i].k, ec_layouts[i].p,
+					  cell_bytes, size, iters, thread_nr);
+	}
+	if (rc)
+		D_PRINT("EC encoding benchmark failed: "DF_RC"\n", DP_RC(rc));
+
+	obj_ec_encode_pool_fini();
+out:
+	daos_debug_fini();
+	return rc;
+}
@@ -1493,6 +1493,137 @@ static const struct CMUnitTest sv_tests[] = {
 	   update_fetch_sv),
 };
 
+/**
+ * ----------------------------------------------------------------------------
+ * Verify on fetch and scrubbing budget
+ * ----------------------------------------------------------------------------
+ */
+static void
+fetch_sampling_rate(void **state)
+{
+	unsigned int	cnt = 0;
+	int		sampled;
+	int		i;
+
+	/** 0 never samples */
+	for (i = 0, sampled = 0; i < 100; i++)
+		sampled += ds_csum_sample(&cnt, 0);
+	assert_int_equal(0, sampled);
+
+	/** 1 samples every call */
+	for (i = 0, sampled = 0; i < 100; i++)
+		sampled += ds_csum_sample(&cnt, 1);
+	assert_int_equal(100, sampled);
+
+	/** N samples every Nth call */
+	cnt = 0;
+	for (i = 1, sampled = 0; i <= 100; i++) {
+		bool s = ds_csum_sample(&cnt, 4);
+
+		assert_int_equal(i % 4 == 0, s);
+		sampled += s;
+	}
+	assert_int_equal(25, sampled);
+}
+
+static void
+fetch_verify_detects_corruption(void **state)
+{
+	struct daos_csummer	*csummer;
+	struct dcs_iod_csums	*iod_csums = NULL;
+	struct bio_sglist	 bsgl;
+	struct bio_iov		*biov;
+	daos_recx_t		 recx = { .rx_idx = 0, .rx_nr = 16 };
+	daos_iod_t		 iod = {0};
+	d_sg_list_t		 sgl;
+	bio_addr_t		 addr = {0};
+	char			 data[] = "0123456789abcdef";
+	size_t			 used;
+
+	assert_success(daos_csummer_init_with_type(&csummer, HASH_TYPE_CRC32,
+						   4, true));
+
+	iod.iod_type = DAOS_IOD_ARRAY;
+	iod.iod_size = 1;
+	iod.iod_nr = 1;
+	iod.iod_recxs = &recx;
+
+	/** stored checksums of the data, 4 chunks */
+	assert_success(d_sgl_init(&sgl, 1));
+	d_iov_set(&sgl.sg_iovs[0], data, recx.rx_nr);
+	assert_success(daos_csummer_calc_iods(csummer, &sgl, &iod, NULL, 1,
+					      false, NULL, -1, &iod_csums));
+	assert_int_equal(4, iod_csums->ic_data[0].cs_nr);
+
+	/** data fetched from VOS */
+	bio_sgl_init(&bsgl, 1);
+	bsgl.bs_nr_out = 1;
+	biov = &bsgl.bs_iovs[0];
+	bio_iov_set(biov, addr, recx.rx_nr);
+	D_ALLOC(biov->bi_buf, recx.rx_nr);
+	assert_non_null(biov->bi_buf);
+	memcpy(biov->bi_buf, data, recx.rx_nr);
+
+	assert_success(ds_csum_verify_fetch(&iod, csummer, &bsgl,
+					    iod_csums->ic_data, &used));
+	assert_int_equal(1, used);
+
+	/** corrupt the third chunk */
+	((char *)biov->bi_buf)[9] ^= 0x1;
+	assert_int_equal(-DER_CSUM,
+			 ds_csum_verify_fetch(&iod, csummer, &bsgl,
+					      iod_csums->ic_data, &used));
+
+	/** a hole has nothing to verify */
+	biov->bi_addr.ba_hole = true;
+	assert_success(ds_csum_verify_fetch(&iod, csummer, &bsgl,
+					    iod_csums->ic_data, &used));
+	assert_int_equal(0, used);
+	biov->bi_addr.ba_hole = false;
+
+	D_FREE(biov->bi_buf);
+	bio_sgl_fini(&bsgl);
+	d_sgl_fini(&sgl, false);
+	daos_csummer_free_ic(csummer, &iod_csums);
+	daos_csummer_destroy(&csummer);
+}
+
+static void
+scrub_budget_throttling(void **state)
+{
+	/** no budget, never waits */
+	assert_int_equal(0, ds_csum_budget_wait(0, 1 << 30, 0, 1 << 20, 0));
+
+	/** 1 MB at 1 MB/s takes a second */
+	assert_int_equal(1000, ds_csum_budget_wait(0, 1 << 20, 1 << 20,
+						   0, 0));
+	assert_int_equal(600, ds_csum_budget_wait(400, 1 << 20, 1 << 20,
+						  0, 0));
+	/** behind the budget, no wait */
+	assert_int_equal(0, ds_csum_budget_wait(1000, 1 << 20, 1 << 20,
+						0, 0));
+	assert_int_equal(0, ds_csum_budget_wait(5000, 1 << 20, 1 << 20,
+						0, 0));
+
+	/** the most restrictive budget wins */
+	assert_int_equal(2000, ds_csum_budget_wait(0, 1 << 20, 1 << 20,
+						   200, 100));
+	assert_int_equal(1500, ds_csum_budget_wait(500, 1 << 20, 1 << 20,
+						   200, 100));
+	assert_int_equal(1000, ds_csum_budget_wait(0, 1 << 20, 1 << 20,
+						   10, 100));
+}
+
+#define	TV(desc, test_fn) \
+	{ "SRV_CSUM_VERIFY" desc, test_fn, sct_setup, sct_teardown }
+
+static const struct CMUnitTest verify_tests[] = {
+	TV("01: Sampling rate of the fetches verified", fetch_sampling_rate),
+	TV("02: Corrupted chunk is detected on fetch",
+	   fetch_verify_detects_corruption),
+	TV("03: Scrubbing waits for its budgets", scrub_budget_throttling),
+};
+
 /** in srv_scrubbing_tests.c */
 extern int run_scrubbing_tests(void);
 
@@ -1517,5 +1648,9 @@ main(int argc, char **argv)
 		"Storage and retrieval of checksums for Single Value Type",
 		sv_tests, NULL, NULL);
 
+	rc += cmocka_run_group_tests_name(
+		"Verification of checksums on fetch and scrubbing",
+		verify_tests, NULL, NULL);
+
 	return rc;
 }
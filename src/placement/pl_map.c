@@ -12,6 +12,7 @@
 
 #include "pl_map.h"
 #include <gurt/hash.h>
+#include <daos/lru.h>
 
 extern struct pl_map_ops        ring_map_ops;
 extern struct pl_map_ops        jump_map_ops;
@@ -683,6 +684,250 @@ pl_select_leader(daos_obj_id_t oid, uint32_t grp_idx, uint32_t grp_size,
 	return -DER_IO;
 }
 
+/**
+ * Cache of computed object layouts.
+ *
+ * Opening an object computes its layout from the placement map, which is
+ * relatively expensive for short-lived opens of many objects. The cache keeps
+ * the layouts keyed by every input of pl_obj_place(), (oid, object version,
+ * placement map version), so that re-opening the same object with the same
+ * inputs only copies the cached layout. All cached layouts of older versions
+ * are evicted once a newer version of the placement map is seen.
+ */
+struct pl_layout_cache {
+	pthread_mutex_t			 plc_lock;
+	struct daos_lru_cache		*plc_lru;
+	/* the latest placement map version seen by the cache */
+	uint32_t			 plc_ver;
+	struct pl_layout_cache_stats	 plc_stats;
+};
+
+struct pl_layout_key {
+	daos_obj_id_t		plk_oid;
+	/* placement map version */
+	uint32_t		plk_ver;
+	/* object version, selects the spare targets, see omd_ver */
+	uint32_t		plk_omd_ver;
+};
+
+struct pl_layout_rec {
+	struct daos_llink	 plr_llink;
+	struct pl_layout_key	 plr_key;
+	struct pl_obj_layout	*plr_layout;
+};
+
+struct pl_layout_create_args {
+	struct pl_map		*pca_map;
+	struct daos_obj_md	*pca_md;
+};
+
+static inline struct pl_layout_rec *
+pl_llink2rec(struct daos_llink *llink)
+{
+	return container_of(llink, struct pl_layout_rec, plr_llink);
+}
+
+static int
+pl_layout_lop_alloc(void *key, unsigned int ksize, void *args,
+		    struct daos_llink **llink_p)
+{
+	struct pl_layout_create_args	*pca = args;
+	struct pl_layout_rec		*rec;
+	int				 rc;
+
+	D_ALLOC_PTR(rec);
+	if (rec == NULL)
+		return -DER_NOMEM;
+
+	rc = pl_obj_place(pca->pca_map, pca->pca_md, NULL, &rec->plr_layout);
+	if (rc != 0) {
+		D_FREE(rec);
+		return rc;
+	}
+
+	rec->plr_key = *(struct pl_layout_key *)key;
+	*llink_p = &rec->plr_llink;
+
+	return 0;
+}
+
+static void
+pl_layout_lop_free(struct daos_llink *llink)
+{
+	struct pl_layout_rec	*rec = pl_llink2rec(llink);
+
+	pl_obj_layout_free(rec->plr_layout);
+	D_FREE(rec);
+}
+
+static bool
+pl_layout_lop_cmp_keys(const void *key, unsigned int ksize,
+		       struct daos_llink *llink)
+{
+	struct pl_layout_rec	*rec = pl_llink2rec(llink);
+
+	D_ASSERT(ksize == sizeof(struct pl_layout_key));
+	return memcmp(key, &rec->plr_key, ksize) == 0;
+}
+
+static uint32_t
+pl_layout_lop_rec_hash(struct daos_llink *llink)
+{
+	struct pl_layout_rec	*rec = pl_llink2rec(llink);
+
+	return d_hash_string_u32((const char *)&rec->plr_key,
+				 sizeof(rec->plr_key));
+}
+
+static struct daos_llink_ops pl_layout_lru_ops = {
+	.lop_alloc_ref	= pl_layout_lop_alloc,
+	.lop_free_ref	= pl_layout_lop_free,
+	.lop_cmp_keys	= pl_layout_lop_cmp_keys,
+	.lop_rec_hash	= pl_layout_lop_rec_hash,
+};
+
+/**
+ * Create a layout cache which can hold up to power2(\a bits) layouts.
+ */
+int
+pl_layout_cache_create(int bits, struct pl_layout_cache **cache_p)
+{
+	struct pl_layout_cache	*cache;
+	int			 rc;
+
+	D_ALLOC_PTR(cache);
+	if (cache == NULL)
+		return -DER_NOMEM;
+
+	rc = D_MUTEX_INIT(&cache->plc_lock, NULL);
+	if (rc != 0)
+		D_GOTO(out, rc);
+
+	rc = daos_lru_cache_create(bits, D_HASH_FT_NOLOCK, &pl_layout_lru_ops,
+				   &cache->plc_lru);
+	if (rc != 0) {
+		D_MUTEX_DESTROY(&cache->plc_lock);
+		D_GOTO(out, rc);
+	}
+
+	*cache_p = cache;
+	return 0;
+out:
+	D_FREE(cache);
+	return rc;
+}
+
+void
+pl_layout_cache_destroy(struct pl_layout_cache *cache)
+{
+	if (cache == NULL)
+		return;
+
+	D_DEBUG(DB_PL, "layout cache %p: hits "DF_U64", misses "DF_U64
+		", evicts "DF_U64"\n", cache, cache->plc_stats.lcs_hits,
+		cache->plc_stats.lcs_misses, cache->plc_stats.lcs_evicts);
+
+	daos_lru_cache_destroy(cache->plc_lru);
+	D_MUTEX_DESTROY(&cache->plc_lock);
+	D_FREE(cache);
+}
+
+static bool
+pl_layout_stale_cond(struct daos_llink *llink, void *arg)
+{
+	uint32_t	ver = *(uint32_t *)arg;
+
+	return pl_llink2rec(llink)->plr_key.plk_ver < ver;
+}
+
+static int
+pl_layout_dup(struct pl_obj_layout *src, struct pl_obj_layout **layout_pp)
+{
+	struct pl_obj_layout	*layout;
+	int			 rc;
+
+	rc = pl_obj_layout_alloc(src->ol_grp_size, src->ol_grp_nr, &layout);
+	if (rc != 0)
+		return rc;
+
+	layout->ol_ver = src->ol_ver;
+	memcpy(layout->ol_shards, src->ol_shards,
+	       sizeof(*src->ol_shards) * src->ol_nr);
+	*layout_pp = layout;
+
+	return 0;
+}
+
+/**
+ * Same as pl_obj_place() without shard metadata, but return a copy of the
+ * cached layout if the object has been placed with the same object version and
+ * the same version of the placement map. The returned layout should be freed
+ * by pl_obj_layout_free().
+ */
+int
+pl_obj_place_cached(struct pl_layout_cache *cache, struct pl_map *map,
+		    struct daos_obj_md *md, struct pl_obj_layout **layout_pp)
+{
+	struct pl_layout_create_args	 pca;
+	struct pl_layout_key		 key = { 0 };
+	struct daos_llink		*llink;
+	uint32_t			 count;
+	int				 rc;
+
+	if (cache == NULL)
+		return pl_obj_place(map, md, NULL, layout_pp);
+
+	key.plk_oid = md->omd_id;
+	key.plk_ver = pl_map_version(map);
+	key.plk_omd_ver = md->omd_ver;
+
+	D_MUTEX_LOCK(&cache->plc_lock);
+	if (key.plk_ver < cache->plc_ver) {
+		/* stale placement map, do not pollute the cache */
+		cache->plc_stats.lcs_misses++;
+		D_MUTEX_UNLOCK(&cache->plc_lock);
+		return pl_obj_place(map, md, NULL, layout_pp);
+	}
+
+	if (key.plk_ver > cache->plc_ver) {
+		count = cache->plc_lru->dlc_count;
+		daos_lru_cache_evict(cache->plc_lru, pl_layout_stale_cond,
+				     &key.plk_ver);
+		cache->plc_stats.lcs_evicts += count -
+					       cache->plc_lru->dlc_count;
+		cache->plc_ver = key.plk_ver;
+	}
+
+	rc = daos_lru_ref_hold(cache->plc_lru, &key, sizeof(key), NULL,
+			       &llink);
+	if (rc == 0) {
+		cache->plc_stats.lcs_hits++;
+	} else if (rc == -DER_NONEXIST) {
+		cache->plc_stats.lcs_misses++;
+		pca.pca_map = map;
+		pca.pca_md = md;
+		rc = daos_lru_ref_hold(cache->plc_lru, &key, sizeof(key), &pca,
+				       &llink);
+	}
+	if (rc != 0)
+		goto out;
+
+	rc = pl_layout_dup(pl_llink2rec(llink)->plr_layout, layout_pp);
+	daos_lru_ref_release(cache->plc_lru, llink);
+out:
+	D_MUTEX_UNLOCK(&cache->plc_lock);
+	return rc;
+}
+
+void
+pl_layout_cache_stats_get(struct pl_layout_cache *cache,
+			  struct pl_layout_cache_stats *stats)
+{
+	D_MUTEX_LOCK(&cache->plc_lock);
+	*stats = cache->plc_stats;
+	D_MUTEX_UNLOCK(&cache->plc_lock);
+}
+
 #define PL_HTABLE_BITS 7
 
 /** Initialize the placement module. */
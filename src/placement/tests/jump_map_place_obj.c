@@ -1688,6 +1688,108 @@ placement_test_teardown(void **state)
 #define T(dsc, test) { "PLACEMENT "STR(__COUNTER__)" ("#test"): " dsc, test, \
 			  placement_test_setup, placement_test_teardown }
 
+static void
+layout_cache_hit_and_invalidate(void **state)
+{
+	struct jm_test_ctx		 ctx;
+	struct pl_layout_cache		*cache;
+	struct pl_layout_cache_stats	 stats;
+	struct pl_obj_layout		*layout;
+	struct daos_obj_md		 md = { 0 };
+
+	jtc_init_with_layout(&ctx, 4, 1, 4, OC_RP_2G2, g_verbose);
+	assert_success(pl_layout_cache_create(4, &cache));
+
+	md.omd_id = ctx.oid;
+	md.omd_ver = ctx.ver;
+
+	/* First lookup computes the layout, second one hits the cache */
+	assert_success(pl_obj_place_cached(cache, ctx.pl_map, &md, &layout));
+	assert_true(plt_obj_layout_match(ctx.layout, layout));
+	pl_obj_layout_free(layout);
+	assert_success(pl_obj_place_cached(cache, ctx.pl_map, &md, &layout));
+	assert_true(plt_obj_layout_match(ctx.layout, layout));
+	pl_obj_layout_free(layout);
+
+	pl_layout_cache_stats_get(cache, &stats);
+	assert_int_equal(1, stats.lcs_hits);
+	assert_int_equal(1, stats.lcs_misses);
+	assert_int_equal(0, stats.lcs_evicts);
+
+	/* A newer pool map version drops the stale layout */
+	jtc_set_status_on_shard_target(&ctx, DOWN, 0);
+	assert_success(jtc_create_layout(&ctx));
+	md.omd_ver = ctx.ver;
+	assert_success(pl_obj_place_cached(cache, ctx.pl_map, &md, &layout));
+	assert_true(plt_obj_layout_match(ctx.layout, layout));
+	pl_obj_layout_free(layout);
+
+	pl_layout_cache_stats_get(cache, &stats);
+	assert_int_equal(1, stats.lcs_hits);
+	assert_int_equal(2, stats.lcs_misses);
+	assert_int_equal(1, stats.lcs_evicts);
+
+	pl_layout_cache_destroy(cache);
+	jtc_fini(&ctx);
+}
+
+static void
+layout_cache_obj_version(void **state)
+{
+	struct jm_test_ctx		 ctx;
+	struct pl_layout_cache		*cache;
+	struct pl_layout_cache_stats	 stats;
+	struct pl_obj_layout		*layout;
+	struct pl_obj_layout		*expected;
+	struct daos_obj_md		 md = { 0 };
+	uint32_t			 vers[2];
+	int				 i;
+
+	jtc_init_with_layout(&ctx, 4, 1, 4, OC_RP_2G2, g_verbose);
+	jtc_set_status_on_shard_target(&ctx, DOWN, 0);
+	assert_success(jtc_create_layout(&ctx));
+	assert_success(pl_layout_cache_create(4, &cache));
+
+	/*
+	 * The object version selects the spare targets, the layouts of two
+	 * versions under the same placement map are not shared.
+	 */
+	md.omd_id = ctx.oid;
+	vers[0] = ctx.ver;
+	vers[1] = 0;
+	for (i = 0; i < ARRAY_SIZE(vers); i++) {
+		md.omd_ver = vers[i];
+		assert_success(pl_obj_place(ctx.pl_map, &md, NULL, &expected));
+		assert_success(pl_obj_place_cached(cache, ctx.pl_map, &md,
+						   &layout));
+		assert_true(plt_obj_layout_match(expected, layout));
+		pl_obj_layout_free(layout);
+		pl_obj_layout_free(expected);
+	}
+
+	pl_layout_cache_stats_get(cache, &stats);
+	assert_int_equal(0, stats.lcs_hits);
+	assert_int_equal(2, stats.lcs_misses);
+
+	/* each version hits its own cached layout */
+	for (i = 0; i < ARRAY_SIZE(vers); i++) {
+		md.omd_ver = vers[i];
+		assert_success(pl_obj_place(ctx.pl_map, &md, NULL, &expected));
+		assert_success(pl_obj_place_cached(cache, ctx.pl_map, &md,
+						   &layout));
+		assert_true(plt_obj_layout_match(expected, layout));
+		pl_obj_layout_free(layout);
+		pl_obj_layout_free(expected);
+	}
+
+	pl_layout_cache_stats_get(cache, &stats);
+	assert_int_equal(2, stats.lcs_hits);
+	assert_int_equal(2, stats.lcs_misses);
+
+	pl_layout_cache_destroy(cache);
+	jtc_fini(&ctx);
+}
+
 static const struct CMUnitTest tests[] = {
 	/* Standard configurations */
 	T("Object class is verified appropriately", object_class_is_verified),
@@ -1738,6 +1840,11 @@ static const struct CMUnitTest tests[] = {
 	/* Non-standard system setups*/
 	T("Non-standard system configurations. All healthy",
 	  unbalanced_config),
+	/* Layout cache */
+	T("Cached layouts are reused and invalidated by a new map version",
+	  layout_cache_hit_and_invalidate),
+	T("Cached layouts are not shared by different object versions",
+	  layout_cache_obj_version),
 };
 
 int
@@ -8,6 +8,8 @@
 
 #include <daos_srv/vos.h>
 #include <daos_srv/srv_csum.h>
+#include <gurt/telemetry_common.h>
+#include <gurt/telemetry_producer.h>
 #include "srv_internal.h"
 
 #define C_TRACE(...) D_DEBUG(DB_CSUM, __VA_ARGS__)
@@ -25,6 +27,14 @@ struct scrub_ctx {
 	struct sched_request	*req;
 	/** Number of checksums scrubbed by a single scrubbing iteration */
 	daos_size_t		 pool_csums_scrubbed;
+	/** Number of bytes scrubbed by a single scrubbing iteration */
+	daos_size_t		 pool_bytes_scrubbed;
+	/** Number of checksums scrubbed by the previous iteration */
+	daos_size_t		 pool_csums_prev;
+	/** When the current iteration started, in nsec */
+	uint64_t		 pool_start_ns;
+	/** Buffer the data to scrub is read into */
+	d_iov_t			 buf;
 
 	/**
 	 * Container
@@ -35,12 +45,26 @@ struct scrub_ctx {
 	daos_size_t		 msec_between_calcs;
 	/** Target number of seconds to scrub entire pool */
 	daos_size_t		 interval_sec;
+	/** Upper bounds of the scrubbing rate, 0 for unbounded */
+	uint64_t		 bytes_per_sec;
+	uint64_t		 csums_per_sec;
+
+	/**
+	 * Telemetry
+	 **/
+	struct d_tm_node_t	*tm_csums;
+	struct d_tm_node_t	*tm_bytes;
+	struct d_tm_node_t	*tm_corruptions;
+	struct d_tm_node_t	*tm_progress;
+	struct d_tm_node_t	*tm_last_duration;
 };
 
 static void
 sc_reset(struct scrub_ctx *ctx)
 {
+	ctx->pool_csums_prev = ctx->pool_csums_scrubbed;
 	ctx->pool_csums_scrubbed = 0;
+	ctx->pool_bytes_scrubbed = 0;
 }
 
 /**
@@ -71,6 +95,157 @@ between_scrub_sec()
 	return sec != NULL ? atoll(sec) : 24 * 60 * 60;
 }
 
+static uint64_t
+scrub_bw()
+{
+	char *bw = getenv("DAOS_CSUM_SCRUB_BW");
+
+	return bw != NULL ? atoll(bw) : 0;
+}
+
+static uint64_t
+scrub_iops()
+{
+	char *iops = getenv("DAOS_CSUM_SCRUB_IOPS");
+
+	return iops != NULL ? atoll(iops) : 0;
+}
+
+/**
+ * Compare the checksums of the data in \a buf to the stored ones. Array
+ * values are verified chunk by chunk, a single value has one checksum.
+ **/
+static int
+scrub_verify(struct daos_csummer *csummer, vos_iter_type_t type,
+	     vos_iter_entry_t *entry, uint8_t *buf)
+{
+	uint16_t		csum_len = daos_csummer_get_csum_len(csummer);
+	struct dcs_csum_info	*ci = &entry->ie_csum;
+	struct daos_csum_range	chunk;
+	uint8_t			csum[csum_len];
+	uint8_t			*stored;
+	uint64_t		rec_len = entry->ie_rsize;
+	uint32_t		chunksize;
+	uint64_t		nr;
+	uint64_t		i;
+
+	if (type == VOS_ITER_SINGLE) {
+		chunk.dcr_lo = 0;
+		chunk.dcr_nr = 1;
+		chunksize = rec_len;
+		nr = 1;
+	} else {
+		chunksize = daos_csummer_get_rec_chunksize(csummer, rec_len);
+		nr = daos_recx_calc_chunks(entry->ie_recx, rec_len, chunksize);
+	}
+
+	for (i = 0; i < nr; i++) {
+		stored = ci_idx2csum(ci, i);
+		if (stored == NULL)
+			break;
+
+		if (type == VOS_ITER_RECX)
+			chunk = csum_recx_chunkidx2range(&entry->ie_recx,
+							 rec_len, chunksize,
+							 i);
+		memset(csum, 0, csum_len);
+		daos_csummer_set_buffer(csummer, csum, csum_len);
+		daos_csummer_reset(csummer);
+		daos_csummer_update(csummer,
+				    buf + (chunk.dcr_lo -
+					   entry->ie_recx.rx_idx) * rec_len,
+				    chunk.dcr_nr * rec_len);
+		daos_csummer_finish(csummer);
+
+		if (!daos_csummer_csum_compare(csummer, csum, stored,
+					       csum_len)) {
+			D_ERROR("Chunk "DF_U64" corrupted. Calculated "
+				"("DF_CI_BUF") != Stored ("DF_CI_BUF")\n", i,
+				DP_CI_BUF(csum, csum_len),
+				DP_CI_BUF(stored, csum_len));
+			return -DER_CSUM;
+		}
+	}
+
+	return 0;
+}
+
+/** Read the data of the entry and verify it against its checksums */
+static int
+scrub_entry(struct scrub_ctx *ctx, daos_handle_t ih, vos_iter_entry_t *entry,
+	    vos_iter_type_t type, vos_iter_param_t *param)
+{
+	struct daos_csummer	*csummer = ctx->cur_cont->sc_csummer;
+	daos_size_t		 len = bio_iov2len(&entry->ie_biov);
+	void			*buf;
+	int			 rc;
+
+	/* Holes and partially visible extents have no checksum of their own */
+	if (bio_addr_is_hole(&entry->ie_biov.bi_addr) ||
+	    !ci_is_valid(&entry->ie_csum) || len == 0)
+		return 0;
+	if (type == VOS_ITER_RECX &&
+	    (entry->ie_recx.rx_idx != entry->ie_orig_recx.rx_idx ||
+	     entry->ie_recx.rx_nr != entry->ie_orig_recx.rx_nr))
+		return 0;
+	/* Single value sharded by EC, the checksum is of the whole value */
+	if (type == VOS_ITER_SINGLE && entry->ie_gsize != entry->ie_rsize)
+		return 0;
+
+	if (ctx->buf.iov_buf_len < len) {
+		D_REALLOC(buf, ctx->buf.iov_buf, len);
+		if (buf == NULL)
+			return -DER_NOMEM;
+		d_iov_set(&ctx->buf, buf, len);
+	}
+
+	rc = vos_iter_copy(ih, entry, &ctx->buf);
+	if (rc != 0) {
+		D_ERROR("Reading "DF_RECX" of "DF_UOID" failed: "DF_RC"\n",
+			DP_RECX(entry->ie_recx), DP_UOID(param->ip_oid),
+			DP_RC(rc));
+		return rc;
+	}
+
+	rc = scrub_verify(csummer, type, entry, ctx->buf.iov_buf);
+	if (rc == -DER_CSUM) {
+		D_ERROR("["DF_UUIDF"] Corruption found in cont "DF_UUIDF
+			", obj "DF_UOID", akey "DF_KEY", extent "DF_RECX
+			", epoch "DF_X64"\n", DP_UUID(ctx->pool_uuid),
+			DP_UUID(ctx->cur_cont->sc_uuid),
+			DP_UOID(param->ip_oid), DP_KEY(&param->ip_akey),
+			DP_RECX(entry->ie_recx), entry->ie_epoch);
+		d_tm_increment_counter(&ctx->tm_corruptions, NULL);
+	} else if (rc != 0) {
+		return rc;
+	}
+
+	ctx->pool_csums_scrubbed++;
+	ctx->pool_bytes_scrubbed += len;
+	d_tm_increment_counter(&ctx->tm_csums, NULL);
+	d_tm_set_gauge(&ctx->tm_bytes, ctx->pool_bytes_scrubbed, NULL);
+	if (ctx->pool_csums_prev != 0)
+		d_tm_set_gauge(&ctx->tm_progress,
+			       min(100, ctx->pool_csums_scrubbed * 100 /
+					ctx->pool_csums_prev), NULL);
+	return 0;
+}
+
+/**
+ * Number of msec the scrubber is ahead of its bandwidth and checksums per
+ * second budgets.
+ **/
+static uint64_t
+scrub_budget_wait(struct scrub_ctx *ctx)
+{
+	uint64_t	elapsed;
+
+	elapsed = (daos_getntime_coarse() - ctx->pool_start_ns) / NSEC_PER_MSEC;
+	return ds_csum_budget_wait(elapsed, ctx->pool_bytes_scrubbed,
+				   ctx->bytes_per_sec, ctx->pool_csums_scrubbed,
+				   ctx->csums_per_sec);
+}
+
 /** vos_iter_cb_t */
 static int
 obj_iter_scrub_cb(daos_handle_t ih, vos_iter_entry_t *entry,
@@ -79,6 +254,8 @@ obj_iter_scrub_cb(daos_handle_t ih, vos_iter_entry_t *entry,
 {
 	struct scrub_ctx	*ctx = cb_arg;
 	struct daos_csummer	*csummer = ctx->cur_cont->sc_csummer;
+	uint64_t		 msec;
+	int			 rc;
 
 	if (!(type == VOS_ITER_RECX || type == VOS_ITER_SINGLE))
 		return 0;
@@ -92,19 +269,18 @@ obj_iter_scrub_cb(daos_handle_t ih, vos_iter_entry_t *entry,
 		daos_csummer_get_csum_len(csummer)
 	);
 
-	/** TODO - implement the actual scrubbing of the checksum by fetching
-	 * the data, calculating a new checksum, and comparing to the stored
-	 * checksum.
-	 */
-	ctx->pool_csums_scrubbed++;
+	rc = scrub_entry(ctx, ih, entry, type, param);
+	if (rc != 0)
+		return rc;
 
-	if (ctx->msec_between_calcs == 0) {
+	msec = max(ctx->msec_between_calcs, scrub_budget_wait(ctx));
+	if (msec == 0) {
 		C_TRACE("Yield after data scrub\n");
 		dss_ult_yield(ctx->req);
 	} else {
 		C_TRACE("Sleeping after data scrub for "DF_U64" msec\n",
-			ctx->msec_between_calcs);
-		sched_req_sleep(ctx->req, ctx->msec_between_calcs);
+			msec);
+		sched_req_sleep(ctx->req, msec);
 	}
 
 	return 0;
@@ -210,6 +386,26 @@ scrub_pool(struct scrub_ctx *ctx)
 	return rc;
 }
 
+static void
+sc_metric_init(struct scrub_ctx *ctx, struct d_tm_node_t **node, char *name,
+	       int type, char *desc, char *units)
+{
+	char	*path;
+	int	 rc;
+
+	D_ASPRINTF(path, "pool/"DF_UUIDF"/scrubber/%u/%s",
+		   DP_UUID(ctx->pool_uuid), dss_get_module_info()->dmi_tgt_id,
+		   name);
+	if (path == NULL)
+		return;
+
+	rc = d_tm_add_metric(node, path, type, desc, units);
+	if (rc != 0)
+		D_WARN("Failed to create metric %s: "DF_RC"\n", path,
+		       DP_RC(rc));
+	D_FREE(path);
+}
+
 static void
 sc_init(struct scrub_ctx *ctx, struct ds_pool_child *child)
 {
@@ -217,6 +413,26 @@ sc_init(struct scrub_ctx *ctx, struct ds_pool_child *child)
 	ctx->req = child->spc_scrubbing_req;
 	ctx->pool_hdl = child->spc_hdl;
 	ctx->interval_sec = interval_sec();
+	ctx->bytes_per_sec = scrub_bw();
+	ctx->csums_per_sec = scrub_iops();
+
+	sc_metric_init(ctx, &ctx->tm_csums, "csums_scrubbed", D_TM_COUNTER,
+		       "checksums scrubbed", "csums");
+	sc_metric_init(ctx, &ctx->tm_bytes, "bytes_scrubbed", D_TM_GAUGE,
+		       "bytes scrubbed by the current pass", "bytes");
+	sc_metric_init(ctx, &ctx->tm_corruptions, "corruptions", D_TM_COUNTER,
+		       "corrupted checksums found", "csums");
+	sc_metric_init(ctx, &ctx->tm_progress, "progress", D_TM_GAUGE,
+		       "progress of the current pass over the previous one",
+		       "%");
+	sc_metric_init(ctx, &ctx->tm_last_duration, "last_duration",
+		       D_TM_GAUGE, "duration of the last pass", "s");
+}
+
+static void
+sc_fini(struct scrub_ctx *ctx)
+{
+	D_FREE(ctx->buf.iov_buf);
 }
 
 /** Setup scrubbing context and start scrubbing the pool */
@@ -244,10 +460,14 @@ scrubbing_ult(void *arg)
 		C_TRACE("["DF_UUIDF"] Pool scrubbing started.\n",
 			DP_UUID(ctx.pool_uuid));
 		d_gettime(&start);
+		ctx.pool_start_ns = daos_getntime_coarse();
 		scrub_pool(&ctx);
 		d_gettime(&end);
 		struct timespec diff = d_timediff(start, end);
 
+		d_tm_set_gauge(&ctx.tm_last_duration, diff.tv_sec, NULL);
+		d_tm_set_gauge(&ctx.tm_progress, 100, NULL);
+
 		C_TRACE("["DF_UUIDF"] Pool scrubbing finished.\n"
 				"\tChecksums Scrubbed:\t"DF_U64" csums\n"
 				"\tTime Spent sec:\t"DF_U64"\n"
@@ -262,6 +482,8 @@ scrubbing_ult(void *arg)
 		sched_req_sleep(child->spc_scrubbing_req,
 				sleep_sec * MSEC_IN_SEC);
 	}
+
+	sc_fini(&ctx);
 }
 
 /** Setup and create the scrubbing ult */
@@ -297,8 +519,8 @@ ds_start_scrubbing_ult(struct ds_pool_child *child)
 
 	D_ASSERT(thread != ABT_THREAD_NULL);
 
+	/* No SCHED_REQ_FL_NO_DELAY, the scrubber yields to foreground IO */
 	sched_req_attr_init(&attr, SCHED_REQ_SCRUB, &child->spc_uuid);
-	attr.sra_flags = SCHED_REQ_FL_NO_DELAY;
 	child->spc_scrubbing_req = sched_req_get(&attr, thread);
 	if (child->spc_scrubbing_req == NULL) {
 		D_CRIT(DF_UUID"[%d]: Failed to get req for Scrubbing ULT\n",
@@ -26,6 +26,8 @@
 
 #include <daos_srv/pool.h>
 
+#include <gurt/telemetry_common.h>
+#include <gurt/telemetry_producer.h>
 #include <daos/pool_map.h>
 #include <daos/rpc.h>
 #include <daos/pool.h>
@@ -70,11 +72,53 @@ ds_pool_child_put(struct ds_pool_child *child)
 			DP_UUID(child->spc_uuid));
 		D_ASSERT(d_list_empty(&child->spc_list));
 		D_ASSERT(d_list_empty(&child->spc_cont_list));
+		if (child->spc_scm_bulk != CRT_BULK_NULL)
+			crt_bulk_free(child->spc_scm_bulk);
 		vos_pool_close(child->spc_hdl);
 		D_FREE(child);
 	}
 }
 
+/**
+ * Get the bulk handle covering the whole SCM mapping of the pool on current
+ * xstream, the mapping is registered on first call and stays registered until
+ * the pool child is destroyed.
+ */
+int
+ds_pool_child_scm_bulk(struct ds_pool_child *child, crt_bulk_t *bulk,
+		       d_iov_t *window)
+{
+	d_sg_list_t	sgl;
+	int		rc;
+
+	if (child->spc_scm_bulk == CRT_BULK_NULL) {
+		rc = vos_pool_scm_window(child->spc_hdl,
+					 &child->spc_scm_window);
+		if (rc)
+			return rc;
+
+		sgl.sg_nr = 1;
+		sgl.sg_nr_out = 1;
+		sgl.sg_iovs = &child->spc_scm_window;
+		rc = crt_bulk_create(dss_get_module_info()->dmi_ctx, &sgl,
+				     CRT_BULK_RO, &child->spc_scm_bulk);
+		if (rc) {
+			D_ERROR(DF_UUID": failed to register SCM window: "
+				DF_RC"\n", DP_UUID(child->spc_uuid), DP_RC(rc));
+			child->spc_scm_bulk = CRT_BULK_NULL;
+			return rc;
+		}
+		D_DEBUG(DF_DSMS, DF_UUID": registered SCM window %p/%zu\n",
+			DP_UUID(child->spc_uuid),
+			child->spc_scm_window.iov_buf,
+			child->spc_scm_window.iov_len);
+	}
+
+	*bulk = child->spc_scm_bulk;
+	*window = child->spc_scm_window;
+	return 0;
+}
+
 static void
 gc_ult(void *arg)
 {
@@ -241,6 +285,30 @@ pool_child_add_one(void *varg)
  * thread. If nobody else is referencing this object, then its VOS pool handle
  * is closed and the object itself is freed.
  */
+/** Remove the dedup gauges published by obj_dedup_stats_update() */
+static void
+pool_child_metrics_fini(struct ds_pool_child *child)
+{
+	char	*path;
+	int	 rc;
+
+	if (child->spc_dedup_ratio == NULL)
+		return;
+
+	D_ASPRINTF(path, "io/%u/dedup/"DF_UUIDF,
+		   dss_get_module_info()->dmi_tgt_id, DP_UUID(child->spc_uuid));
+	if (path == NULL)
+		return;
+
+	rc = d_tm_del_metric(path);
+	if (rc != 0 && rc != -DER_UNINIT && rc != -DER_METRIC_NOT_FOUND)
+		D_WARN("Failed to remove dedup sensors %s: "DF_RC"\n", path,
+		       DP_RC(rc));
+	D_FREE(path);
+	child->spc_dedup_ratio = NULL;
+	child->spc_dedup_index = NULL;
+}
+
 static int
 pool_child_delete_one(void *uuid)
 {
@@ -254,6 +322,7 @@ pool_child_delete_one(void *uuid)
 	ds_cont_child_stop_all(child);
 	stop_gc_ult(child);
 	ds_stop_scrubbing_ult(child);
+	pool_child_metrics_fini(child);
 	ds_pool_child_put(child); /* -1 for the list */
 
 	ds_pool_child_put(child); /* -1 for lookup */
@@ -1091,6 +1160,60 @@ ds_pool_tgt_disconnect_aggregator(crt_rpc_t *source, crt_rpc_t *result,
 	return 0;
 }
 
+/*
+ * Set the fault domain of each rank of the pool group, i.e. the domain right
+ * under the root of the pool map, for the topology aware broadcasts.
+ */
+static int
+update_pool_group_domains(struct ds_pool *pool, struct pool_map *map,
+			  d_rank_list_t *ranks)
+{
+	struct pool_domain	*root;
+	struct pool_domain	*doms;
+	struct pool_domain	*node;
+	uint32_t		*domains;
+	int			 ndoms;
+	int			 i;
+	int			 j;
+	int			 rc;
+
+	rc = pool_map_find_domain(map, PO_COMP_TP_ROOT, PO_COMP_ID_ALL, &root);
+	if (rc != 1 || root->do_child_nr == 0)
+		return crt_group_domains_set(pool->sp_group, NULL, NULL);
+
+	/* nodes right under the root, no fault domain to follow */
+	doms = root->do_children;
+	if (doms[0].do_comp.co_type == PO_COMP_TP_NODE)
+		return crt_group_domains_set(pool->sp_group, NULL, NULL);
+
+	ndoms = pool_map_find_domain(map, doms[0].do_comp.co_type,
+				     PO_COMP_ID_ALL, &doms);
+	D_ALLOC_ARRAY(domains, ranks->rl_nr);
+	if (domains == NULL)
+		return -DER_NOMEM;
+
+	/* the targets of a domain are contiguous, find the one of the node */
+	for (i = 0; i < ranks->rl_nr; i++) {
+		domains[i] = CRT_NO_DOMAIN;
+		node = pool_map_find_node_by_rank(map, ranks->rl_ranks[i]);
+		if (node == NULL || node->do_target_nr == 0)
+			continue;
+
+		for (j = 0; j < ndoms; j++) {
+			if (node->do_targets >= doms[j].do_targets &&
+			    node->do_targets < doms[j].do_targets +
+					       doms[j].do_target_nr) {
+				domains[i] = doms[j].do_comp.co_id;
+				break;
+			}
+		}
+	}
+
+	rc = crt_group_domains_set(pool->sp_group, ranks, domains);
+	D_FREE(domains);
+	return rc;
+}
+
 static int
 update_pool_group(struct ds_pool *pool, struct pool_map *map)
 {
@@ -1107,6 +1230,18 @@ update_pool_group(struct ds_pool *pool, struct pool_map *map)
 	if (rc != 0)
 		return rc;
 
+	/*
+	 * The domains are set first, so that the group is left as it was if
+	 * they fail. Domains of ranks not in the group are not used, and a
+	 * member without one is in no domain.
+	 */
+	rc = update_pool_group_domains(pool, map, &ranks);
+	if (rc != 0) {
+		D_ERROR(DF_UUID": failed to update group domains: "DF_RC"\n",
+			DP_UUID(pool->sp_uuid), DP_RC(rc));
+		D_GOTO(out, rc);
+	}
+
 	/* Let secondary rank == primary rank. */
 	rc = crt_group_secondary_modify(pool->sp_group, &ranks, &ranks,
 					CRT_GROUP_MOD_OP_REPLACE,
@@ -1120,6 +1255,7 @@ update_pool_group(struct ds_pool *pool, struct pool_map *map)
 				DP_UUID(pool->sp_uuid), rc);
 	}
 
+out:
 	map_ranks_fini(&ranks);
 	return rc;
 }
@@ -20,6 +20,7 @@
 #include <mpi.h>
 #include <abt.h>
 #include <daos/common.h>
+#include <daos/cipher.h>
 #include <daos/tests_lib.h>
 #include <daos_srv/vos.h>
 #include <daos_test.h>
@@ -56,6 +57,15 @@ unsigned int		 ts_seed;
 bool			 ts_single	= true;
 /* use zero-copy API for VOS, ignored for "echo" or "daos" */
 bool			 ts_zero_copy;
+/* report bytes copied per byte fetched by the in-process VOS, "vos" only */
+bool			 ts_copy_stats;
+/* bytes copied out of the zero-copy fetch buffers by this tool (-z) */
+uint64_t		 ts_zc_copied;
+/* container encryption algorithm, NULL for plaintext */
+char			*ts_encrypt;
+/* generated key file, removed once the container is open */
+char			 ts_key_path[] = "/tmp/daos_perf_key.XXXXXX";
+bool			 ts_key_generated;
 /* random write (array value only) */
 bool			 ts_random;
 bool			 ts_pause;
@@ -89,6 +99,9 @@ struct pf_param {
 	int		pa_iteration;
 	/* output parameter */
 	double		pa_duration;
+	/* latency of the fastest and slowest I/O in us, synchronous only */
+	double		pa_lat_min;
+	double		pa_lat_max;
 	union {
 		/* private parameter for rebuild */
 		struct {
@@ -374,6 +387,7 @@ _vos_update_or_fetch(int obj_idx, enum ts_op_type op_type,
 			memcpy(cred->tc_sgl.sg_iovs[0].iov_buf,
 			       bio_iov2raw_buf(&bsgl->bs_iovs[0]),
 			       bio_iov2raw_len(&bsgl->bs_iovs[0]));
+			ts_zc_copied += bio_iov2raw_len(&bsgl->bs_iovs[0]);
 		} else {
 			memcpy(bio_iov2req_buf(&bsgl->bs_iovs[0]),
 			       cred->tc_sgl.sg_iovs[0].iov_buf,
@@ -483,6 +497,7 @@ akey_update_or_fetch(int obj_idx, enum ts_op_type op_type,
 	d_sg_list_t	     *sgl;
 	daos_recx_t	     *recx;
 	size_t		      len;
+	double		      duration;
 	int		      rc = 0;
 
 	cred = dts_credit_take(&ts_ctx);
@@ -536,6 +551,7 @@ akey_update_or_fetch(int obj_idx, enum ts_op_type op_type,
 	sgl->sg_nr = 1;
 	sgl->sg_nr_out = 0;
 
+	duration = param->pa_duration;
 	if (ts_mode == TS_MODE_VOS)
 		rc = vos_update_or_fetch(obj_idx, op_type, cred, *epoch,
 					 &param->pa_duration);
@@ -544,6 +560,15 @@ akey_update_or_fetch(int obj_idx, enum ts_op_type op_type,
 					  !!param->pa_rw.verify,
 					  &param->pa_duration);
 
+	/* nothing is accounted to a single I/O in asynchronous mode */
+	duration = param->pa_duration - duration;
+	if (duration > 0) {
+		if (param->pa_lat_min == 0 || duration < param->pa_lat_min)
+			param->pa_lat_min = duration;
+		if (duration > param->pa_lat_max)
+			param->pa_lat_max = duration;
+	}
+
 	if (rc != 0) {
 		fprintf(stderr, "%s failed. rc=%d, epoch=%"PRIu64"\n",
 			op_type == TS_DO_FETCH ? "Fetch" : "Update",
@@ -837,20 +862,49 @@ pf_update(struct pf_test *ts, struct pf_param *param)
 	return rc;
 }
 
+static void
+show_copy_stats(struct bio_copy_stats *stats)
+{
+	uint64_t	copied = stats->bcs_copied + ts_zc_copied;
+	double		ratio = 0;
+
+	if (stats->bcs_fetched != 0)
+		ratio = (double)copied / stats->bcs_fetched;
+
+	fprintf(stdout, "Fetch copy statistics:\n"
+		"\tfetched  : "DF_U64" bytes ("DF_U64" from NVMe by DMA)\n"
+		"\tcopied   : "DF_U64" bytes by bio, "DF_U64" bytes by -z\n"
+		"\tzero-copy: "DF_U64" bytes accessed in place\n"
+		"\tratio    : %-10.3f bytes copied per byte fetched\n",
+		stats->bcs_fetched, stats->bcs_dma, stats->bcs_copied,
+		ts_zc_copied, stats->bcs_zero_copy, ratio);
+}
+
 static int
 pf_fetch(struct pf_test *ts, struct pf_param *param)
 {
-	int	rc;
+	struct bio_copy_stats	stats;
+	int			rc;
 
 	rc = objects_open();
 	if (rc)
 		return rc;
 
+	if (ts_copy_stats) {
+		bio_copy_stats_get(&stats, true);
+		ts_zc_copied = 0;
+	}
+
 	param->pa_rw.verify = false;
 	rc = objects_fetch(param);
 	if (rc)
 		return rc;
 
+	if (ts_copy_stats) {
+		bio_copy_stats_get(&stats, true);
+		show_copy_stats(&stats);
+	}
+
 	rc = objects_close();
 	return rc;
 }
@@ -1593,6 +1647,11 @@ The options are as follows:\n\
 \n\
 -z	Use zero copy API, this option is only valid for 'vos'\n\
 \n\
+-m	Report bytes copied by the CPU per byte fetched, against bytes\n\
+	accessed in place (zero-copy), this option is only valid for 'vos'.\n\
+	It measures the in-process VOS fetch path, not the bulk transfer of\n\
+	the engine.\n\
+\n\
 -t	Instead of using different indices and epochs, all I/Os land to the\n\
 	same extent in the same epoch. This option can reduce usage of\n\
 	storage space.\n\
@@ -1602,6 +1661,12 @@ The options are as follows:\n\
 -f pathname\n\
 	Full path name of the VOS file.\n\
 \n\
+-e aes-xts128|aes-xts256\n\
+	Create an encrypted container, data is encrypted and decrypted by\n\
+	the client. The key is read from DAOS_CONT_ENCRYPT_KEY_FILE, a random\n\
+	key is generated if it is not set. Compare with a run without this\n\
+	option for the cost of encryption. Only valid for 'daos'.\n\
+\n\
 -w	Pause after initialization for attaching debugger or analysis\n\
 	tool.\n\
 \n\
@@ -1610,6 +1675,59 @@ The options are as follows:\n\
 -p	run vos perf with profile.\n");
 }
 
+/**
+ * Set the encryption property of the container to create and, if no key is
+ * provided, share a random key between all ranks through a temporary file.
+ */
+static int
+ts_encrypt_init(const char *algo)
+{
+	unsigned char	key[64];
+	int		val;
+	int		fd;
+	int		i;
+
+	if (ts_mode != TS_MODE_DAOS) {
+		fprintf(stderr, "encryption is only supported in DAOS mode\n");
+		return -1;
+	}
+
+	val = daos_str2encryptcontprop(algo);
+	if (val < 0 || val == DAOS_PROP_CO_ENCRYPT_OFF) {
+		fprintf(stderr, "unknown encryption algorithm %s\n", algo);
+		return -1;
+	}
+
+	ts_ctx.tsc_cont_prop = daos_prop_alloc(1);
+	if (ts_ctx.tsc_cont_prop == NULL)
+		return -1;
+	ts_ctx.tsc_cont_prop->dpp_entries[0].dpe_type = DAOS_PROP_CO_ENCRYPT;
+	ts_ctx.tsc_cont_prop->dpp_entries[0].dpe_val = val;
+
+	if (getenv("DAOS_CONT_ENCRYPT_KEY_FILE") != NULL)
+		return 0;
+
+	if (ts_ctx.tsc_mpi_rank == 0) {
+		srand(ts_seed);
+		for (i = 0; i < sizeof(key); i++)
+			key[i] = rand();
+	}
+	MPI_Bcast(key, sizeof(key), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+	fd = mkstemp(ts_key_path);
+	if (fd < 0)
+		return -1;
+	ts_key_generated = true;
+	if (write(fd, key, sizeof(key)) != sizeof(key)) {
+		close(fd);
+		return -1;
+	}
+	close(fd);
+	/* the file is read once by container open, in dts_ctx_init() */
+	setenv("DAOS_CONT_ENCRYPT_KEY_FILE", ts_key_path, 1);
+	return 0;
+}
+
 static struct option ts_ops[] = {
 	{ "pool_scm",	required_argument,	NULL,	'P' },
 	{ "pool_nvme",	required_argument,	NULL,	'N' },
@@ -1624,11 +1742,13 @@ static struct option ts_ops[] = {
 	{ "array",	optional_argument,	NULL,	'A' },
 	{ "size",	required_argument,	NULL,	's' },
 	{ "zcopy",	no_argument,		NULL,	'z' },
+	{ "copy_stats",	no_argument,		NULL,	'm' },
 	{ "run",	required_argument,	NULL,	'R' },
 	{ "file",	required_argument,	NULL,	'f' },
 	{ "dmg_conf",	required_argument,	NULL,	'g' },
 	{ "help",	no_argument,		NULL,	'h' },
 	{ "wait",	no_argument,		NULL,	'w' },
+	{ "encrypt",	required_argument,	NULL,	'e' },
 	{ NULL,		0,			NULL,	0   },
 };
 
@@ -1642,6 +1762,8 @@ show_result(struct pf_param *param, uint64_t start, uint64_t end,
 	double		duration_max;
 	double		duration_min;
 	double		duration_sum;
+	double		lat_min;
+	double		lat_max;
 
 	if (ts_ctx.tsc_mpi_size > 1) {
 		MPI_Reduce(&start, &first_start, 1, MPI_UINT64_T,
@@ -1663,9 +1785,15 @@ show_result(struct pf_param *param, uint64_t start, uint64_t end,
 			   MPI_MIN, 0, MPI_COMM_WORLD);
 		MPI_Reduce(&param->pa_duration, &duration_sum, 1, MPI_DOUBLE,
 			   MPI_SUM, 0, MPI_COMM_WORLD);
+		MPI_Reduce(&param->pa_lat_min, &lat_min, 1, MPI_DOUBLE,
+			   MPI_MIN, 0, MPI_COMM_WORLD);
+		MPI_Reduce(&param->pa_lat_max, &lat_max, 1, MPI_DOUBLE,
+			   MPI_MAX, 0, MPI_COMM_WORLD);
 	} else {
 		duration_max = duration_min =
 		duration_sum = param->pa_duration;
+		lat_min = param->pa_lat_min;
+		lat_max = param->pa_lat_max;
 	}
 
 	if (ts_ctx.tsc_mpi_rank == 0) {
@@ -1689,6 +1817,9 @@ show_result(struct pf_param *param, uint64_t start, uint64_t end,
 			"\tlatency  : %-10.3f us "
 			"(nonsense if credits > 1)\n",
 			test_name, agg_duration, bandwidth, rate, latency);
+		if (lat_max > 0)
+			fprintf(stdout, "\tlatency min/max : %.3f/%.3f us\n",
+				lat_min, lat_max);
 
 		fprintf(stdout, "Duration across processes:\n");
 		fprintf(stdout, "\tMAX duration : %-10.6f sec\n",
@@ -1718,7 +1849,7 @@ main(int argc, char **argv)
 
 	memset(ts_pmem_file, 0, sizeof(ts_pmem_file));
 	while ((rc = getopt_long(argc, argv,
-				 "P:N:T:C:c:o:d:a:n:s:R:g:G:zf:hwxpA::",
+				 "P:N:T:C:c:o:d:a:n:s:R:g:G:e:zmf:hwxpA::",
 				 ts_ops, NULL)) != -1) {
 		char	*endp;
 
@@ -1729,6 +1860,9 @@ main(int argc, char **argv)
 		case 'w':
 			ts_pause = true;
 			break;
+		case 'e':
+			ts_encrypt = optarg;
+			break;
 		case 'T':
 			if (!strcasecmp(optarg, "echo")) {
 				/* just network, no storage */
@@ -1802,6 +1936,9 @@ main(int argc, char **argv)
 		case 'z':
 			ts_zero_copy = true;
 			break;
+		case 'm':
+			ts_copy_stats = true;
+			break;
 		case 'f':
 			if (strnlen(optarg, PATH_MAX) >= (PATH_MAX - 5)) {
 				fprintf(stderr, "filename size must be < %d\n",
@@ -1846,6 +1983,11 @@ main(int argc, char **argv)
 	} else { /* no RAW for other modes */
 		if (ts_class == DAOS_OC_RAW)
 			ts_class = OC_S1;
+		/* copies are only visible when storage runs in process */
+		if (ts_copy_stats && ts_ctx.tsc_mpi_rank == 0)
+			fprintf(stderr,
+				"-m is only valid for 'vos', ignored\n");
+		ts_copy_stats = false;
 	}
 
 	if (ts_mode == TS_MODE_ECHO) {
@@ -1923,7 +2065,15 @@ main(int argc, char **argv)
 		uuid_generate(ts_ctx.tsc_pool_uuid);
 	}
 
+	if (ts_encrypt != NULL) {
+		rc = ts_encrypt_init(ts_encrypt);
+		if (rc)
+			return -1;
+	}
+
 	rc = dts_ctx_init(&ts_ctx);
+	if (ts_key_generated)
+		unlink(ts_key_path);
 	if (rc)
 		return -1;
 
@@ -1950,6 +2100,7 @@ main(int argc, char **argv)
 			"\tvalue type    : %s\n"
 			"\tstride size   : %u\n"
 			"\tzero copy     : %s\n"
+			"\tencryption    : %s\n"
 			"\tVOS file      : %s\n",
 			pf_class2name(), uuid_buf,
 			(unsigned int)(scm_size >> 20),
@@ -1963,6 +2114,7 @@ main(int argc, char **argv)
 			ts_val_type(),
 			ts_stride,
 			ts_yes_or_no(ts_zero_copy),
+			ts_encrypt != NULL ? ts_encrypt : "off",
 			ts_mode == TS_MODE_VOS ? ts_pmem_file : "<NULL>");
 	}
 
@@ -1990,6 +2142,8 @@ main(int argc, char **argv)
 		free(ts_indices);
 	stride_buf_fini();
 	dts_ctx_fini(&ts_ctx);
+	if (ts_ctx.tsc_cont_prop != NULL)
+		daos_prop_free(ts_ctx.tsc_cont_prop);
 
 	MPI_Finalize();
 
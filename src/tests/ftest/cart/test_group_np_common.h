@@ -46,6 +46,8 @@ struct test_t {
 	char			*t_cfg_path;
 	uint32_t		 t_hold_time;
 	unsigned int		 t_srv_ctx_num;
+	/* helper progress threads per context */
+	unsigned int		 t_srv_prog_threads;
 	crt_context_t		 t_crt_ctx[TEST_CTX_MAX_NUM];
 	pthread_t		 t_tid[TEST_CTX_MAX_NUM];
 	sem_t			 t_token_to_proceed;
@@ -584,6 +586,7 @@ test_parse_args(int argc, char **argv)
 		{"holdtime", required_argument, 0, 'h'},
 		{"hold", no_argument, &test_g.t_hold, 1},
 		{"srv_ctx_num", required_argument, 0, 'c'},
+		{"progress_threads", required_argument, 0, 'p'},
 		{"shut_only", no_argument, &test_g.t_shut_only, 1},
 		{"init_only", no_argument, &test_g.t_init_only, 1},
 		{"skip_init", no_argument, &test_g.t_skip_init, 1},
@@ -613,7 +616,7 @@ test_parse_args(int argc, char **argv)
 	struct t_swim_status vss;
 
 	while (1) {
-		rc = getopt_long(argc, argv, "n:a:c:h:u:r:", long_options,
+		rc = getopt_long(argc, argv, "n:a:c:p:h:u:r:", long_options,
 				 &option_index);
 
 		if (rc == -1)
@@ -644,6 +647,9 @@ test_parse_args(int argc, char **argv)
 			}
 			break;
 		}
+		case 'p':
+			test_g.t_srv_prog_threads = atoi(optarg);
+			break;
 		case 'h':
 			test_g.t_hold = 1;
 			test_g.t_hold_time = atoi(optarg);
@@ -104,6 +104,17 @@ test_run(d_rank_t my_rank)
 	}
 	DBG_PRINT("Contexts created %d\n", test_g.t_srv_ctx_num);
 
+	for (i = 0; i < test_g.t_srv_ctx_num; i++) {
+		if (test_g.t_srv_prog_threads == 0)
+			break;
+		rc = crt_context_set_progress_threads(test_g.t_crt_ctx[i],
+						test_g.t_srv_prog_threads);
+		D_ASSERTF(rc == 0, "crt_context_set_progress_threads() failed."
+			  " rc: %d\n", rc);
+		DBG_PRINT("Context %d progress threads started %d\n", i,
+			  test_g.t_srv_prog_threads);
+	}
+
 	if (my_rank == 0) {
 		rc = crt_group_config_save(NULL, true);
 		D_ASSERTF(rc == 0,
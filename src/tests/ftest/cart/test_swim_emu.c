@@ -32,11 +32,15 @@ static int glitches;
 static int failures;
 static int net_delay;
 static size_t members_count;
+static size_t lagging_count;
 static swim_id_t victim = SWIM_ID_INVALID;
 
 static size_t pkt_sent;
 static size_t pkt_total;
 static size_t pkt_glitch;
+static size_t upd_sent;
+static size_t upd_max;
+static size_t false_suspects;
 
 struct network_pkt {
 	TAILQ_ENTRY(network_pkt)	 np_link;
@@ -61,6 +65,9 @@ static struct global {
 	CIRCLEQ_HEAD(, swim_target)	 target_list[MEMBERS_MAX];
 	struct swim_target		*target[MEMBERS_MAX];
 	struct swim_context		*swim_ctx[MEMBERS_MAX];
+	/* the lagging members stall until lag_end, once per lag period */
+	uint64_t			 lag_end[MEMBERS_MAX];
+	uint64_t			 lag_next[MEMBERS_MAX];
 	/* SWIM statistics: */
 	uint64_t			 detect_sec[MEMBERS_MAX];
 	uint64_t			 victim_sec;
@@ -88,6 +95,9 @@ static int test_send_message(struct swim_context *ctx, swim_id_t to,
 		D_SPIN_LOCK(&g.lock);
 		TAILQ_INSERT_TAIL(&g.pkts, item, np_link);
 		pkt_sent++;
+		upd_sent += nupds;
+		if (nupds > upd_max)
+			upd_max = nupds;
 		D_SPIN_UNLOCK(&g.lock);
 
 		rc = 0;
@@ -162,6 +172,11 @@ static int test_set_member_state(struct swim_context *ctx,
 		break;
 	case SWIM_MEMBER_SUSPECT:
 		state->sms_delay += swim_ping_timeout_get();
+		if (id != victim) {
+			D_SPIN_LOCK(&g.lock);
+			false_suspects++;
+			D_SPIN_UNLOCK(&g.lock);
+		}
 		break;
 	case SWIM_MEMBER_DEAD:
 		if (id == victim) {
@@ -276,7 +291,10 @@ int test_run(void)
 		if (victim == SWIM_ID_INVALID && !g.victim_sec && tick > 0) {
 			rc = clock_gettime(CLOCK_MONOTONIC, &now);
 			if (!rc) {
-				victim = rand() % members_count;
+				/* not one of the lagging members */
+				victim = lagging_count +
+					 rand() % (members_count -
+						   lagging_count);
 				g.victim_sec = now.tv_sec;
 
 				fprintf(stdout, "%3d. *** VICTIM %lu ***\n",
@@ -293,6 +311,10 @@ int test_run(void)
 	fprintf(stderr, "\nWith %zu members failure was detected after:\n"
 		"min %lu sec max %lu sec\n",
 		members_count, g.detect_min, g.detect_max);
+	fprintf(stderr, "%zu messages sent with %zu updates (avg %.1f max %zu "
+		"per message), %zu false suspicions, %zu lagging members\n",
+		pkt_sent, upd_sent, pkt_sent ? (double)upd_sent / pkt_sent : 0,
+		upd_max, false_suspects, lagging_count);
 
 	return rc;
 }
@@ -362,7 +384,12 @@ static void *network_thread(void *arg)
 			pkt_total++;
 			D_SPIN_UNLOCK(&g.lock);
 
-			if (!(rand() % glitches)) {
+			if (swim_now_ms() < g.lag_end[item->np_to]) {
+				/* not received until the target resumes */
+				D_SPIN_LOCK(&g.lock);
+				TAILQ_INSERT_TAIL(&g.pkts, item, np_link);
+				D_SPIN_UNLOCK(&g.lock);
+			} else if (!(rand() % glitches)) {
 				usleep(rand() % (6 * net_delay));
 				D_SPIN_LOCK(&g.lock);
 				TAILQ_INSERT_TAIL(&g.pkts, item, np_link);
@@ -405,6 +432,16 @@ static void *progress_thread(void *arg)
 
 	do {
 		for (i = 0; i < members_count; i++) {
+			uint64_t now = swim_now_ms();
+
+			/* emulate a progress loop late under load */
+			if (i < lagging_count && now >= g.lag_next[i]) {
+				g.lag_end[i] = now + 3 * swim_period_get() / 2;
+				g.lag_next[i] = now + 4 * swim_period_get();
+			}
+			if (now < g.lag_end[i])
+				continue;
+
 			rc = swim_progress(g.swim_ctx[i], timeout);
 			if (rc == -ESHUTDOWN)
 				swim_self_set(g.swim_ctx[i], SWIM_ID_INVALID);
@@ -465,6 +502,98 @@ int test_fini(void)
 extern int crt_init_opt(char *grpid, uint32_t flags, void *opt);
 #endif
 
+/* Deadline of the suspicion of \a id by \a ctx, 0 if not suspected */
+static uint64_t test_suspect_deadline(struct swim_context *ctx, swim_id_t id)
+{
+	struct swim_item *item;
+
+	TAILQ_FOREACH(item, &ctx->sc_suspects, si_link) {
+		if (item->si_id == id)
+			return item->u.si_deadline;
+	}
+	return 0;
+}
+
+/* Member 0 hears from \a from that \a origin suspects member 3 */
+static int test_suspect_parse(struct swim_context *ctx, swim_id_t from,
+			      swim_id_t origin)
+{
+	struct swim_member_update upds[2];
+
+	/* a dping response of the sender, so that nothing is sent back */
+	upds[0].smu_id = from;
+	upds[0].smu_state = g.swim_state[from][from];
+	upds[0].smu_origin = SWIM_ID_INVALID;
+	upds[1].smu_id = 3;
+	upds[1].smu_state.sms_incarnation = 0;
+	upds[1].smu_state.sms_status = SWIM_MEMBER_SUSPECT;
+	upds[1].smu_state.sms_delay = 0;
+	upds[1].smu_origin = origin;
+
+	return swim_parse_message(ctx, from, upds, ARRAY_SIZE(upds));
+}
+
+/*
+ * The suspicion timeout shrinks when another member suspects the member too,
+ * not when other members only relay the same suspicion.
+ */
+static int test_relayed_suspicion(void)
+{
+	struct swim_context *ctx;
+	uint64_t deadline[3];
+	int i, j, rc;
+
+	/* member 3 is the only one suspected, as the victim */
+	victim = 3;
+	for (i = 0; i <= victim; i++)
+		for (j = 0; j <= victim; j++) {
+			g.swim_state[i][j].sms_incarnation = 0;
+			g.swim_state[i][j].sms_status = SWIM_MEMBER_ALIVE;
+		}
+
+	rc = D_SPIN_INIT(&g.lock, PTHREAD_PROCESS_PRIVATE);
+	if (rc) {
+		fprintf(stderr, "D_SPIN_INIT() rc=%d\n", rc);
+		return rc;
+	}
+
+	ctx = swim_init(0, &swim_ops, &g);
+	if (ctx == NULL) {
+		fprintf(stderr, "swim_init() failed\n");
+		D_GOTO(out, rc = -DER_NOMEM);
+	}
+
+	/* 1 suspects 3, then 2 relays the suspicion of 1 */
+	rc = test_suspect_parse(ctx, 1, 1);
+	if (rc)
+		D_GOTO(out_fini, rc);
+	deadline[0] = test_suspect_deadline(ctx, 3);
+	rc = test_suspect_parse(ctx, 2, 1);
+	if (rc)
+		D_GOTO(out_fini, rc);
+	deadline[1] = test_suspect_deadline(ctx, 3);
+
+	/* then 2 suspects 3 on its own */
+	rc = test_suspect_parse(ctx, 2, 2);
+	if (rc)
+		D_GOTO(out_fini, rc);
+	deadline[2] = test_suspect_deadline(ctx, 3);
+
+	fprintf(stdout, "suspicion deadline %lu, relayed %lu, confirmed %lu\n",
+		deadline[0], deadline[1], deadline[2]);
+	if (deadline[0] == 0 || deadline[1] != deadline[0] ||
+	    deadline[2] >= deadline[1]) {
+		fprintf(stderr, "relayed suspicion test failed\n");
+		rc = -DER_MISMATCH;
+	}
+
+out_fini:
+	swim_fini(ctx);
+out:
+	D_SPIN_DESTROY(&g.lock);
+	return rc;
+}
+
 int test_init(void)
 {
 	struct swim_target *st;
@@ -556,12 +685,13 @@ int test_parse_args(int argc, char **argv)
 		{"glitches", required_argument, 0, 'g'},
 		{"failures", required_argument, 0, 'f'},
 		{"delay",    required_argument, 0, 'd'},
+		{"lagging",  required_argument, 0, 'l'},
 		{"verbose",  no_argument, &verbose, 1},
 		{0, 0, 0, 0}
 	};
 
 	while (1) {
-		rc = getopt_long(argc, argv, "?s:g:f:d:v", long_options,
+		rc = getopt_long(argc, argv, "?s:g:f:d:l:v", long_options,
 				 &option_index);
 		if (rc == -1)
 			break;
@@ -619,6 +749,17 @@ int test_parse_args(int argc, char **argv)
 					"net delay.\n", nr);
 			}
 			break;
+		case 'l':
+			nr = strtoul(optarg, &end, 10);
+			if (end == optarg || nr > members_count / 2) {
+				fprintf(stderr, "lagging %d not in range "
+					"[0, %zu], using %zu for test.\n",
+					nr, members_count / 2, lagging_count);
+			} else {
+				lagging_count = nr;
+				fprintf(stderr, "will lag %d members.\n", nr);
+			}
+			break;
 		case 'v':
 			verbose = 1;
 			break;
@@ -633,6 +774,7 @@ int test_parse_args(int argc, char **argv)
 "-g (--glitches) : how many glitches will be introduced in communication\n"
 "-f (--failures) : how many failures will be introduced in communication\n"
 "-d (--delay)    : the amount of communication delay for each packet in usec\n"
+"-l (--lagging)  : how many members stall 1.5 periods every 4 periods\n"
 "-v              : verbose output about internal state during simulation\n");
 			return 1;
 		}
@@ -641,6 +783,10 @@ int test_parse_args(int argc, char **argv)
 		fprintf(stderr, "non-option argv elements encountered");
 		return 1;
 	}
+	if (lagging_count > members_count / 2) {
+		lagging_count = members_count / 2;
+		fprintf(stderr, "will lag %zu members.\n", lagging_count);
+	}
 
 	return 0;
 }
@@ -665,6 +811,8 @@ int main(int argc, char **argv)
 	if (!rc)
 		rc = test_run();
 	test_fini();
+	if (!rc)
+		rc = test_relayed_suspicion();
 
 	return rc;
 }
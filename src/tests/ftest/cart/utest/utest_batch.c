@@ -0,0 +1,257 @@
+/*
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * This file is part of CaRT testing.
+ *
+ * RPCs packed in an envelope are run without an HG handle of their own, check
+ * that their handler can still pull a bulk from the origin, as IV updates do.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+
+#include <cmocka.h>
+
+#include <cart/api.h>
+#include "../cart/crt_internal.h"
+
+#define MY_BASE		0x010000000
+#define MY_VER		0
+
+/* RPCs sent at once, packed in the same envelope */
+#define BATCH_RPC_NR	8
+#define BATCH_BUF_LEN	4096
+
+#define CRT_ISEQ_RPC_BATCH_BULK	/* input fields */		 \
+	((crt_bulk_t)		(bulk)			CRT_VAR) \
+	((uint32_t)		(seed)			CRT_VAR) \
+	((uint32_t)		(len)			CRT_VAR)
+
+#define CRT_OSEQ_RPC_BATCH_BULK	/* output fields */		 \
+	((int32_t)		(rc)			CRT_VAR)
+
+CRT_RPC_DECLARE(RPC_BATCH_BULK, CRT_ISEQ_RPC_BATCH_BULK,
+		CRT_OSEQ_RPC_BATCH_BULK)
+CRT_RPC_DEFINE(RPC_BATCH_BULK, CRT_ISEQ_RPC_BATCH_BULK,
+	       CRT_OSEQ_RPC_BATCH_BULK)
+
+struct bulk_pull {
+	crt_rpc_t	*bp_rpc;
+	crt_bulk_t	 bp_bulk;
+	char		*bp_buf;
+};
+
+static void
+buf_fill(char *buf, uint32_t len, uint32_t seed)
+{
+	uint32_t	i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (char)(seed + i);
+}
+
+static int
+bulk_pull_cb(const struct crt_bulk_cb_info *info)
+{
+	struct bulk_pull		*bp = info->bci_arg;
+	struct RPC_BATCH_BULK_in	*in = crt_req_get(bp->bp_rpc);
+	struct RPC_BATCH_BULK_out	*out = crt_reply_get(bp->bp_rpc);
+	char				*expected;
+
+	out->rc = info->bci_rc;
+	if (out->rc == 0) {
+		expected = malloc(in->len);
+		assert_non_null(expected);
+		buf_fill(expected, in->len, in->seed);
+		if (memcmp(expected, bp->bp_buf, in->len) != 0)
+			out->rc = -DER_MISC;
+		free(expected);
+	}
+
+	crt_reply_send(bp->bp_rpc);
+	crt_req_decref(bp->bp_rpc);
+	crt_bulk_free(bp->bp_bulk);
+	free(bp->bp_buf);
+	free(bp);
+	return 0;
+}
+
+static int
+handler_batch_bulk(crt_rpc_t *rpc)
+{
+	struct RPC_BATCH_BULK_in	*in = crt_req_get(rpc);
+	struct crt_rpc_priv		*rpc_priv;
+	struct crt_bulk_desc		 desc = {0};
+	struct bulk_pull		*bp;
+	d_sg_list_t			 sgl;
+	d_iov_t				 iov;
+	int				 rc;
+
+	/* the RPC was unpacked from an envelope */
+	rpc_priv = container_of(rpc, struct crt_rpc_priv, crp_pub);
+	assert_true(rpc_priv->crp_batched);
+	assert_null(rpc_priv->crp_hg_hdl);
+
+	bp = calloc(1, sizeof(*bp));
+	assert_non_null(bp);
+	bp->bp_buf = calloc(1, in->len);
+	assert_non_null(bp->bp_buf);
+	bp->bp_rpc = rpc;
+
+	d_iov_set(&iov, bp->bp_buf, in->len);
+	sgl.sg_nr = 1;
+	sgl.sg_nr_out = 1;
+	sgl.sg_iovs = &iov;
+	rc = crt_bulk_create(rpc->cr_ctx, &sgl, CRT_BULK_RW, &bp->bp_bulk);
+	assert_int_equal(rc, 0);
+
+	desc.bd_rpc = rpc;
+	desc.bd_bulk_op = CRT_BULK_GET;
+	desc.bd_remote_hdl = in->bulk;
+	desc.bd_local_hdl = bp->bp_bulk;
+	desc.bd_len = in->len;
+
+	/* decref in bulk_pull_cb */
+	crt_req_addref(rpc);
+	rc = crt_bulk_transfer(&desc, bulk_pull_cb, bp, NULL);
+	assert_int_equal(rc, 0);
+	return 0;
+}
+
+static struct crt_proto_rpc_format my_proto_rpc_fmt[] = {
+	{
+		.prf_flags	= CRT_RPC_FEAT_BATCH,
+		.prf_req_fmt	= &CQF_RPC_BATCH_BULK,
+		.prf_hdlr	= (void *)handler_batch_bulk,
+		.prf_co_ops	= NULL,
+	}
+};
+
+static struct crt_proto_format my_proto_fmt = {
+	.cpf_name	= "utest-batch",
+	.cpf_ver	= MY_VER,
+	.cpf_count	= ARRAY_SIZE(my_proto_rpc_fmt),
+	.cpf_prf	= &my_proto_rpc_fmt[0],
+	.cpf_base	= MY_BASE,
+};
+
+static void
+batch_bulk_cb(const struct crt_cb_info *info)
+{
+	struct RPC_BATCH_BULK_out	*out = crt_reply_get(info->cci_rpc);
+	int				*done = info->cci_arg;
+
+	assert_int_equal(info->cci_rc, 0);
+	assert_int_equal(out->rc, 0);
+	(*done)++;
+}
+
+static void
+test_batch_bulk(void **state)
+{
+	struct RPC_BATCH_BULK_in	*in;
+	crt_endpoint_t			 ep = { .ep_rank = 0, .ep_tag = 0 };
+	crt_context_t			 ctx;
+	crt_rpc_t			*rpc;
+	crt_bulk_t			 bulks[BATCH_RPC_NR];
+	char				*bufs[BATCH_RPC_NR];
+	d_sg_list_t			 sgl;
+	d_iov_t				 iov;
+	uint64_t			 batched;
+	int				 done = 0;
+	int				 i;
+	int				 rc;
+
+	rc = crt_init(NULL, CRT_FLAG_BIT_SERVER |
+		      CRT_FLAG_BIT_AUTO_SWIM_DISABLE);
+	assert_int_equal(rc, 0);
+
+	rc = crt_proto_register(&my_proto_fmt);
+	assert_int_equal(rc, 0);
+
+	rc = crt_rank_self_set(0);
+	assert_int_equal(rc, 0);
+
+	rc = crt_context_create(&ctx);
+	assert_int_equal(rc, 0);
+
+	batched = atomic_load_relaxed(&crt_gdata.cg_batch_rpc_cnt);
+	for (i = 0; i < BATCH_RPC_NR; i++) {
+		bufs[i] = malloc(BATCH_BUF_LEN);
+		assert_non_null(bufs[i]);
+		buf_fill(bufs[i], BATCH_BUF_LEN, i);
+
+		d_iov_set(&iov, bufs[i], BATCH_BUF_LEN);
+		sgl.sg_nr = 1;
+		sgl.sg_nr_out = 1;
+		sgl.sg_iovs = &iov;
+		rc = crt_bulk_create(ctx, &sgl, CRT_BULK_RO, &bulks[i]);
+		assert_int_equal(rc, 0);
+
+		rc = crt_req_create(ctx, &ep, CRT_PROTO_OPC(MY_BASE, MY_VER, 0),
+				    &rpc);
+		assert_int_equal(rc, 0);
+		in = crt_req_get(rpc);
+		in->bulk = bulks[i];
+		in->seed = i;
+		in->len = BATCH_BUF_LEN;
+		rc = crt_req_send(rpc, batch_bulk_cb, &done);
+		assert_int_equal(rc, 0);
+	}
+
+	while (done < BATCH_RPC_NR) {
+		rc = crt_progress(ctx, 1000);
+		assert_true(rc == 0 || rc == -DER_TIMEDOUT);
+	}
+
+	/* they were all received in envelopes */
+	assert_int_equal(atomic_load_relaxed(&crt_gdata.cg_batch_rpc_cnt),
+			 batched + BATCH_RPC_NR);
+
+	for (i = 0; i < BATCH_RPC_NR; i++) {
+		crt_bulk_free(bulks[i]);
+		free(bufs[i]);
+	}
+
+	rc = crt_context_destroy(ctx, false);
+	assert_int_equal(rc, 0);
+
+	rc = crt_finalize();
+	assert_int_equal(rc, 0);
+}
+
+static int
+init_tests(void **state)
+{
+	setenv("CRT_PHY_ADDR_STR", "ofi+sockets", 1);
+	setenv("OFI_INTERFACE", "lo", 1);
+	/* long enough for all the RPCs to be packed in one envelope */
+	setenv("CRT_BATCH_DELAY", "10000", 1);
+
+	return 0;
+}
+
+static int
+fini_tests(void **state)
+{
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_batch_bulk),
+	};
+
+	d_register_alt_assert(mock_assert);
+
+	return cmocka_run_group_tests_name("utest_batch", tests, init_tests,
+		fini_tests);
+}
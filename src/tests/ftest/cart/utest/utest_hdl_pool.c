@@ -0,0 +1,184 @@
+/*
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * This file is part of CaRT testing.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+
+#include <cmocka.h>
+
+#include <cart/api.h>
+#include "../cart/crt_internal.h"
+
+#define MY_BASE		0x010000000
+#define MY_VER		0
+
+/* RPCs in flight at once, more than the initial size of the pool */
+#define BURST_NR	(CRT_HG_POOL_MAX_NUM + 64)
+
+#define CRT_ISEQ_RPC_POOL_PING	/* input fields */		 \
+	((uint64_t)		(field)			CRT_VAR)
+
+#define CRT_OSEQ_RPC_POOL_PING	/* output fields */		 \
+	((uint64_t)		(field)			CRT_VAR)
+
+CRT_RPC_DECLARE(RPC_POOL_PING, CRT_ISEQ_RPC_POOL_PING, CRT_OSEQ_RPC_POOL_PING)
+CRT_RPC_DEFINE(RPC_POOL_PING, CRT_ISEQ_RPC_POOL_PING, CRT_OSEQ_RPC_POOL_PING)
+
+static int
+handler_pool_ping(crt_rpc_t *rpc)
+{
+	crt_reply_send(rpc);
+	return 0;
+}
+
+static struct crt_proto_rpc_format my_proto_rpc_fmt[] = {
+	{
+		.prf_flags	= 0,
+		.prf_req_fmt	= &CQF_RPC_POOL_PING,
+		.prf_hdlr	= (void *)handler_pool_ping,
+		.prf_co_ops	= NULL,
+	}
+};
+
+static struct crt_proto_format my_proto_fmt = {
+	.cpf_name	= "utest-hdl-pool",
+	.cpf_ver	= MY_VER,
+	.cpf_count	= ARRAY_SIZE(my_proto_rpc_fmt),
+	.cpf_prf	= &my_proto_rpc_fmt[0],
+	.cpf_base	= MY_BASE,
+};
+
+static void
+ping_cb(const struct crt_cb_info *info)
+{
+	int	*done = info->cci_arg;
+
+	assert_int_equal(info->cci_rc, 0);
+	(*done)++;
+}
+
+/* send \a nr RPCs to self at once, and progress until they all complete */
+static void
+ping_send(crt_context_t ctx, int nr)
+{
+	crt_endpoint_t	 ep = { .ep_rank = 0, .ep_tag = 0 };
+	crt_rpc_t	*rpc;
+	int		 done = 0;
+	int		 i;
+	int		 rc;
+
+	for (i = 0; i < nr; i++) {
+		rc = crt_req_create(ctx, &ep, CRT_PROTO_OPC(MY_BASE, MY_VER, 0),
+				    &rpc);
+		assert_int_equal(rc, 0);
+		rc = crt_req_send(rpc, ping_cb, &done);
+		assert_int_equal(rc, 0);
+	}
+
+	while (done < nr) {
+		rc = crt_progress(ctx, 1000);
+		assert_true(rc == 0 || rc == -DER_TIMEDOUT);
+	}
+}
+
+static void
+test_hdl_pool_grow_shrink(void **state)
+{
+	struct crt_hdl_pool_stats	stats;
+	crt_context_t			ctx;
+	uint64_t			misses;
+	int				i;
+	int				rc;
+
+	rc = crt_init(NULL, CRT_FLAG_BIT_SERVER |
+		      CRT_FLAG_BIT_AUTO_SWIM_DISABLE);
+	assert_int_equal(rc, 0);
+
+	rc = crt_proto_register(&my_proto_fmt);
+	assert_int_equal(rc, 0);
+
+	rc = crt_rank_self_set(0);
+	assert_int_equal(rc, 0);
+
+	rc = crt_context_create(&ctx);
+	assert_int_equal(rc, 0);
+
+	/* the pool starts with the preposted handles */
+	rc = crt_context_hdl_pool_stats(ctx, &stats);
+	assert_int_equal(rc, 0);
+	assert_int_equal(stats.hps_num, CRT_HG_POOL_PREPOST_NUM);
+	assert_int_equal(stats.hps_max_num, CRT_HG_POOL_MAX_NUM);
+
+	/* a burst larger than the pool grows it to keep all its handles */
+	ping_send(ctx, BURST_NR);
+	rc = crt_context_hdl_pool_stats(ctx, &stats);
+	assert_int_equal(rc, 0);
+	assert_true(stats.hps_max_num >= BURST_NR);
+	assert_true(stats.hps_num >= BURST_NR);
+	assert_true(stats.hps_misses >= BURST_NR - CRT_HG_POOL_PREPOST_NUM);
+	misses = stats.hps_misses;
+
+	/* the next burst is served from the pool */
+	ping_send(ctx, BURST_NR);
+	rc = crt_context_hdl_pool_stats(ctx, &stats);
+	assert_int_equal(rc, 0);
+	assert_int_equal(stats.hps_misses, misses);
+	assert_true(stats.hps_addr_hits > 0);
+
+	/*
+	 * One RPC at a time for more than two windows, the first one still
+	 * saw the burst, then the pool shrinks back to its minimum.
+	 */
+	for (i = 0; i < 3 * CRT_HG_POOL_WINDOW; i++)
+		ping_send(ctx, 1);
+	rc = crt_context_hdl_pool_stats(ctx, &stats);
+	assert_int_equal(rc, 0);
+	assert_int_equal(stats.hps_max_num, CRT_HG_POOL_PREPOST_NUM);
+	assert_true(stats.hps_num <= CRT_HG_POOL_PREPOST_NUM);
+	assert_int_equal(stats.hps_misses, misses);
+
+	rc = crt_context_destroy(ctx, false);
+	assert_int_equal(rc, 0);
+
+	rc = crt_finalize();
+	assert_int_equal(rc, 0);
+}
+
+static int
+init_tests(void **state)
+{
+	setenv("CRT_PHY_ADDR_STR", "ofi+sockets", 1);
+	setenv("OFI_INTERFACE", "lo", 1);
+	/* no flow control, to have the whole burst in flight */
+	setenv("CRT_CREDIT_EP_CTX", "0", 1);
+
+	return 0;
+}
+
+static int
+fini_tests(void **state)
+{
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_hdl_pool_grow_shrink),
+	};
+
+	d_register_alt_assert(mock_assert);
+
+	return cmocka_run_group_tests_name("utest_hdl_pool", tests, init_tests,
+		fini_tests);
+}
@@ -0,0 +1,237 @@
+/*
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * This file is part of CaRT testing.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <time.h>
+
+#include <cmocka.h>
+
+#include <cart/api.h>
+#include "../cart/crt_internal.h"
+
+/*
+ * Cost model of the simulated group (us): a message takes SEND_COST of the
+ * sender, and arrives LOCAL_LAT or REMOTE_LAT later within or across domains
+ */
+#define SEND_COST	1
+#define LOCAL_LAT	2
+#define REMOTE_LAT	20
+
+struct tree_stats {
+	/* time for the broadcast to reach all the ranks */
+	uint32_t	ts_latency;
+	/* messages crossing domains */
+	uint32_t	ts_remote;
+	/* longest chain of messages from the root */
+	uint32_t	ts_depth;
+};
+
+/* rank i of the group is in domain i % ndoms, as in round-robin placement */
+static uint32_t *
+doms_alloc(uint32_t size, uint32_t ndoms)
+{
+	uint32_t	*doms;
+	uint32_t	 i;
+
+	doms = calloc(size, sizeof(*doms));
+	assert_non_null(doms);
+	for (i = 0; i < size; i++)
+		doms[i] = ndoms == 0 ? CRT_NO_DOMAIN : i % ndoms;
+
+	return doms;
+}
+
+/*
+ * Walk the tree from the root, checking that each rank is reached once and
+ * that its parent is the rank it is reached from, and simulate a broadcast
+ */
+static void
+tree_walk(struct crt_topo_ops *ops, uint32_t size, uint32_t ratio,
+	  uint32_t *doms, uint32_t root, struct tree_stats *stats)
+{
+	uint32_t	*queue;
+	uint32_t	*arrival;
+	uint32_t	*depth;
+	uint32_t	*children;
+	uint32_t	 head = 0;
+	uint32_t	 tail = 0;
+	uint32_t	 nchildren;
+	uint32_t	 parent;
+	uint32_t	 self;
+	uint32_t	 i;
+	int		 rc;
+
+	queue = calloc(size, sizeof(*queue));
+	arrival = calloc(size, sizeof(*arrival));
+	depth = calloc(size, sizeof(*depth));
+	children = calloc(size, sizeof(*children));
+	assert_non_null(queue);
+	assert_non_null(arrival);
+	assert_non_null(depth);
+	assert_non_null(children);
+	memset(stats, 0, sizeof(*stats));
+	for (i = 0; i < size; i++)
+		arrival[i] = UINT32_MAX;
+
+	arrival[root] = 0;
+	queue[tail++] = root;
+	while (head < tail) {
+		self = queue[head++];
+
+		rc = ops->to_get_children_cnt(size, ratio, doms, root, self,
+					      &nchildren);
+		assert_int_equal(rc, 0);
+		assert_true(nchildren < size);
+		if (nchildren == 0)
+			continue;
+
+		rc = ops->to_get_children(size, ratio, doms, root, self,
+					  children);
+		assert_int_equal(rc, 0);
+
+		for (i = 0; i < nchildren; i++) {
+			uint32_t	child = children[i];
+			bool		remote;
+
+			assert_true(child < size);
+			/* reached once */
+			assert_int_equal(arrival[child], UINT32_MAX);
+
+			rc = ops->to_get_parent(size, ratio, doms, root, child,
+						&parent);
+			assert_int_equal(rc, 0);
+			assert_int_equal(parent, self);
+
+			remote = doms == NULL || doms[child] == CRT_NO_DOMAIN ||
+				 doms[child] != doms[self];
+			if (remote)
+				stats->ts_remote++;
+			/* the children are sent to in order */
+			arrival[child] = arrival[self] + (i + 1) * SEND_COST +
+					 (remote ? REMOTE_LAT : LOCAL_LAT);
+			depth[child] = depth[self] + 1;
+			if (arrival[child] > stats->ts_latency)
+				stats->ts_latency = arrival[child];
+			if (depth[child] > stats->ts_depth)
+				stats->ts_depth = depth[child];
+			queue[tail++] = child;
+		}
+	}
+	/* all ranks reached */
+	assert_int_equal(tail, size);
+
+	rc = ops->to_get_parent(size, ratio, doms, root, root, &parent);
+	assert_int_equal(rc, -DER_INVAL);
+
+	free(queue);
+	free(arrival);
+	free(depth);
+	free(children);
+}
+
+static void
+test_tree_domain_shape(void **state)
+{
+	struct tree_stats	 stats;
+	uint32_t		 sizes[] = {1, 2, 7, 64, 129};
+	uint32_t		 ndoms[] = {0, 1, 3, 8};
+	uint32_t		 ratios[] = {2, 4, 32};
+	uint32_t		*doms;
+	uint32_t		 s, d, r, root;
+
+	for (s = 0; s < ARRAY_SIZE(sizes); s++) {
+		for (d = 0; d < ARRAY_SIZE(ndoms); d++) {
+			doms = doms_alloc(sizes[s], ndoms[d]);
+			for (r = 0; r < ARRAY_SIZE(ratios); r++) {
+				for (root = 0; root < sizes[s];
+				     root += sizes[s] / 3 + 1) {
+					tree_walk(&crt_domain_ops, sizes[s],
+						  ratios[r], doms, root,
+						  &stats);
+					if (ndoms[d] == 0 ||
+					    sizes[s] < ndoms[d])
+						continue;
+					/* each domain is entered once */
+					assert_int_equal(stats.ts_remote,
+							 ndoms[d] - 1);
+				}
+			}
+			free(doms);
+		}
+
+		/* no domains set on the group */
+		tree_walk(&crt_domain_ops, sizes[s], 4, NULL, 0, &stats);
+		assert_int_equal(stats.ts_remote, sizes[s] - 1);
+	}
+}
+
+static void
+test_tree_domain_bench(void **state)
+{
+	struct tree_stats	 knomial;
+	struct tree_stats	 domain;
+	uint32_t		 ndoms[] = {4, 16, 64};
+	uint32_t		 per_dom = 16;
+	uint32_t		 ratio = 32;
+	uint32_t		*doms;
+	uint32_t		 d;
+
+	fprintf(stdout, "simulated broadcast, ratio %u, %u ranks per domain, "
+		"send %uus, latency %uus local / %uus remote\n", ratio,
+		per_dom, SEND_COST, LOCAL_LAT, REMOTE_LAT);
+	fprintf(stdout, "%8s %8s | %10s %8s %6s | %10s %8s %6s\n",
+		"domains", "ranks", "knomial us", "remote", "depth",
+		"domain us", "remote", "depth");
+
+	for (d = 0; d < ARRAY_SIZE(ndoms); d++) {
+		uint32_t size = ndoms[d] * per_dom;
+
+		doms = doms_alloc(size, ndoms[d]);
+		tree_walk(&crt_knomial_ops, size, ratio, doms, 0, &knomial);
+		tree_walk(&crt_domain_ops, size, ratio, doms, 0, &domain);
+		free(doms);
+
+		fprintf(stdout, "%8u %8u | %10u %8u %6u | %10u %8u %6u\n",
+			ndoms[d], size, knomial.ts_latency, knomial.ts_remote,
+			knomial.ts_depth, domain.ts_latency, domain.ts_remote,
+			domain.ts_depth);
+
+		assert_true(domain.ts_remote < knomial.ts_remote);
+		assert_true(domain.ts_latency <= knomial.ts_latency);
+	}
+}
+
+static int
+init_tests(void **state)
+{
+	return 0;
+}
+
+static int
+fini_tests(void **state)
+{
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_tree_domain_shape),
+		cmocka_unit_test(test_tree_domain_bench),
+	};
+
+	d_register_alt_assert(mock_assert);
+
+	return cmocka_run_group_tests_name("utest_tree", tests, init_tests,
+		fini_tests);
+}
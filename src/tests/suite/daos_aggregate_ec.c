@@ -556,6 +556,148 @@ test_partial_stripe(struct ec_agg_test_ctx *ctx)
 	assert_rc_equal(rc, 0);
 }
 
+/* Object of the partial cell test, and the rewritten range of its cell 1 */
+#define PCELL_OBJ_LOW	5
+#define PCELL_OFF(len)	((len) + (len) / 4)
+#define PCELL_NR(len)	((len) / 2)
+
+/* Rewrite part of one cell of full stripes, aggregation folds it by delta */
+static void
+test_partial_cell(struct ec_agg_test_ctx *ctx)
+{
+	struct daos_oclass_attr	*oca;
+	unsigned int		 len;
+	int			 i, j, rc;
+
+	dts_ec_agg_oc = DAOS_OC_EC_K4P1_L32K;
+	ec_setup_obj(ctx, dts_ec_agg_oc, PCELL_OBJ_LOW);
+	assert_int_equal(daos_oclass_is_ec(ctx->oid, &oca), true);
+	len = oca->u.ec.e_len;
+
+	for (j = 0; j < NUM_KEYS; j++)
+		for (i = 0; i < NUM_STRIPES; i++) {
+			ec_setup_single_recx_data(ctx, EC_SPECIFIED,
+						  i * (len * 4), len * 4, j,
+						  false, false, 0);
+			rc = daos_obj_update(ctx->oh, DAOS_TX_NONE, 0,
+					     &ctx->dkey, 1, &ctx->update_iod,
+					     &ctx->update_sgl, NULL);
+			assert_rc_equal(rc, 0);
+			ec_cleanup_data(ctx);
+		}
+
+	sleep(2);
+
+	for (j = 0; j < NUM_KEYS; j++)
+		for (i = 0; i < NUM_STRIPES; i++) {
+			ec_setup_single_recx_data(ctx, EC_SPECIFIED,
+						  i * (len * 4) + PCELL_OFF(len),
+						  PCELL_NR(len), j, true,
+						  false, 128);
+			rc = daos_obj_update(ctx->oh, DAOS_TX_NONE, 0,
+					     &ctx->dkey, 1, &ctx->update_iod,
+					     &ctx->update_sgl, NULL);
+			assert_rc_equal(rc, 0);
+			ec_cleanup_data(ctx);
+		}
+
+	rc = daos_obj_close(ctx->oh, NULL);
+	assert_rc_equal(rc, 0);
+}
+
+/*
+ * The parity folded by delta from the partial cell rewrite must be the same
+ * as the parity of the whole stripe encoded from scratch.
+ */
+static void
+verify_partial_cell(struct ec_agg_test_ctx *ctx)
+{
+	struct daos_oclass_attr	*oca;
+	struct obj_ec_codec     *codec;
+	tse_task_t		*task = NULL;
+	unsigned char		**data = NULL;
+	unsigned char		**parity = NULL;
+	unsigned char		*buf = NULL;
+	unsigned int		 k, p, len, shard;
+	int			 i, j, rc;
+
+	ec_setup_obj(ctx, DAOS_OC_EC_K4P1_L32K, PCELL_OBJ_LOW);
+	assert_int_equal(daos_oclass_is_ec(ctx->oid, &oca), true);
+	len = oca->u.ec.e_len;
+	k = oca->u.ec.e_k;
+	p = oca->u.ec.e_p;
+	shard = k;
+	D_ALLOC_ARRAY(data, k);
+	assert_int_equal(!data, 0);
+	D_ALLOC_ARRAY(parity, p);
+	assert_int_equal(!parity, 0);
+	for (i = 0; i < p; i++) {
+		D_ALLOC_ARRAY(parity[i], len);
+		assert_int_equal(!parity[i], 0);
+	}
+
+	ec_setup_single_recx_data(ctx, EC_SPECIFIED, 0, k * len, 0, false,
+				  false, 0);
+	buf = ctx->update_sgl.sg_iovs[0].iov_buf;
+	memset(&buf[PCELL_OFF(len)], 128, PCELL_NR(len));
+	for (j = 0; j < k; j++)
+		data[j] = &buf[j * len];
+	codec = obj_ec_codec_get(daos_obj_id2class(ctx->oid));
+	ec_encode_data(len, k, p, codec->ec_gftbls, data, parity);
+	ec_cleanup_data(ctx);
+
+	for (j = 0; j < NUM_KEYS; j++)
+		for (i = 0; i < NUM_STRIPES; i++) {
+			ec_setup_single_recx_data(ctx, EC_SPECIFIED,
+						  i * (k * len), k * len, j,
+						  false, false, 0);
+			ctx->fetch_iom.iom_flags = DAOS_IOMF_DETAIL;
+			rc = dc_obj_fetch_task_create(ctx->oh, DAOS_TX_NONE, 0,
+						      &ctx->dkey, 1,
+						      DIOF_TO_SPEC_SHARD,
+						      &ctx->fetch_iod,
+						      &ctx->fetch_sgl,
+						      &ctx->fetch_iom, &shard,
+						      NULL, NULL, &task);
+			assert_rc_equal(rc, 0);
+			rc = dc_task_schedule(task, true);
+			assert_rc_equal(rc, 0);
+			/* verify the rewrite has been aggregated */
+			assert_int_equal(ctx->fetch_iom.iom_nr_out, 0);
+			task = NULL;
+			memset(&ctx->fetch_iom, 0, sizeof(daos_iom_t));
+			ctx->fetch_iom.iom_flags = DAOS_IOMF_DETAIL;
+			ctx->fetch_iod.iod_recxs[0].rx_idx = (i * len) |
+							     PARITY_INDICATOR;
+			ctx->fetch_iod.iod_recxs[0].rx_nr = len;
+			ctx->iom_recx.rx_nr = len;
+			rc = dc_obj_fetch_task_create(ctx->oh, DAOS_TX_NONE, 0,
+						      &ctx->dkey, 1,
+						      DIOF_TO_SPEC_SHARD,
+						      &ctx->fetch_iod,
+						      &ctx->fetch_sgl,
+						      &ctx->fetch_iom, &shard,
+						      NULL, NULL, &task);
+			assert_rc_equal(rc, 0);
+			rc = dc_task_schedule(task, true);
+			assert_rc_equal(rc, 0);
+			/* verify the parity matches a full re-encode */
+			assert_int_equal(ctx->fetch_iom.iom_nr_out, 1);
+			assert_int_equal(memcmp(ctx->
+						fetch_sgl.sg_iovs[0].iov_buf,
+						parity[0], len), 0);
+			task = NULL;
+			ec_cleanup_data(ctx);
+		}
+	rc = daos_obj_close(ctx->oh, NULL);
+	assert_rc_equal(rc, 0);
+
+	for (i = 0; i < p; i++)
+		D_FREE(parity[i]);
+	D_FREE(parity);
+	D_FREE(data);
+}
+
 static void
 setup_ec_agg_tests(void **statep, struct ec_agg_test_ctx *ctx)
 {
@@ -579,12 +721,14 @@ test_all_ec_agg(void **statep)
 	test_half_stripe(&ctx);
 #endif
 	test_partial_stripe(&ctx);
+	test_partial_cell(&ctx);
 	sleep(60);
 	verify_1p(&ctx, DAOS_OC_EC_K2P1_L32K, 2);
 #ifdef LAYER_COORD
 	verify_2p(&ctx, DAOS_OC_EC_K2P2_L32K);
 #endif
 	verify_1p(&ctx, DAOS_OC_EC_K4P1_L32K, 4);
+	verify_partial_cell(&ctx);
 	cleanup_ec_agg_tests(&ctx);
 }
 
@@ -17,6 +17,7 @@
 #include <daos/pool.h>
 #include <daos/mgmt.h>
 #include <daos/container.h>
+#include <daos/object.h>
 
 static void
 degrade_ec_internal(void **state, int *shards, int shards_nr, int write_type)
@@ -288,6 +289,95 @@ degrade_dfs_fail_data_parity_s3p0(void **state)
 	dfs_ec_rebuild_io(state, shards, 2);
 }
 
+/* one full stripe of OC_EC_4P2G1 */
+#define DEGRADE_CACHE_DATA_SIZE	(4 << 20)
+
+struct degrade_cache_stats {
+	uint64_t	hits;
+	uint64_t	misses;
+	uint64_t	dropped;
+};
+
+static void
+degrade_cache_fetch(struct ioreq *req, char *data, char *expected,
+		    struct degrade_cache_stats *stats)
+{
+	memset(data, 0, DEGRADE_CACHE_DATA_SIZE);
+	lookup_single_with_rxnr("dkey", "akey", 0, data, 1,
+				DEGRADE_CACHE_DATA_SIZE, DAOS_TX_NONE, req);
+	assert_memory_equal(data, expected, DEGRADE_CACHE_DATA_SIZE);
+	dc_obj_ec_recov_cache_stats(&stats->hits, &stats->misses,
+				    &stats->dropped);
+}
+
+static void
+degrade_recov_cache(void **state)
+{
+	test_arg_t			*arg = *state;
+	struct degrade_cache_stats	 stats[2];
+	daos_obj_id_t			 oid;
+	struct ioreq			 req;
+	uint16_t			 fail_shard = 1 + 1;
+	d_rank_t			 rank;
+	char				*data;
+	char				*expected;
+
+	if (!test_runable(arg, 6))
+		return;
+
+	oid = daos_test_oid_gen(arg->coh, OC_EC_4P2G1, 0, 0, arg->myrank);
+	ioreq_init(&req, arg->coh, oid, DAOS_IOD_ARRAY, arg);
+	D_ALLOC(data, DEGRADE_CACHE_DATA_SIZE);
+	assert_non_null(data);
+	D_ALLOC(expected, DEGRADE_CACHE_DATA_SIZE);
+	assert_non_null(expected);
+
+	make_buffer(expected, 'a', DEGRADE_CACHE_DATA_SIZE);
+	insert_single_with_rxnr("dkey", "akey", 0, expected, 1,
+				DEGRADE_CACHE_DATA_SIZE, DAOS_TX_NONE, &req);
+
+	/* fetches of shard 1 fail, its cell is rebuilt from the stripe */
+	daos_fail_value_set(daos_shard_fail_value(&fail_shard, 1));
+	daos_fail_loc_set(DAOS_FAIL_SHARD_FETCH | DAOS_FAIL_ALWAYS);
+
+	print_message("the second degraded fetch hits the cache\n");
+	degrade_cache_fetch(&req, data, expected, &stats[0]);
+	degrade_cache_fetch(&req, data, expected, &stats[1]);
+	/* disabled by DAOS_EC_RECOV_CACHE_SIZE=0 */
+	if (stats[1].misses == stats[0].misses &&
+	    stats[1].hits == stats[0].hits) {
+		print_message("EC recovery cache disabled, skipping\n");
+		goto out;
+	}
+	assert_int_equal(stats[1].hits, stats[0].hits + 1);
+	assert_int_equal(stats[1].misses, stats[0].misses);
+
+	print_message("an update of the stripe is not served from cache\n");
+	make_buffer(expected, 'b', DEGRADE_CACHE_DATA_SIZE);
+	insert_single_with_rxnr("dkey", "akey", 0, expected, 1,
+				DEGRADE_CACHE_DATA_SIZE, DAOS_TX_NONE, &req);
+	degrade_cache_fetch(&req, data, expected, &stats[0]);
+	assert_int_equal(stats[0].hits, stats[1].hits);
+	assert_int_equal(stats[0].misses, stats[1].misses + 1);
+	degrade_cache_fetch(&req, data, expected, &stats[1]);
+	assert_int_equal(stats[1].hits, stats[0].hits + 1);
+
+	print_message("a pool map change drops the cached stripe\n");
+	rank = get_rank_by_oid_shard(arg, oid, 5);
+	rebuild_single_pool_rank(arg, rank, false);
+	degrade_cache_fetch(&req, data, expected, &stats[0]);
+	assert_int_equal(stats[0].hits, stats[1].hits);
+	assert_int_equal(stats[0].dropped, stats[1].dropped + 1);
+
+	rebuild_add_back_tgts(arg, rank, NULL, 1);
+out:
+	daos_fail_loc_set(0);
+	daos_fail_value_set(0);
+	D_FREE(expected);
+	D_FREE(data);
+	ioreq_fini(&req);
+}
+
 #define DEGRADE_SMALL_POOL_SIZE (1ULL << 28)
 int
 degrade_small_sub_setup(void **state)
@@ -366,6 +456,8 @@ static const struct CMUnitTest degrade_tests[] = {
 	{"DEGRADE22: degrade io with 1data 1parity(s2, p0)",
 	 degrade_dfs_fail_data_parity_s2p0, degrade_small_sub_setup,
 	 test_teardown},
+	{"DEGRADE23: degrade fetch reuses and drops reconstructed stripes",
+	 degrade_recov_cache, degrade_small_sub_setup, test_teardown},
 };
 
 int
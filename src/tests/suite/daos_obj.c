@@ -14,6 +14,9 @@
 #include "daos_iotest.h"
 #include <daos_types.h>
 #include <daos/checksum.h>
+#include <daos/container.h>
+#include <daos/object.h>
+#include <daos/placement.h>
 
 int dts_obj_class	= OC_RP_2G1;
 int dts_obj_replica_cnt	= 2;
@@ -4120,6 +4123,399 @@ io_fetch_retry_another_replica(void **state)
 	ioreq_fini(&req);
 }
 
+/* akeys of the mixed bulk update, large ones are pulled in chunks */
+#define MIXED_BULK_NR	4
+
+/**
+ * Update akeys of small and large arrays in one RPC, with the engines pulling
+ * data larger than DAOS_BULK_CHUNK in chunks, the large ones are written back
+ * while the other transfers of the same update are still in flight.
+ */
+static void
+io_mixed_bulk_pipeline(void **state)
+{
+	test_arg_t	*arg = *state;
+	daos_obj_id_t	 oid;
+	daos_handle_t	 oh;
+	d_iov_t		 dkey;
+	daos_iod_t	 iods[MIXED_BULK_NR];
+	daos_recx_t	 recxs[MIXED_BULK_NR];
+	d_sg_list_t	 sgls[MIXED_BULK_NR];
+	d_iov_t		 iovs[MIXED_BULK_NR];
+	char		 akeys[MIXED_BULK_NR][16];
+	char		*update_bufs[MIXED_BULK_NR];
+	char		*fetch_bufs[MIXED_BULK_NR];
+	daos_size_t	 sizes[MIXED_BULK_NR] = {
+		16 << 10, 4 << 20, 64 << 10, (3 << 20) + 123 };
+	int		 i;
+	int		 rc;
+
+	oid = daos_test_oid_gen(arg->coh, dts_obj_class, 0, 0, arg->myrank);
+	rc = daos_obj_open(arg->coh, oid, 0, &oh, NULL);
+	assert_rc_equal(rc, 0);
+
+	d_iov_set(&dkey, "dkey_mixed_bulk", strlen("dkey_mixed_bulk"));
+	for (i = 0; i < MIXED_BULK_NR; i++) {
+		D_ALLOC(update_bufs[i], sizes[i]);
+		assert_non_null(update_bufs[i]);
+		D_ALLOC(fetch_bufs[i], sizes[i]);
+		assert_non_null(fetch_bufs[i]);
+		dts_buf_render(update_bufs[i], sizes[i]);
+
+		snprintf(akeys[i], sizeof(akeys[i]), "akey_%d", i);
+		d_iov_set(&iods[i].iod_name, akeys[i], strlen(akeys[i]));
+		recxs[i].rx_idx = 0;
+		recxs[i].rx_nr = sizes[i];
+		iods[i].iod_type = DAOS_IOD_ARRAY;
+		iods[i].iod_size = 1;
+		iods[i].iod_nr = 1;
+		iods[i].iod_recxs = &recxs[i];
+
+		d_iov_set(&iovs[i], update_bufs[i], sizes[i]);
+		sgls[i].sg_nr = 1;
+		sgls[i].sg_nr_out = 0;
+		sgls[i].sg_iovs = &iovs[i];
+	}
+
+	print_message("update %d akeys of small and large arrays at once\n",
+		      MIXED_BULK_NR);
+	rc = daos_obj_update(oh, DAOS_TX_NONE, 0, &dkey, MIXED_BULK_NR, iods,
+			     sgls, NULL);
+	assert_rc_equal(rc, 0);
+
+	for (i = 0; i < MIXED_BULK_NR; i++)
+		d_iov_set(&iovs[i], fetch_bufs[i], sizes[i]);
+	rc = daos_obj_fetch(oh, DAOS_TX_NONE, 0, &dkey, MIXED_BULK_NR, iods,
+			    sgls, NULL, NULL);
+	assert_rc_equal(rc, 0);
+
+	for (i = 0; i < MIXED_BULK_NR; i++) {
+		assert_int_equal(iods[i].iod_size, 1);
+		assert_memory_equal(update_bufs[i], fetch_bufs[i], sizes[i]);
+		D_FREE(update_bufs[i]);
+		D_FREE(fetch_bufs[i]);
+	}
+
+	rc = daos_obj_close(oh, NULL);
+	assert_rc_equal(rc, 0);
+	print_message("all good\n");
+}
+
+/* Above the inline threshold, below the max size of the cached bulk buffers */
+#define CRYPT_IO_SIZE	(32 << 10)
+
+/**
+ * Update and fetch \a CRYPT_IO_SIZE bytes in container \a coh, return the bytes
+ * copied by the bulk buffer cache and whether it served the I/Os.
+ */
+static void
+crypt_io_copied(test_arg_t *arg, daos_handle_t coh, uint64_t *copied,
+		bool *cached)
+{
+	daos_obj_id_t	 oid;
+	daos_handle_t	 oh;
+	d_iov_t		 dkey;
+	daos_iod_t	 iod;
+	daos_recx_t	 recx;
+	d_sg_list_t	 sgl;
+	d_iov_t		 iov;
+	char		*update_buf;
+	char		*fetch_buf;
+	uint64_t	 hits[2];
+	uint64_t	 misses[2];
+	uint64_t	 bytes[2];
+	int		 rc;
+
+	D_ALLOC(update_buf, CRYPT_IO_SIZE);
+	assert_non_null(update_buf);
+	D_ALLOC(fetch_buf, CRYPT_IO_SIZE);
+	assert_non_null(fetch_buf);
+	dts_buf_render(update_buf, CRYPT_IO_SIZE);
+
+	oid = daos_test_oid_gen(coh, dts_obj_class, 0, 0, arg->myrank);
+	rc = daos_obj_open(coh, oid, 0, &oh, NULL);
+	assert_rc_equal(rc, 0);
+
+	d_iov_set(&dkey, "dkey_crypt", strlen("dkey_crypt"));
+	d_iov_set(&iod.iod_name, "akey_crypt", strlen("akey_crypt"));
+	recx.rx_idx = 0;
+	recx.rx_nr = CRYPT_IO_SIZE;
+	iod.iod_type = DAOS_IOD_ARRAY;
+	iod.iod_size = 1;
+	iod.iod_nr = 1;
+	iod.iod_recxs = &recx;
+	sgl.sg_nr = 1;
+	sgl.sg_nr_out = 0;
+	sgl.sg_iovs = &iov;
+
+	dc_obj_bulk_cache_stats(&hits[0], &misses[0], &bytes[0]);
+	d_iov_set(&iov, update_buf, CRYPT_IO_SIZE);
+	rc = daos_obj_update(oh, DAOS_TX_NONE, 0, &dkey, 1, &iod, &sgl, NULL);
+	assert_rc_equal(rc, 0);
+
+	d_iov_set(&iov, fetch_buf, CRYPT_IO_SIZE);
+	rc = daos_obj_fetch(oh, DAOS_TX_NONE, 0, &dkey, 1, &iod, &sgl, NULL,
+			    NULL);
+	assert_rc_equal(rc, 0);
+	dc_obj_bulk_cache_stats(&hits[1], &misses[1], &bytes[1]);
+	assert_memory_equal(update_buf, fetch_buf, CRYPT_IO_SIZE);
+
+	*copied = bytes[1] - bytes[0];
+	*cached = hits[1] + misses[1] != hits[0] + misses[0];
+
+	rc = daos_obj_close(oh, NULL);
+	assert_rc_equal(rc, 0);
+	D_FREE(update_buf);
+	D_FREE(fetch_buf);
+}
+
+/**
+ * The data of an encrypted container is encrypted into the buffer registered
+ * for bulk on update, and decrypted in place in the user buffer on fetch. It
+ * must never be copied again through the cached bulk buffers.
+ */
+static void
+io_encrypt_no_copy(void **state)
+{
+	test_arg_t	*arg = *state;
+	daos_prop_t	*prop;
+	daos_handle_t	 coh;
+	uuid_t		 uuid;
+	char		 key_path[] = "/tmp/daos_test_key.XXXXXX";
+	unsigned char	 key[64];
+	char		*key_env;
+	uint64_t	 copied;
+	bool		 cached;
+	int		 fd;
+	int		 i;
+	int		 rc;
+
+	/* the plaintext I/O goes through the cache, if it is enabled */
+	crypt_io_copied(arg, arg->coh, &copied, &cached);
+	print_message("plaintext: "DF_U64" bytes copied by the bulk cache\n",
+		      copied);
+	if (cached)
+		assert_int_equal(copied, 2 * CRYPT_IO_SIZE);
+
+	key_env = getenv("DAOS_CONT_ENCRYPT_KEY_FILE");
+	if (key_env == NULL) {
+		for (i = 0; i < sizeof(key); i++)
+			key[i] = rand();
+		/* created with 0600, as the key file must be */
+		fd = mkstemp(key_path);
+		assert_true(fd >= 0);
+		assert_int_equal(write(fd, key, sizeof(key)), sizeof(key));
+		close(fd);
+		setenv("DAOS_CONT_ENCRYPT_KEY_FILE", key_path, 1);
+	}
+
+	prop = daos_prop_alloc(1);
+	assert_non_null(prop);
+	prop->dpp_entries[0].dpe_type = DAOS_PROP_CO_ENCRYPT;
+	prop->dpp_entries[0].dpe_val = DAOS_PROP_CO_ENCRYPT_AES_XTS256;
+
+	uuid_generate(uuid);
+	rc = daos_cont_create(arg->pool.poh, uuid, prop, NULL);
+	assert_rc_equal(rc, 0);
+	rc = daos_cont_open(arg->pool.poh, uuid, DAOS_COO_RW, &coh, NULL,
+			    NULL);
+	assert_rc_equal(rc, 0);
+
+	crypt_io_copied(arg, coh, &copied, &cached);
+	print_message("encrypted: "DF_U64" bytes copied by the bulk cache\n",
+		      copied);
+	assert_false(cached);
+	assert_int_equal(copied, 0);
+
+	rc = daos_cont_close(coh, NULL);
+	assert_rc_equal(rc, 0);
+	rc = daos_cont_destroy(arg->pool.poh, uuid, 1, NULL);
+	assert_rc_equal(rc, 0);
+	daos_prop_free(prop);
+
+	if (key_env == NULL) {
+		unsetenv("DAOS_CONT_ENCRYPT_KEY_FILE");
+		unlink(key_path);
+	}
+	print_message("all good\n");
+}
+
+/**
+ * Re-opening an object under the same pool map reuses the layout cached by the
+ * container handle.
+ */
+static void
+io_layout_cache(void **state)
+{
+	test_arg_t			*arg = *state;
+	struct pl_layout_cache_stats	 stats[2];
+	daos_obj_id_t			 oid;
+	daos_handle_t			 oh;
+	int				 i;
+	int				 rc;
+
+	oid = daos_test_oid_gen(arg->coh, dts_obj_class, 0, 0, arg->myrank);
+	rc = dc_cont_layout_cache_stats(arg->coh, &stats[0]);
+	assert_rc_equal(rc, 0);
+	for (i = 0; i < 2; i++) {
+		rc = daos_obj_open(arg->coh, oid, 0, &oh, NULL);
+		assert_rc_equal(rc, 0);
+		rc = daos_obj_close(oh, NULL);
+		assert_rc_equal(rc, 0);
+	}
+	rc = dc_cont_layout_cache_stats(arg->coh, &stats[1]);
+	assert_rc_equal(rc, 0);
+
+	print_message("layout cache: "DF_U64" hits, "DF_U64" misses\n",
+		      stats[1].lcs_hits - stats[0].lcs_hits,
+		      stats[1].lcs_misses - stats[0].lcs_misses);
+	/* disabled by DAOS_LAYOUT_CACHE_BITS=0 */
+	if (stats[1].lcs_misses == stats[0].lcs_misses) {
+		assert_int_equal(stats[1].lcs_hits, stats[0].lcs_hits);
+		print_message("layout cache disabled, skipping\n");
+		return;
+	}
+
+	/* the pool map may be refreshed between the two opens */
+	assert_true(stats[1].lcs_hits - stats[0].lcs_hits +
+		    stats[1].lcs_misses - stats[0].lcs_misses == 2);
+	if (stats[1].lcs_evicts == stats[0].lcs_evicts)
+		assert_int_equal(stats[1].lcs_hits - stats[0].lcs_hits, 1);
+	print_message("all good\n");
+}
+
+/* Updates sent together, less than any batch size enabling the coalescing */
+#define COALESCE_IO_NR	2
+
+/**
+ * Send a small async update of each dkey of \a dkeys to object \a oh, all at
+ * once, and return their results in \a results.
+ */
+static void
+coalesce_io(test_arg_t *arg, daos_handle_t oh, const char **dkeys,
+	    int *results)
+{
+	daos_event_t	ev[COALESCE_IO_NR];
+	d_iov_t		dkey[COALESCE_IO_NR];
+	daos_iod_t	iod[COALESCE_IO_NR];
+	daos_recx_t	recx[COALESCE_IO_NR];
+	d_sg_list_t	sgl[COALESCE_IO_NR];
+	d_iov_t		iov[COALESCE_IO_NR];
+	char		buf[COALESCE_IO_NR][32];
+	bool		flag;
+	int		i;
+	int		rc;
+
+	for (i = 0; i < COALESCE_IO_NR; i++) {
+		dts_buf_render(buf[i], sizeof(buf[i]));
+		d_iov_set(&dkey[i], (void *)dkeys[i], strlen(dkeys[i]));
+		d_iov_set(&iod[i].iod_name, "akey", strlen("akey"));
+		recx[i].rx_idx = 0;
+		recx[i].rx_nr = sizeof(buf[i]);
+		iod[i].iod_type = DAOS_IOD_ARRAY;
+		iod[i].iod_size = 1;
+		iod[i].iod_nr = 1;
+		iod[i].iod_recxs = &recx[i];
+		d_iov_set(&iov[i], buf[i], sizeof(buf[i]));
+		sgl[i].sg_nr = 1;
+		sgl[i].sg_nr_out = 0;
+		sgl[i].sg_iovs = &iov[i];
+
+		rc = daos_event_init(&ev[i], arg->eq, NULL);
+		assert_rc_equal(rc, 0);
+		rc = daos_obj_update(oh, DAOS_TX_NONE, 0, &dkey[i], 1, &iod[i],
+				     &sgl[i], &ev[i]);
+		assert_rc_equal(rc, 0);
+	}
+
+	for (i = 0; i < COALESCE_IO_NR; i++) {
+		rc = daos_event_test(&ev[i], DAOS_EQ_WAIT, &flag);
+		assert_rc_equal(rc, 0);
+		assert_true(flag);
+		results[i] = ev[i].ev_error;
+		rc = daos_event_fini(&ev[i]);
+		assert_rc_equal(rc, 0);
+	}
+}
+
+/**
+ * Small updates to the same target are coalesced into one CPD RPC, and when
+ * one of them fails, each caller still gets the result of its own update.
+ * Only runs when coalescing is enabled, by DAOS_OBJ_COALESCE_NR.
+ */
+static void
+io_coalesce_updates(void **state)
+{
+	test_arg_t	*arg = *state;
+	const char	*dkeys[COALESCE_IO_NR];
+	daos_obj_id_t	 oid;
+	daos_handle_t	 oh;
+	d_iov_t		 dkey;
+	daos_iod_t	 iod;
+	d_sg_list_t	 sgl;
+	d_iov_t		 iov;
+	uint64_t	 val = 1;
+	uint64_t	 commits[2];
+	uint64_t	 updates[2];
+	uint64_t	 resubmits[2];
+	int		 results[COALESCE_IO_NR];
+	int		 i;
+	int		 rc;
+
+	/* all the dkeys of a single shard object have the same leader */
+	oid = daos_test_oid_gen(arg->coh, OC_S1, 0, 0, arg->myrank);
+	rc = daos_obj_open(arg->coh, oid, 0, &oh, NULL);
+	assert_rc_equal(rc, 0);
+
+	/* an array update of this akey fails, it is a single value */
+	d_iov_set(&dkey, "dkey_sv", strlen("dkey_sv"));
+	d_iov_set(&iod.iod_name, "akey", strlen("akey"));
+	iod.iod_type = DAOS_IOD_SINGLE;
+	iod.iod_size = sizeof(val);
+	iod.iod_nr = 1;
+	iod.iod_recxs = NULL;
+	d_iov_set(&iov, &val, sizeof(val));
+	sgl.sg_nr = 1;
+	sgl.sg_nr_out = 0;
+	sgl.sg_iovs = &iov;
+	rc = daos_obj_update(oh, DAOS_TX_NONE, 0, &dkey, 1, &iod, &sgl, NULL);
+	assert_rc_equal(rc, 0);
+
+	print_message("coalesced updates succeed in one CPD RPC\n");
+	dkeys[0] = "dkey_0";
+	dkeys[1] = "dkey_1";
+	dc_obj_coalesce_stats(&commits[0], &updates[0], &resubmits[0]);
+	coalesce_io(arg, oh, dkeys, results);
+	dc_obj_coalesce_stats(&commits[1], &updates[1], &resubmits[1]);
+	for (i = 0; i < COALESCE_IO_NR; i++)
+		assert_rc_equal(results[i], 0);
+
+	if (updates[1] == updates[0]) {
+		print_message("coalescing disabled, skipping\n");
+		goto out;
+	}
+	assert_int_equal(updates[1] - updates[0], COALESCE_IO_NR);
+	assert_int_equal(commits[1] - commits[0], 1);
+	assert_int_equal(resubmits[1] - resubmits[0], 0);
+
+	print_message("a failed update is reported to its caller only\n");
+	dkeys[0] = "dkey_sv";
+	dkeys[1] = "dkey_2";
+	dc_obj_coalesce_stats(&commits[0], &updates[0], &resubmits[0]);
+	coalesce_io(arg, oh, dkeys, results);
+	dc_obj_coalesce_stats(&commits[1], &updates[1], &resubmits[1]);
+	assert_rc_equal(results[0], -DER_NO_PERM);
+	assert_rc_equal(results[1], 0);
+	assert_int_equal(updates[1] - updates[0], COALESCE_IO_NR);
+	assert_int_equal(commits[1] - commits[0], 1);
+	assert_int_equal(resubmits[1] - resubmits[0], COALESCE_IO_NR);
+
+	print_message("all good\n");
+out:
+	rc = daos_obj_close(oh, NULL);
+	assert_rc_equal(rc, 0);
+}
+
 static const struct CMUnitTest io_tests[] = {
 	{ "IO1: simple update/fetch/verify",
 	  io_simple, async_disable, test_case_teardown},
@@ -4207,6 +4603,14 @@ static const struct CMUnitTest io_tests[] = {
 	{ "IO42: IO fetch from an alternative node after first try failed",
 	  io_fetch_retry_another_replica, async_disable,
 	  test_case_teardown},
+	{ "IO43: update mixing chunked and single bulk pulls",
+	  io_mixed_bulk_pipeline, async_disable, test_case_teardown},
+	{ "IO44: encrypted data is not copied by the bulk cache",
+	  io_encrypt_no_copy, async_disable, test_case_teardown},
+	{ "IO45: object layout is cached by the container handle",
+	  io_layout_cache, async_disable, test_case_teardown},
+	{ "IO46: small updates to one target are coalesced",
+	  io_coalesce_updates, async_disable, test_case_teardown},
 };
 
 int
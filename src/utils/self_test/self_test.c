@@ -265,6 +265,11 @@ status_req_cb(const struct crt_cb_info *cb_info)
 	 *   (they are on x86 if 4-byte aligned)
 	 */
 	return_status->test_duration_ns = reply_status->test_duration_ns;
+	return_status->proc_inplace = reply_status->proc_inplace;
+	return_status->proc_alloc = reply_status->proc_alloc;
+	return_status->batch_envs = reply_status->batch_envs;
+	return_status->batch_rpcs = reply_status->batch_rpcs;
+	return_status->cpu_ns = reply_status->cpu_ns;
 	return_status->num_remaining = reply_status->num_remaining;
 	return_status->status = reply_status->status;
 }
@@ -313,6 +318,31 @@ static void print_fail_counts(struct st_latency *latencies,
 
 }
 
+/*
+ * Print the transport messages the requests took and the CPU time spent by the
+ * master endpoint, which RPC batching (CRT_BATCH_DELAY) trades with latency
+ */
+static void print_batch_results(struct crt_st_status_req_out *reply,
+				struct crt_st_start_params *test_params)
+{
+	uint64_t	num_msgs;
+	double		duration_s;
+
+	/* Each envelope carries batch_rpcs / batch_envs requests */
+	num_msgs = test_params->rep_count;
+	if (reply->batch_rpcs <= num_msgs)
+		num_msgs = num_msgs - reply->batch_rpcs + reply->batch_envs;
+	duration_s = reply->test_duration_ns / 1000000000.0F;
+
+	printf("\tRPC Batching:\n"
+	       "\t\tMessages/sec: %.0f\n"
+	       "\t\tRPCs/message: %.2f\n"
+	       "\t\tCPU us/RPC  : %.2f\n",
+	       num_msgs / duration_s,
+	       (double)test_params->rep_count / num_msgs,
+	       reply->cpu_ns / 1000.0F / test_params->rep_count);
+}
+
 static void print_results(struct st_latency *latencies,
 			  struct crt_st_start_params *test_params,
 			  int64_t test_duration_ns, int output_megabits)
@@ -730,6 +760,17 @@ static int test_msg_size(crt_context_t crt_ctx,
 		print_results(latencies[m_idx], test_params,
 			      ms_endpts[m_idx].reply.test_duration_ns,
 			      output_megabits);
+
+		/* Input decodes done by the endpoints, per RPC */
+		printf("\tRPC Input Decodes (per RPC):\n"
+		       "\t\tIn place   : %.2f\n"
+		       "\t\tAllocations: %.2f\n",
+		       (double)ms_endpts[m_idx].reply.proc_inplace /
+		       test_params->rep_count,
+		       (double)ms_endpts[m_idx].reply.proc_alloc /
+		       test_params->rep_count);
+
+		print_batch_results(&ms_endpts[m_idx].reply, test_params);
 	}
 
 	return 0;
@@ -764,13 +805,161 @@ randomize_endpts(struct st_endpoint *endpts, uint32_t num_endpts)
 	printf("\n");
 }
 
+/* One sending thread of the submission overhead test */
+struct st_submit_thread {
+	pthread_t		 tid;
+	crt_context_t		 crt_ctx;
+	crt_group_t		*srv_grp;
+	struct st_endpoint	*endpts;
+	uint32_t		 num_endpts;
+	uint32_t		 rep_count;
+	uint32_t		 max_inflight;
+	uint32_t		 sent;
+	ATOMIC uint32_t		 completed;
+	ATOMIC uint32_t		 failed;
+	/* time spent in crt_req_send() */
+	int64_t			 submit_ns;
+	int			 rc;
+};
+
+static void
+submit_test_cb(const struct crt_cb_info *cb_info)
+{
+	struct st_submit_thread *thread = cb_info->cci_arg;
+
+	if (cb_info->cci_rc != 0)
+		atomic_fetch_add_relaxed(&thread->failed, 1);
+	atomic_fetch_add_relaxed(&thread->completed, 1);
+}
+
+static void *submit_test_fn(void *arg)
+{
+	struct st_submit_thread	*thread = arg;
+	struct st_endpoint	*st_endpt;
+	crt_endpoint_t		 endpt;
+	crt_rpc_t		*new_rpc;
+	struct timespec		 t_start;
+	struct timespec		 t_end;
+	uint32_t		 sent;
+	int			 ret;
+
+	endpt.ep_grp = thread->srv_grp;
+	for (sent = 0; sent < thread->rep_count; sent++) {
+		while (sent - atomic_load_relaxed(&thread->completed) >=
+		       thread->max_inflight)
+			sched_yield();
+
+		st_endpt = &thread->endpts[sent % thread->num_endpts];
+		endpt.ep_rank = st_endpt->rank;
+		endpt.ep_tag = st_endpt->tag;
+		ret = crt_req_create(thread->crt_ctx, &endpt,
+				     CRT_OPC_SELF_TEST_BOTH_EMPTY, &new_rpc);
+		if (ret != 0) {
+			D_ERROR("crt_req_create failed; ret = %d\n", ret);
+			thread->rc = ret;
+			break;
+		}
+
+		d_gettime(&t_start);
+		/* failures are reported through the callback */
+		crt_req_send(new_rpc, submit_test_cb, thread);
+		d_gettime(&t_end);
+		thread->submit_ns += d_timediff_ns(&t_start, &t_end);
+	}
+
+	/* Wait for the replies of everything sent */
+	while (atomic_load_relaxed(&thread->completed) < sent)
+		sched_yield();
+	thread->sent = sent;
+
+	pthread_exit(NULL);
+}
+
+/*
+ * Send empty RPCs to the endpoints from num_threads threads sharing the
+ * context, and report the time each RPC spends in crt_req_send(), i.e. the
+ * cost of submitting it to the context, along with the overall throughput.
+ */
+static int test_submit_overhead(crt_context_t crt_ctx, crt_group_t *srv_grp,
+				struct st_endpoint *endpts,
+				uint32_t num_endpts, int rep_count,
+				int max_inflight, int num_threads)
+{
+	struct st_submit_thread	*threads;
+	struct timespec		 t_start;
+	struct timespec		 t_end;
+	int64_t			 duration_ns;
+	int64_t			 submit_ns = 0;
+	int64_t			 thread_ns;
+	int64_t			 max_thread_ns = 0;
+	uint32_t		 sent = 0;
+	uint32_t		 failed = 0;
+	int			 started;
+	int			 i;
+	int			 ret = 0;
+
+	D_ALLOC_ARRAY(threads, num_threads);
+	if (threads == NULL)
+		return -DER_NOMEM;
+
+	d_gettime(&t_start);
+	for (started = 0; started < num_threads; started++) {
+		struct st_submit_thread *thread = &threads[started];
+
+		thread->crt_ctx = crt_ctx;
+		thread->srv_grp = srv_grp;
+		thread->endpts = endpts;
+		thread->num_endpts = num_endpts;
+		thread->rep_count = rep_count / num_threads +
+				    (started < rep_count % num_threads);
+		thread->max_inflight = max(max_inflight / num_threads, 1);
+		ret = pthread_create(&thread->tid, NULL, submit_test_fn,
+				     thread);
+		if (ret != 0) {
+			D_ERROR("failed to create sending thread: %s\n",
+				strerror(ret));
+			ret = -DER_MISC;
+			break;
+		}
+	}
+
+	for (i = 0; i < started; i++) {
+		pthread_join(threads[i].tid, NULL);
+		sent += threads[i].sent;
+		failed += threads[i].failed;
+		submit_ns += threads[i].submit_ns;
+		if (threads[i].sent > 0) {
+			thread_ns = threads[i].submit_ns / threads[i].sent;
+			max_thread_ns = max(max_thread_ns, thread_ns);
+		}
+		if (ret == 0)
+			ret = threads[i].rc;
+	}
+	d_gettime(&t_end);
+	duration_ns = d_timediff_ns(&t_start, &t_end);
+
+	if (sent > 0)
+		printf("Submission overhead (%d sending threads, empty RPCs):\n"
+		       "\tRPCs sent: %u, failed: %u\n"
+		       "\tRPC Throughput (RPCs/sec): %.0f\n"
+		       "\tcrt_req_send() per RPC (ns):\n"
+		       "\t\tAverage          : %ld\n"
+		       "\t\tSlowest thread   : %ld\n\n",
+		       started, sent, failed,
+		       sent / (duration_ns / 1000000000.0F),
+		       submit_ns / sent, max_thread_ns);
+
+	D_FREE(threads);
+	return ret;
+}
+
 static int run_self_test(struct st_size_params all_params[],
 			 int num_msg_sizes, int rep_count, int max_inflight,
 			 char *dest_name, struct st_endpoint *ms_endpts_in,
 			 uint32_t num_ms_endpts_in,
 			 struct st_endpoint *endpts, uint32_t num_endpts,
 			 int output_megabits, int16_t buf_alignment,
-			 char *attach_info_path)
+			 char *attach_info_path, int submit_threads)
 {
 	crt_context_t		  crt_ctx;
 	crt_group_t		 *srv_grp;
@@ -809,6 +998,13 @@ static int run_self_test(struct st_size_params all_params[],
 		D_GOTO(cleanup_nothread, ret);
 	}
 
+	if (submit_threads > 0) {
+		ret = test_submit_overhead(crt_ctx, srv_grp, endpts,
+					   num_endpts, rep_count, max_inflight,
+					   submit_threads);
+		D_GOTO(cleanup, ret);
+	}
+
 	/* Get the group/rank/tag for this application (self_endpt) */
 	ret = crt_group_rank(NULL, &self_endpt.ep_rank);
 	if (ret != 0) {
@@ -1190,6 +1386,14 @@ static void print_usage(const char *prog_name, const char *msg_sizes_str,
 	       "  --singleton\n"
 	       "      Short version: -t\n"
 	       "      If specified, self_test will launch as a singleton process (with no orterun).\n"
+	       "  --submit-threads <N>\n"
+	       "      Short version: -T\n"
+	       "      Instead of running a test session on the master endpoints, send empty\n"
+	       "        RPCs to the endpoints directly from N threads sharing one context,\n"
+	       "        and report the time spent per RPC in crt_req_send(), i.e. the cost\n"
+	       "        of submitting RPCs to a context under concurrency.\n"
+	       "        --repetitions-per-size and --max-inflight-rpcs are shared by the\n"
+	       "        threads, --message-sizes and --master-endpoint are ignored.\n"
 	       "  --path  /path/to/attach_info_file/directory/n"
 	       "      Short version: -p  prefix\n"
 	       "      This option implies --singleton is set.\n"
@@ -1665,6 +1869,7 @@ int main(int argc, char *argv[])
 	int16_t				 buf_alignment =
 		CRT_ST_BUF_ALIGN_DEFAULT;
 	char				*attach_info_path = NULL;
+	int				 submit_threads = 0;
 
 	ret = d_log_init();
 	if (ret != 0) {
@@ -1686,10 +1891,11 @@ int main(int argc, char *argv[])
 			{"randomize-endpoints", no_argument, 0, 'q'},
 			{"path", required_argument, 0, 'p'},
 			{"nopmix", no_argument, 0, 'n'},
+			{"submit-threads", required_argument, 0, 'T'},
 			{0, 0, 0, 0}
 		};
 
-		c = getopt_long(argc, argv, "g:m:e:s:r:i:a:btnqp:",
+		c = getopt_long(argc, argv, "g:m:e:s:r:i:a:btnqp:T:",
 				long_options, NULL);
 		if (c == -1)
 			break;
@@ -1750,6 +1956,14 @@ int main(int argc, char *argv[])
 			break;
 		case 'n':
 			break;
+		case 'T':
+			ret = sscanf(optarg, "%d", &submit_threads);
+			if (ret != 1 || submit_threads < 0) {
+				printf("Warning: Invalid submit-threads\n"
+				       "  Submission overhead test disabled\n");
+				submit_threads = 0;
+			}
+			break;
 		case '?':
 		default:
 			print_usage(argv[0], default_msg_sizes_str,
@@ -1882,14 +2096,18 @@ int main(int argc, char *argv[])
 	else
 		printf("  Buffer addresses end with:  %d\n", buf_alignment);
 	printf("  Repetitions per size:       %d\n"
-	       "  Max inflight RPCs:          %d\n\n",
+	       "  Max inflight RPCs:          %d\n",
 	       rep_count, max_inflight);
+	if (submit_threads > 0)
+		printf("  Submit threads:             %d\n", submit_threads);
+	printf("\n");
 
 	/********************* Run the self test *********************/
 	ret = run_self_test(all_params, num_msg_sizes, rep_count,
 			    max_inflight, dest_name, ms_endpts,
 			    num_ms_endpts, endpts, num_endpts,
-			    output_megabits, buf_alignment, attach_info_path);
+			    output_megabits, buf_alignment, attach_info_path,
+			    submit_threads);
 
 	/********************* Clean up *********************/
 cleanup:
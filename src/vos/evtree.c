@@ -575,6 +575,13 @@ evt_ent_addr_update(struct evt_context *tcx, struct evt_entry *ent,
 	if (bio_addr_is_hole(&ent->en_addr))
 		return; /* Nothing to do for holes */
 
+	/*
+	 * Compressed record can't be addressed by offset, it's always
+	 * referenced from the start, see evt_entry_selected_offset().
+	 */
+	if (ent->en_addr.ba_compressed)
+		return;
+
 	D_ASSERT(tcx->tc_inob != 0);
 	ent->en_addr.ba_off += diff * tcx->tc_inob;
 }
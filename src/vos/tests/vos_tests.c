@@ -41,6 +41,8 @@ print_usage()
 	print_message("vos_tests -e|--exclude <filter>\n");
 	print_message("vos_tests -m|--punch-model-tests\n");
 	print_message("vos_tests -C|--mvcc-tests\n");
+	print_message("vos_tests -D|--dedup-tests\n");
+	print_message("vos_tests -Z|--compress-tests\n");
 	print_message("vos_tests -h|--help\n");
 	print_message("Default <vos_tests> runs all tests\n");
 }
@@ -91,6 +93,8 @@ run_all_tests(int keys, bool nest_iterators)
 		failed += run_dtx_tests(cfg_desc_io);
 		failed += run_ilog_tests(cfg_desc_io);
 		failed += run_csum_extent_tests(cfg_desc_io);
+		failed += run_dedup_tests(cfg_desc_io);
+		failed += run_compress_tests(cfg_desc_io);
 
 		it = "standalone";
 	} else {
@@ -120,7 +124,7 @@ main(int argc, char **argv)
 	int	ofeats;
 	int	keys;
 	bool	nest_iterators = false;
-	const char *short_options = "apcdglzni:mXA:hf:e:tC";
+	const char *short_options = "apcdglzni:mXA:hf:e:tCDZ";
 	static struct option long_options[] = {
 		{"all_tests",		required_argument, 0, 'A'},
 		{"pool_tests",		no_argument, 0, 'p'},
@@ -136,6 +140,8 @@ main(int argc, char **argv)
 		{"epoch cache tests",	no_argument, 0, 't'},
 		{"mvcc_tests",		no_argument, 0, 'C'},
 		{"csum_tests",		no_argument, 0, 'z'},
+		{"dedup_tests",		no_argument, 0, 'D'},
+		{"compress_tests",	no_argument, 0, 'Z'},
 		{"help",		no_argument, 0, 'h'},
 		{"filter",		required_argument, 0, 'f'},
 		{"exclude",		required_argument, 0, 'e'},
@@ -253,6 +259,14 @@ main(int argc, char **argv)
 			nr_failed += run_mvcc_tests("");
 			test_run = true;
 			break;
+		case 'D':
+			nr_failed += run_dedup_tests("");
+			test_run = true;
+			break;
+		case 'Z':
+			nr_failed += run_compress_tests("");
+			test_run = true;
+			break;
 		case 'f':
 		case 'e':
 			/** already handled */
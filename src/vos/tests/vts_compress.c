@@ -0,0 +1,245 @@
+/**
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * This file is part of vos/tests/
+ *
+ * vos/tests/vts_compress.c
+ *
+ * Inline compression of SCM array records, see vos_compress.c.
+ */
+#define D_LOGFAC	DD_FAC(tests)
+
+#include <daos/compression.h>
+#include "vts_io.h"
+
+/** Data of each update, a few chunks of the default size */
+#define CMP_LEN		(128U << 10)
+
+static struct dts_context	cmp_ctx;
+
+static void
+cmp_iod_init(daos_key_t *dkey, daos_iod_t *iod, daos_recx_t *recx,
+	     d_sg_list_t *sgl, d_iov_t *iov, char *buf, uint64_t off,
+	     uint64_t len)
+{
+	d_iov_set(dkey, "dkey", strlen("dkey"));
+	memset(iod, 0, sizeof(*iod));
+	d_iov_set(&iod->iod_name, "akey", strlen("akey"));
+	recx->rx_idx = off;
+	recx->rx_nr = len;
+	iod->iod_type = DAOS_IOD_ARRAY;
+	iod->iod_size = 1;
+	iod->iod_nr = 1;
+	iod->iod_recxs = recx;
+
+	d_iov_set(iov, buf, len);
+	sgl->sg_nr = 1;
+	sgl->sg_nr_out = 0;
+	sgl->sg_iovs = iov;
+}
+
+static void
+cmp_update(daos_unit_oid_t oid, daos_epoch_t epoch, char *buf)
+{
+	daos_key_t	dkey;
+	daos_iod_t	iod;
+	daos_recx_t	recx;
+	d_sg_list_t	sgl;
+	d_iov_t		iov;
+	int		rc;
+
+	cmp_iod_init(&dkey, &iod, &recx, &sgl, &iov, buf, 0, CMP_LEN);
+	rc = vos_obj_update(cmp_ctx.tsc_coh, oid, epoch, 0, 0, &dkey, 1, &iod,
+			    NULL, &sgl);
+	assert_rc_equal(rc, 0);
+}
+
+/** Fetch [\a off, \a off + \a len) of the record and compare it with \a buf */
+static void
+cmp_fetch_verify(daos_unit_oid_t oid, daos_epoch_t epoch, char *buf,
+		 uint64_t off, uint64_t len)
+{
+	daos_key_t	 dkey;
+	daos_iod_t	 iod;
+	daos_recx_t	 recx;
+	d_sg_list_t	 sgl;
+	d_iov_t		 iov;
+	char		*fbuf;
+	int		 rc;
+
+	D_ALLOC(fbuf, len);
+	assert_non_null(fbuf);
+
+	cmp_iod_init(&dkey, &iod, &recx, &sgl, &iov, fbuf, off, len);
+	rc = vos_obj_fetch(cmp_ctx.tsc_coh, oid, epoch, 0, &dkey, 1, &iod,
+			   &sgl);
+	assert_rc_equal(rc, 0);
+	assert_memory_equal(fbuf, buf + off, len);
+	D_FREE(fbuf);
+}
+
+static void
+cmp_stats_get(struct vos_cmp_stats *stats)
+{
+	vos_cont_info_t	cinfo;
+	int		rc;
+
+	rc = vos_cont_query(cmp_ctx.tsc_coh, &cinfo);
+	assert_rc_equal(rc, 0);
+	*stats = cinfo.ci_cmp_stats;
+}
+
+static void
+cmp_enable(void)
+{
+	int	rc;
+
+	rc = vos_cont_set_compress(cmp_ctx.tsc_coh, COMPRESS_TYPE_LZ4);
+	assert_rc_equal(rc, 0);
+}
+
+/** Repetitive data is stored compressed and read back whole or in part */
+static void
+cmp_compressible(void **state)
+{
+	struct vos_cmp_stats	 stats;
+	daos_unit_oid_t		 oid = dts_unit_oid_gen(0, 0, 0);
+	char			*buf;
+	uint32_t		 i;
+
+	D_ALLOC(buf, CMP_LEN);
+	assert_non_null(buf);
+	for (i = 0; i < CMP_LEN; i++)
+		buf[i] = 'a' + (i / 64) % 4;
+
+	cmp_enable();
+	cmp_update(oid, 1, buf);
+
+	cmp_stats_get(&stats);
+	assert_int_equal(stats.cs_in, CMP_LEN);
+	assert_true(stats.cs_out < CMP_LEN / 2);
+
+	cmp_fetch_verify(oid, 1, buf, 0, CMP_LEN);
+	/* across the first two chunks, partially */
+	cmp_fetch_verify(oid, 1, buf, 1000, 40000);
+	D_FREE(buf);
+}
+
+/** Random data is stored raw and read back as it is */
+static void
+cmp_incompressible(void **state)
+{
+	struct vos_cmp_stats	 stats;
+	daos_unit_oid_t		 oid = dts_unit_oid_gen(0, 0, 0);
+	char			*buf;
+	uint32_t		 i;
+
+	D_ALLOC(buf, CMP_LEN);
+	assert_non_null(buf);
+	for (i = 0; i < CMP_LEN; i++)
+		buf[i] = rand();
+
+	cmp_enable();
+	cmp_update(oid, 1, buf);
+
+	cmp_stats_get(&stats);
+	assert_int_equal(stats.cs_in, 0);
+	assert_int_equal(stats.cs_out, 0);
+
+	cmp_fetch_verify(oid, 1, buf, 0, CMP_LEN);
+	cmp_fetch_verify(oid, 1, buf, 1000, 40000);
+	D_FREE(buf);
+}
+
+/** Pools of an older durable format never get compressed records */
+static void
+cmp_old_pool(void **state)
+{
+	struct vos_pool		*pool = vos_hdl2pool(cmp_ctx.tsc_poh);
+	struct vos_pool_df	*pool_df = pool->vp_pool_df;
+	struct umem_instance	*umm = &pool->vp_umm;
+	struct vos_cmp_stats	 stats;
+	daos_unit_oid_t		 oid = dts_unit_oid_gen(0, 0, 0);
+	char			*buf;
+	int			 rc;
+
+	rc = umem_tx_begin(umm, NULL);
+	assert_rc_equal(rc, 0);
+	rc = umem_tx_add_ptr(umm, &pool_df->pd_version,
+			     sizeof(pool_df->pd_version));
+	assert_rc_equal(rc, 0);
+	pool_df->pd_version = POOL_DF_VER_2;
+	rc = umem_tx_commit(umm);
+	assert_rc_equal(rc, 0);
+
+	D_ALLOC(buf, CMP_LEN);
+	assert_non_null(buf);
+	memset(buf, 'a', CMP_LEN);
+
+	cmp_enable();
+	cmp_update(oid, 1, buf);
+
+	cmp_stats_get(&stats);
+	assert_int_equal(stats.cs_in, 0);
+	cmp_fetch_verify(oid, 1, buf, 0, CMP_LEN);
+	D_FREE(buf);
+}
+
+/** Each test runs against a pool of its own, without NVMe */
+static int
+cmp_setup(void **state)
+{
+	struct dts_context	*tc = &cmp_ctx;
+	int			 rc;
+
+	memset(tc, 0, sizeof(*tc));
+	tc->tsc_scm_size	= (1ULL << 30);
+	tc->tsc_nvme_size	= 0;
+	tc->tsc_cred_vsize	= 4096;
+	tc->tsc_cred_nr		= 1;
+	tc->tsc_mpi_rank	= 0;
+	tc->tsc_mpi_size	= 1;
+	uuid_generate(tc->tsc_pool_uuid);
+	uuid_generate(tc->tsc_cont_uuid);
+	vts_pool_fallocate(&tc->tsc_pmem_file);
+
+	rc = dts_ctx_init(tc);
+	if (rc != 0)
+		return rc;
+
+	*state = tc;
+	return 0;
+}
+
+static int
+cmp_teardown(void **state)
+{
+	struct dts_context	*tc = &cmp_ctx;
+
+	dts_ctx_fini(tc);
+	free(tc->tsc_pmem_file);
+	memset(tc, 0, sizeof(*tc));
+	return 0;
+}
+
+static const struct CMUnitTest cmp_tests[] = {
+	{ "VOS1100: Compressible record",
+	  cmp_compressible, cmp_setup, cmp_teardown},
+	{ "VOS1101: Incompressible record",
+	  cmp_incompressible, cmp_setup, cmp_teardown},
+	{ "VOS1102: No compression on older pool format",
+	  cmp_old_pool, cmp_setup, cmp_teardown},
+};
+
+int
+run_compress_tests(const char *cfg)
+{
+	char	test_name[DTS_CFG_MAX];
+
+	dts_create_config(test_name, "Compression %s", cfg);
+	return cmocka_run_group_tests_name(test_name, cmp_tests, NULL,
+					   NULL);
+}
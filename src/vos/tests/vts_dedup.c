@@ -0,0 +1,356 @@
+/**
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * This file is part of vos/tests/
+ *
+ * vos/tests/vts_dedup.c
+ *
+ * Content defined chunking dedup of NVMe array extents, see vos_dedup.c.
+ */
+#define D_LOGFAC	DD_FAC(tests)
+
+#include "vts_io.h"
+
+/** Data of each update, a few chunks of the default size */
+#define DEDUP_LEN	(1UL << 20)
+/** Extents of this size or larger are chunked */
+#define DEDUP_TH	4096
+
+static struct dts_context	dedup_ctx;
+static bool			dedup_cdc_saved;
+/** The test pool has an NVMe device, hence a dedup index */
+static bool			dedup_nvme;
+
+/** Update \a akey of \a oid at \a epoch with \a buf, chunked for dedup */
+static int
+dedup_update(daos_unit_oid_t oid, daos_epoch_t epoch, const char *akey,
+	     char *buf)
+{
+	daos_handle_t	 coh = dedup_ctx.tsc_coh;
+	daos_handle_t	 ioh;
+	struct bio_desc	*biod;
+	daos_key_t	 dkey;
+	daos_iod_t	 iod = { 0 };
+	daos_recx_t	 recx;
+	d_sg_list_t	 sgl;
+	d_iov_t		 iov;
+	int		 rc;
+
+	d_iov_set(&dkey, "dkey", strlen("dkey"));
+	d_iov_set(&iod.iod_name, (void *)akey, strlen(akey));
+	recx.rx_idx = 0;
+	recx.rx_nr = DEDUP_LEN;
+	iod.iod_type = DAOS_IOD_ARRAY;
+	iod.iod_size = 1;
+	iod.iod_nr = 1;
+	iod.iod_recxs = &recx;
+
+	d_iov_set(&iov, buf, DEDUP_LEN);
+	sgl.sg_nr = 1;
+	sgl.sg_nr_out = 0;
+	sgl.sg_iovs = &iov;
+
+	rc = vos_update_begin(coh, oid, epoch, 0, &dkey, 1, &iod, NULL, true,
+			      DEDUP_TH, &ioh, NULL);
+	if (rc != 0)
+		return rc;
+
+	biod = vos_ioh2desc(ioh);
+	rc = bio_iod_prep(biod);
+	if (rc == 0) {
+		rc = bio_iod_copy(biod, &sgl, 1);
+		if (rc == 0)
+			rc = vos_dedup_scan(ioh);
+		if (rc == 0)
+			rc = bio_iod_post(biod);
+		else
+			bio_iod_post(biod);
+	}
+
+	return vos_update_end(ioh, 0, &dkey, rc, NULL);
+}
+
+/** Fetch \a akey of \a oid at \a epoch and compare it with \a buf */
+static void
+dedup_fetch_verify(daos_unit_oid_t oid, daos_epoch_t epoch, const char *akey,
+		   char *buf)
+{
+	daos_key_t	 dkey;
+	daos_iod_t	 iod = { 0 };
+	daos_recx_t	 recx;
+	d_sg_list_t	 sgl;
+	d_iov_t		 iov;
+	char		*fbuf;
+	int		 rc;
+
+	D_ALLOC(fbuf, DEDUP_LEN);
+	assert_non_null(fbuf);
+
+	d_iov_set(&dkey, "dkey", strlen("dkey"));
+	d_iov_set(&iod.iod_name, (void *)akey, strlen(akey));
+	recx.rx_idx = 0;
+	recx.rx_nr = DEDUP_LEN;
+	iod.iod_type = DAOS_IOD_ARRAY;
+	iod.iod_size = 1;
+	iod.iod_nr = 1;
+	iod.iod_recxs = &recx;
+
+	d_iov_set(&iov, fbuf, DEDUP_LEN);
+	sgl.sg_nr = 1;
+	sgl.sg_nr_out = 0;
+	sgl.sg_iovs = &iov;
+
+	rc = vos_obj_fetch(dedup_ctx.tsc_coh, oid, epoch, 0, &dkey, 1, &iod,
+			   &sgl);
+	assert_rc_equal(rc, 0);
+	assert_memory_equal(fbuf, buf, DEDUP_LEN);
+	D_FREE(fbuf);
+}
+
+struct dedup_walk {
+	/** Expected reference count of all the extents */
+	uint32_t	dw_ref;
+	uint64_t	dw_nr;
+};
+
+static int
+dedup_walk_cb(daos_handle_t ih, d_iov_t *key, d_iov_t *val, void *arg)
+{
+	struct vos_dedup_df	*df = val->iov_buf;
+	struct dedup_walk	*walk = arg;
+
+	assert_int_equal(df->dd_ref, walk->dw_ref);
+	walk->dw_nr++;
+	return 0;
+}
+
+/**
+ * Check that the persistent index holds the same number of extents as its
+ * DRAM side, all referenced \a ref times, and return that number.
+ */
+static uint64_t
+dedup_index_check(uint32_t ref)
+{
+	struct vos_pool		*pool = vos_hdl2pool(dedup_ctx.tsc_poh);
+	struct vos_dedup_stats	 stats;
+	struct dedup_walk	 walk = { .dw_ref = ref };
+	daos_handle_t		 toh;
+	int			 rc;
+
+	rc = dbtree_open_inplace(&pool->vp_pool_df->pd_dedup_root,
+				 &pool->vp_uma, &toh);
+	assert_rc_equal(rc, 0);
+	rc = dbtree_iterate(toh, DAOS_INTENT_DEFAULT, false, dedup_walk_cb,
+			    &walk);
+	assert_rc_equal(rc, 0);
+	dbtree_close(toh);
+
+	rc = vos_pool_dedup_query(dedup_ctx.tsc_poh, &stats);
+	assert_rc_equal(rc, 0);
+	assert_int_equal(stats.ds_extents, walk.dw_nr);
+	return walk.dw_nr;
+}
+
+static char *
+dedup_buf_alloc(void)
+{
+	char	*buf;
+
+	D_ALLOC(buf, DEDUP_LEN);
+	assert_non_null(buf);
+	dts_buf_render(buf, DEDUP_LEN);
+	return buf;
+}
+
+/** Same content under two akeys, the second one references the first one */
+static void
+dedup_index_ref(void **state)
+{
+	struct vos_dedup_stats	 stats;
+	daos_unit_oid_t		 oid = dts_unit_oid_gen(0, 0, 0);
+	uint64_t		 nr;
+	char			*buf;
+	int			 rc;
+
+	if (!dedup_nvme)
+		skip();
+
+	buf = dedup_buf_alloc();
+
+	rc = dedup_update(oid, 1, "akey0", buf);
+	assert_rc_equal(rc, 0);
+	nr = dedup_index_check(1);
+	assert_true(nr > 1);
+
+	rc = vos_pool_dedup_query(dedup_ctx.tsc_poh, &stats);
+	assert_rc_equal(rc, 0);
+	assert_int_equal(stats.ds_in, DEDUP_LEN);
+	assert_int_equal(stats.ds_stored, DEDUP_LEN);
+
+	rc = dedup_update(oid, 2, "akey1", buf);
+	assert_rc_equal(rc, 0);
+	assert_int_equal(dedup_index_check(2), nr);
+
+	rc = vos_pool_dedup_query(dedup_ctx.tsc_poh, &stats);
+	assert_rc_equal(rc, 0);
+	assert_int_equal(stats.ds_in, 2 * DEDUP_LEN);
+	assert_int_equal(stats.ds_stored, DEDUP_LEN);
+
+	dedup_fetch_verify(oid, 2, "akey0", buf);
+	dedup_fetch_verify(oid, 2, "akey1", buf);
+	D_FREE(buf);
+}
+
+/** Freeing the records of shared extents drops their references */
+static void
+dedup_extent_free(void **state)
+{
+	daos_unit_oid_t		 oid = dts_unit_oid_gen(0, 0, 0);
+	daos_epoch_range_t	 epr;
+	uint64_t		 nr;
+	char			*buf;
+	int			 rc;
+
+	if (!dedup_nvme)
+		skip();
+
+	buf = dedup_buf_alloc();
+
+	rc = dedup_update(oid, 1, "akey0", buf);
+	assert_rc_equal(rc, 0);
+	rc = dedup_update(oid, 2, "akey1", buf);
+	assert_rc_equal(rc, 0);
+	nr = dedup_index_check(2);
+
+	/* The first copy is still referenced by the other one */
+	epr.epr_lo = epr.epr_hi = 1;
+	rc = vos_discard(dedup_ctx.tsc_coh, &epr, NULL, NULL);
+	assert_rc_equal(rc, 0);
+	assert_int_equal(dedup_index_check(1), nr);
+	dedup_fetch_verify(oid, 2, "akey1", buf);
+
+	/* The last reference frees the extents */
+	epr.epr_lo = epr.epr_hi = 2;
+	rc = vos_discard(dedup_ctx.tsc_coh, &epr, NULL, NULL);
+	assert_rc_equal(rc, 0);
+	assert_int_equal(dedup_index_check(0), 0);
+	D_FREE(buf);
+}
+
+/** The DRAM side of the index is rebuilt when the pool is opened again */
+static void
+dedup_index_reopen(void **state)
+{
+	struct vos_dedup_stats	 stats;
+	daos_unit_oid_t		 oid = dts_unit_oid_gen(0, 0, 0);
+	uint64_t		 nr;
+	char			*buf;
+	int			 rc;
+
+	if (!dedup_nvme)
+		skip();
+
+	buf = dedup_buf_alloc();
+
+	rc = dedup_update(oid, 1, "akey0", buf);
+	assert_rc_equal(rc, 0);
+	nr = dedup_index_check(1);
+
+	rc = vos_cont_close(dedup_ctx.tsc_coh);
+	assert_rc_equal(rc, 0);
+	rc = vos_pool_close(dedup_ctx.tsc_poh);
+	assert_rc_equal(rc, 0);
+	rc = vos_pool_open(dedup_ctx.tsc_pmem_file, dedup_ctx.tsc_pool_uuid,
+			   false, &dedup_ctx.tsc_poh);
+	assert_rc_equal(rc, 0);
+	rc = vos_cont_open(dedup_ctx.tsc_poh, dedup_ctx.tsc_cont_uuid,
+			   &dedup_ctx.tsc_coh);
+	assert_rc_equal(rc, 0);
+
+	/* Byte counters restart, the extents are loaded from the index */
+	rc = vos_pool_dedup_query(dedup_ctx.tsc_poh, &stats);
+	assert_rc_equal(rc, 0);
+	assert_int_equal(stats.ds_in, 0);
+	assert_int_equal(dedup_index_check(1), nr);
+
+	/* and are found by the next update of the same content */
+	rc = dedup_update(oid, 2, "akey1", buf);
+	assert_rc_equal(rc, 0);
+	assert_int_equal(dedup_index_check(2), nr);
+
+	rc = vos_pool_dedup_query(dedup_ctx.tsc_poh, &stats);
+	assert_rc_equal(rc, 0);
+	assert_int_equal(stats.ds_in, DEDUP_LEN);
+	assert_int_equal(stats.ds_stored, 0);
+
+	dedup_fetch_verify(oid, 2, "akey0", buf);
+	dedup_fetch_verify(oid, 2, "akey1", buf);
+	D_FREE(buf);
+}
+
+/** Each test runs against a pool of its own */
+static int
+dedup_setup(void **state)
+{
+	struct dts_context	*tc = &dedup_ctx;
+	struct vos_pool		*pool;
+	int			 rc;
+
+	memset(tc, 0, sizeof(*tc));
+	tc->tsc_scm_size	= (1ULL << 30);
+	tc->tsc_nvme_size	= (4ULL << 30);
+	tc->tsc_cred_vsize	= 4096;
+	tc->tsc_cred_nr		= 1;
+	tc->tsc_mpi_rank	= 0;
+	tc->tsc_mpi_size	= 1;
+	uuid_generate(tc->tsc_pool_uuid);
+	uuid_generate(tc->tsc_cont_uuid);
+	vts_pool_fallocate(&tc->tsc_pmem_file);
+
+	rc = dts_ctx_init(tc);
+	if (rc != 0)
+		return rc;
+
+	/* Shared extents are on NVMe only */
+	pool = vos_hdl2pool(tc->tsc_poh);
+	dedup_nvme = pool->vp_cdc != NULL;
+
+	dedup_cdc_saved = vos_cdc_enabled;
+	vos_cdc_enabled = true;
+	*state = tc;
+	return 0;
+}
+
+static int
+dedup_teardown(void **state)
+{
+	struct dts_context	*tc = &dedup_ctx;
+
+	vos_cdc_enabled = dedup_cdc_saved;
+	dts_ctx_fini(tc);
+	free(tc->tsc_pmem_file);
+	memset(tc, 0, sizeof(*tc));
+	return 0;
+}
+
+static const struct CMUnitTest dedup_tests[] = {
+	{ "VOS1000: Dedup index and references",
+	  dedup_index_ref, dedup_setup, dedup_teardown},
+	{ "VOS1001: Dedup shared extent free",
+	  dedup_extent_free, dedup_setup, dedup_teardown},
+	{ "VOS1002: Dedup index rebuilt on pool open",
+	  dedup_index_reopen, dedup_setup, dedup_teardown},
+};
+
+int
+run_dedup_tests(const char *cfg)
+{
+	char	test_name[DTS_CFG_MAX];
+
+	dts_create_config(test_name, "Dedup %s", cfg);
+	return cmocka_run_group_tests_name(test_name, dedup_tests, NULL,
+					   NULL);
+}
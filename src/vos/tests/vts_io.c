@@ -2474,12 +2474,64 @@ static const struct CMUnitTest io_tests[] = {
 		io_pool_overflow_test, NULL, io_pool_overflow_teardown},
 };
 
+#define CDC_TEST_LEN	(4UL << 20)
+#define CDC_TEST_CUTS	512
+
+static void
+io_cdc_cut(void **state)
+{
+	uint64_t	 cuts[2][CDC_TEST_CUTS];
+	int		 nr[2] = { 0 };
+	uint8_t		*buf;
+	uint8_t		*data;
+	uint64_t	 len;
+	uint64_t	 off;
+	uint64_t	 end;
+	int		 matched = 0;
+	int		 i, j;
+
+	D_ALLOC(buf, CDC_TEST_LEN + VOS_BLK_SZ);
+	assert_non_null(buf);
+	for (i = 0; i < CDC_TEST_LEN + VOS_BLK_SZ; i++)
+		buf[i] = rand();
+
+	/* The second pass has one more block at the start of the data */
+	for (i = 0; i < 2; i++) {
+		data = buf + (1 - i) * VOS_BLK_SZ;
+		len = CDC_TEST_LEN + i * VOS_BLK_SZ;
+		for (off = 0; off < len; off = end) {
+			end = vos_cdc_cut(data, len, off, VOS_BLK_SZ, 0, 0);
+			assert_true(end > off);
+			assert_true(end == len || end % VOS_BLK_SZ == 0);
+			assert_true(nr[i] < CDC_TEST_CUTS);
+			cuts[i][nr[i]++] = end - i * VOS_BLK_SZ;
+		}
+	}
+
+	/* Cut points only depend on the data, so they are found again */
+	for (i = 0; i < nr[0]; i++) {
+		for (j = 0; j < nr[1]; j++) {
+			if (cuts[0][i] == cuts[1][j]) {
+				matched++;
+				break;
+			}
+		}
+	}
+	print_message("%d of %d cut points found after insertion\n", matched,
+		      nr[0]);
+	assert_true(nr[0] > 1);
+	assert_true(matched >= nr[0] - 2);
+	D_FREE(buf);
+}
+
 static const struct CMUnitTest int_tests[] = {
 	{ "VOS300.1: Test key query punch with subsequent update",
 		io_query_key_punch_update, NULL, NULL},
 	{ "VOS300.2: Key query test", io_query_key, NULL, NULL},
 	{ "VOS300.3: Key query negative test",
 		io_query_key_negative, NULL, NULL},
+	{ "VOS300.4: Content defined chunking cut points",
+		io_cdc_cut, NULL, NULL},
 };
 
 int
@@ -1263,6 +1263,7 @@ need_flush(struct agg_merge_window *mw)
 	struct evt_extent	 lgc_ext, phy_ext;
 	int			 i;
 	bool			 hole = false;
+	bool			 shared = false;
 
 	for (i = 0; i < mw->mw_lgc_cnt; i++) {
 		lgc_ent = &mw->mw_lgc_ents[i];
@@ -1278,11 +1279,16 @@ need_flush(struct agg_merge_window *mw)
 		    lgc_ext.ex_hi != phy_ext.ex_hi)
 			return true;
 
-		/* If any consecutive visible entries can be merged */
-		if (i != 0 && hole == bio_addr_is_hole(&phy_ent->pe_addr))
+		/*
+		 * If any consecutive visible entries can be merged, shared
+		 * extents (content defined chunks) are kept as they are.
+		 */
+		if (i != 0 && hole == bio_addr_is_hole(&phy_ent->pe_addr) &&
+		    !shared && !phy_ent->pe_addr.ba_shared)
 			return true;
 
 		hole = bio_addr_is_hole(&phy_ent->pe_addr);
+		shared = phy_ent->pe_addr.ba_shared;
 	}
 
 	/* Any invisible physical entries ? */
@@ -1749,6 +1755,17 @@ vos_agg_ev(daos_handle_t ih, vos_iter_entry_t *entry,
 		return rc;
 	}
 
+	/*
+	 * Merging reads payloads by offset, which doesn't work for compressed
+	 * records. Aggregation isn't scheduled for containers with compression
+	 * enabled, see cont_aggregate_runnable().
+	 */
+	if (entry->ie_biov.bi_addr.ba_compressed) {
+		D_ERROR("Can't aggregate compressed extent "DF_EXT"\n",
+			DP_EXT(&phy_ext));
+		return -DER_NOSYS;
+	}
+
 	/* Aggregation Yield for testing purpose */
 	while (DAOS_FAIL_CHECK(DAOS_VOS_AGG_BLOCKED)) {
 		ABT_thread_yield();
@@ -152,7 +152,9 @@ vos_bio_addr_free(struct vos_pool *pool, bio_addr_t *addr, daos_size_t nob)
 	if (bio_addr_is_hole(addr))
 		return 0;
 
-	if (addr->ba_type == DAOS_MEDIA_SCM) {
+	if (addr->ba_shared) {
+		rc = vos_cdc_put(pool, addr);
+	} else if (addr->ba_type == DAOS_MEDIA_SCM) {
 		rc = umem_free(&pool->vp_umm, addr->ba_off);
 	} else {
 		uint64_t blk_off;
@@ -437,10 +439,12 @@ vos_mod_init(void)
 	}
 
 	rc = vos_ilog_init();
-	if (rc)
+	if (rc) {
 		D_ERROR("Failed to initialize incarnation log capability\n");
+		return rc;
+	}
 
-	return rc;
+	return vos_cdc_register();
 }
 
 static int
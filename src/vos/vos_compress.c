@@ -0,0 +1,472 @@
+/**
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * This file is part of daos
+ *
+ * vos/vos_compress.c
+ *
+ * Inline compression of SCM resident array records.
+ *
+ * When compression is enabled on a container, the payload of an array record
+ * landed on SCM is compressed at the end of update, chunk by chunk, and moved
+ * to a smaller reservation if that saves at least 1/VOS_CMP_MIN_GAIN of it.
+ * Chunks are compressed before the update transaction starts, on the offload
+ * xstreams if the engine provides them (see daos_compressor_set_offload()).
+ * The evtree record references the compressed image with ba_compressed set,
+ * the image starts with a vos_cmp_hdr giving the stored length of each chunk.
+ *
+ * Chunks have the checksum chunk size of the record when the container has
+ * checksums, so that a partial fetch only decompresses the chunks it needs.
+ * Fetch decompresses into DRAM buffers handed to bio as staged data.
+ */
+#define D_LOGFAC	DD_FAC(vos)
+
+#include <abt.h>
+#include <daos/compression.h>
+#include "vos_internal.h"
+
+/** Chunk size of records without checksums */
+#define VOS_CMP_CHUNK_DEF	(32U << 10)
+#define VOS_CMP_CHUNK_MIN	(4U << 10)
+#define VOS_CMP_CHUNK_MAX	(1U << 20)
+/** Records smaller than this are never compressed */
+#define VOS_CMP_SIZE_MIN	(4U << 10)
+/** A record is compressed only if it shrinks by 1/VOS_CMP_MIN_GAIN at least */
+#define VOS_CMP_MIN_GAIN	8
+
+static inline uint64_t
+vos_cmp_hdr_size(uint32_t chunk_nr)
+{
+	return D_ALIGNUP(sizeof(struct vos_cmp_hdr) +
+			 chunk_nr * sizeof(uint32_t), 8);
+}
+
+static void *
+vos_cmp_scratch(struct vos_container *cont, size_t len)
+{
+	void	*buf;
+
+	if (cont->vc_cmp_buf_len >= len)
+		return cont->vc_cmp_buf;
+
+	D_REALLOC(buf, cont->vc_cmp_buf, len);
+	if (buf == NULL)
+		return NULL;
+
+	cont->vc_cmp_buf = buf;
+	cont->vc_cmp_buf_len = len;
+	return buf;
+}
+
+/** Get a compressor for \a type, the container one if it matches */
+static int
+vos_cmp_compressor_get(struct vos_container *cont, uint16_t type,
+		       struct daos_compressor **dc)
+{
+	if (cont->vc_compressor != NULL &&
+	    cont->vc_compressor->dc_algo->cf_type == type) {
+		*dc = cont->vc_compressor;
+		return 0;
+	}
+
+	return daos_compressor_init_with_type(dc, type, false, 0);
+}
+
+static void
+vos_cmp_compressor_put(struct vos_container *cont, struct daos_compressor *dc)
+{
+	if (dc != cont->vc_compressor)
+		daos_compressor_destroy(&dc);
+}
+
+int
+vos_cont_set_compress(daos_handle_t coh, int type)
+{
+	struct vos_container	*cont;
+	struct daos_compressor	*dc = NULL;
+	int			 rc;
+
+	cont = vos_hdl2cont(coh);
+	if (cont == NULL)
+		return -DER_NO_HDL;
+
+	/* Engines before POOL_DF_VER_3 cannot read compressed records */
+	if (type != COMPRESS_TYPE_UNKNOWN &&
+	    cont->vc_pool->vp_pool_df->pd_version < POOL_DF_VER_3) {
+		D_INFO("Cont "DF_UUID": pool DF version %u too old, "
+		       "compression disabled\n", DP_UUID(cont->vc_id),
+		       cont->vc_pool->vp_pool_df->pd_version);
+		type = COMPRESS_TYPE_UNKNOWN;
+	}
+
+	if (type != COMPRESS_TYPE_UNKNOWN) {
+		if (cont->vc_compressor != NULL &&
+		    cont->vc_compressor->dc_algo->cf_type == type)
+			return 0;
+
+		rc = daos_compressor_init_with_type(&dc, type, false,
+						    VOS_CMP_CHUNK_MAX);
+		if (rc != 0) {
+			D_ERROR("Failed to init compressor type %d: "DF_RC"\n",
+				type, DP_RC(rc));
+			return rc;
+		}
+	}
+
+	/* updates waiting for offloaded jobs still use the old compressor */
+	ABT_mutex_lock(cont->vc_cmp_lock);
+	while (cont->vc_cmp_inflight > 0)
+		ABT_cond_wait(cont->vc_cmp_cond, cont->vc_cmp_lock);
+	ABT_mutex_unlock(cont->vc_cmp_lock);
+
+	if (cont->vc_compressor != NULL)
+		daos_compressor_destroy(&cont->vc_compressor);
+	cont->vc_compressor = dc;
+
+	D_DEBUG(DB_IO, "Cont "DF_UUID" compression type %d\n",
+		DP_UUID(cont->vc_id), type);
+	return 0;
+}
+
+/** Compression of one chunk of an image */
+struct vos_cmp_job {
+	/** batch of the job if it is asynchronous */
+	struct vos_cmp_batch	*cj_batch;
+	/** stored length of the chunk in the image header */
+	uint32_t		*cj_len;
+	uint32_t		 cj_src_len;
+};
+
+/** Asynchronous jobs of a vos_cmp_encode() call */
+struct vos_cmp_batch {
+	ABT_eventual		 cb_eventual;
+	uint32_t		 cb_inflight;
+};
+
+static void
+vos_cmp_job_done(void *cb_data, int produced, int status)
+{
+	struct vos_cmp_job	*job = cb_data;
+
+	if (status == DC_STATUS_OK && produced < job->cj_src_len)
+		*job->cj_len = produced;
+	else /* incompressible, keep the chunk as it is */
+		*job->cj_len = job->cj_src_len | VOS_CMP_RAW;
+
+	if (job->cj_batch != NULL && --job->cj_batch->cb_inflight == 0)
+		ABT_eventual_set(job->cj_batch->cb_eventual, NULL, 0);
+}
+
+/**
+ * Allocate the buffer of \a img, large enough to hold each chunk compressed
+ * in its own slot, return the number of chunks, 0 if it isn't compressible.
+ */
+static uint32_t
+vos_cmp_img_alloc(struct daos_compressor *dc, struct vos_cmp_img *img)
+{
+	struct vos_cmp_hdr	*hdr;
+	uint32_t		 chunk_size = img->ci_chunk_size;
+	uint32_t		 chunk_nr;
+
+	img->ci_buf = NULL;
+	if (img->ci_size < VOS_CMP_SIZE_MIN)
+		return 0;
+
+	if (chunk_size == 0)
+		chunk_size = VOS_CMP_CHUNK_DEF;
+	chunk_size = min(max(chunk_size, VOS_CMP_CHUNK_MIN), VOS_CMP_CHUNK_MAX);
+	chunk_nr = (img->ci_size + chunk_size - 1) / chunk_size;
+	if (vos_cmp_hdr_size(chunk_nr) >=
+	    img->ci_size - img->ci_size / VOS_CMP_MIN_GAIN)
+		return 0;
+
+	D_ALLOC(hdr, vos_cmp_hdr_size(chunk_nr) + img->ci_size);
+	if (hdr == NULL)
+		return 0;
+
+	hdr->ch_magic		= VOS_CMP_MAGIC;
+	hdr->ch_type		= dc->dc_algo->cf_type;
+	hdr->ch_padding		= 0;
+	hdr->ch_chunk_size	= chunk_size;
+	hdr->ch_chunk_nr	= chunk_nr;
+	hdr->ch_size		= img->ci_size;
+	img->ci_buf = hdr;
+	return chunk_nr;
+}
+
+/** Address of the slot of chunk \a idx in the buffer of an image */
+static inline uint8_t *
+vos_cmp_img_slot(struct vos_cmp_hdr *hdr, uint32_t idx)
+{
+	return (uint8_t *)hdr + vos_cmp_hdr_size(hdr->ch_chunk_nr) +
+	       (uint64_t)idx * hdr->ch_chunk_size;
+}
+
+/**
+ * Move the chunks of \a img from their slots to be back to back, and drop the
+ * image if it doesn't save enough space.
+ */
+static void
+vos_cmp_img_pack(struct vos_container *cont, struct vos_cmp_img *img)
+{
+	struct vos_cmp_hdr	*hdr = img->ci_buf;
+	uint8_t			*out = img->ci_buf;
+	uint64_t		 off, max, stored;
+	uint32_t		 len, chunk_len, i;
+
+	max = hdr->ch_size - hdr->ch_size / VOS_CMP_MIN_GAIN;
+	stored = vos_cmp_hdr_size(hdr->ch_chunk_nr);
+	for (i = 0, off = 0; i < hdr->ch_chunk_nr; i++, off += len) {
+		len = min(hdr->ch_chunk_size, hdr->ch_size - off);
+		chunk_len = hdr->ch_lens[i] & ~VOS_CMP_RAW;
+		if (stored + chunk_len >= max) {
+			D_FREE(img->ci_buf);
+			return;
+		}
+
+		/* never beyond the slot, so the next chunks are intact */
+		if (hdr->ch_lens[i] & VOS_CMP_RAW)
+			memcpy(out + stored, (uint8_t *)img->ci_src + off, len);
+		else
+			memmove(out + stored, vos_cmp_img_slot(hdr, i),
+				chunk_len);
+		stored += chunk_len;
+	}
+
+	cont->vc_cmp_stats.cs_in += hdr->ch_size;
+	cont->vc_cmp_stats.cs_out += stored;
+	img->ci_len = stored;
+}
+
+/**
+ * Compress the extents of \a imgs chunk by chunk with the container
+ * compressor, the images which save enough space are returned in their
+ * \a ci_buf, the others are left NULL.
+ *
+ * When the compressor runs on the offload xstreams, the chunks are compressed
+ * in the background and the calling ULT waits for them, unless \a can_wait is
+ * false, e.g. in a transaction. The context of the compressor is not thread
+ * safe, so it is never used on this xstream while offloaded jobs of other
+ * updates may be running, the records are left uncompressed instead.
+ */
+void
+vos_cmp_encode(struct vos_container *cont, struct vos_cmp_img *imgs,
+	       unsigned int nr, bool can_wait)
+{
+	struct daos_compressor	*dc = cont->vc_compressor;
+	struct vos_cmp_batch	 batch = { 0 };
+	struct vos_cmp_job	*jobs;
+	struct vos_cmp_job	*job;
+	struct vos_cmp_hdr	*hdr;
+	struct timespec		 start, end;
+	uint8_t			*src;
+	uint64_t		 off;
+	uint32_t		 chunk_nr = 0;
+	uint32_t		 len, i, j;
+	size_t			 produced;
+	bool			 offload;
+	int			 rc;
+
+	if (dc == NULL)
+		return;
+
+	offload = daos_compressor_offloaded(dc);
+	if (offload && can_wait &&
+	    ABT_eventual_create(0, &batch.cb_eventual) != ABT_SUCCESS)
+		can_wait = false;
+	/* the jobs of other updates may be running with the context */
+	if (offload && !can_wait) {
+		if (cont->vc_cmp_inflight > 0)
+			return;
+		offload = false;
+	}
+
+	for (i = 0; i < nr; i++)
+		chunk_nr += vos_cmp_img_alloc(dc, &imgs[i]);
+	if (chunk_nr == 0)
+		goto out;
+
+	D_ALLOC_ARRAY(jobs, chunk_nr);
+	if (jobs == NULL) {
+		for (i = 0; i < nr; i++)
+			D_FREE(imgs[i].ci_buf);
+		goto out;
+	}
+
+	d_gettime(&start);
+	job = jobs;
+	for (i = 0; i < nr; i++) {
+		hdr = imgs[i].ci_buf;
+		if (hdr == NULL)
+			continue;
+
+		for (j = 0, off = 0; j < hdr->ch_chunk_nr; j++, off += len) {
+			len = min(hdr->ch_chunk_size, hdr->ch_size - off);
+			src = (uint8_t *)imgs[i].ci_src + off;
+			job->cj_len = &hdr->ch_lens[j];
+			job->cj_src_len = len;
+
+			if (offload) {
+				job->cj_batch = &batch;
+				batch.cb_inflight++;
+				rc = daos_compressor_compress_async(dc, src,
+						len, vos_cmp_img_slot(hdr, j),
+						len, vos_cmp_job_done, job);
+				if (rc != DC_STATUS_OK) {
+					/* the runner may use the context,
+					 * keep the chunk as it is
+					 */
+					job->cj_batch = NULL;
+					batch.cb_inflight--;
+					vos_cmp_job_done(job, 0, rc);
+				}
+				job++;
+				continue;
+			}
+
+			produced = 0;
+			rc = daos_compressor_compress(dc, src, len,
+						      vos_cmp_img_slot(hdr, j),
+						      len, &produced);
+			vos_cmp_job_done(job, produced, rc);
+			job++;
+		}
+	}
+	/* only the time spent on this xstream */
+	d_gettime(&end);
+	cont->vc_cmp_stats.cs_cmp_ns += d_timediff_ns(&start, &end);
+
+	if (offload && batch.cb_inflight > 0) {
+		cont->vc_cmp_inflight++;
+		ABT_eventual_wait(batch.cb_eventual, NULL);
+		ABT_mutex_lock(cont->vc_cmp_lock);
+		if (--cont->vc_cmp_inflight == 0)
+			ABT_cond_broadcast(cont->vc_cmp_cond);
+		ABT_mutex_unlock(cont->vc_cmp_lock);
+	}
+	D_FREE(jobs);
+
+	for (i = 0; i < nr; i++) {
+		if (imgs[i].ci_buf != NULL)
+			vos_cmp_img_pack(cont, &imgs[i]);
+	}
+out:
+	if (batch.cb_eventual != ABT_EVENTUAL_NULL)
+		ABT_eventual_free(&batch.cb_eventual);
+}
+
+/**
+ * Decompress bytes [\a off, \a off + \a len) of the payload of the compressed
+ * record at \a addr into \a buf. Only the chunks covering the range are
+ * decompressed.
+ */
+int
+vos_cmp_read(struct vos_container *cont, bio_addr_t addr, uint64_t off,
+	     uint64_t len, void *buf)
+{
+	struct vos_cmp_hdr	*hdr;
+	struct daos_compressor	*dc;
+	struct timespec		 start, end;
+	unsigned char		*src, *dst = buf, *chunk;
+	uint64_t		 chunk_off, in_off, copy;
+	uint32_t		 chunk_len, stored, i;
+	size_t			 produced;
+	int			 rc;
+
+	D_ASSERT(addr.ba_compressed && addr.ba_type == DAOS_MEDIA_SCM);
+	hdr = umem_off2ptr(vos_cont2umm(cont), addr.ba_off);
+	if (hdr->ch_magic != VOS_CMP_MAGIC || off + len > hdr->ch_size) {
+		D_ERROR("Invalid compressed record "DF_X64", magic %x, "
+			"size "DF_U64", read "DF_U64"/"DF_U64"\n", addr.ba_off,
+			hdr->ch_magic, hdr->ch_size, off, len);
+		return -DER_IO;
+	}
+
+	rc = vos_cmp_compressor_get(cont, hdr->ch_type, &dc);
+	if (rc != 0) {
+		D_ERROR("No decompressor for type %u: "DF_RC"\n",
+			hdr->ch_type, DP_RC(rc));
+		return rc;
+	}
+
+	d_gettime(&start);
+	src = (unsigned char *)hdr + vos_cmp_hdr_size(hdr->ch_chunk_nr);
+	for (i = 0, chunk_off = 0; i < hdr->ch_chunk_nr && len > 0;
+	     i++, chunk_off += chunk_len, src += stored) {
+		chunk_len = min(hdr->ch_chunk_size, hdr->ch_size - chunk_off);
+		stored = hdr->ch_lens[i] & ~VOS_CMP_RAW;
+		if (off >= chunk_off + chunk_len)
+			continue;
+
+		in_off = off - chunk_off;
+		copy = min(chunk_len - in_off, len);
+		if (hdr->ch_lens[i] & VOS_CMP_RAW) {
+			memcpy(dst, src + in_off, copy);
+			goto next;
+		}
+
+		/* partially read chunk goes through the scratch buffer */
+		chunk = dst;
+		if (copy != chunk_len) {
+			chunk = vos_cmp_scratch(cont, chunk_len);
+			if (chunk == NULL)
+				D_GOTO(out, rc = -DER_NOMEM);
+		}
+
+		rc = daos_compressor_decompress(dc, src, stored, chunk,
+						chunk_len, &produced);
+		if (rc != DC_STATUS_OK || produced != chunk_len) {
+			D_ERROR("Failed to decompress chunk %u of "DF_X64": "
+				DF_RC", %zu/%u\n", i, addr.ba_off, DP_RC(rc),
+				produced, chunk_len);
+			D_GOTO(out, rc = -DER_IO);
+		}
+		if (chunk != dst)
+			memcpy(dst, chunk + in_off, copy);
+next:
+		dst += copy;
+		off += copy;
+		len -= copy;
+	}
+	D_ASSERT(len == 0);
+out:
+	d_gettime(&end);
+	cont->vc_cmp_stats.cs_dcmp_ns += d_timediff_ns(&start, &end);
+	vos_cmp_compressor_put(cont, dc);
+	return rc;
+}
+
+int
+vos_cmp_init(struct vos_container *cont)
+{
+	int	rc;
+
+	rc = ABT_mutex_create(&cont->vc_cmp_lock);
+	if (rc != ABT_SUCCESS)
+		return -DER_NOMEM;
+
+	rc = ABT_cond_create(&cont->vc_cmp_cond);
+	if (rc != ABT_SUCCESS) {
+		ABT_mutex_free(&cont->vc_cmp_lock);
+		return -DER_NOMEM;
+	}
+
+	return 0;
+}
+
+void
+vos_cmp_fini(struct vos_container *cont)
+{
+	D_ASSERT(cont->vc_cmp_inflight == 0);
+	if (cont->vc_compressor != NULL)
+		daos_compressor_destroy(&cont->vc_compressor);
+	D_FREE(cont->vc_cmp_buf);
+	cont->vc_cmp_buf_len = 0;
+	if (cont->vc_cmp_cond != ABT_COND_NULL)
+		ABT_cond_free(&cont->vc_cmp_cond);
+	if (cont->vc_cmp_lock != ABT_MUTEX_NULL)
+		ABT_mutex_free(&cont->vc_cmp_lock);
+}
@@ -193,6 +193,7 @@ cont_free_internal(struct vos_container *cont)
 			vea_hint_unload(cont->vc_hint_ctxt[i]);
 	}
 
+	vos_cmp_fini(cont);
 	D_FREE(cont);
 }
 
@@ -369,6 +370,10 @@ vos_cont_open(daos_handle_t poh, uuid_t co_uuid, daos_handle_t *coh)
 	cont->vc_dtx_committed_count = 0;
 	cont->vc_dtx_committed_tmp_count = 0;
 
+	rc = vos_cmp_init(cont);
+	if (rc != 0)
+		D_GOTO(exit, rc);
+
 	/* Cache this btr object ID in container handle */
 	rc = dbtree_open_inplace_ex(&cont->vc_cont_df->cd_obj_root,
 				    &pool->vp_uma, vos_cont2hdl(cont),
@@ -498,6 +503,7 @@ vos_cont_query(daos_handle_t coh, vos_cont_info_t *cont_info)
 	cont_info->ci_nobjs = cont->vc_cont_df->cd_nobjs;
 	cont_info->ci_used = cont->vc_cont_df->cd_used;
 	cont_info->ci_hae = cont->vc_cont_df->cd_hae;
+	cont_info->ci_cmp_stats = cont->vc_cmp_stats;
 
 	return 0;
 }
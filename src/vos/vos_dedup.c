@@ -0,0 +1,787 @@
+/**
+ * (C) Copyright 2021 Intel Corporation.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause-Patent
+ */
+/**
+ * This file is part of daos
+ *
+ * vos/vos_dedup.c
+ *
+ * Content defined chunking (CDC) deduplication of array records on NVMe.
+ *
+ * When DAOS_DEDUP_CDC is set, the NVMe extents of updates to containers with
+ * dedup enabled are cut into chunks of DAOS_DEDUP_CDC_SIZE bytes on average
+ * (64KiB by default, between a quarter and four times that), and each chunk
+ * is stored as an evtree record of its own. Cut points are chosen by a gear
+ * rolling hash over the data preceding them, so that an insertion in a file
+ * only changes the chunks around it. They are restricted to block boundaries
+ * which are also record and checksum chunk boundaries, so a chunk owns whole
+ * blocks and carries a subset of the checksums of the extent.
+ *
+ * Chunks are identified by their SHA-256 fingerprint. The dedup index of the
+ * pool (pd_dedup_root) maps the block offset of each shared extent to its
+ * fingerprint and reference count, a DRAM hash rebuilt when the pool is opened
+ * maps fingerprints back to extents. A chunk whose fingerprint is indexed
+ * references the existing extent, and the blocks it was written to are freed
+ * once the update is committed. Records of shared extents have ba_shared set,
+ * freeing them drops a reference and the last one frees the blocks.
+ *
+ * Chunks are fingerprinted by vos_dedup_scan() while the data of the update is
+ * in the bio buffers, and are indexed by vos_update_end().
+ */
+#define D_LOGFAC	DD_FAC(vos)
+
+#include <daos/checksum.h>
+#include "vos_internal.h"
+
+#define VOS_CDC_ENV		"DAOS_DEDUP_CDC"
+#define VOS_CDC_SIZE_ENV	"DAOS_DEDUP_CDC_SIZE"
+/** Default average chunk size */
+#define VOS_CDC_SIZE_DEF	(64U << 10)
+#define VOS_CDC_SIZE_MIN	(16U << 10)
+#define VOS_CDC_SIZE_MAX	(4U << 20)
+/** Bytes of data preceding a cut point its gear hash depends on */
+#define VOS_CDC_WINDOW		64
+/** Chunks are allocated by this number */
+#define VOS_CDC_CHUNKS_INC	16
+#define VOS_CDC_ORDER		16
+#define VOS_CDC_HASH_BITS	16
+
+bool		vos_cdc_enabled;
+static uint32_t	vos_cdc_size = VOS_CDC_SIZE_DEF;
+/** Cut at a candidate point if the top bits of its gear hash are clear */
+static uint64_t	vos_cdc_mask;
+static uint64_t	vos_cdc_gear[256];
+
+/** DRAM side of the dedup index of a pool */
+struct vos_cdc_index {
+	/** Open handle of pd_dedup_root */
+	daos_handle_t		 ci_toh;
+	/** Fingerprint to extent hash */
+	struct d_hash_table	 ci_htable;
+	/** SHA-256 for fingerprints */
+	struct daos_csummer	*ci_csummer;
+	struct vos_dedup_stats	 ci_stats;
+};
+
+struct vos_cdc_entry {
+	d_list_t	ce_link;
+	uint64_t	ce_blk_off;
+	uint32_t	ce_blk_cnt;
+	uint8_t		ce_fp[VOS_DEDUP_FP_LEN];
+};
+
+static inline struct vos_cdc_entry *
+cdc_link2entry(d_list_t *link)
+{
+	return container_of(link, struct vos_cdc_entry, ce_link);
+}
+
+static bool
+cdc_key_cmp(struct d_hash_table *htable, d_list_t *link, const void *key,
+	    unsigned int ksize)
+{
+	D_ASSERT(ksize == VOS_DEDUP_FP_LEN);
+	return memcmp(cdc_link2entry(link)->ce_fp, key, ksize) == 0;
+}
+
+/** Fingerprints are uniformly distributed, any part of them is a hash */
+static uint32_t
+cdc_key_hash(struct d_hash_table *htable, const void *key, unsigned int ksize)
+{
+	uint32_t	hash;
+
+	memcpy(&hash, key, sizeof(hash));
+	return hash;
+}
+
+static uint32_t
+cdc_rec_hash(struct d_hash_table *htable, d_list_t *link)
+{
+	return cdc_key_hash(htable, cdc_link2entry(link)->ce_fp,
+			    VOS_DEDUP_FP_LEN);
+}
+
+static bool
+cdc_entry_decref(struct d_hash_table *htable, d_list_t *link)
+{
+	return true;
+}
+
+static void
+cdc_entry_free(struct d_hash_table *htable, d_list_t *link)
+{
+	struct vos_cdc_entry	*entry = cdc_link2entry(link);
+
+	D_FREE(entry);
+}
+
+static d_hash_table_ops_t cdc_hash_ops = {
+	.hop_key_cmp	= cdc_key_cmp,
+	.hop_key_hash	= cdc_key_hash,
+	.hop_rec_hash	= cdc_rec_hash,
+	.hop_rec_decref	= cdc_entry_decref,
+	.hop_rec_free	= cdc_entry_free,
+};
+
+static void
+cdc_index_bytes(struct vos_cdc_index *idx)
+{
+	idx->ci_stats.ds_index_bytes =
+		idx->ci_stats.ds_extents * sizeof(struct vos_cdc_entry) +
+		(1ULL << VOS_CDC_HASH_BITS) * sizeof(struct d_hash_bucket);
+}
+
+static int
+cdc_entry_add(struct vos_cdc_index *idx, uint8_t *fp, uint64_t blk_off,
+	      uint32_t blk_cnt)
+{
+	struct vos_cdc_entry	*entry;
+	int			 rc;
+
+	D_ALLOC_PTR(entry);
+	if (entry == NULL)
+		return -DER_NOMEM;
+
+	entry->ce_blk_off = blk_off;
+	entry->ce_blk_cnt = blk_cnt;
+	memcpy(entry->ce_fp, fp, VOS_DEDUP_FP_LEN);
+
+	rc = d_hash_rec_insert(&idx->ci_htable, entry->ce_fp, VOS_DEDUP_FP_LEN,
+			       &entry->ce_link, true);
+	if (rc != 0) {
+		D_FREE(entry);
+		/* Same content stored twice, only one of them is shared */
+		return rc == -DER_EXIST ? 0 : rc;
+	}
+
+	idx->ci_stats.ds_extents++;
+	cdc_index_bytes(idx);
+	return 0;
+}
+
+static void
+cdc_entry_del(struct vos_cdc_index *idx, uint8_t *fp, uint64_t blk_off)
+{
+	d_list_t	*link;
+
+	link = d_hash_rec_find(&idx->ci_htable, fp, VOS_DEDUP_FP_LEN);
+	if (link == NULL || cdc_link2entry(link)->ce_blk_off != blk_off)
+		return;
+
+	d_hash_rec_delete_at(&idx->ci_htable, link);
+	idx->ci_stats.ds_extents--;
+	cdc_index_bytes(idx);
+}
+
+/**
+ * Customized functions for the dedup index btree, records are vos_dedup_df
+ * keyed by block offset.
+ */
+
+static int
+cdc_rec_msize(int alloc_overhead)
+{
+	return alloc_overhead + sizeof(struct vos_dedup_df);
+}
+
+static int
+cdc_rec_alloc(struct btr_instance *tins, d_iov_t *key_iov, d_iov_t *val_iov,
+	      struct btr_record *rec)
+{
+	struct vos_dedup_df	*df;
+	umem_off_t		 off;
+
+	D_ASSERT(val_iov->iov_len == sizeof(*df));
+	off = umem_alloc(&tins->ti_umm, sizeof(*df));
+	if (UMOFF_IS_NULL(off))
+		return -DER_NOSPACE;
+
+	df = umem_off2ptr(&tins->ti_umm, off);
+	memcpy(df, val_iov->iov_buf, sizeof(*df));
+	rec->rec_off = off;
+	return 0;
+}
+
+static int
+cdc_rec_free(struct btr_instance *tins, struct btr_record *rec, void *args)
+{
+	return umem_free(&tins->ti_umm, rec->rec_off);
+}
+
+static int
+cdc_rec_fetch(struct btr_instance *tins, struct btr_record *rec,
+	      d_iov_t *key_iov, d_iov_t *val_iov)
+{
+	struct vos_dedup_df	*df = umem_off2ptr(&tins->ti_umm, rec->rec_off);
+
+	if (key_iov != NULL)
+		d_iov_set(key_iov, &rec->rec_ukey[0], sizeof(uint64_t));
+	if (val_iov != NULL)
+		d_iov_set(val_iov, df, sizeof(*df));
+	return 0;
+}
+
+static int
+cdc_rec_update(struct btr_instance *tins, struct btr_record *rec,
+	       d_iov_t *key_iov, d_iov_t *val_iov)
+{
+	struct vos_dedup_df	*df = umem_off2ptr(&tins->ti_umm, rec->rec_off);
+	int			 rc;
+
+	D_ASSERT(val_iov->iov_len == sizeof(*df));
+	rc = umem_tx_add_ptr(&tins->ti_umm, df, sizeof(*df));
+	if (rc == 0)
+		memcpy(df, val_iov->iov_buf, sizeof(*df));
+	return rc;
+}
+
+static btr_ops_t cdc_btr_ops = {
+	.to_rec_msize		= cdc_rec_msize,
+	.to_rec_alloc		= cdc_rec_alloc,
+	.to_rec_free		= cdc_rec_free,
+	.to_rec_fetch		= cdc_rec_fetch,
+	.to_rec_update		= cdc_rec_update,
+};
+
+/** splitmix64, the gear table only has to be the same on every engine */
+static uint64_t
+cdc_gear_next(uint64_t *state)
+{
+	uint64_t	z = (*state += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+int
+vos_cdc_register(void)
+{
+	uint64_t	state = 0x5ca1ab1e;
+	unsigned int	size = VOS_CDC_SIZE_DEF;
+	int		bits = 0;
+	int		i;
+	int		rc;
+
+	rc = dbtree_class_register(VOS_BTR_DEDUP, BTR_FEAT_UINT_KEY,
+				   &cdc_btr_ops);
+	if (rc != 0) {
+		D_ERROR("Failed to register dedup index btree class: "DF_RC"\n",
+			DP_RC(rc));
+		return rc;
+	}
+
+	vos_cdc_enabled = false;
+	d_getenv_bool(VOS_CDC_ENV, &vos_cdc_enabled);
+	d_getenv_int(VOS_CDC_SIZE_ENV, &size);
+	if (size < VOS_CDC_SIZE_MIN || size > VOS_CDC_SIZE_MAX) {
+		D_WARN("Invalid %s %u, using %u\n", VOS_CDC_SIZE_ENV, size,
+		       VOS_CDC_SIZE_DEF);
+		size = VOS_CDC_SIZE_DEF;
+	}
+	vos_cdc_size = size;
+
+	/*
+	 * Candidate cut points are one block apart at least, past the minimum
+	 * chunk size one of every 2^bits of them is a cut point on average.
+	 */
+	while ((VOS_BLK_SZ << (bits + 1)) <= size - size / 4)
+		bits++;
+	vos_cdc_mask = bits == 0 ? 0 : ~0ULL << (64 - bits);
+
+	for (i = 0; i < ARRAY_SIZE(vos_cdc_gear); i++)
+		vos_cdc_gear[i] = cdc_gear_next(&state);
+
+	if (vos_cdc_enabled)
+		D_INFO("Content defined chunking dedup, chunks of %u bytes\n",
+		       vos_cdc_size);
+	return 0;
+}
+
+int
+vos_cdc_create(struct umem_attr *uma, struct vos_pool_df *pool_df)
+{
+	daos_handle_t	hdl;
+	int		rc;
+
+	rc = dbtree_create_inplace(VOS_BTR_DEDUP, BTR_FEAT_UINT_KEY,
+				   VOS_CDC_ORDER, uma, &pool_df->pd_dedup_root,
+				   &hdl);
+	if (rc != 0)
+		return rc;
+
+	dbtree_close(hdl);
+	return 0;
+}
+
+static int
+cdc_load_cb(daos_handle_t ih, d_iov_t *key, d_iov_t *val, void *arg)
+{
+	struct vos_dedup_df	*df = val->iov_buf;
+	uint64_t		 blk_off;
+
+	memcpy(&blk_off, key->iov_buf, sizeof(blk_off));
+	return cdc_entry_add(arg, df->dd_fp, blk_off, df->dd_blk_cnt);
+}
+
+int
+vos_cdc_open(struct vos_pool *pool, struct vos_pool_df *pool_df)
+{
+	struct vos_cdc_index	*idx;
+	int			 rc;
+
+	/* Shared extents are on NVMe only */
+	if (pool_df->pd_version < POOL_DF_VER_2 || pool->vp_vea_info == NULL)
+		return 0;
+
+	D_ALLOC_PTR(idx);
+	if (idx == NULL)
+		return -DER_NOMEM;
+
+	rc = d_hash_table_create_inplace(D_HASH_FT_NOLOCK, VOS_CDC_HASH_BITS,
+					 NULL, &cdc_hash_ops, &idx->ci_htable);
+	if (rc != 0) {
+		D_FREE(idx);
+		return rc;
+	}
+	pool->vp_cdc = idx;
+
+	rc = daos_csummer_init_with_type(&idx->ci_csummer, HASH_TYPE_SHA256,
+					 0, false);
+	if (rc != 0)
+		goto failed;
+	D_ASSERT(daos_csummer_get_csum_len(idx->ci_csummer) ==
+		 VOS_DEDUP_FP_LEN);
+
+	rc = dbtree_open_inplace(&pool_df->pd_dedup_root, &pool->vp_uma,
+				 &idx->ci_toh);
+	if (rc != 0)
+		goto failed;
+
+	rc = dbtree_iterate(idx->ci_toh, DAOS_INTENT_DEFAULT, false,
+			    cdc_load_cb, idx);
+	if (rc != 0)
+		goto failed;
+
+	cdc_index_bytes(idx);
+	D_DEBUG(DB_MGMT, DF_UUID": loaded "DF_U64" shared extents\n",
+		DP_UUID(pool->vp_id), idx->ci_stats.ds_extents);
+	return 0;
+failed:
+	D_ERROR(DF_UUID": failed to load the dedup index: "DF_RC"\n",
+		DP_UUID(pool->vp_id), DP_RC(rc));
+	vos_cdc_close(pool);
+	return rc;
+}
+
+void
+vos_cdc_close(struct vos_pool *pool)
+{
+	struct vos_cdc_index	*idx = pool->vp_cdc;
+
+	if (idx == NULL)
+		return;
+
+	if (daos_handle_is_valid(idx->ci_toh))
+		dbtree_close(idx->ci_toh);
+	daos_csummer_destroy(&idx->ci_csummer);
+	d_hash_table_destroy_inplace(&idx->ci_htable, true);
+	D_FREE(idx);
+	pool->vp_cdc = NULL;
+}
+
+/**
+ * Return the end of the chunk starting at byte \a off of the \a len bytes of
+ * \a buf. Candidate cut points are multiples of \a step which are also
+ * multiples of \a chunk_size (if not zero) once \a base is added.
+ */
+uint64_t
+vos_cdc_cut(const uint8_t *buf, uint64_t len, uint64_t off, uint64_t step,
+	    uint64_t base, uint32_t chunk_size)
+{
+	uint64_t	min = off + vos_cdc_size / 4;
+	uint64_t	max = off + (uint64_t)vos_cdc_size * 4;
+	uint64_t	hash;
+	uint64_t	pos;
+	uint64_t	i;
+
+	for (pos = off + step; pos < len; pos += step) {
+		if (chunk_size != 0 && (base + pos) % chunk_size != 0)
+			continue;
+		if (pos >= max)
+			return pos;
+		if (pos < min)
+			continue;
+
+		hash = 0;
+		for (i = pos - VOS_CDC_WINDOW; i < pos; i++)
+			hash = (hash << 1) + vos_cdc_gear[buf[i]];
+		if ((hash & vos_cdc_mask) == 0)
+			return pos;
+	}
+	return len;
+}
+
+static int
+cdc_fingerprint(struct vos_cdc_index *idx, uint8_t *buf, uint64_t len,
+		uint8_t *fp)
+{
+	int	rc;
+
+	daos_csummer_set_buffer(idx->ci_csummer, fp, VOS_DEDUP_FP_LEN);
+	rc = daos_csummer_reset(idx->ci_csummer);
+	if (rc == 0)
+		rc = daos_csummer_update(idx->ci_csummer, buf, len);
+	if (rc == 0)
+		rc = daos_csummer_finish(idx->ci_csummer);
+	return rc;
+}
+
+static struct vos_cdc_chunk *
+cdc_chunk_alloc(struct vos_cdc_io **ciop)
+{
+	struct vos_cdc_io	*cio = *ciop;
+	struct vos_cdc_chunk	*chunks;
+
+	if (cio == NULL) {
+		D_ALLOC_PTR(cio);
+		if (cio == NULL)
+			return NULL;
+		*ciop = cio;
+	}
+
+	if (cio->cio_nr == cio->cio_cap) {
+		D_REALLOC_ARRAY(chunks, cio->cio_chunks,
+				cio->cio_cap + VOS_CDC_CHUNKS_INC);
+		if (chunks == NULL)
+			return NULL;
+		cio->cio_chunks = chunks;
+		cio->cio_cap += VOS_CDC_CHUNKS_INC;
+	}
+	return &cio->cio_chunks[cio->cio_nr++];
+}
+
+static uint64_t
+cdc_gcd(uint64_t a, uint64_t b)
+{
+	uint64_t	t;
+
+	while (b != 0) {
+		t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/**
+ * Cut the extent \a recx, whose data is in \a buf, into chunks and fingerprint
+ * them. The chunks are appended to \a ciop, allocated on first use.
+ */
+int
+vos_cdc_scan(struct vos_pool *pool, struct vos_cdc_io **ciop, uint32_t sgl,
+	     uint32_t iov, uint8_t *buf, daos_recx_t *recx, daos_size_t rsize,
+	     struct dcs_csum_info *csum)
+{
+	struct vos_cdc_chunk	*cc;
+	uint64_t		 len = recx->rx_nr * rsize;
+	uint64_t		 step;
+	uint64_t		 off;
+	uint64_t		 end;
+	int			 rc;
+
+	D_ASSERT(vos_cdc_active(pool));
+	/* Cut points are on block and record boundaries */
+	step = VOS_BLK_SZ / cdc_gcd(VOS_BLK_SZ, rsize) * rsize;
+
+	for (off = 0; off < len; off = end) {
+		end = vos_cdc_cut(buf, len, off, step, recx->rx_idx * rsize,
+				  ci_is_valid(csum) ? csum->cs_chunksize : 0);
+
+		cc = cdc_chunk_alloc(ciop);
+		if (cc == NULL)
+			return -DER_NOMEM;
+
+		memset(cc, 0, sizeof(*cc));
+		cc->cc_sgl = sgl;
+		cc->cc_iov = iov;
+		cc->cc_off = off;
+		cc->cc_len = end - off;
+		rc = cdc_fingerprint(pool->vp_cdc, buf + off, cc->cc_len,
+				     cc->cc_fp);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
+/**
+ * Return the chunks of the extent of IOV \a iov of SGL \a sgl, their number
+ * in \a nr, or NULL if the extent isn't chunked. Extents must be looked up in
+ * the order they were scanned.
+ */
+struct vos_cdc_chunk *
+vos_cdc_chunks(struct vos_cdc_io *cio, uint32_t sgl, uint32_t iov,
+	       uint32_t *nr)
+{
+	struct vos_cdc_chunk	*chunks;
+	struct vos_cdc_chunk	*cc;
+
+	if (cio == NULL)
+		return NULL;
+
+	while (cio->cio_at < cio->cio_nr) {
+		cc = &cio->cio_chunks[cio->cio_at];
+		if (cc->cc_sgl > sgl ||
+		    (cc->cc_sgl == sgl && cc->cc_iov >= iov))
+			break;
+		cio->cio_at++;
+	}
+
+	chunks = &cio->cio_chunks[cio->cio_at];
+	*nr = 0;
+	while (cio->cio_at < cio->cio_nr) {
+		cc = &cio->cio_chunks[cio->cio_at];
+		if (cc->cc_sgl != sgl || cc->cc_iov != iov)
+			break;
+		cio->cio_at++;
+		(*nr)++;
+	}
+	return *nr == 0 ? NULL : chunks;
+}
+
+/** Find the extent of the content of \a cc, indexed or new in this update */
+static bool
+cdc_lookup(struct vos_cdc_index *idx, struct vos_cdc_io *cio,
+	   struct vos_cdc_chunk *cc, uint64_t *blk_off)
+{
+	struct vos_cdc_entry	*entry;
+	struct vos_cdc_chunk	*prev;
+	d_list_t		*link;
+
+	link = d_hash_rec_find(&idx->ci_htable, cc->cc_fp, VOS_DEDUP_FP_LEN);
+	if (link != NULL) {
+		entry = cdc_link2entry(link);
+		if (entry->ce_blk_cnt == cc->cc_blk_cnt) {
+			*blk_off = entry->ce_blk_off;
+			return true;
+		}
+	}
+
+	for (prev = cio->cio_chunks; prev < cc; prev++) {
+		if (prev->cc_state == VOS_CDC_NEW &&
+		    prev->cc_blk_cnt == cc->cc_blk_cnt &&
+		    memcmp(prev->cc_fp, cc->cc_fp, VOS_DEDUP_FP_LEN) == 0) {
+			*blk_off = prev->cc_blk_off;
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Take a reference on the indexed extent at \a blk_off with content \a cc */
+static int
+cdc_addref(struct vos_pool *pool, uint64_t blk_off, struct vos_cdc_chunk *cc)
+{
+	struct vos_dedup_df	*df;
+	d_iov_t			 key;
+	d_iov_t			 val;
+	int			 rc;
+
+	d_iov_set(&key, &blk_off, sizeof(blk_off));
+	d_iov_set(&val, NULL, 0);
+	rc = dbtree_lookup(pool->vp_cdc->ci_toh, &key, &val);
+	if (rc != 0)
+		return rc;
+
+	df = val.iov_buf;
+	/* The DRAM hash can be stale if a transaction has been aborted */
+	if (df->dd_blk_cnt != cc->cc_blk_cnt || df->dd_ref == UINT32_MAX ||
+	    memcmp(df->dd_fp, cc->cc_fp, VOS_DEDUP_FP_LEN) != 0)
+		return -DER_NONEXIST;
+
+	rc = umem_tx_add_ptr(&pool->vp_umm, &df->dd_ref, sizeof(df->dd_ref));
+	if (rc == 0)
+		df->dd_ref++;
+	return rc;
+}
+
+/**
+ * Return in \a chunk_addr the address of the chunk \a cc of the extent at
+ * \a addr: the indexed extent with the same content, whose reference is taken,
+ * or the blocks of the chunk in the extent, which are added to the index.
+ * Called in the transaction of the update.
+ */
+int
+vos_cdc_chunk_addr(struct vos_pool *pool, struct vos_cdc_io *cio,
+		   struct vos_cdc_chunk *cc, bio_addr_t *addr,
+		   bio_addr_t *chunk_addr)
+{
+	struct vos_dedup_df	df;
+	uint64_t		blk_off;
+	d_iov_t			key;
+	d_iov_t			val;
+	int			rc;
+
+	D_ASSERT(addr->ba_type == DAOS_MEDIA_NVME);
+	cc->cc_blk_off = vos_byte2blkoff(addr->ba_off + cc->cc_off);
+	cc->cc_blk_cnt = vos_byte2blkcnt(cc->cc_len);
+	*chunk_addr = *addr;
+	chunk_addr->ba_shared = 1;
+
+	if (cdc_lookup(pool->vp_cdc, cio, cc, &blk_off)) {
+		rc = cdc_addref(pool, blk_off, cc);
+		if (rc == 0) {
+			cc->cc_state = VOS_CDC_DUP;
+			chunk_addr->ba_off = blk_off << VOS_BLK_SHIFT;
+			return 0;
+		}
+		if (rc != -DER_NONEXIST)
+			return rc;
+		cdc_entry_del(pool->vp_cdc, cc->cc_fp, blk_off);
+	}
+
+	memcpy(df.dd_fp, cc->cc_fp, VOS_DEDUP_FP_LEN);
+	df.dd_blk_cnt = cc->cc_blk_cnt;
+	df.dd_ref = 1;
+	d_iov_set(&key, &cc->cc_blk_off, sizeof(cc->cc_blk_off));
+	d_iov_set(&val, &df, sizeof(df));
+	rc = dbtree_update(pool->vp_cdc->ci_toh, &key, &val);
+	if (rc != 0)
+		return rc;
+
+	cc->cc_state = VOS_CDC_NEW;
+	chunk_addr->ba_off += cc->cc_off;
+	return 0;
+}
+
+/**
+ * Finish the chunks of an update: if it is committed (\a err is zero), add the
+ * new extents to the DRAM hash and free the blocks of the duplicated chunks.
+ * \a cio is freed.
+ */
+void
+vos_cdc_io_end(struct vos_pool *pool, struct vos_cdc_io *cio, int err)
+{
+	struct vos_cdc_index	*idx = pool->vp_cdc;
+	struct vos_cdc_chunk	*cc;
+	bool			 tx_started = false;
+	int			 rc = 0;
+	int			 i;
+
+	if (cio == NULL)
+		return;
+
+	for (i = 0; i < cio->cio_nr && err == 0; i++) {
+		cc = &cio->cio_chunks[i];
+		if (cc->cc_state == 0)
+			continue;
+
+		idx->ci_stats.ds_in += cc->cc_len;
+		if (cc->cc_state == VOS_CDC_NEW) {
+			idx->ci_stats.ds_stored += cc->cc_len;
+			rc = cdc_entry_add(idx, cc->cc_fp, cc->cc_blk_off,
+					   cc->cc_blk_cnt);
+			if (rc != 0)
+				D_ERROR("Failed to index extent "DF_U64": "
+					DF_RC"\n", cc->cc_blk_off, DP_RC(rc));
+			continue;
+		}
+
+		/*
+		 * A crash before this transaction commits leaks the blocks
+		 * of the duplicated chunks, nothing references them.
+		 */
+		if (!tx_started) {
+			rc = umem_tx_begin(&pool->vp_umm, vos_txd_get());
+			if (rc != 0)
+				break;
+			tx_started = true;
+		}
+		rc = vea_free(pool->vp_vea_info, cc->cc_blk_off,
+			      cc->cc_blk_cnt);
+		if (rc != 0)
+			break;
+	}
+
+	if (tx_started)
+		rc = umem_tx_end(&pool->vp_umm, rc);
+	if (rc != 0)
+		D_ERROR(DF_UUID": failed to free duplicated chunks: "DF_RC"\n",
+			DP_UUID(pool->vp_id), DP_RC(rc));
+
+	D_FREE(cio->cio_chunks);
+	D_FREE(cio);
+}
+
+/**
+ * Drop a reference on the shared extent at \a addr, the last one frees it.
+ * Called in a transaction by vos_bio_addr_free().
+ */
+int
+vos_cdc_put(struct vos_pool *pool, bio_addr_t *addr)
+{
+	struct vos_cdc_index	*idx = pool->vp_cdc;
+	struct vos_dedup_df	*df;
+	uint64_t		 blk_off;
+	uint32_t		 blk_cnt;
+	d_iov_t			 key;
+	d_iov_t			 val;
+	int			 rc;
+
+	D_ASSERT(addr->ba_type == DAOS_MEDIA_NVME);
+	if (idx == NULL) {
+		D_ERROR(DF_UUID": shared extent "DF_X64" without dedup index\n",
+			DP_UUID(pool->vp_id), addr->ba_off);
+		return -DER_INVAL;
+	}
+
+	blk_off = vos_byte2blkoff(addr->ba_off);
+	d_iov_set(&key, &blk_off, sizeof(blk_off));
+	d_iov_set(&val, NULL, 0);
+	rc = dbtree_lookup(idx->ci_toh, &key, &val);
+	if (rc != 0) {
+		D_ERROR(DF_UUID": shared extent "DF_U64" isn't indexed: "
+			DF_RC"\n", DP_UUID(pool->vp_id), blk_off, DP_RC(rc));
+		return rc;
+	}
+
+	df = val.iov_buf;
+	D_ASSERT(df->dd_ref > 0);
+	if (df->dd_ref > 1) {
+		rc = umem_tx_add_ptr(&pool->vp_umm, &df->dd_ref,
+				     sizeof(df->dd_ref));
+		if (rc == 0)
+			df->dd_ref--;
+		return rc;
+	}
+
+	blk_cnt = df->dd_blk_cnt;
+	cdc_entry_del(idx, df->dd_fp, blk_off);
+	rc = dbtree_delete(idx->ci_toh, BTR_PROBE_EQ, &key, NULL);
+	if (rc != 0)
+		return rc;
+
+	rc = vea_free(pool->vp_vea_info, blk_off, blk_cnt);
+	if (rc)
+		D_ERROR("Error on block ["DF_U64", %u] free. "DF_RC"\n",
+			blk_off, blk_cnt, DP_RC(rc));
+	return rc;
+}
+
+int
+vos_pool_dedup_query(daos_handle_t poh, struct vos_dedup_stats *stats)
+{
+	struct vos_pool	*pool = vos_hdl2pool(poh);
+
+	if (pool == NULL)
+		return -DER_NO_HDL;
+
+	if (pool->vp_cdc == NULL)
+		memset(stats, 0, sizeof(*stats));
+	else
+		*stats = pool->vp_cdc->ci_stats;
+	return 0;
+}
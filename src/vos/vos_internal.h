@@ -162,6 +162,8 @@ struct vos_pool {
 	daos_size_t		vp_space_held[DAOS_MEDIA_MAX];
 	/** Dedup hash */
 	struct d_hash_table	*vp_dedup_hash;
+	/** Index of shared NVMe extents, NULL if the pool has none */
+	struct vos_cdc_index	*vp_cdc;
 };
 
 /**
@@ -212,6 +214,18 @@ struct vos_container {
 				vc_in_discard:1,
 				vc_reindex_cmt_dtx:1;
 	unsigned int		vc_open_count;
+	/** Compressor of array records, NULL if compression is disabled */
+	struct daos_compressor	*vc_compressor;
+	/** Scratch buffer for partial chunk decompression */
+	void			*vc_cmp_buf;
+	size_t			vc_cmp_buf_len;
+	/** Compression statistics since the container is loaded */
+	struct vos_cmp_stats	vc_cmp_stats;
+	/** Updates waiting for their offloaded compression jobs */
+	uint32_t		vc_cmp_inflight;
+	/** Signaled when vc_cmp_inflight drops to 0 */
+	ABT_mutex		vc_cmp_lock;
+	ABT_cond		vc_cmp_cond;
 };
 
 struct vos_dtx_act_ent {
@@ -534,6 +548,8 @@ enum vos_tree_class {
 	VOS_BTR_DTX_CMT_TABLE	= (VOS_BTR_BEGIN + 6),
 	/** The VOS incarnation log tree */
 	VOS_BTR_ILOG		= (VOS_BTR_BEGIN + 7),
+	/** Dedup index of the shared NVMe extents of a pool */
+	VOS_BTR_DEDUP		= (VOS_BTR_BEGIN + 8),
 	/** the last reserved tree class */
 	VOS_BTR_END,
 };
@@ -1170,6 +1186,103 @@ vos_slab_alloc(struct umem_instance *umm, int size, int slab_id)
 					POBJ_FLAG_ZERO, size);
 }
 
+/* vos_compress.c */
+
+/** Compressed image of an SCM extent of an update */
+struct vos_cmp_img {
+	/** SGL and IOV of the extent in the bio descriptor */
+	uint32_t	 ci_sgl;
+	uint32_t	 ci_iov;
+	/** Extent to compress, and its checksum chunk size if any */
+	void		*ci_src;
+	uint64_t	 ci_size;
+	uint32_t	 ci_chunk_size;
+	/** Compressed image, NULL if the extent is stored as it is */
+	void		*ci_buf;
+	uint64_t	 ci_len;
+};
+
+void
+vos_cmp_encode(struct vos_container *cont, struct vos_cmp_img *imgs,
+	       unsigned int nr, bool can_wait);
+int
+vos_cmp_read(struct vos_container *cont, bio_addr_t addr, uint64_t off,
+	     uint64_t len, void *buf);
+int
+vos_cmp_init(struct vos_container *cont);
+void
+vos_cmp_fini(struct vos_container *cont);
+
+/* vos_dedup.c */
+
+/** Content defined chunk of an NVMe extent of an update */
+struct vos_cdc_chunk {
+	/** SGL and IOV of the extent in the bio descriptor */
+	uint32_t	cc_sgl;
+	uint32_t	cc_iov;
+	/** Byte offset and length of the chunk in the extent */
+	uint64_t	cc_off;
+	uint64_t	cc_len;
+	/** Blocks the chunk has been written to */
+	uint64_t	cc_blk_off;
+	uint32_t	cc_blk_cnt;
+	/** VOS_CDC_NEW or VOS_CDC_DUP once the update is indexed */
+	uint32_t	cc_state;
+	uint8_t		cc_fp[VOS_DEDUP_FP_LEN];
+};
+
+enum {
+	/** The chunk is a new shared extent */
+	VOS_CDC_NEW	= 1,
+	/** The chunk references an existing extent, its blocks are freed */
+	VOS_CDC_DUP,
+};
+
+/** Chunks of the extents of an update, in the order of the extents */
+struct vos_cdc_io {
+	struct vos_cdc_chunk	*cio_chunks;
+	uint32_t		 cio_nr;
+	uint32_t		 cio_cap;
+	/** Cursor of the chunks being indexed */
+	uint32_t		 cio_at;
+};
+
+extern bool vos_cdc_enabled;
+
+int
+vos_cdc_register(void);
+int
+vos_cdc_create(struct umem_attr *uma, struct vos_pool_df *pool_df);
+int
+vos_cdc_open(struct vos_pool *pool, struct vos_pool_df *pool_df);
+void
+vos_cdc_close(struct vos_pool *pool);
+uint64_t
+vos_cdc_cut(const uint8_t *buf, uint64_t len, uint64_t off, uint64_t step,
+	    uint64_t base, uint32_t chunk_size);
+int
+vos_cdc_scan(struct vos_pool *pool, struct vos_cdc_io **ciop, uint32_t sgl,
+	     uint32_t iov, uint8_t *buf, daos_recx_t *recx, daos_size_t rsize,
+	     struct dcs_csum_info *csum);
+struct vos_cdc_chunk *
+vos_cdc_chunks(struct vos_cdc_io *cio, uint32_t sgl, uint32_t iov,
+	       uint32_t *nr);
+int
+vos_cdc_chunk_addr(struct vos_pool *pool, struct vos_cdc_io *cio,
+		   struct vos_cdc_chunk *cc, bio_addr_t *addr,
+		   bio_addr_t *chunk_addr);
+void
+vos_cdc_io_end(struct vos_pool *pool, struct vos_cdc_io *cio, int err);
+int
+vos_cdc_put(struct vos_pool *pool, bio_addr_t *addr);
+
+/** Is content defined chunking used for the updates of \a pool? */
+static inline bool
+vos_cdc_active(struct vos_pool *pool)
+{
+	return vos_cdc_enabled && pool->vp_cdc != NULL;
+}
+
 /* vos_space.c */
 void
 vos_space_sys_init(struct vos_pool *pool);
@@ -59,11 +59,14 @@ struct vos_io_context {
 	uint32_t		 ic_dedup_th;
 	/** dedup entries to be inserted after transaction done */
 	d_list_t		 ic_dedup_entries;
+	/** content defined chunks of the NVMe extents, see vos_dedup_scan() */
+	struct vos_cdc_io	*ic_cdc_io;
 	/** flags */
 	unsigned int		 ic_update:1,
 				 ic_size_fetch:1,
 				 ic_save_recx:1,
 				 ic_dedup:1, /** candidate for dedup */
+				 ic_cdc:1, /** NVMe extents can be chunked */
 				 ic_read_ts_only:1,
 				 ic_check_existence:1,
 				 ic_remove:1;
@@ -78,6 +81,13 @@ struct vos_io_context {
 	 * by vos_ioh2recx_list() and shall free it by daos_recx_ep_list_free().
 	 */
 	struct daos_recx_ep_list *ic_recx_lists;
+	/** DRAM buffers holding the decompressed extents for fetch */
+	void			**ic_cmp_bufs;
+	unsigned int		 ic_cmp_buf_nr;
+	/** Compressed images of the SCM extents for update */
+	struct vos_cmp_img	*ic_cmp_imgs;
+	unsigned int		 ic_cmp_img_nr;
+	unsigned int		 ic_cmp_img_at;
 };
 
 static inline daos_size_t
@@ -395,6 +405,10 @@ vos_ioc_reserve_init(struct vos_io_context *ioc, struct dtx_handle *dth)
 	if (vos_ioc2umm(ioc)->umm_ops->mo_reserve == NULL)
 		return 0;
 
+	/* Spare action to move a compressed record, see iod_compress() */
+	if (ioc->ic_cont->vc_compressor != NULL)
+		total_acts++;
+
 	size = sizeof(*ioc->ic_rsrvd_scm) +
 		sizeof(struct pobj_action) * total_acts;
 	D_ALLOC(ioc->ic_rsrvd_scm, size);
@@ -428,6 +442,14 @@ vos_ioc_destroy(struct vos_io_context *ioc, bool evict)
 	if (ioc->ic_biov_csums != NULL)
 		D_FREE(ioc->ic_biov_csums);
 
+	while (ioc->ic_cmp_buf_nr > 0)
+		D_FREE(ioc->ic_cmp_bufs[--ioc->ic_cmp_buf_nr]);
+	D_FREE(ioc->ic_cmp_bufs);
+
+	while (ioc->ic_cmp_img_nr > 0)
+		D_FREE(ioc->ic_cmp_imgs[--ioc->ic_cmp_img_nr].ci_buf);
+	D_FREE(ioc->ic_cmp_imgs);
+
 	if (ioc->ic_obj)
 		vos_obj_release(vos_obj_cache_current(), ioc->ic_obj, evict);
 
@@ -480,6 +502,14 @@ vos_ioc_create(daos_handle_t coh, daos_unit_oid_t oid, bool read_only,
 	ioc->ic_save_recx = ((vos_flags & VOS_OF_FETCH_RECX_LIST) != 0);
 	ioc->ic_dedup = dedup;
 	ioc->ic_dedup_th = dedup_th;
+	/*
+	 * The blocks of duplicated chunks are freed once the update is
+	 * published, so it must be the only modification of the DTX.
+	 */
+	ioc->ic_cdc = dedup && !read_only &&
+		      vos_cdc_active(vos_cont2pool(ioc->ic_cont)) &&
+		      (!dtx_is_valid_handle(dth) ||
+		       dth->dth_modification_cnt <= 1);
 	if (vos_flags & VOS_OF_FETCH_CHECK_EXISTENCE)
 		ioc->ic_read_ts_only = ioc->ic_check_existence = 1;
 	else if (vos_flags & VOS_OF_FETCH_SET_TS_ONLY)
@@ -718,6 +748,44 @@ out:
 	return rc;
 }
 
+/**
+ * Decompress the extent of a compressed record referenced by \a biov, with
+ * the prefix and suffix needed for checksum verification, into a DRAM buffer
+ * held by the I/O context.
+ */
+static int
+iod_fetch_decompress(struct vos_io_context *ioc, struct evt_entry *ent,
+		     daos_size_t rsize, struct bio_iov *biov)
+{
+	void	**bufs;
+	void	 *buf;
+	uint64_t  off;
+	int	  rc;
+
+	if (ioc->ic_size_fetch)
+		return 0;
+
+	D_REALLOC_ARRAY(bufs, ioc->ic_cmp_bufs, ioc->ic_cmp_buf_nr + 1);
+	if (bufs == NULL)
+		return -DER_NOMEM;
+	ioc->ic_cmp_bufs = bufs;
+
+	D_ALLOC(buf, bio_iov2raw_len(biov));
+	if (buf == NULL)
+		return -DER_NOMEM;
+	ioc->ic_cmp_bufs[ioc->ic_cmp_buf_nr++] = buf;
+
+	off = evt_entry_selected_offset(ent) * rsize - biov->bi_prefix_len;
+	rc = vos_cmp_read(ioc->ic_cont, ent->en_addr, off,
+			  bio_iov2raw_len(biov), buf);
+	if (rc != 0)
+		return rc;
+
+	biov->bi_addr = ent->en_addr;
+	bio_iov_set_raw_buf(biov, buf);
+	return 0;
+}
+
 static inline void
 biov_set_hole(struct bio_iov *biov, ssize_t len)
 {
@@ -877,6 +945,12 @@ akey_fetch_recx(daos_handle_t toh, const daos_epoch_range_t *epr,
 					"but not all\n");
 		}
 
+		if (biov.bi_addr.ba_compressed) {
+			rc = iod_fetch_decompress(ioc, ent, rsize, &biov);
+			if (rc != 0)
+				goto failed;
+		}
+
 		rc = iod_fetch(ioc, &biov);
 		if (rc != 0)
 			goto failed;
@@ -1432,6 +1506,191 @@ akey_update_single(daos_handle_t toh, uint32_t pm_ver, daos_size_t rsize,
 	return rc;
 }
 
+/* Cancel the SCM reservation at \a umoff, the last one takes its slot */
+static void
+vos_cancel_scm(struct vos_container *cont, struct vos_rsrvd_scm *rsrvd_scm,
+	       umem_off_t umoff)
+{
+	struct pobj_action	*act;
+	unsigned int		 i;
+
+	for (i = 0; i < rsrvd_scm->rs_actv_at; i++) {
+		act = &rsrvd_scm->rs_actv[i];
+		if (act->heap.offset != umem_off2offset(umoff))
+			continue;
+
+		umem_cancel(vos_cont2umm(cont), act, 1);
+		rsrvd_scm->rs_actv_at--;
+		if (i != rsrvd_scm->rs_actv_at)
+			*act = rsrvd_scm->rs_actv[rsrvd_scm->rs_actv_at];
+		return;
+	}
+	D_ASSERTF(0, "No reservation at "DF_X64"\n", umoff);
+}
+
+/**
+ * Compress the SCM payloads of the array records of an update, if the
+ * container has compression enabled. Deduped records are left alone since the
+ * dedup table references the raw payload.
+ *
+ * It is done before the update transaction, since the compression may run on
+ * the offload xstreams while this ULT waits for it. The local transaction of a
+ * DTX may already be open though, the compression is not offloaded then.
+ */
+static void
+vos_ioc_compress(struct vos_io_context *ioc, struct dtx_handle *dth)
+{
+	struct vos_container	*cont = ioc->ic_cont;
+	struct umem_instance	*umm = vos_cont2umm(cont);
+	struct dcs_csum_info	*csum;
+	struct vos_cmp_img	*img;
+	struct bio_sglist	*bsgl;
+	struct bio_iov		*biov;
+	daos_iod_t		*iod;
+	unsigned int		 nr = 0;
+	int			 i, j;
+
+	if (cont->vc_compressor == NULL || ioc->ic_dedup || ioc->ic_remove ||
+	    umm->umm_ops->mo_reserve == NULL)
+		return;
+
+	for (i = 0; i < ioc->ic_iod_nr; i++) {
+		if (ioc->ic_iods[i].iod_type == DAOS_IOD_ARRAY)
+			nr += bio_iod_sgl(ioc->ic_biod, i)->bs_nr_out;
+	}
+	if (nr == 0)
+		return;
+
+	D_ALLOC_ARRAY(ioc->ic_cmp_imgs, nr);
+	if (ioc->ic_cmp_imgs == NULL)
+		return; /* keep them uncompressed */
+
+	for (i = 0; i < ioc->ic_iod_nr; i++) {
+		iod = &ioc->ic_iods[i];
+		bsgl = bio_iod_sgl(ioc->ic_biod, i);
+		/* Extents and bio IOVs only match one to one without holes */
+		if (iod->iod_type != DAOS_IOD_ARRAY ||
+		    bsgl->bs_nr_out != iod->iod_nr)
+			continue;
+
+		for (j = 0; j < iod->iod_nr; j++) {
+			biov = &bsgl->bs_iovs[j];
+			if (biov->bi_addr.ba_type != DAOS_MEDIA_SCM ||
+			    bio_addr_is_hole(&biov->bi_addr))
+				continue;
+
+			csum = NULL;
+			if (ioc->iod_csums != NULL &&
+			    ioc->iod_csums[i].ic_nr > 0)
+				csum = &ioc->iod_csums[i].ic_data[j];
+
+			img = &ioc->ic_cmp_imgs[ioc->ic_cmp_img_nr++];
+			img->ci_sgl = i;
+			img->ci_iov = j;
+			img->ci_src = umem_off2ptr(umm, bio_iov2off(biov));
+			img->ci_size = bio_iov2len(biov);
+			img->ci_chunk_size = ci_is_valid(csum) ?
+					     csum->cs_chunksize : 0;
+		}
+	}
+
+	vos_cmp_encode(cont, ioc->ic_cmp_imgs, ioc->ic_cmp_img_nr,
+		       !dtx_is_valid_handle(dth) || !dth->dth_local_tx_started);
+}
+
+/**
+ * Move the SCM payload of an array record to a smaller reservation holding
+ * its compressed image, if vos_ioc_compress() made one.
+ */
+static void
+iod_compress(struct vos_io_context *ioc, struct bio_iov *biov)
+{
+	struct vos_container	*cont = ioc->ic_cont;
+	struct umem_instance	*umm = vos_cont2umm(cont);
+	struct vos_cmp_img	*img;
+	umem_off_t		 umoff;
+
+	/* Images are in the order of the update */
+	while (ioc->ic_cmp_img_at < ioc->ic_cmp_img_nr) {
+		img = &ioc->ic_cmp_imgs[ioc->ic_cmp_img_at];
+		if (img->ci_sgl > ioc->ic_sgl_at ||
+		    (img->ci_sgl == ioc->ic_sgl_at &&
+		     img->ci_iov >= ioc->ic_iov_at - 1))
+			break;
+		ioc->ic_cmp_img_at++;
+	}
+
+	if (ioc->ic_cmp_img_at == ioc->ic_cmp_img_nr)
+		return;
+	img = &ioc->ic_cmp_imgs[ioc->ic_cmp_img_at];
+	if (img->ci_sgl != ioc->ic_sgl_at ||
+	    img->ci_iov != ioc->ic_iov_at - 1 || img->ci_buf == NULL)
+		return;
+
+	umoff = vos_reserve_scm(cont, ioc->ic_rsrvd_scm, img->ci_len);
+	if (UMOFF_IS_NULL(umoff))
+		return; /* keep it uncompressed */
+
+	pmemobj_memcpy_persist(umm->umm_pool, umem_off2ptr(umm, umoff),
+			       img->ci_buf, img->ci_len);
+	vos_cancel_scm(cont, ioc->ic_rsrvd_scm, bio_iov2off(biov));
+	biov->bi_addr.ba_off = umoff;
+	biov->bi_addr.ba_compressed = 1;
+}
+
+/**
+ * Is the extent a candidate for whole extent dedup? NVMe extents are chunked
+ * instead when content defined chunking is used.
+ */
+static inline bool
+ioc_dedup_extent(struct vos_io_context *ioc, uint16_t media, daos_size_t size)
+{
+	return ioc->ic_dedup && size >= ioc->ic_dedup_th &&
+	       !(ioc->ic_cdc && media == DAOS_MEDIA_NVME);
+}
+
+/**
+ * Insert one record per content defined chunk of the extent of \a ent, each
+ * with the checksums of its own checksum chunks.
+ */
+static int
+akey_update_chunks(daos_handle_t toh, struct evt_entry_in *ent,
+		   struct vos_cdc_chunk *chunks, uint32_t nr,
+		   struct vos_io_context *ioc)
+{
+	struct vos_pool		*pool = vos_cont2pool(ioc->ic_cont);
+	struct evt_entry_in	 chunk_ent = *ent;
+	struct dcs_csum_info	*csum = &ent->ei_csum;
+	struct evt_extent	*ext = &chunk_ent.ei_rect.rc_ex;
+	daos_size_t		 rsize = ent->ei_inob;
+	uint32_t		 csum_at = 0;
+	int			 i;
+	int			 rc;
+
+	for (i = 0; i < nr; i++) {
+		ext->ex_lo = ent->ei_rect.rc_ex.ex_lo +
+			     chunks[i].cc_off / rsize;
+		ext->ex_hi = ext->ex_lo + chunks[i].cc_len / rsize - 1;
+		if (ci_is_valid(csum)) {
+			chunk_ent.ei_csum.cs_csum = ci_idx2csum(csum, csum_at);
+			chunk_ent.ei_csum.cs_nr =
+				csum_chunk_count(csum->cs_chunksize,
+						 ext->ex_lo, ext->ex_hi, rsize);
+			chunk_ent.ei_csum.cs_buf_len =
+				chunk_ent.ei_csum.cs_nr * csum->cs_len;
+			csum_at += chunk_ent.ei_csum.cs_nr;
+		}
+
+		rc = vos_cdc_chunk_addr(pool, ioc->ic_cdc_io, &chunks[i],
+					&ent->ei_addr, &chunk_ent.ei_addr);
+		if (rc == 0)
+			rc = evt_insert(toh, &chunk_ent, NULL);
+		if (rc != 0)
+			return rc;
+	}
+	return 0;
+}
+
 /**
  * Update a record extent.
  * See comment of vos_recx_fetch for explanation of @off_p.
@@ -1443,7 +1702,9 @@ akey_update_recx(daos_handle_t toh, uint32_t pm_ver, daos_recx_t *recx,
 {
 	struct evt_entry_in	 ent;
 	struct bio_iov		*biov;
+	struct vos_cdc_chunk	*chunks;
 	daos_epoch_t		 epoch = ioc->ic_epr.epr_hi;
+	uint32_t		 chunk_nr;
 	int rc;
 
 	D_ASSERT(recx->rx_nr > 0);
@@ -1460,15 +1721,23 @@ akey_update_recx(daos_handle_t toh, uint32_t pm_ver, daos_recx_t *recx,
 		ent.ei_csum = *csum;
 
 	biov = iod_update_biov(ioc);
+	if (!ioc->ic_remove)
+		iod_compress(ioc, biov);
 	ent.ei_addr = biov->bi_addr;
 	ent.ei_addr.ba_dedup = false;	/* Don't make this flag persistent */
 
 	if (ioc->ic_remove)
 		return evt_remove_all(toh, &ent.ei_rect.rc_ex, &ioc->ic_epr);
 
+	chunks = vos_cdc_chunks(ioc->ic_cdc_io, ioc->ic_sgl_at,
+				ioc->ic_iov_at - 1, &chunk_nr);
+	if (chunks != NULL)
+		return akey_update_chunks(toh, &ent, chunks, chunk_nr, ioc);
+
 	rc = evt_insert(toh, &ent, NULL);
 
-	if (ioc->ic_dedup && !rc && (rsize * recx->rx_nr) >= ioc->ic_dedup_th) {
+	if (!rc && ioc_dedup_extent(ioc, biov->bi_addr.ba_type,
+				    rsize * recx->rx_nr)) {
 		daos_size_t csum_len = recx_csum_len(recx, csum, rsize);
 
 		vos_dedup_update(vos_cont2pool(ioc->ic_cont), csum, csum_len,
@@ -1852,7 +2121,7 @@ vos_reserve_recx(struct vos_io_context *ioc, uint16_t media, daos_size_t size,
 		}
 	}
 
-	if (ioc->ic_dedup && size >= ioc->ic_dedup_th &&
+	if (ioc_dedup_extent(ioc, media, size) &&
 	    vos_dedup_lookup(vos_cont2pool(ioc->ic_cont), csum, csum_len,
 			     &biov)) {
 		if (biov.bi_data_len == size) {
@@ -2030,6 +2299,8 @@ vos_update_end(daos_handle_t ioh, uint32_t pm_ver, daos_key_t *dkey, int err,
 	if (err != 0)
 		goto abort;
 
+	vos_ioc_compress(ioc, dth);
+
 	err = vos_ts_set_add(ioc->ic_ts_set, ioc->ic_cont->vc_ts_idx, NULL, 0);
 	D_ASSERT(err == 0);
 
@@ -2092,6 +2363,8 @@ abort:
 
 	err = vos_tx_end(ioc->ic_cont, dth, &ioc->ic_rsrvd_scm,
 			 &ioc->ic_blk_exts, tx_started, err);
+	vos_cdc_io_end(vos_cont2pool(ioc->ic_cont), ioc->ic_cdc_io, err);
+	ioc->ic_cdc_io = NULL;
 	if (err == 0) {
 		vos_ts_set_upgrade(ioc->ic_ts_set);
 		if (daes != NULL) {
@@ -2204,6 +2477,57 @@ error:
 	return rc;
 }
 
+int
+vos_dedup_scan(daos_handle_t ioh)
+{
+	struct vos_io_context	*ioc = vos_ioh2ioc(ioh);
+	struct dcs_csum_info	*csum;
+	struct bio_sglist	*bsgl;
+	struct bio_iov		*biov;
+	daos_iod_t		*iod;
+	int			 i, j;
+	int			 rc;
+
+	D_ASSERT(ioc->ic_update);
+	if (!ioc->ic_cdc || ioc->ic_cdc_io != NULL)
+		return 0;
+
+	for (i = 0; i < ioc->ic_iod_nr; i++) {
+		iod = &ioc->ic_iods[i];
+		bsgl = bio_iod_sgl(ioc->ic_biod, i);
+		/* Extents and bio IOVs only match one to one without holes */
+		if (iod->iod_type != DAOS_IOD_ARRAY ||
+		    bsgl->bs_nr_out != iod->iod_nr)
+			continue;
+
+		for (j = 0; j < iod->iod_nr; j++) {
+			biov = &bsgl->bs_iovs[j];
+			if (biov->bi_addr.ba_type != DAOS_MEDIA_NVME ||
+			    bio_addr_is_hole(&biov->bi_addr) ||
+			    bio_iov2buf(biov) == NULL ||
+			    bio_iov2len(biov) < ioc->ic_dedup_th)
+				continue;
+
+			csum = NULL;
+			if (ioc->iod_csums != NULL &&
+			    ioc->iod_csums[i].ic_nr > 0)
+				csum = &ioc->iod_csums[i].ic_data[j];
+
+			rc = vos_cdc_scan(vos_cont2pool(ioc->ic_cont),
+					  &ioc->ic_cdc_io, i, j,
+					  bio_iov2buf(biov), &iod->iod_recxs[j],
+					  iod->iod_size, csum);
+			if (rc != 0) {
+				vos_cdc_io_end(vos_cont2pool(ioc->ic_cont),
+					       ioc->ic_cdc_io, rc);
+				ioc->ic_cdc_io = NULL;
+				return rc;
+			}
+		}
+	}
+	return 0;
+}
+
 struct daos_recx_ep_list *
 vos_ioh2recx_list(daos_handle_t ioh)
 {
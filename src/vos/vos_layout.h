@@ -89,8 +89,12 @@ enum vos_gc_type {
 
 /** Lowest supported durable format version */
 #define POOL_DF_VER_1				13
+/** Durable format version adding the dedup index */
+#define POOL_DF_VER_2				14
+/** Durable format version adding compressed SCM records (ba_compressed) */
+#define POOL_DF_VER_3				15
 /** Current durable format version */
-#define POOL_DF_VERSION				POOL_DF_VER_1
+#define POOL_DF_VERSION				POOL_DF_VER_3
 
 /**
  * Durable format for VOS pool
@@ -118,6 +122,24 @@ struct vos_pool_df {
 	struct vea_space_df			pd_vea_df;
 	/** GC bins for container/object/dkey... */
 	struct vos_gc_bin_df			pd_gc_bins[GC_MAX];
+	/** Index of the shared NVMe extents, since POOL_DF_VER_2 */
+	struct btr_root				pd_dedup_root;
+};
+
+/** Length of the fingerprint of a shared extent (SHA-256) */
+#define VOS_DEDUP_FP_LEN			32
+
+/**
+ * Record of the dedup index of a pool, keyed by the block offset of a shared
+ * NVMe extent, see vos_dedup.c.
+ */
+struct vos_dedup_df {
+	/** Fingerprint of the extent data */
+	uint8_t					dd_fp[VOS_DEDUP_FP_LEN];
+	/** Number of blocks of the extent */
+	uint32_t				dd_blk_cnt;
+	/** Number of evtree records referencing the extent */
+	uint32_t				dd_ref;
 };
 
 /**
@@ -352,4 +374,28 @@ struct vos_obj_df {
 	struct btr_root			vo_tree;
 };
 
+#define VOS_CMP_MAGIC			0xc0de5ca1
+/** Stored length flag of a chunk kept uncompressed */
+#define VOS_CMP_RAW			(1U << 31)
+
+/**
+ * Header of a compressed array record, referenced by an evtree record with
+ * bio_addr_t::ba_compressed set. It is followed by the chunks of the record,
+ * each compressed on its own, back to back.
+ * NB: PMEM data structure.
+ */
+struct vos_cmp_hdr {
+	uint32_t			ch_magic;
+	/** enum DAOS_COMPRESS_TYPE */
+	uint16_t			ch_type;
+	uint16_t			ch_padding;
+	/** uncompressed bytes of each chunk, but the last one */
+	uint32_t			ch_chunk_size;
+	uint32_t			ch_chunk_nr;
+	/** uncompressed bytes of the record */
+	uint64_t			ch_size;
+	/** stored bytes of each chunk, VOS_CMP_RAW may be set */
+	uint32_t			ch_lens[0];
+};
+
 #endif
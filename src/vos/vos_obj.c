@@ -1325,6 +1325,13 @@ recx_iter_copy(struct vos_obj_iter *oiter, vos_iter_entry_t *it_entry,
 	 * size in bio_read().
 	 */
 	iov_out->iov_len = bio_iov2len(biov);
+	if (biov->bi_addr.ba_compressed)
+		return vos_cmp_read(oiter->it_obj->obj_cont, biov->bi_addr,
+				    (it_entry->ie_recx.rx_idx -
+				     it_entry->ie_orig_recx.rx_idx) *
+				    it_entry->ie_rsize, iov_out->iov_len,
+				    iov_out->iov_buf);
+
 	bioc = oiter->it_obj->obj_cont->vc_pool->vp_io_ctxt;
 	D_ASSERT(bioc != NULL);
 
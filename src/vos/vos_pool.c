@@ -121,6 +121,8 @@ pool_hop_free(struct d_ulink *hlink)
 	if (daos_handle_is_valid(pool->vp_cont_th))
 		dbtree_close(pool->vp_cont_th);
 
+	vos_cdc_close(pool);
+
 	if (pool->vp_uma.uma_pool)
 		vos_pmemobj_close(pool->vp_uma.uma_pool);
 
@@ -313,6 +315,10 @@ vos_pool_create(const char *path, uuid_t uuid, daos_size_t scm_sz,
 
 	dbtree_close(hdl);
 
+	rc = vos_cdc_create(&uma, pool_df);
+	if (rc != 0)
+		goto end;
+
 	uuid_copy(pool_df->pd_id, uuid);
 	pool_df->pd_scm_sz	= scm_sz;
 	pool_df->pd_nvme_sz	= nvme_sz;
@@ -713,6 +719,10 @@ vos_pool_open(const char *path, uuid_t uuid, bool small, daos_handle_t *poh)
 	if (rc)
 		goto failed;
 
+	rc = vos_cdc_open(pool, pool_df);
+	if (rc)
+		goto failed;
+
 	/* Insert the opened pool to the uuid hash table */
 	rc = pool_link(pool, &ukey, poh);
 	if (rc) {
@@ -808,6 +818,20 @@ vos_pool_query_space(uuid_t pool_id, struct vos_pool_space *vps)
 	return rc;
 }
 
+int
+vos_pool_scm_window(daos_handle_t poh, d_iov_t *iov)
+{
+	struct vos_pool	*pool = vos_hdl2pool(poh);
+
+	if (pool == NULL)
+		return -DER_NO_HDL;
+
+	D_ASSERT(iov != NULL);
+	d_iov_set(iov, (void *)vos_pool2umm(pool)->umm_base,
+		  pool->vp_pool_df->pd_scm_sz);
+	return 0;
+}
+
 int
 vos_pool_space_sys_set(daos_handle_t poh, daos_size_t *space_sys)
 {